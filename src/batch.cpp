@@ -0,0 +1,154 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <exception>
+
+#include "config.h"
+#include "exception.h"
+#include "batch.h"
+
+namespace libhtmlpp {
+    //stores the failure of one document, a message that can't be copied is dropped
+    static void _failed(HtmlElement **roots,std::string *errs,size_t i,const char *msg){
+        roots[i]=nullptr;
+        if(!errs)
+            return;
+        try{
+            errs[i]=msg;
+        }catch(...){
+            errs[i].clear();
+        }
+    }
+};
+
+libhtmlpp::HtmlBatch::HtmlBatch() : HtmlBatch(MAXTHREADS){
+}
+
+libhtmlpp::HtmlBatch::HtmlBatch(size_t threads){
+    _Docs=nullptr;
+    _Roots=nullptr;
+    _Errors=nullptr;
+    _Count=0;
+    _Next=0;
+    _Failed=0;
+    _Pending=0;
+    _Generation=0;
+    _Stop=false;
+
+    if(threads<1)
+        threads=1;
+
+    for(size_t i=0; i<threads; ++i){
+        _Workers.push_back(std::thread(&HtmlBatch::_work,this));
+    }
+}
+
+libhtmlpp::HtmlBatch::~HtmlBatch(){
+    {
+        std::lock_guard<std::mutex> lock(_Lock);
+        _Stop=true;
+    }
+    _Wake.notify_all();
+    for(std::thread &worker : _Workers){
+        worker.join();
+    }
+}
+
+size_t libhtmlpp::HtmlBatch::threads() const{
+    return _Workers.size();
+}
+
+size_t libhtmlpp::HtmlBatch::parse(std::vector<HtmlString> &docs,std::vector<HtmlElement*> &roots,
+                                   std::vector<std::string> *errs){
+    roots.resize(docs.size());
+    if(errs){
+        errs->clear();
+        errs->resize(docs.size());
+    }
+    return parse(docs.data(),docs.size(),roots.data(),errs ? errs->data() : nullptr);
+}
+
+size_t libhtmlpp::HtmlBatch::parse(HtmlString *docs,size_t count,HtmlElement **roots,std::string *errs){
+    if(count==0)
+        return 0;
+
+    std::lock_guard<std::mutex> run(_RunLock);
+    std::unique_lock<std::mutex> lock(_Lock);
+
+    _Docs=docs;
+    _Roots=roots;
+    _Errors=errs;
+    _Count=count;
+    _Next=0;
+    _Failed=0;
+    _Pending=_Workers.size();
+    ++_Generation;
+
+    _Wake.notify_all();
+    _Done.wait(lock,[this]{ return _Pending==0; });
+
+    _Docs=nullptr;
+    _Roots=nullptr;
+    _Errors=nullptr;
+    return _Failed;
+}
+
+void libhtmlpp::HtmlBatch::_work(){
+    unsigned long seen=0;
+    for(;;){
+        std::unique_lock<std::mutex> lock(_Lock);
+        _Wake.wait(lock,[this,seen]{ return _Stop || _Generation!=seen; });
+        if(_Stop)
+            return;
+        seen=_Generation;
+        HtmlString  *docs=_Docs;
+        HtmlElement **roots=_Roots;
+        std::string *errs=_Errors;
+        size_t       count=_Count;
+        lock.unlock();
+
+        for(size_t i=_Next++; i<count; i=_Next++){
+            try{
+                roots[i]=docs[i].parse();
+            }catch(HTMLException &e){
+                _failed(roots,errs,i,e.what());
+                ++_Failed;
+            }catch(std::exception &e){
+                //bad_alloc and friends must not end the worker and the process
+                _failed(roots,errs,i,e.what());
+                ++_Failed;
+            }catch(...){
+                _failed(roots,errs,i,"unknown error while parsing");
+                ++_Failed;
+            }
+        }
+
+        lock.lock();
+        if(--_Pending==0)
+            _Done.notify_one();
+    }
+}
@@ -0,0 +1,85 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "html.h"
+
+#pragma once
+
+namespace libhtmlpp {
+
+    /*
+     * parses many independent documents on a fixed pool of worker threads.
+     * The pool is created once and sized from MAXTHREADS by default, every
+     * worker keeps its own parse arena alive between batches. Each parsed
+     * tree is owned by the HtmlString it was parsed from, exactly like
+     * HtmlString::parse(), so results can be used and freed independently.
+     */
+    class HtmlBatch {
+    public:
+        HtmlBatch();
+        HtmlBatch(size_t threads);
+        ~HtmlBatch();
+
+        /*
+         * parses docs[0..count) and stores what HtmlString::parse() returns
+         * in roots[i], nullptr if the document failed to parse or has no
+         * element. Returns the number of failed documents, the messages are
+         * stored in errs[i] if errs is given. Any exception of a document,
+         * bad_alloc too, only fails that document.
+         */
+        size_t parse(HtmlString *docs,size_t count,HtmlElement **roots,std::string *errs=nullptr);
+        size_t parse(std::vector<HtmlString> &docs,std::vector<HtmlElement*> &roots,
+                     std::vector<std::string> *errs=nullptr);
+
+        size_t threads() const;
+    private:
+        void                     _work();
+
+        std::vector<std::thread> _Workers;
+        std::mutex               _RunLock;
+        std::mutex               _Lock;
+        std::condition_variable  _Wake;
+        std::condition_variable  _Done;
+
+        HtmlString              *_Docs;
+        HtmlElement            **_Roots;
+        std::string             *_Errors;
+        size_t                   _Count;
+        std::atomic<size_t>      _Next;
+        std::atomic<size_t>      _Failed;
+        size_t                   _Pending;
+        unsigned long            _Generation;
+        bool                     _Stop;
+    };
+};
@@ -0,0 +1,904 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "cascade.h"
+#include "tokenizer.h"
+
+namespace libhtmlpp {
+    static inline bool _selSpace(char c){
+        return c==' ' || c=='\t' || c=='\n' || c=='\r' || c=='\f';
+    }
+
+    static inline bool _selNameChar(char c){
+        return (c>='a' && c<='z') || (c>='A' && c<='Z') || (c>='0' && c<='9') ||
+               c=='-' || c=='_' || c=='\\' || (unsigned char)c>=0x80;
+    }
+
+    static void _selLower(std::string &str){
+        for(char &c : str){
+            if(c>='A' && c<='Z')
+                c|=0x20;
+        }
+    }
+
+    static const char *_selSkip(const char *pos,const char *end){
+        while(pos<end && _selSpace(*pos))
+            ++pos;
+        return pos;
+    }
+
+    //reads a name, escaped characters are taken as they are
+    static const char *_selIdent(const char *pos,const char *end,std::string &out){
+        out.clear();
+        while(pos<end && _selNameChar(*pos)){
+            if(*pos=='\\'){
+                if(pos+1>=end)
+                    break;
+                ++pos;
+            }
+            out+=*pos++;
+        }
+        return pos;
+    }
+
+    //next , or ) on the same level, end if there is none
+    static const char *_selNext(const char *pos,const char *end,char stop){
+        int level=0;
+        char quote=0;
+        for(; pos<end; ++pos){
+            char c=*pos;
+            if(c=='\\'){
+                ++pos;
+                continue;
+            }
+            if(quote){
+                if(c==quote)
+                    quote=0;
+                continue;
+            }
+            switch(c){
+                case '"': case '\'':
+                    quote=c;
+                    break;
+                case '(': case '[':
+                    ++level;
+                    break;
+                case ')': case ']':
+                    if(level==0 && c==stop)
+                        return pos;
+                    --level;
+                    break;
+                case ',':
+                    if(level==0 && c==stop)
+                        return pos;
+                    break;
+            }
+        }
+        return end;
+    }
+
+    //an+b, odd and even
+    static bool _selNth(const char *pos,const char *end,int &a,int &b){
+        std::string arg;
+        for(; pos<end; ++pos){
+            if(!_selSpace(*pos))
+                arg+=*pos;
+        }
+        _selLower(arg);
+
+        if(arg=="odd"){
+            a=2;
+            b=1;
+            return true;
+        }else if(arg=="even"){
+            a=2;
+            b=0;
+            return true;
+        }
+
+        auto number=[](const std::string &str,int &out){
+            size_t i=0;
+            bool neg=false;
+            if(i<str.size() && (str[i]=='+' || str[i]=='-'))
+                neg=str[i++]=='-';
+            if(i>=str.size())
+                return false;
+            out=0;
+            for(; i<str.size(); ++i){
+                if(str[i]<'0' || str[i]>'9')
+                    return false;
+                out=out*10+(str[i]-'0');
+            }
+            if(neg)
+                out=-out;
+            return true;
+        };
+
+        size_t n=arg.find('n');
+        if(n==std::string::npos){
+            a=0;
+            return number(arg,b);
+        }
+
+        std::string coef=arg.substr(0,n);
+        if(coef.empty() || coef=="+")
+            a=1;
+        else if(coef=="-")
+            a=-1;
+        else if(!number(coef,a))
+            return false;
+
+        b=0;
+        return n+1==arg.size() || ((arg[n+1]=='+' || arg[n+1]=='-') && number(arg.substr(n+1),b));
+    }
+
+    static uint32_t _selHash(char type,const char *str,size_t len){
+        uint32_t hash=2166136261u;
+        hash=(hash^(unsigned char)type)*16777619u;
+        for(size_t i=0; i<len; ++i){
+            char c=str[i];
+            //tag names are compared case insensitive
+            if(type=='<' && c>='A' && c<='Z')
+                c|=0x20;
+            hash=(hash^(unsigned char)c)*16777619u;
+        }
+        return hash ? hash : 1;
+    }
+
+    #define FILTERSIZE 4096
+
+    static bool _selNthMatch(int a,int b,int index){
+        if(a==0)
+            return index==b;
+        return (index-b)/a>=0 && (index-b)%a==0;
+    }
+
+    static bool _selEqual(const char *a,const char *b,size_t len,bool nocase){
+        if(!nocase)
+            return memcmp(a,b,len)==0;
+        for(size_t i=0; i<len; ++i){
+            char ca=a[i],cb=b[i];
+            if(ca>='A' && ca<='Z')
+                ca|=0x20;
+            if(cb>='A' && cb<='Z')
+                cb|=0x20;
+            if(ca!=cb)
+                return false;
+        }
+        return true;
+    }
+
+    //true if the whitespace separated list contains word
+    static bool _selWord(const char *list,size_t len,const char *word,size_t wlen,bool nocase){
+        size_t i=0;
+        while(i<len){
+            while(i<len && _selSpace(list[i]))
+                ++i;
+            size_t start=i;
+            while(i<len && !_selSpace(list[i]))
+                ++i;
+            if(i-start==wlen && wlen>0 && _selEqual(list+start,word,wlen,nocase))
+                return true;
+        }
+        return false;
+    }
+
+    static bool _selAttribute(char op,bool nocase,const std::vector<char> &value,const std::string &want){
+        const char *v=value.data();
+        size_t vlen=value.size(),wlen=want.size();
+        switch(op){
+            case '=':
+                return vlen==wlen && _selEqual(v,want.data(),wlen,nocase);
+            case '~':
+                return _selWord(v,vlen,want.data(),wlen,nocase);
+            case '|':
+                return (vlen==wlen || (vlen>wlen && v[wlen]=='-')) && _selEqual(v,want.data(),wlen,nocase);
+            case '^':
+                return wlen>0 && vlen>=wlen && _selEqual(v,want.data(),wlen,nocase);
+            case '$':
+                return wlen>0 && vlen>=wlen && _selEqual(v+vlen-wlen,want.data(),wlen,nocase);
+            case '*':
+                if(wlen==0 || vlen<wlen)
+                    return false;
+                for(size_t i=0; i+wlen<=vlen; ++i){
+                    if(_selEqual(v+i,want.data(),wlen,nocase))
+                        return true;
+                }
+                return false;
+        }
+        return true;
+    }
+
+    //elements that aren't rendered, nothing in them gets a style
+    static const char *UnstyledElements[]={
+        "base","head","link","meta","noscript","script","style","template","title",nullptr
+    };
+
+    //declarations of a style attribute
+    class CssInline : public CssParser {
+    public:
+        std::vector<CssCascade::Property> Properties;
+    protected:
+        void onRule(const char *selector,size_t slen,const Declaration *decls,size_t dcount) override{
+            for(size_t i=0; i<dcount; ++i){
+                CssCascade::Property prop;
+                prop.Name.assign(decls[i].Property,decls[i].PropertySize);
+                prop.Value.assign(decls[i].Value,decls[i].ValueSize);
+                prop.Important=decls[i].Important;
+                Properties.push_back(prop);
+            }
+        }
+    };
+};
+
+libhtmlpp::CssCascade::CssCascade(){
+    _Order=0;
+}
+
+libhtmlpp::CssCascade::~CssCascade(){
+}
+
+void libhtmlpp::CssCascade::clear(){
+    _Selectors.clear();
+    _Compounds.clear();
+    _Conditions.clear();
+    _Ids.clear();
+    _Classes.clear();
+    _Tags.clear();
+    _Universal.clear();
+    _Order=0;
+}
+
+size_t libhtmlpp::CssCascade::getSelectorCount() const{
+    size_t count=_Universal.size();
+    for(auto &bucket : _Ids)
+        count+=bucket.second.size();
+    for(auto &bucket : _Classes)
+        count+=bucket.second.size();
+    for(auto &bucket : _Tags)
+        count+=bucket.second.size();
+    return count;
+}
+
+void libhtmlpp::CssCascade::addStylesheet(const CssStylesheet &sheet){
+    const CssStylesheet::Rule *rules=sheet.getRules();
+    const CssStylesheet::Selector *selectors=sheet.getSelectors();
+
+    for(size_t r=0; r<sheet.getRuleCount(); ++r){
+        const CssStylesheet::Rule &rule=rules[r];
+        if(rule.Type!=CssStylesheet::StyleRule || rule.Parent!=CssStylesheet::NoRule ||
+            rule.DeclarationCount==0)
+            continue;
+
+        uint32_t order=_Order++;
+        for(uint32_t i=0; i<rule.SelectorCount; ++i){
+            const CssStylesheet::Selector &ssel=selectors[rule.FirstSelector+i];
+            Selector sel;
+            if(!_compile(sheet.data()+ssel.Text.Offset,ssel.Text.Size,sel))
+                continue;
+            sel.Specificity=ssel.Specificity;
+            sel.Order=order;
+            sel.Sheet=&sheet;
+            sel.Rule=r;
+
+            //compounds before a descendant or child combinator are ancestors
+            size_t hashes=0;
+            for(uint32_t c=0; c+1<sel.CompoundCount && hashes<4; ++c){
+                const Compound &comp=_Compounds[sel.FirstCompound+c];
+                char comb=_Compounds[sel.FirstCompound+c+1].Combinator;
+                if(comb!=' ' && comb!='>')
+                    continue;
+                for(uint32_t n=0; n<comp.ConditionCount && hashes<4; ++n){
+                    const Condition &cond=_Conditions[comp.FirstCondition+n];
+                    if(cond.Type==Id || cond.Type==Class)
+                        sel.Filter[hashes++]=_selHash(cond.Type==Id ? '#' : '.',cond.Name.data(),cond.Name.size());
+                }
+                if(!comp.Tag.empty() && hashes<4)
+                    sel.Filter[hashes++]=_selHash('<',comp.Tag.data(),comp.Tag.size());
+            }
+
+            uint32_t idx=_Selectors.size();
+            _Selectors.push_back(sel);
+
+            //the rightmost compound decides which elements can match at all
+            const Compound &last=_Compounds[sel.FirstCompound+sel.CompoundCount-1];
+            const Condition *cls=nullptr,*id=nullptr;
+            for(uint32_t c=0; c<last.ConditionCount; ++c){
+                const Condition &cond=_Conditions[last.FirstCondition+c];
+                if(cond.Type==Id && !id)
+                    id=&cond;
+                else if(cond.Type==Class && !cls)
+                    cls=&cond;
+            }
+            if(id)
+                _Ids[id->Name].push_back(idx);
+            else if(cls)
+                _Classes[cls->Name].push_back(idx);
+            else if(!last.Tag.empty())
+                _Tags[last.Tag].push_back(idx);
+            else
+                _Universal.push_back(idx);
+        }
+    }
+}
+
+bool libhtmlpp::CssCascade::_compile(const char *sel,size_t len,Selector &out){
+    const char *pos=_selSkip(sel,sel+len),*end=sel+len;
+    std::vector<Compound> compounds;
+    char combinator=0;
+
+    while(end>pos && _selSpace(end[-1]))
+        --end;
+
+    while(pos<end){
+        Compound comp;
+        std::vector<Condition> conds;
+        if(!_compound(pos,end,comp,conds))
+            return false;
+        comp.Combinator=combinator;
+        comp.FirstCondition=_Conditions.size();
+        comp.ConditionCount=conds.size();
+        _Conditions.insert(_Conditions.end(),conds.begin(),conds.end());
+        compounds.push_back(comp);
+
+        const char *next=_selSkip(pos,end);
+        if(next>=end)
+            break;
+        if(*next=='>' || *next=='+' || *next=='~'){
+            combinator=*next;
+            pos=_selSkip(next+1,end);
+            if(pos>=end)
+                return false;
+        }else if(next>pos){
+            combinator=' ';
+            pos=next;
+        }else{
+            return false;
+        }
+    }
+
+    if(compounds.empty())
+        return false;
+
+    out.FirstCompound=_Compounds.size();
+    out.CompoundCount=compounds.size();
+    out.Specificity=0;
+    out.Order=0;
+    out.Sheet=nullptr;
+    out.Rule=0;
+    memset(out.Filter,0,sizeof(out.Filter));
+    _Compounds.insert(_Compounds.end(),compounds.begin(),compounds.end());
+    return true;
+}
+
+bool libhtmlpp::CssCascade::_compound(const char *&pos,const char *end,Compound &out,
+                                      std::vector<Condition> &conds){
+    bool any=false;
+
+    if(pos<end && *pos=='*'){
+        ++pos;
+        any=true;
+    }else if(pos<end && _selNameChar(*pos)){
+        pos=_selIdent(pos,end,out.Tag);
+        _selLower(out.Tag);
+        any=true;
+    }
+
+    //namespace prefix like svg|rect
+    if(pos+1<end && *pos=='|' && pos[1]!='='){
+        out.Tag.clear();
+        ++pos;
+        if(*pos=='*'){
+            ++pos;
+        }else{
+            pos=_selIdent(pos,end,out.Tag);
+            _selLower(out.Tag);
+        }
+    }
+
+    while(pos<end){
+        Condition cond;
+        cond.Operator=0;
+        cond.NoCase=false;
+        cond.A=0;
+        cond.B=0;
+        cond.FirstSelector=0;
+        cond.SelectorCount=0;
+
+        char c=*pos;
+        if(c=='#' || c=='.'){
+            cond.Type=c=='#' ? Id : Class;
+            pos=_selIdent(pos+1,end,cond.Name);
+            if(cond.Name.empty())
+                return false;
+        }else if(c=='['){
+            const char *close=_selNext(pos+1,end,']');
+            if(close>=end)
+                return false;
+            cond.Type=Attribute;
+            pos=_selIdent(_selSkip(pos+1,close),close,cond.Name);
+            _selLower(cond.Name);
+            if(cond.Name.empty())
+                return false;
+            pos=_selSkip(pos,close);
+            if(pos<close){
+                if(*pos=='='){
+                    cond.Operator='=';
+                    ++pos;
+                }else if(pos+1<close && pos[1]=='=' && strchr("~|^$*",*pos)){
+                    cond.Operator=*pos;
+                    pos+=2;
+                }else{
+                    return false;
+                }
+                pos=_selSkip(pos,close);
+                if(pos<close && (*pos=='"' || *pos=='\'')){
+                    char quote=*pos++;
+                    while(pos<close && *pos!=quote){
+                        if(*pos=='\\' && pos+1<close)
+                            ++pos;
+                        cond.Value+=*pos++;
+                    }
+                    if(pos>=close)
+                        return false;
+                    ++pos;
+                }else{
+                    pos=_selIdent(pos,close,cond.Value);
+                }
+                pos=_selSkip(pos,close);
+                if(pos<close && (*pos=='i' || *pos=='I')){
+                    cond.NoCase=true;
+                    ++pos;
+                }else if(pos<close && (*pos=='s' || *pos=='S')){
+                    ++pos;
+                }
+                if(_selSkip(pos,close)!=close)
+                    return false;
+            }
+            pos=close+1;
+        }else if(c==':'){
+            ++pos;
+            //pseudo elements never belong to an element
+            if(pos<end && *pos==':')
+                return false;
+            std::string name;
+            pos=_selIdent(pos,end,name);
+            _selLower(name);
+
+            if(pos<end && *pos=='('){
+                const char *arg=pos+1,*close=_selNext(arg,end,')');
+                if(close>=end)
+                    return false;
+
+                if(name=="not" || name=="is" || name=="where" || name=="matches" ||
+                    name=="-webkit-any" || name=="-moz-any"){
+                    cond.Type=name=="not" ? Not : Is;
+                    std::vector<Selector> list;
+                    for(const char *part=arg; part<=close; ){
+                        const char *comma=_selNext(part,close,',');
+                        Selector sel;
+                        if(_compile(part,comma-part,sel))
+                            list.push_back(sel);
+                        else if(cond.Type==Not)
+                            return false;
+                        part=comma+1;
+                    }
+                    cond.FirstSelector=_Selectors.size();
+                    cond.SelectorCount=list.size();
+                    _Selectors.insert(_Selectors.end(),list.begin(),list.end());
+                }else if(name=="nth-child" || name=="nth-last-child" ||
+                         name=="nth-of-type" || name=="nth-last-of-type"){
+                    if(name=="nth-child")
+                        cond.Type=Nth;
+                    else if(name=="nth-last-child")
+                        cond.Type=NthLast;
+                    else if(name=="nth-of-type")
+                        cond.Type=NthOfType;
+                    else
+                        cond.Type=NthLastOfType;
+                    if(!_selNth(arg,close,cond.A,cond.B))
+                        return false;
+                }else{
+                    return false;
+                }
+                pos=close+1;
+            }else{
+                cond.A=0;
+                cond.B=1;
+                if(name=="first-child"){
+                    cond.Type=Nth;
+                }else if(name=="last-child"){
+                    cond.Type=NthLast;
+                }else if(name=="only-child"){
+                    cond.Type=Nth;
+                    conds.push_back(cond);
+                    cond.Type=NthLast;
+                }else if(name=="first-of-type"){
+                    cond.Type=NthOfType;
+                }else if(name=="last-of-type"){
+                    cond.Type=NthLastOfType;
+                }else if(name=="only-of-type"){
+                    cond.Type=NthOfType;
+                    conds.push_back(cond);
+                    cond.Type=NthLastOfType;
+                }else if(name=="root"){
+                    cond.Type=Root;
+                }else if(name=="empty"){
+                    cond.Type=Empty;
+                }else if(name=="checked" || name=="disabled"){
+                    cond.Type=Attribute;
+                    cond.Name=name;
+                }else{
+                    //:hover, :focus and the old pseudo elements like :before
+                    return false;
+                }
+            }
+        }else{
+            break;
+        }
+        conds.push_back(cond);
+        any=true;
+    }
+    return any;
+}
+
+const std::vector<char> *libhtmlpp::CssCascade::_attribute(const HtmlElement *el,const char *name) const{
+    for(const HtmlElement::Attributes *attr=el->_firstAttr; attr; attr=attr->_nextAttr){
+        if(HtmlTokenizer::isName(attr->_Key.data(),attr->_Key.size(),name))
+            return &attr->_Value;
+    }
+    return nullptr;
+}
+
+bool libhtmlpp::CssCascade::_matches(const Selector &sel,const HtmlElement *el) const{
+    return _matches(sel,sel.CompoundCount-1,el);
+}
+
+bool libhtmlpp::CssCascade::_matches(const Selector &sel,uint32_t compound,const HtmlElement *el) const{
+    const Compound &comp=_Compounds[sel.FirstCompound+compound];
+    if(!_matches(comp,el))
+        return false;
+    if(compound==0)
+        return true;
+
+    auto previous=[](const Element *cur){
+        for(cur=cur->_prevElement; cur; cur=cur->_prevElement){
+            if(cur->_Type==HtmlEl)
+                return (const HtmlElement*)cur;
+        }
+        return (const HtmlElement*)nullptr;
+    };
+
+    switch(comp.Combinator){
+        case '>':{
+            const HtmlElement *parent=(const HtmlElement*)el->_parentElement;
+            return parent && _matches(sel,compound-1,parent);
+        }
+        case ' ':
+            for(const Element *parent=el->_parentElement; parent; parent=parent->_parentElement){
+                if(_matches(sel,compound-1,(const HtmlElement*)parent))
+                    return true;
+            }
+            return false;
+        case '+':{
+            const HtmlElement *prev=previous(el);
+            return prev && _matches(sel,compound-1,prev);
+        }
+        case '~':
+            for(const HtmlElement *prev=previous(el); prev; prev=previous(prev)){
+                if(_matches(sel,compound-1,prev))
+                    return true;
+            }
+            return false;
+    }
+    return false;
+}
+
+bool libhtmlpp::CssCascade::_matches(const Compound &comp,const HtmlElement *el) const{
+    if(!comp.Tag.empty() &&
+        !HtmlTokenizer::isName(el->_TagName.data(),el->_TagName.size(),comp.Tag.c_str()))
+        return false;
+
+    for(uint32_t i=0; i<comp.ConditionCount; ++i){
+        const Condition &cond=_Conditions[comp.FirstCondition+i];
+        switch(cond.Type){
+            case Id:{
+                const std::vector<char> *id=_attribute(el,"id");
+                if(!id || id->size()!=cond.Name.size() || memcmp(id->data(),cond.Name.data(),id->size())!=0)
+                    return false;
+            }break;
+            case Class:{
+                const std::vector<char> *cls=_attribute(el,"class");
+                if(!cls || !_selWord(cls->data(),cls->size(),cond.Name.data(),cond.Name.size(),false))
+                    return false;
+            }break;
+            case Attribute:{
+                const std::vector<char> *value=_attribute(el,cond.Name.c_str());
+                if(!value || (cond.Operator && !_selAttribute(cond.Operator,cond.NoCase,*value,cond.Value)))
+                    return false;
+            }break;
+            case Nth:
+            case NthLast:
+            case NthOfType:
+            case NthLastOfType:{
+                bool last=cond.Type==NthLast || cond.Type==NthLastOfType;
+                bool type=cond.Type==NthOfType || cond.Type==NthLastOfType;
+                int index=1;
+                for(const Element *sib=last ? el->_nextElement : el->_prevElement; sib;
+                    sib=last ? sib->_nextElement : sib->_prevElement){
+                    if(sib->_Type!=HtmlEl)
+                        continue;
+                    const HtmlElement *hsib=(const HtmlElement*)sib;
+                    if(type && (hsib->_TagName.size()!=el->_TagName.size() ||
+                        !_selEqual(hsib->_TagName.data(),el->_TagName.data(),el->_TagName.size(),true)))
+                        continue;
+                    ++index;
+                }
+                if(!_selNthMatch(cond.A,cond.B,index))
+                    return false;
+            }break;
+            case Root:
+                if(el->_parentElement || el->_TagName.empty() || el->_TagName[0]=='!')
+                    return false;
+                break;
+            case Empty:
+                for(const Element *child=el->_children(); child; child=child->_nextElement){
+                    if(child->_Type==HtmlEl || (child->_Type==TextEl && !((const TextElement*)child)->_Text.empty()))
+                        return false;
+                }
+                break;
+            case Not:
+            case Is:{
+                bool found=false;
+                for(uint32_t s=0; s<cond.SelectorCount && !found; ++s)
+                    found=_matches(_Selectors[cond.FirstSelector+s],el);
+                if(found==(cond.Type==Not))
+                    return false;
+            }break;
+        }
+    }
+    return true;
+}
+
+void libhtmlpp::CssCascade::_ancestor(AncestorFilter &filter,const HtmlElement *el,int count) const{
+    auto add=[&filter,count](uint32_t hash){
+        filter.Counts[hash%FILTERSIZE]+=count;
+        filter.Counts[(hash>>12)%FILTERSIZE]+=count;
+    };
+
+    const std::vector<char> *id=_attribute(el,"id");
+    if(id)
+        add(_selHash('#',id->data(),id->size()));
+
+    const std::vector<char> *cls=_attribute(el,"class");
+    if(cls){
+        const char *list=cls->data();
+        size_t len=cls->size(),i=0;
+        while(i<len){
+            while(i<len && _selSpace(list[i]))
+                ++i;
+            size_t start=i;
+            while(i<len && !_selSpace(list[i]))
+                ++i;
+            if(i>start)
+                add(_selHash('.',list+start,i-start));
+        }
+    }
+
+    add(_selHash('<',el->_TagName.data(),el->_TagName.size()));
+}
+
+void libhtmlpp::CssCascade::_style(const HtmlElement *el,const AncestorFilter &filter,
+                                   std::vector<Property> &style,std::vector<uint32_t> &matched) const{
+    matched.clear();
+    style.clear();
+
+    auto candidates=[this,el,&filter,&matched](const std::vector<uint32_t> &list){
+        for(uint32_t idx : list){
+            const Selector &sel=_Selectors[idx];
+            bool possible=true;
+            for(size_t i=0; i<4 && sel.Filter[i] && possible; ++i){
+                possible=filter.Counts[sel.Filter[i]%FILTERSIZE] &&
+                         filter.Counts[(sel.Filter[i]>>12)%FILTERSIZE];
+            }
+            if(possible && _matches(sel,el))
+                matched.push_back(idx);
+        }
+    };
+
+    std::string key;
+    const std::vector<char> *id=_attribute(el,"id");
+    if(id && !_Ids.empty()){
+        key.assign(id->data(),id->size());
+        auto bucket=_Ids.find(key);
+        if(bucket!=_Ids.end())
+            candidates(bucket->second);
+    }
+
+    const std::vector<char> *cls=_attribute(el,"class");
+    if(cls && !_Classes.empty()){
+        const char *list=cls->data();
+        size_t len=cls->size(),i=0;
+        while(i<len){
+            while(i<len && _selSpace(list[i]))
+                ++i;
+            size_t start=i;
+            while(i<len && !_selSpace(list[i]))
+                ++i;
+            if(i==start)
+                break;
+            key.assign(list+start,i-start);
+            auto bucket=_Classes.find(key);
+            if(bucket!=_Classes.end())
+                candidates(bucket->second);
+        }
+    }
+
+    if(!_Tags.empty()){
+        key.assign(el->_TagName.begin(),el->_TagName.end());
+        _selLower(key);
+        auto bucket=_Tags.find(key);
+        if(bucket!=_Tags.end())
+            candidates(bucket->second);
+    }
+
+    candidates(_Universal);
+
+    //a class listed twice finds the same selectors again
+    std::sort(matched.begin(),matched.end(),[this](uint32_t a,uint32_t b){
+        const Selector &sa=_Selectors[a],&sb=_Selectors[b];
+        if(sa.Specificity!=sb.Specificity)
+            return sa.Specificity<sb.Specificity;
+        if(sa.Order!=sb.Order)
+            return sa.Order<sb.Order;
+        return a<b;
+    });
+    matched.erase(std::unique(matched.begin(),matched.end()),matched.end());
+
+    //a property set again moves to the end, so it wins over shorthands before it
+    auto apply=[&style](const char *name,size_t nlen,const char *value,size_t vlen,bool important){
+        Property prop;
+        prop.Name.assign(name,nlen);
+        if(nlen<2 || name[0]!='-' || name[1]!='-')
+            _selLower(prop.Name);
+        prop.Value.assign(value,vlen);
+        prop.Important=important;
+        for(size_t i=0; i<style.size(); ++i){
+            if(style[i].Name==prop.Name){
+                style.erase(style.begin()+i);
+                break;
+            }
+        }
+        style.push_back(std::move(prop));
+    };
+
+    CssInline inl;
+    const std::vector<char> *attr=_attribute(el,"style");
+    if(attr && !attr->empty()){
+        HtmlString decoded;
+        decoded.append("a{",2);
+        HtmlDecode(attr->data(),attr->size(),&decoded);
+        decoded.append("}",1);
+        inl.parse(decoded.data(),decoded.size());
+    }
+
+    for(int important=0; important<2; ++important){
+        for(uint32_t idx : matched){
+            const Selector &sel=_Selectors[idx];
+            const CssStylesheet::Rule &rule=sel.Sheet->getRules()[sel.Rule];
+            const CssStylesheet::Declaration *decls=sel.Sheet->getDeclarations()+rule.FirstDeclaration;
+            const char *data=sel.Sheet->data();
+            for(uint32_t d=0; d<rule.DeclarationCount; ++d){
+                if((decls[d].Important!=0)!=(important!=0))
+                    continue;
+                apply(data+decls[d].Property.Offset,decls[d].Property.Size,
+                      data+decls[d].Value.Offset,decls[d].Value.Size,important);
+            }
+        }
+        //the style attribute wins over the stylesheets of the same importance
+        for(const Property &prop : inl.Properties){
+            if(prop.Important==(important!=0))
+                apply(prop.Name.data(),prop.Name.size(),prop.Value.data(),prop.Value.size(),important);
+        }
+    }
+}
+
+void libhtmlpp::CssCascade::getStyle(const HtmlElement *el,std::vector<Property> &style) const{
+    std::vector<uint32_t> matched;
+    AncestorFilter filter;
+    filter.Counts.assign(FILTERSIZE,0);
+    for(const Element *parent=el->_parentElement; parent; parent=parent->_parentElement)
+        _ancestor(filter,(const HtmlElement*)parent,1);
+    _style(el,filter,style,matched);
+}
+
+void libhtmlpp::CssCascade::inlineStyles(HtmlElement *el) const{
+    std::vector<Property> style;
+    std::vector<uint32_t> matched;
+    std::vector<HtmlElement*> parents;
+    std::string value;
+
+    AncestorFilter filter;
+    filter.Counts.assign(FILTERSIZE,0);
+    for(const Element *parent=el->_parentElement; parent; parent=parent->_parentElement)
+        _ancestor(filter,(const HtmlElement*)parent,1);
+
+    Element *cur=el;
+    for(;;){
+        if(cur->_Type==HtmlEl){
+            HtmlElement *hel=(HtmlElement*)cur;
+            bool skip=hel->_TagName.empty() || hel->_TagName[0]=='!';
+            for(size_t i=0; UnstyledElements[i] && !skip; ++i)
+                skip=HtmlTokenizer::isName(hel->_TagName.data(),hel->_TagName.size(),UnstyledElements[i]);
+
+            if(!skip){
+                _style(hel,filter,style,matched);
+                if(!style.empty()){
+                    value.clear();
+                    for(const Property &prop : style){
+                        if(!value.empty())
+                            value+=';';
+                        value+=prop.Name;
+                        value+=':';
+                        //the value ends up between double quotes
+                        for(char c : prop.Value){
+                            if(c=='"')
+                                value+="&quot;";
+                            else if(c=='&')
+                                value+="&amp;";
+                            else
+                                value+=c;
+                        }
+                        if(prop.Important)
+                            value+=" !important";
+                    }
+                    hel->setAttribute("style",5,value.data(),value.size());
+                }
+
+                if(hel->_children()){
+                    parents.push_back(hel);
+                    _ancestor(filter,hel,1);
+                    cur=hel->_children();
+                    continue;
+                }
+            }
+        }
+
+        while(!cur->_nextElement){
+            if(parents.empty())
+                return;
+            cur=parents.back();
+            parents.pop_back();
+            _ancestor(filter,(HtmlElement*)cur,-1);
+        }
+        cur=cur->_nextElement;
+    }
+}
@@ -0,0 +1,144 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <stdint.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "css.h"
+#include "html.h"
+
+#pragma once
+
+namespace libhtmlpp {
+
+    /*
+     * applies stylesheets to HtmlElement trees. Every selector is compiled
+     * once and put into a bucket by the id, class or tag of its rightmost
+     * compound, an element is only matched against the selectors in the
+     * buckets of its own id, classes and tag. A bloom filter of the
+     * ancestors skips selectors like ".nav a" under elements without a
+     * .nav before they get matched. Rules inside @media and other
+     * grouping rules are skipped, selectors with pseudo elements or dynamic
+     * pseudo classes like :hover never match. The stylesheets must live as
+     * long as the cascade.
+     */
+    class CssCascade {
+    public:
+        struct Property {
+            std::string Name;
+            std::string Value;
+            bool        Important;
+        };
+
+        CssCascade();
+        ~CssCascade();
+
+        //later stylesheets win over earlier ones with the same specificity
+        void   addStylesheet(const CssStylesheet &sheet);
+        void   clear();
+
+        size_t getSelectorCount() const;
+
+        //declarations of the cascade for el including its style attribute,
+        //every property once in the order they have to be applied
+        void   getStyle(const HtmlElement *el,std::vector<Property> &style) const;
+
+        //writes the style of el, its following siblings and all their
+        //children into their style attributes, head and script are skipped
+        void   inlineStyles(HtmlElement *el) const;
+    private:
+        enum ConditionType {
+            Id=0,Class,Attribute,Nth,NthLast,NthOfType,NthLastOfType,Root,Empty,Not,Is
+        };
+
+        struct Condition {
+            int         Type;
+            //id, class or lower case attribute name
+            std::string Name;
+            std::string Value;
+            //operator of an attribute selector, 0 if it only has to exist
+            char        Operator;
+            bool        NoCase;
+            //an+b of the nth pseudo classes
+            int         A,B;
+            //argument list of :not() and :is()
+            uint32_t    FirstSelector;
+            uint32_t    SelectorCount;
+        };
+
+        struct Compound {
+            //lower case tag name, empty for every tag
+            std::string Tag;
+            uint32_t    FirstCondition;
+            uint32_t    ConditionCount;
+            //relation to the compound before, 0 for the first one
+            char        Combinator;
+        };
+
+        struct Selector {
+            uint32_t             FirstCompound;
+            uint32_t             CompoundCount;
+            uint32_t             Specificity;
+            //position of the rule in all stylesheets
+            uint32_t             Order;
+            const CssStylesheet *Sheet;
+            uint32_t             Rule;
+            //hashes of ids, classes and tags the ancestors must have, 0 if unused
+            uint32_t             Filter[4];
+        };
+
+        //counting bloom filter of the ids, classes and tags of all ancestors
+        struct AncestorFilter {
+            std::vector<uint16_t> Counts;
+        };
+
+        bool _compile(const char *sel,size_t len,Selector &out);
+        bool _compound(const char *&pos,const char *end,Compound &out,
+                       std::vector<Condition> &conds);
+        bool _matches(const Selector &sel,const HtmlElement *el) const;
+        bool _matches(const Selector &sel,uint32_t compound,const HtmlElement *el) const;
+        bool _matches(const Compound &comp,const HtmlElement *el) const;
+        //raw value of the attribute with the lower case name, nullptr if missing
+        const std::vector<char> *_attribute(const HtmlElement *el,const char *name) const;
+        void _ancestor(AncestorFilter &filter,const HtmlElement *el,int count) const;
+        void _style(const HtmlElement *el,const AncestorFilter &filter,
+                    std::vector<Property> &style,std::vector<uint32_t> &matched) const;
+
+        std::vector<Selector>  _Selectors;
+        std::vector<Compound>  _Compounds;
+        std::vector<Condition> _Conditions;
+
+        std::unordered_map<std::string,std::vector<uint32_t>> _Ids;
+        std::unordered_map<std::string,std::vector<uint32_t>> _Classes;
+        std::unordered_map<std::string,std::vector<uint32_t>> _Tags;
+        std::vector<uint32_t>  _Universal;
+        uint32_t               _Order;
+    };
+};
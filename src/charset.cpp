@@ -0,0 +1,509 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <string.h>
+
+#include <algorithm>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "charset.h"
+#include "exception.h"
+#include "tokenizer.h"
+
+//bytes the encoding of a document is detected from
+#define CHARSET_SNIFFSIZE 1024
+
+namespace libhtmlpp {
+    struct CharsetLabel {
+        const char *Label;
+        int         Encoding;
+    };
+
+    //labels of the encoding standard for the supported encodings
+    static const CharsetLabel CharsetLabels[]={
+        {"unicode-1-1-utf-8",HtmlCharset::Utf8},{"unicode11utf8",HtmlCharset::Utf8},
+        {"unicode20utf8",HtmlCharset::Utf8},{"utf-8",HtmlCharset::Utf8},{"utf8",HtmlCharset::Utf8},
+        {"x-unicode20utf8",HtmlCharset::Utf8},
+        {"ansi_x3.4-1968",HtmlCharset::Windows1252},{"ascii",HtmlCharset::Windows1252},
+        {"cp1252",HtmlCharset::Windows1252},{"cp819",HtmlCharset::Windows1252},
+        {"csisolatin1",HtmlCharset::Windows1252},{"ibm819",HtmlCharset::Windows1252},
+        {"iso-8859-1",HtmlCharset::Windows1252},{"iso-ir-100",HtmlCharset::Windows1252},
+        {"iso8859-1",HtmlCharset::Windows1252},{"iso88591",HtmlCharset::Windows1252},
+        {"iso_8859-1",HtmlCharset::Windows1252},{"iso_8859-1:1987",HtmlCharset::Windows1252},
+        {"l1",HtmlCharset::Windows1252},{"latin1",HtmlCharset::Windows1252},
+        {"us-ascii",HtmlCharset::Windows1252},{"windows-1252",HtmlCharset::Windows1252},
+        {"x-cp1252",HtmlCharset::Windows1252},
+        {"csunicode",HtmlCharset::Utf16LE},{"iso-10646-ucs-2",HtmlCharset::Utf16LE},
+        {"ucs-2",HtmlCharset::Utf16LE},{"unicode",HtmlCharset::Utf16LE},
+        {"unicodefeff",HtmlCharset::Utf16LE},{"utf-16",HtmlCharset::Utf16LE},
+        {"utf-16le",HtmlCharset::Utf16LE},
+        {"unicodefffe",HtmlCharset::Utf16BE},{"utf-16be",HtmlCharset::Utf16BE},
+        {nullptr,HtmlCharset::Unknown}
+    };
+
+    //code points of the bytes 0x80 to 0x9f, the rest of windows-1252 is latin-1
+    static const unsigned short Windows1252[32]={
+        0x20AC,0x0081,0x201A,0x0192,0x201E,0x2026,0x2020,0x2021,
+        0x02C6,0x2030,0x0160,0x2039,0x0152,0x008D,0x017D,0x008F,
+        0x0090,0x2018,0x2019,0x201C,0x201D,0x2022,0x2013,0x2014,
+        0x02DC,0x2122,0x0161,0x203A,0x0153,0x009D,0x017E,0x0178
+    };
+
+    static const char Replacement[]="\xEF\xBF\xBD";
+
+    /*
+     * length of the utf-8 sequence at data, 0 if it is invalid or not
+     * complete. valid gets the bytes of its longest valid start, they are
+     * replaced by one U+FFFD.
+     */
+    static inline size_t _sequence(const unsigned char *data,size_t size,size_t &valid){
+        unsigned char c=data[0];
+        unsigned char lo=0x80,hi=0xBF;
+        size_t len;
+        if(c<0x80){
+            valid=1;
+            return 1;
+        }else if(c>=0xC2 && c<=0xDF){
+            len=2;
+        }else if(c>=0xE0 && c<=0xEF){
+            len=3;
+            if(c==0xE0)
+                lo=0xA0;
+            else if(c==0xED)
+                hi=0x9F;
+        }else if(c>=0xF0 && c<=0xF4){
+            len=4;
+            if(c==0xF0)
+                lo=0x90;
+            else if(c==0xF4)
+                hi=0x8F;
+        }else{
+            valid=0;
+            return 0;
+        }
+        valid=1;
+        for(size_t i=1; i<len; ++i){
+            if(i>=size || data[i]<lo || data[i]>hi)
+                return 0;
+            lo=0x80;
+            hi=0xBF;
+            ++valid;
+        }
+        return len;
+    }
+
+    //position of the first byte above 0x7f from pos, size if there is none
+    static inline size_t _asciiEnd(const unsigned char *data,size_t size,size_t pos){
+#ifdef __SSE2__
+        for(; pos+16<=size; pos+=16){
+            int mask=_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)(data+pos)));
+            if(mask)
+                return pos+__builtin_ctz(mask);
+        }
+#endif
+        while(pos<size && data[pos]<0x80)
+            ++pos;
+        return pos;
+    }
+
+    static inline bool _charsetSpace(char c){
+        return c==' ' || c=='\t' || c=='\n' || c=='\r' || c=='\f';
+    }
+
+    static inline bool _charsetName(const char *data,size_t size,const char *name){
+        size_t nlen=strlen(name);
+        return size==nlen && HtmlTokenizer::isName(data,nlen,name);
+    }
+
+    //charset=value in the content of <meta http-equiv="content-type">
+    static int _contentCharset(const char *data,size_t size){
+        for(size_t pos=0; pos+7<=size; ++pos){
+            if(!HtmlTokenizer::isName(data+pos,7,"charset"))
+                continue;
+            size_t vpos=pos+7;
+            while(vpos<size && _charsetSpace(data[vpos]))
+                ++vpos;
+            if(vpos>=size || data[vpos]!='=')
+                continue;
+            ++vpos;
+            while(vpos<size && _charsetSpace(data[vpos]))
+                ++vpos;
+            if(vpos<size && (data[vpos]=='"' || data[vpos]=='\'')){
+                const char *end=(const char*)memchr(data+vpos+1,data[vpos],size-vpos-1);
+                if(!end)
+                    return HtmlCharset::Unknown;
+                return HtmlCharset::getEncoding(data+vpos+1,end-data-vpos-1);
+            }
+            size_t vend=vpos;
+            while(vend<size && !_charsetSpace(data[vend]) && data[vend]!=';')
+                ++vend;
+            return HtmlCharset::getEncoding(data+vpos,vend-vpos);
+        }
+        return HtmlCharset::Unknown;
+    }
+
+    /*
+     * reads the attributes of a meta tag from pos, the position after <meta.
+     * Returns the encoding it declares or Unknown and the end of the tag in pos.
+     */
+    static int _metaCharset(const char *data,size_t size,size_t &pos){
+        int charset=HtmlCharset::Unknown,content=HtmlCharset::Unknown;
+        bool pragma=false;
+        while(pos<size){
+            while(pos<size && (_charsetSpace(data[pos]) || data[pos]=='/'))
+                ++pos;
+            if(pos>=size || data[pos]=='>')
+                break;
+            size_t nst=pos;
+            while(pos<size && !_charsetSpace(data[pos]) && data[pos]!='=' &&
+                  data[pos]!='>' && data[pos]!='/')
+                ++pos;
+            size_t net=pos;
+            while(pos<size && _charsetSpace(data[pos]))
+                ++pos;
+            const char *value=data+pos;
+            size_t vlen=0;
+            if(pos<size && data[pos]=='='){
+                ++pos;
+                while(pos<size && _charsetSpace(data[pos]))
+                    ++pos;
+                if(pos<size && (data[pos]=='"' || data[pos]=='\'')){
+                    const char *end=(const char*)memchr(data+pos+1,data[pos],size-pos-1);
+                    if(!end)
+                        return HtmlCharset::Unknown;
+                    value=data+pos+1;
+                    vlen=end-value;
+                    pos=end-data+1;
+                }else{
+                    value=data+pos;
+                    while(pos<size && !_charsetSpace(data[pos]) && data[pos]!='>')
+                        ++pos;
+                    vlen=data+pos-value;
+                }
+            }
+            if(_charsetName(data+nst,net-nst,"charset") && charset==HtmlCharset::Unknown)
+                charset=HtmlCharset::getEncoding(value,vlen);
+            else if(_charsetName(data+nst,net-nst,"http-equiv"))
+                pragma=pragma || _charsetName(value,vlen,"content-type");
+            else if(_charsetName(data+nst,net-nst,"content") && content==HtmlCharset::Unknown)
+                content=_contentCharset(value,vlen);
+        }
+        if(charset!=HtmlCharset::Unknown)
+            return charset;
+        return pragma ? content : HtmlCharset::Unknown;
+    }
+
+    //the encoding declared by the first meta tag that has a supported one
+    static int _prescan(const char *data,size_t size){
+        size_t pos=0;
+        while(pos<size){
+            const char *lt=(const char*)memchr(data+pos,'<',size-pos);
+            if(!lt)
+                break;
+            pos=lt-data;
+            if(pos+4<=size && memcmp(data+pos,"<!--",4)==0){
+                size_t end=pos+4;
+                while(end+3<=size && memcmp(data+end,"-->",3)!=0)
+                    ++end;
+                pos=end+3;
+                continue;
+            }
+            if(pos+6<=size && HtmlTokenizer::isName(data+pos+1,4,"meta") &&
+               (_charsetSpace(data[pos+5]) || data[pos+5]=='/')){
+                pos+=5;
+                int enc=_metaCharset(data,size,pos);
+                //a page in utf-16 can't declare it in ascii
+                if(enc==HtmlCharset::Utf16LE || enc==HtmlCharset::Utf16BE)
+                    enc=HtmlCharset::Utf8;
+                if(enc!=HtmlCharset::Unknown)
+                    return enc;
+                continue;
+            }
+            const char *gt=(const char*)memchr(data+pos,'>',size-pos);
+            if(!gt)
+                break;
+            pos=gt-data+1;
+        }
+        return HtmlCharset::Unknown;
+    }
+};
+
+int libhtmlpp::HtmlCharset::getEncoding(const char *label,size_t len){
+    while(len && _charsetSpace(*label)){
+        ++label;
+        --len;
+    }
+    while(len && _charsetSpace(label[len-1]))
+        --len;
+    for(size_t i=0; CharsetLabels[i].Label; ++i){
+        if(_charsetName(label,len,CharsetLabels[i].Label))
+            return CharsetLabels[i].Encoding;
+    }
+    return Unknown;
+}
+
+const char *libhtmlpp::HtmlCharset::getName(int encoding){
+    switch(encoding){
+        case Utf8:
+            return "utf-8";
+        case Windows1252:
+            return "windows-1252";
+        case Utf16LE:
+            return "utf-16le";
+        case Utf16BE:
+            return "utf-16be";
+    }
+    return nullptr;
+}
+
+size_t libhtmlpp::HtmlCharset::validUtf8(const char *data,size_t size){
+    const unsigned char *udata=(const unsigned char*)data;
+    size_t pos=0,valid;
+    for(;;){
+        pos=_asciiEnd(udata,size,pos);
+        if(pos>=size)
+            return size;
+        size_t len=_sequence(udata+pos,size-pos,valid);
+        if(!len)
+            return pos;
+        pos+=len;
+    }
+}
+
+bool libhtmlpp::HtmlCharset::isUtf8(const char *data,size_t size){
+    return validUtf8(data,size)==size;
+}
+
+int libhtmlpp::HtmlCharset::detect(const char *data,size_t size,size_t *bomlen){
+    const unsigned char *udata=(const unsigned char*)data;
+    size_t bom=0;
+    int enc=Unknown;
+    if(size>=3 && udata[0]==0xEF && udata[1]==0xBB && udata[2]==0xBF){
+        bom=3;
+        enc=Utf8;
+    }else if(size>=2 && udata[0]==0xFF && udata[1]==0xFE){
+        bom=2;
+        enc=Utf16LE;
+    }else if(size>=2 && udata[0]==0xFE && udata[1]==0xFF){
+        bom=2;
+        enc=Utf16BE;
+    }
+    if(bomlen)
+        *bomlen=bom;
+    if(enc!=Unknown)
+        return enc;
+
+    enc=_prescan(data,std::min<size_t>(size,CHARSET_SNIFFSIZE));
+    if(enc!=Unknown)
+        return enc;
+
+    //a sequence cut off at the end of the data doesn't count
+    size_t pos=validUtf8(data,size),valid;
+    if(pos==size || (!_sequence(udata+pos,size-pos,valid) && valid==size-pos))
+        return Utf8;
+    return Windows1252;
+}
+
+libhtmlpp::HtmlCharsetDecoder::HtmlCharsetDecoder(){
+    reset();
+}
+
+libhtmlpp::HtmlCharsetDecoder::~HtmlCharsetDecoder(){
+}
+
+void libhtmlpp::HtmlCharsetDecoder::setEncoding(int encoding){
+    if(!HtmlCharset::getName(encoding)){
+        HTMLException excp;
+        excp[HTMLException::Error] << "unsupported encoding";
+        throw excp;
+    }
+    _Encoding=encoding;
+    _Detect=false;
+}
+
+int libhtmlpp::HtmlCharsetDecoder::getEncoding() const{
+    return _Encoding;
+}
+
+size_t libhtmlpp::HtmlCharsetDecoder::getErrors() const{
+    return _Errors;
+}
+
+void libhtmlpp::HtmlCharsetDecoder::reset(){
+    _Encoding=HtmlCharset::Unknown;
+    _Detect=true;
+    _Pending.clear();
+    _Output.clear();
+    _Errors=0;
+}
+
+void libhtmlpp::HtmlCharsetDecoder::feed(const char *data,size_t size,HtmlString &output){
+    if(_Pending.empty() && !_Detect){
+        size_t used=_decode(data,size,false,output);
+        _Pending.assign(data+used,data+size);
+        return;
+    }
+    _Pending.insert(_Pending.end(),data,data+size);
+    if(_Detect){
+        if(_Pending.size()<CHARSET_SNIFFSIZE)
+            return;
+        _detect();
+    }
+    size_t used=_decode(_Pending.data(),_Pending.size(),false,output);
+    _Pending.erase(_Pending.begin(),_Pending.begin()+used);
+}
+
+void libhtmlpp::HtmlCharsetDecoder::finish(HtmlString &output){
+    if(_Detect)
+        _detect();
+    _decode(_Pending.data(),_Pending.size(),true,output);
+    _Pending.clear();
+}
+
+void libhtmlpp::HtmlCharsetDecoder::decode(const char *data,size_t size,HtmlString &output){
+    if(_Detect){
+        size_t bom;
+        _Encoding=HtmlCharset::detect(data,size,&bom);
+        _Detect=false;
+        data+=bom;
+        size-=bom;
+    }
+    feed(data,size,output);
+    finish(output);
+}
+
+void libhtmlpp::HtmlCharsetDecoder::_detect(){
+    size_t bom;
+    _Encoding=HtmlCharset::detect(_Pending.data(),_Pending.size(),&bom);
+    _Pending.erase(_Pending.begin(),_Pending.begin()+bom);
+    _Detect=false;
+}
+
+size_t libhtmlpp::HtmlCharsetDecoder::_decode(const char *data,size_t size,bool last,HtmlString &output){
+    const unsigned char *udata=(const unsigned char*)data;
+    switch(_Encoding){
+        case HtmlCharset::Windows1252:
+            return _windows1252(udata,size,output);
+        case HtmlCharset::Utf16LE:
+        case HtmlCharset::Utf16BE:
+            return _utf16(udata,size,last,output);
+        default:
+            return _utf8(udata,size,last,output);
+    }
+}
+
+size_t libhtmlpp::HtmlCharsetDecoder::_utf8(const unsigned char *data,size_t size,bool last,
+                                            HtmlString &output){
+    size_t pos=0;
+    while(pos<size){
+        //valid runs are copied in one piece
+        size_t run=HtmlCharset::validUtf8((const char*)data+pos,size-pos);
+        output.append((const char*)data+pos,run);
+        pos+=run;
+        if(pos>=size)
+            break;
+        size_t valid;
+        _sequence(data+pos,size-pos,valid);
+        if(valid==size-pos && !last)
+            break;
+        output.append(Replacement,3);
+        ++_Errors;
+        pos+=std::max<size_t>(valid,1);
+    }
+    return pos;
+}
+
+size_t libhtmlpp::HtmlCharsetDecoder::_windows1252(const unsigned char *data,size_t size,
+                                                   HtmlString &output){
+    _Output.clear();
+    size_t pos=0;
+    while(pos<size){
+        size_t end=_asciiEnd(data,size,pos);
+        _Output.insert(_Output.end(),data+pos,data+end);
+        for(pos=end; pos<size && data[pos]>=0x80; ++pos)
+            _put(data[pos]<0xA0 ? Windows1252[data[pos]-0x80] : data[pos]);
+    }
+    output.append(_Output.data(),_Output.size());
+    return size;
+}
+
+size_t libhtmlpp::HtmlCharsetDecoder::_utf16(const unsigned char *data,size_t size,bool last,
+                                             HtmlString &output){
+    _Output.clear();
+    bool be=_Encoding==HtmlCharset::Utf16BE;
+    size_t pos=0;
+    while(pos+2<=size){
+        unsigned long unit=be ? data[pos]<<8 | data[pos+1] : data[pos+1]<<8 | data[pos];
+        if(unit<0xD800 || unit>0xDFFF){
+            _put(unit);
+            pos+=2;
+            continue;
+        }
+        if(unit<=0xDBFF && pos+4>size && !last)
+            break;
+        unsigned long low=0;
+        if(unit<=0xDBFF && pos+4<=size)
+            low=be ? data[pos+2]<<8 | data[pos+3] : data[pos+3]<<8 | data[pos+2];
+        if(low>=0xDC00 && low<=0xDFFF){
+            _put(0x10000+((unit-0xD800)<<10)+(low-0xDC00));
+            pos+=4;
+        }else{
+            //a lone surrogate, the unit after it is read on its own
+            _Output.insert(_Output.end(),Replacement,Replacement+3);
+            ++_Errors;
+            pos+=2;
+        }
+    }
+    if(last && pos<size){
+        _Output.insert(_Output.end(),Replacement,Replacement+3);
+        ++_Errors;
+        pos=size;
+    }
+    output.append(_Output.data(),_Output.size());
+    return pos;
+}
+
+void libhtmlpp::HtmlCharsetDecoder::_put(unsigned long cp){
+    if(cp<0x80){
+        _Output.push_back(cp);
+    }else if(cp<0x800){
+        _Output.push_back(0xC0|(cp>>6));
+        _Output.push_back(0x80|(cp&0x3F));
+    }else if(cp<0x10000){
+        _Output.push_back(0xE0|(cp>>12));
+        _Output.push_back(0x80|((cp>>6)&0x3F));
+        _Output.push_back(0x80|(cp&0x3F));
+    }else{
+        _Output.push_back(0xF0|(cp>>18));
+        _Output.push_back(0x80|((cp>>12)&0x3F));
+        _Output.push_back(0x80|((cp>>6)&0x3F));
+        _Output.push_back(0x80|(cp&0x3F));
+    }
+}
@@ -0,0 +1,105 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <stddef.h>
+
+#include <vector>
+
+#include "html.h"
+
+#pragma once
+
+namespace libhtmlpp {
+
+    /*
+     * encodings a document can be loaded from, everything is converted to
+     * utf-8. Like in browsers iso-8859-1 and ascii are read as windows-1252.
+     */
+    class HtmlCharset {
+    public:
+        enum Encoding {Unknown=-1,Utf8=0,Windows1252,Utf16LE,Utf16BE};
+
+        //encoding of a label like "latin1" or "UTF-8", Unknown if it isn't supported
+        static int    getEncoding(const char *label,size_t len);
+        static const char *getName(int encoding);
+
+        //length of the valid utf-8 at the begin of data, complete sequences only
+        static size_t validUtf8(const char *data,size_t size);
+        static bool   isUtf8(const char *data,size_t size);
+
+        /*
+         * encoding of a document: a byte order mark wins, then <meta charset>
+         * or <meta http-equiv="content-type"> in the first 1024 bytes and
+         * utf-8 if data is valid utf-8, windows-1252 otherwise. bomlen gets
+         * the size of the byte order mark.
+         */
+        static int    detect(const char *data,size_t size,size_t *bomlen=nullptr);
+    };
+
+    /*
+     * converts a document to utf-8 in one pass, the input can be fed in
+     * blocks. Without setEncoding() the encoding is detected from the first
+     * 1024 bytes, they are kept until then. Invalid sequences become U+FFFD,
+     * an incomplete one at the end of a block waits for the next. Valid
+     * utf-8 is copied as it is.
+     */
+    class HtmlCharsetDecoder {
+    public:
+        HtmlCharsetDecoder();
+        ~HtmlCharsetDecoder();
+
+        void   setEncoding(int encoding);
+        //the set or detected encoding, Unknown before it is known
+        int    getEncoding() const;
+
+        //appends the utf-8 of data to output
+        void   feed(const char *data,size_t size,HtmlString &output);
+        //ends the input, an incomplete sequence becomes U+FFFD
+        void   finish(HtmlString &output);
+        void   reset();
+
+        //converts a complete document
+        void   decode(const char *data,size_t size,HtmlString &output);
+
+        //replaced invalid sequences
+        size_t getErrors() const;
+    private:
+        void   _detect();
+        //returns the bytes used, the rest is an incomplete sequence
+        size_t _decode(const char *data,size_t size,bool last,HtmlString &output);
+        size_t _utf8(const unsigned char *data,size_t size,bool last,HtmlString &output);
+        size_t _windows1252(const unsigned char *data,size_t size,HtmlString &output);
+        size_t _utf16(const unsigned char *data,size_t size,bool last,HtmlString &output);
+        void   _put(unsigned long cp);
+
+        int               _Encoding;
+        bool              _Detect;
+        std::vector<char> _Pending;
+        std::vector<char> _Output;
+        size_t            _Errors;
+    };
+};
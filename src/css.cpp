@@ -1 +1,1148 @@
- 
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <string.h>
+
+#include <fstream>
+
+#include "config.h"
+#include "exception.h"
+#include "css.h"
+
+namespace libhtmlpp {
+    static inline bool _cssSpace(char c){
+        return c==' ' || c=='\t' || c=='\n' || c=='\r' || c=='\f';
+    }
+
+    static inline bool _cssNameStart(char c){
+        return (c>='a' && c<='z') || (c>='A' && c<='Z') || c=='_' || (unsigned char)c>=0x80;
+    }
+
+    static inline bool _cssNameChar(char c){
+        return _cssNameStart(c) || (c>='0' && c<='9') || c=='-';
+    }
+
+    static bool _cssEqual(const char *name,size_t nlen,const char *cmp){
+        size_t i=0;
+        for(; i<nlen; ++i){
+            if(!cmp[i] || (name[i]|0x20)!=cmp[i])
+                return false;
+        }
+        return cmp[i]=='\0';
+    }
+
+    //at-rules with declarations instead of rules in their block
+    static const char *DeclarationAtRules[]={
+        "font-face","page","counter-style","property","font-palette-values",
+        "viewport","-ms-viewport",nullptr
+    };
+};
+
+libhtmlpp::CssTokenizer::CssTokenizer(const char *data,size_t size,bool last){
+    _Data=data;
+    _Size=size;
+    _Pos=0;
+    _Last=last;
+}
+
+size_t libhtmlpp::CssTokenizer::getPosition() const{
+    return _Pos;
+}
+
+void libhtmlpp::CssTokenizer::setPosition(size_t pos){
+    _Pos=pos;
+}
+
+bool libhtmlpp::CssTokenizer::_name(size_t pos) const{
+    return pos<_Size && (_cssNameChar(_Data[pos]) || _escape(pos));
+}
+
+bool libhtmlpp::CssTokenizer::_escape(size_t pos) const{
+    return pos+1<_Size && _Data[pos]=='\\' && _Data[pos+1]!='\n';
+}
+
+bool libhtmlpp::CssTokenizer::_identStart(size_t pos) const{
+    if(pos>=_Size)
+        return false;
+    if(_Data[pos]=='-'){
+        return pos+1<_Size && (_cssNameStart(_Data[pos+1]) || _Data[pos+1]=='-' || _escape(pos+1));
+    }
+    return _cssNameStart(_Data[pos]) || _escape(pos);
+}
+
+bool libhtmlpp::CssTokenizer::_numberStart(size_t pos) const{
+    if(pos>=_Size)
+        return false;
+    char c=_Data[pos];
+    if(c=='+' || c=='-'){
+        ++pos;
+        if(pos>=_Size)
+            return false;
+        c=_Data[pos];
+    }
+    if(c>='0' && c<='9')
+        return true;
+    return c=='.' && pos+1<_Size && _Data[pos+1]>='0' && _Data[pos+1]<='9';
+}
+
+size_t libhtmlpp::CssTokenizer::_consumeName(size_t pos) const{
+    while(pos<_Size){
+        if(_cssNameChar(_Data[pos]))
+            ++pos;
+        else if(_escape(pos))
+            pos+=2;
+        else
+            break;
+    }
+    return pos;
+}
+
+bool libhtmlpp::CssTokenizer::next(Token &token){
+    token.Data=_Data+_Pos;
+    token.Size=0;
+
+    if(_Pos>=_Size){
+        token.Type=_Last ? End : Incomplete;
+        return false;
+    }
+
+    size_t start=_Pos,end=start+1;
+    int type=Delim;
+    char c=_Data[start];
+
+    auto digits=[this](size_t pos){
+        while(pos<_Size && _Data[pos]>='0' && _Data[pos]<='9')
+            ++pos;
+        return pos;
+    };
+
+    auto numeric=[&](){
+        end=start;
+        if(_Data[end]=='+' || _Data[end]=='-')
+            ++end;
+        end=digits(end);
+        if(end+1<_Size && _Data[end]=='.' && _Data[end+1]>='0' && _Data[end+1]<='9')
+            end=digits(end+1);
+        if(end<_Size && (_Data[end]=='e' || _Data[end]=='E')){
+            size_t exp=end+1;
+            if(exp<_Size && (_Data[exp]=='+' || _Data[exp]=='-'))
+                ++exp;
+            if(exp<_Size && _Data[exp]>='0' && _Data[exp]<='9')
+                end=digits(exp);
+        }
+        if(_identStart(end)){
+            end=_consumeName(end);
+            type=Dimension;
+        }else if(end<_Size && _Data[end]=='%'){
+            ++end;
+            type=Percentage;
+        }else{
+            type=Number;
+        }
+    };
+
+    auto identlike=[&](){
+        end=_consumeName(start);
+        type=Ident;
+        if(end>=_Size || _Data[end]!='(')
+            return;
+        ++end;
+        type=Function;
+        if(end-start!=4 || !_cssEqual(_Data+start,3,"url"))
+            return;
+        size_t pos=end;
+        while(pos<_Size && _cssSpace(_Data[pos]))
+            ++pos;
+        if(pos>=_Size){
+            end=_Size;
+            return;
+        }
+        if(_Data[pos]=='"' || _Data[pos]=='\'')
+            return;
+        type=Url;
+        while(pos<_Size && _Data[pos]!=')'){
+            char u=_Data[pos];
+            if(_escape(pos)){
+                pos+=2;
+                continue;
+            }
+            if(u=='"' || u=='\'' || u=='(' || u=='\\' || (unsigned char)u<0x20 || u==0x7f){
+                type=BadUrl;
+            }else if(_cssSpace(u)){
+                size_t ws=pos;
+                while(ws<_Size && _cssSpace(_Data[ws]))
+                    ++ws;
+                if(ws<_Size && _Data[ws]!=')')
+                    type=BadUrl;
+                pos=ws;
+                continue;
+            }
+            ++pos;
+        }
+        end=pos<_Size ? pos+1 : _Size;
+    };
+
+    switch(c){
+        case ' ': case '\t': case '\n': case '\r': case '\f':
+            while(end<_Size && _cssSpace(_Data[end]))
+                ++end;
+            type=Whitespace;
+            break;
+        case '/':
+            if(end<_Size && _Data[end]=='*'){
+                const char *close=nullptr;
+                for(size_t pos=start+2; pos+1<_Size; ++pos){
+                    const char *star=(const char*)memchr(_Data+pos,'*',_Size-pos-1);
+                    if(!star)
+                        break;
+                    if(star[1]=='/'){
+                        close=star;
+                        break;
+                    }
+                    pos=star-_Data;
+                }
+                end=close ? (close-_Data)+2 : _Size;
+                type=Comment;
+            }
+            break;
+        case '"': case '\'':
+            type=String;
+            while(end<_Size){
+                if(_Data[end]==c){
+                    ++end;
+                    break;
+                }
+                if(_Data[end]=='\n'){
+                    type=BadString;
+                    break;
+                }
+                end+=_Data[end]=='\\' ? 2 : 1;
+            }
+            if(end>_Size)
+                end=_Size;
+            break;
+        case '#':
+            if(_name(start+1)){
+                end=_consumeName(start+1);
+                type=Hash;
+            }
+            break;
+        case '(': type=LeftParen; break;
+        case ')': type=RightParen; break;
+        case '[': type=LeftSquare; break;
+        case ']': type=RightSquare; break;
+        case '{': type=LeftCurly; break;
+        case '}': type=RightCurly; break;
+        case ',': type=Comma; break;
+        case ':': type=Colon; break;
+        case ';': type=Semicolon; break;
+        case '+': case '.':
+            if(_numberStart(start))
+                numeric();
+            break;
+        case '-':
+            if(_numberStart(start)){
+                numeric();
+            }else if(start+2<_Size && _Data[start+1]=='-' && _Data[start+2]=='>'){
+                end=start+3;
+                type=CDC;
+            }else if(_identStart(start)){
+                identlike();
+            }
+            break;
+        case '<':
+            if(start+3<_Size && memcmp(_Data+start,"<!--",4)==0){
+                end=start+4;
+                type=CDO;
+            }
+            break;
+        case '@':
+            if(_identStart(start+1)){
+                end=_consumeName(start+1);
+                type=AtKeyword;
+            }
+            break;
+        case '\\':
+            if(_escape(start))
+                identlike();
+            break;
+        default:
+            if(c>='0' && c<='9')
+                numeric();
+            else if(_cssNameStart(c))
+                identlike();
+            break;
+    }
+
+    //a token at the end of a block could go on in the next block, numbers
+    //and names look up to three code points ahead
+    if(!_Last && end+3>_Size){
+        switch(type){
+            case LeftParen: case RightParen: case LeftSquare: case RightSquare:
+            case LeftCurly: case RightCurly: case Comma: case Colon: case Semicolon:
+                break;
+            default:
+                token.Type=Incomplete;
+                return false;
+        }
+    }
+
+    token.Type=type;
+    token.Size=end-start;
+    _Pos=end;
+    return true;
+}
+
+namespace libhtmlpp {
+    /*
+     * reads tokens until {, } or at level 0 ; and returns the stop token
+     * type. begin and end span the tokens before without the surrounding
+     * whitespace and comments.
+     */
+    static int _collect(CssTokenizer &tok,bool semicolon,const char *&begin,const char *&end){
+        CssTokenizer::Token token;
+        int level=0;
+        begin=nullptr;
+        end=nullptr;
+        for(;;){
+            if(!tok.next(token))
+                return token.Type;
+            switch(token.Type){
+                case CssTokenizer::Whitespace:
+                case CssTokenizer::Comment:
+                    continue;
+                case CssTokenizer::LeftCurly:
+                case CssTokenizer::RightCurly:
+                    return token.Type;
+                case CssTokenizer::Semicolon:
+                    if(semicolon && level==0)
+                        return token.Type;
+                    break;
+                case CssTokenizer::Function:
+                case CssTokenizer::LeftParen:
+                case CssTokenizer::LeftSquare:
+                    ++level;
+                    break;
+                case CssTokenizer::RightParen:
+                case CssTokenizer::RightSquare:
+                    if(level>0)
+                        --level;
+                    break;
+            }
+            if(!begin)
+                begin=token.Data;
+            end=token.Data+token.Size;
+        }
+    }
+
+    //skips a block after its { and returns RightCurly, End or Incomplete
+    static int _skipBlock(CssTokenizer &tok){
+        CssTokenizer::Token token;
+        size_t level=1;
+        while(tok.next(token)){
+            if(token.Type==CssTokenizer::LeftCurly)
+                ++level;
+            else if(token.Type==CssTokenizer::RightCurly && --level==0)
+                return CssTokenizer::RightCurly;
+        }
+        return token.Type;
+    }
+
+    static bool _important(const char *begin,const char *&end){
+        const char important[]="important";
+        if(end-begin<10)
+            return false;
+        if(!_cssEqual(end-9,9,important))
+            return false;
+        const char *pos=end-9;
+        while(pos>begin && _cssSpace(pos[-1]))
+            --pos;
+        if(pos<=begin || pos[-1]!='!')
+            return false;
+        --pos;
+        while(pos>begin && _cssSpace(pos[-1]))
+            --pos;
+        end=pos;
+        return true;
+    }
+};
+
+libhtmlpp::CssParser::CssParser(){
+    _Depth=0;
+}
+
+libhtmlpp::CssParser::~CssParser(){
+}
+
+void libhtmlpp::CssParser::onRule(const char *selector,size_t slen,
+                                  const Declaration *decls,size_t dcount){
+}
+
+void libhtmlpp::CssParser::onAtRule(const char *name,size_t nlen,const char *prelude,size_t plen,
+                                    const Declaration *decls,size_t dcount){
+}
+
+void libhtmlpp::CssParser::onBlockStart(const char *name,size_t nlen,const char *prelude,size_t plen){
+}
+
+void libhtmlpp::CssParser::onBlockEnd(){
+}
+
+void libhtmlpp::CssParser::onEnd(){
+}
+
+void libhtmlpp::CssParser::reset(){
+    _Pending.clear();
+    _Depth=0;
+}
+
+void libhtmlpp::CssParser::feed(const char *data,size_t size){
+    if(_Pending.empty()){
+        size_t used=_scan(data,size,false);
+        _Pending.assign(data+used,data+size);
+    }else{
+        _Pending.insert(_Pending.end(),data,data+size);
+        size_t used=_scan(_Pending.data(),_Pending.size(),false);
+        _Pending.erase(_Pending.begin(),_Pending.begin()+used);
+    }
+}
+
+void libhtmlpp::CssParser::finish(){
+    std::vector<char> rest;
+    rest.swap(_Pending);
+    if(!rest.empty())
+        _scan(rest.data(),rest.size(),true);
+    while(_Depth>0){
+        --_Depth;
+        onBlockEnd();
+    }
+    onEnd();
+}
+
+void libhtmlpp::CssParser::parse(const char *data,size_t size){
+    reset();
+    _scan(data,size,true);
+    while(_Depth>0){
+        --_Depth;
+        onBlockEnd();
+    }
+    onEnd();
+}
+
+void libhtmlpp::CssParser::loadFile(const char *path){
+    char tmp[HTML_BLOCKSIZE];
+    std::ifstream fs(path,std::ios::binary);
+
+    if(!fs.is_open()){
+        HTMLException excp;
+        excp[HTMLException::Critical] << "CssParser: can't open " << path;
+        throw excp;
+    }
+
+    reset();
+    while (fs.good()) {
+        fs.read(tmp,HTML_BLOCKSIZE);
+        feed(tmp,fs.gcount());
+    }
+    finish();
+}
+
+size_t libhtmlpp::CssParser::_scan(const char *data,size_t size,bool last){
+    CssTokenizer tok(data,size,last);
+    CssTokenizer::Token token;
+
+    for(;;){
+        size_t start=tok.getPosition();
+        if(!tok.next(token))
+            return token.Type==CssTokenizer::Incomplete ? start : size;
+
+        switch(token.Type){
+            case CssTokenizer::Whitespace:
+            case CssTokenizer::Comment:
+            case CssTokenizer::CDO:
+            case CssTokenizer::CDC:
+            case CssTokenizer::Semicolon:
+                break;
+            case CssTokenizer::RightCurly:
+                if(_Depth>0){
+                    --_Depth;
+                    onBlockEnd();
+                }
+                break;
+            case CssTokenizer::AtKeyword:{
+                const char *name=token.Data+1,*begin,*end;
+                size_t nlen=token.Size-1;
+                int stop=_collect(tok,true,begin,end);
+                if(stop==CssTokenizer::Incomplete)
+                    return start;
+                size_t plen=begin ? end-begin : 0;
+                if(!begin)
+                    begin=name+nlen;
+
+                if(stop==CssTokenizer::LeftCurly){
+                    bool decls=false;
+                    for(size_t i=0; DeclarationAtRules[i] && !decls; ++i)
+                        decls=_cssEqual(name,nlen,DeclarationAtRules[i]);
+                    if(decls){
+                        if(!_declarations(tok))
+                            return start;
+                        onAtRule(name,nlen,begin,plen,_Decls.data(),_Decls.size());
+                    }else{
+                        ++_Depth;
+                        onBlockStart(name,nlen,begin,plen);
+                    }
+                }else{
+                    onAtRule(name,nlen,begin,plen,nullptr,0);
+                    if(stop==CssTokenizer::RightCurly && _Depth>0){
+                        --_Depth;
+                        onBlockEnd();
+                    }
+                }
+            }break;
+            default:{
+                const char *begin,*end;
+                tok.setPosition(start);
+                int stop=_collect(tok,false,begin,end);
+                if(stop==CssTokenizer::Incomplete)
+                    return start;
+                if(stop==CssTokenizer::LeftCurly){
+                    if(!_declarations(tok))
+                        return start;
+                    if(begin)
+                        onRule(begin,end-begin,_Decls.data(),_Decls.size());
+                }else if(stop==CssTokenizer::RightCurly && _Depth>0){
+                    //a selector without block is dropped
+                    --_Depth;
+                    onBlockEnd();
+                }
+            }break;
+        }
+    }
+}
+
+bool libhtmlpp::CssParser::_declarations(CssTokenizer &tok){
+    CssTokenizer::Token token;
+    const char *begin,*end;
+
+    _Decls.clear();
+    for(;;){
+        if(!tok.next(token))
+            return token.Type!=CssTokenizer::Incomplete;
+
+        switch(token.Type){
+            case CssTokenizer::Whitespace:
+            case CssTokenizer::Comment:
+            case CssTokenizer::Semicolon:
+                continue;
+            case CssTokenizer::RightCurly:
+                return true;
+            case CssTokenizer::LeftCurly:{
+                int stop=_skipBlock(tok);
+                if(stop==CssTokenizer::Incomplete)
+                    return false;
+                if(stop==CssTokenizer::End)
+                    return true;
+            }continue;
+            case CssTokenizer::Ident:{
+                CssTokenizer::Token prop=token;
+                size_t pos;
+                do{
+                    pos=tok.getPosition();
+                    if(!tok.next(token))
+                        return token.Type!=CssTokenizer::Incomplete;
+                }while(token.Type==CssTokenizer::Whitespace || token.Type==CssTokenizer::Comment);
+
+                if(token.Type==CssTokenizer::RightCurly)
+                    return true;
+                if(token.Type==CssTokenizer::Semicolon)
+                    continue;
+                if(token.Type!=CssTokenizer::Colon){
+                    tok.setPosition(pos);
+                    break;
+                }
+
+                int stop=_collect(tok,true,begin,end);
+                if(stop==CssTokenizer::Incomplete)
+                    return false;
+                if(stop==CssTokenizer::LeftCurly){
+                    //nested rule like a:hover{...}
+                    stop=_skipBlock(tok);
+                    if(stop==CssTokenizer::Incomplete)
+                        return false;
+                    if(stop==CssTokenizer::End)
+                        return true;
+                    continue;
+                }
+
+                Declaration decl;
+                decl.Property=prop.Data;
+                decl.PropertySize=prop.Size;
+                if(!begin)
+                    begin=end=token.Data+token.Size;
+                decl.Important=_important(begin,end);
+                decl.Value=begin;
+                decl.ValueSize=end-begin;
+                _Decls.push_back(decl);
+
+                if(stop!=CssTokenizer::Semicolon)
+                    return true;
+            }continue;
+        }
+
+        //no declaration, skip it or the nested rule it starts
+        int stop=_collect(tok,true,begin,end);
+        if(stop==CssTokenizer::Incomplete)
+            return false;
+        if(stop==CssTokenizer::LeftCurly){
+            stop=_skipBlock(tok);
+            if(stop==CssTokenizer::Incomplete)
+                return false;
+            if(stop==CssTokenizer::End)
+                return true;
+        }else if(stop!=CssTokenizer::Semicolon){
+            return true;
+        }
+    }
+}
+
+libhtmlpp::CssMinifier::CssMinifier(){
+    reset();
+}
+
+libhtmlpp::CssMinifier::~CssMinifier(){
+}
+
+void libhtmlpp::CssMinifier::reset(){
+    _Pending.clear();
+    _Output.clear();
+    _Blocks.clear();
+    _Parens=0;
+    _Count=0;
+    _Grouping=false;
+    _Prev=CssTokenizer::Whitespace;
+    _PrevChar=0;
+    _Space=false;
+    _Semicolon=false;
+}
+
+void libhtmlpp::CssMinifier::feed(const char *data,size_t size){
+    if(_Pending.empty()){
+        size_t used=_scan(data,size,false);
+        _Pending.assign(data+used,data+size);
+    }else{
+        _Pending.insert(_Pending.end(),data,data+size);
+        size_t used=_scan(_Pending.data(),_Pending.size(),false);
+        _Pending.erase(_Pending.begin(),_Pending.begin()+used);
+    }
+}
+
+void libhtmlpp::CssMinifier::finish(){
+    std::vector<char> rest;
+    rest.swap(_Pending);
+    if(!rest.empty())
+        _scan(rest.data(),rest.size(),true);
+    //keep the last semicolon, the output may get concatenated
+    if(_Semicolon)
+        _Output.push_back(';');
+    _Blocks.clear();
+    _Parens=0;
+    _Count=0;
+    _Grouping=false;
+    _Space=false;
+    _Semicolon=false;
+}
+
+void libhtmlpp::CssMinifier::minify(const char *data,size_t size){
+    reset();
+    _scan(data,size,true);
+    finish();
+}
+
+const char *libhtmlpp::CssMinifier::data() const{
+    return _Output.data();
+}
+
+size_t libhtmlpp::CssMinifier::size() const{
+    return _Output.size();
+}
+
+void libhtmlpp::CssMinifier::clear(){
+    _Output.clear();
+}
+
+size_t libhtmlpp::CssMinifier::_scan(const char *data,size_t size,bool last){
+    CssTokenizer tok(data,size,last);
+    CssTokenizer::Token token;
+
+    for(;;){
+        size_t start=tok.getPosition();
+        if(!tok.next(token))
+            return token.Type==CssTokenizer::Incomplete ? start : size;
+        _token(token);
+    }
+}
+
+void libhtmlpp::CssMinifier::_token(const CssTokenizer::Token &token){
+    switch(token.Type){
+        case CssTokenizer::Whitespace:
+        case CssTokenizer::CDO:
+        case CssTokenizer::CDC:
+            _Space=true;
+            return;
+        case CssTokenizer::Comment:
+            //a dropped comment still separates the tokens around it
+            if(token.Size<3 || token.Data[2]!='!'){
+                _Space=true;
+                return;
+            }
+            break;
+        case CssTokenizer::Semicolon:
+            if(_Parens==0){
+                if(_Prev!=CssTokenizer::LeftCurly && _Prev!=CssTokenizer::Whitespace)
+                    _Semicolon=true;
+                _Space=false;
+                _Count=0;
+                _Grouping=false;
+                return;
+            }
+            break;
+        default:
+            break;
+    }
+    _flush(token);
+}
+
+void libhtmlpp::CssMinifier::_flush(const CssTokenizer::Token &token){
+    if(_Semicolon){
+        _Semicolon=false;
+        if(token.Type!=CssTokenizer::RightCurly){
+            _Output.push_back(';');
+            _Prev=CssTokenizer::Semicolon;
+        }
+    }
+
+    if(_Space){
+        _Space=false;
+        bool decls=_Parens==0 && !_Blocks.empty() && _Blocks.back();
+        bool space=true;
+
+        switch(_Prev){
+            case CssTokenizer::Whitespace:
+            case CssTokenizer::LeftCurly:
+            case CssTokenizer::RightCurly:
+            case CssTokenizer::Semicolon:
+            case CssTokenizer::Comma:
+            case CssTokenizer::LeftParen:
+            case CssTokenizer::Function:
+            case CssTokenizer::Comment:
+                space=false;
+                break;
+            case CssTokenizer::Colon:
+                space=!decls && _Parens==0;
+                break;
+            case CssTokenizer::Delim:
+                if(_PrevChar=='!' || _PrevChar=='/')
+                    space=false;
+                else if(_Parens==0 && (_PrevChar=='>' || _PrevChar=='~' || _PrevChar=='+'))
+                    space=false;
+                break;
+            default:
+                break;
+        }
+
+        switch(token.Type){
+            case CssTokenizer::LeftCurly:
+            case CssTokenizer::RightCurly:
+            case CssTokenizer::Semicolon:
+            case CssTokenizer::Comma:
+            case CssTokenizer::RightParen:
+            case CssTokenizer::Comment:
+                space=false;
+                break;
+            case CssTokenizer::Colon:
+                //only after a property or a media feature, "a :hover" is a selector
+                if(_Prev==CssTokenizer::Ident && ((decls && _Count==1) || (_Grouping && _Parens>0)))
+                    space=false;
+                break;
+            case CssTokenizer::Delim:{
+                char c=token.Data[0];
+                if(c=='!' || c=='/')
+                    space=false;
+                else if(_Parens==0 && (c=='>' || c=='~' || c=='+'))
+                    space=false;
+            }break;
+            default:
+                break;
+        }
+
+        if(space)
+            _Output.push_back(' ');
+    }
+
+    const char *data=token.Data;
+    size_t size=token.Size;
+
+    if(token.Type==CssTokenizer::Number || token.Type==CssTokenizer::Percentage ||
+        token.Type==CssTokenizer::Dimension){
+        size_t sign=(data[0]=='-' || data[0]=='+') ? 1 : 0;
+        if(size>sign+2 && data[sign]=='0' && data[sign+1]=='.' &&
+            data[sign+2]>='0' && data[sign+2]<='9'){
+            if(sign)
+                _Output.push_back(data[0]);
+            data+=sign+1;
+            size-=sign+1;
+        }
+    }
+    _Output.insert(_Output.end(),data,data+size);
+
+    switch(token.Type){
+        case CssTokenizer::Function:
+        case CssTokenizer::LeftParen:
+            ++_Parens;
+            break;
+        case CssTokenizer::RightParen:
+            if(_Parens>0)
+                --_Parens;
+            break;
+        case CssTokenizer::AtKeyword:
+            if(_Count==0){
+                _Grouping=true;
+                for(size_t i=0; DeclarationAtRules[i] && _Grouping; ++i)
+                    _Grouping=!_cssEqual(token.Data+1,token.Size-1,DeclarationAtRules[i]);
+            }
+            break;
+        default:
+            break;
+    }
+
+    if(token.Type==CssTokenizer::LeftCurly){
+        _Blocks.push_back(!_Grouping);
+        _Parens=0;
+        _Count=0;
+        _Grouping=false;
+    }else if(token.Type==CssTokenizer::RightCurly){
+        if(!_Blocks.empty())
+            _Blocks.pop_back();
+        _Parens=0;
+        _Count=0;
+        _Grouping=false;
+    }else{
+        ++_Count;
+    }
+
+    _Prev=token.Type;
+    _PrevChar=token.Type==CssTokenizer::Delim ? token.Data[0] : 0;
+}
+
+namespace libhtmlpp {
+    class CssBuilder : public CssParser {
+    public:
+        CssBuilder(CssStylesheet *sheet){
+            _Sheet=sheet;
+        }
+    protected:
+        void onRule(const char *selector,size_t slen,const Declaration *decls,size_t dcount) override{
+            CssStylesheet::Rule rule=_rule(CssStylesheet::StyleRule,nullptr,0,selector,slen,decls,dcount);
+
+            //split the selector list at commas outside of brackets and strings
+            size_t start=0,level=0;
+            for(size_t i=0; i<=slen; ++i){
+                if(i<slen){
+                    char c=selector[i];
+                    if(c=='(' || c=='[')
+                        ++level;
+                    else if((c==')' || c==']') && level>0)
+                        --level;
+                    else if(c=='"' || c=='\''){
+                        const char *quote=(const char*)memchr(selector+i+1,c,slen-i-1);
+                        i=quote ? quote-selector : slen-1;
+                    }
+                    if(c!=',' || level>0)
+                        continue;
+                }
+                size_t sb=start,se=i;
+                while(sb<se && _cssSpace(selector[sb]))
+                    ++sb;
+                while(se>sb && _cssSpace(selector[se-1]))
+                    --se;
+                if(se>sb){
+                    CssStylesheet::Selector sel;
+                    sel.Text=_span(selector+sb,se-sb);
+                    sel.Specificity=CssStylesheet::getSpecificity(selector+sb,se-sb);
+                    _Sheet->_Selectors.push_back(sel);
+                    ++rule.SelectorCount;
+                }
+                start=i+1;
+            }
+            _Sheet->_Rules.push_back(rule);
+        }
+
+        void onAtRule(const char *name,size_t nlen,const char *prelude,size_t plen,
+                      const Declaration *decls,size_t dcount) override{
+            _Sheet->_Rules.push_back(_rule(CssStylesheet::AtRule,name,nlen,prelude,plen,decls,dcount));
+        }
+
+        void onBlockStart(const char *name,size_t nlen,const char *prelude,size_t plen) override{
+            _Sheet->_Rules.push_back(_rule(CssStylesheet::BlockRule,name,nlen,prelude,plen,nullptr,0));
+            _Parents.push_back(_Sheet->_Rules.size()-1);
+        }
+
+        void onBlockEnd() override{
+            if(!_Parents.empty())
+                _Parents.pop_back();
+        }
+    private:
+        CssStylesheet::Span _span(const char *data,size_t size){
+            CssStylesheet::Span span;
+            span.Offset=data ? data-_Sheet->_Source.data() : 0;
+            span.Size=size;
+            return span;
+        }
+
+        CssStylesheet::Rule _rule(int type,const char *name,size_t nlen,const char *prelude,size_t plen,
+                                  const Declaration *decls,size_t dcount){
+            CssStylesheet::Rule rule;
+            rule.Type=type;
+            rule.Parent=_Parents.empty() ? CssStylesheet::NoRule : _Parents.back();
+            rule.Name=_span(name,nlen);
+            rule.Prelude=_span(prelude,plen);
+            rule.FirstSelector=_Sheet->_Selectors.size();
+            rule.SelectorCount=0;
+            rule.FirstDeclaration=_Sheet->_Declarations.size();
+            rule.DeclarationCount=dcount;
+            for(size_t i=0; i<dcount; ++i){
+                CssStylesheet::Declaration decl;
+                decl.Property=_span(decls[i].Property,decls[i].PropertySize);
+                decl.Value=_span(decls[i].Value,decls[i].ValueSize);
+                decl.Important=decls[i].Important;
+                _Sheet->_Declarations.push_back(decl);
+            }
+            return rule;
+        }
+
+        CssStylesheet          *_Sheet;
+        std::vector<uint32_t>   _Parents;
+    };
+
+    static size_t _skipCssName(const char *sel,size_t len,size_t pos){
+        while(pos<len){
+            if(_cssNameChar(sel[pos]))
+                ++pos;
+            else if(sel[pos]=='\\' && pos+1<len)
+                pos+=2;
+            else
+                break;
+        }
+        return pos;
+    }
+
+    //position after the bracket that closes the one at pos
+    static size_t _skipCssBrackets(const char *sel,size_t len,size_t pos){
+        size_t level=0;
+        while(pos<len){
+            char c=sel[pos];
+            if(c=='(' || c=='['){
+                ++level;
+            }else if(c==')' || c==']'){
+                if(--level==0)
+                    return pos+1;
+            }else if(c=='"' || c=='\''){
+                const char *quote=(const char*)memchr(sel+pos+1,c,len-pos-1);
+                pos=quote ? quote-sel : len;
+            }
+            ++pos;
+        }
+        return len;
+    }
+
+    static uint32_t _selectorListSpecificity(const char *sel,size_t len);
+
+    static uint32_t _selectorSpecificity(const char *sel,size_t len){
+        uint32_t a=0,b=0,c=0;
+        size_t pos=0;
+
+        while(pos<len){
+            char ch=sel[pos];
+            if(ch=='#'){
+                pos=_skipCssName(sel,len,pos+1);
+                ++a;
+            }else if(ch=='.'){
+                pos=_skipCssName(sel,len,pos+1);
+                ++b;
+            }else if(ch=='['){
+                pos=_skipCssBrackets(sel,len,pos);
+                ++b;
+            }else if(ch==':'){
+                if(pos+1<len && sel[pos+1]==':'){
+                    pos=_skipCssName(sel,len,pos+2);
+                    if(pos<len && sel[pos]=='(')
+                        pos=_skipCssBrackets(sel,len,pos);
+                    ++c;
+                    continue;
+                }
+                size_t nstart=pos+1;
+                pos=_skipCssName(sel,len,nstart);
+                const char *name=sel+nstart;
+                size_t nlen=pos-nstart;
+                if(_cssEqual(name,nlen,"before") || _cssEqual(name,nlen,"after")
+                    || _cssEqual(name,nlen,"first-line") || _cssEqual(name,nlen,"first-letter")){
+                    ++c;
+                }else if(pos<len && sel[pos]=='('){
+                    size_t args=pos+1;
+                    pos=_skipCssBrackets(sel,len,pos);
+                    size_t alen=pos>args ? pos-args-1 : 0;
+                    if(_cssEqual(name,nlen,"not") || _cssEqual(name,nlen,"is") || _cssEqual(name,nlen,"has")
+                        || _cssEqual(name,nlen,"matches") || _cssEqual(name,nlen,"-webkit-any")
+                        || _cssEqual(name,nlen,"-moz-any")){
+                        uint32_t inner=_selectorListSpecificity(sel+args,alen);
+                        a+=inner>>20;
+                        b+=(inner>>10)&0x3ff;
+                        c+=inner&0x3ff;
+                    }else if(!_cssEqual(name,nlen,"where")){
+                        ++b;
+                    }
+                }else{
+                    ++b;
+                }
+            }else if(ch=='"' || ch=='\''){
+                const char *quote=(const char*)memchr(sel+pos+1,ch,len-pos-1);
+                pos=quote ? (quote-sel)+1 : len;
+            }else if(_cssNameStart(ch) || ch=='\\'){
+                pos=_skipCssName(sel,len,pos);
+                //namespace prefix like svg|rect counts once
+                if(pos<len && sel[pos]=='|' && (pos+1>=len || sel[pos+1]!='='))
+                    continue;
+                ++c;
+            }else{
+                ++pos;
+            }
+        }
+
+        return (a>1023 ? 1023 : a)<<20 | (b>1023 ? 1023 : b)<<10 | (c>1023 ? 1023 : c);
+    }
+
+    //the highest specificity of a comma separated list
+    static uint32_t _selectorListSpecificity(const char *sel,size_t len){
+        uint32_t max=0;
+        size_t start=0,pos=0;
+        while(pos<=len){
+            if(pos<len && (sel[pos]=='(' || sel[pos]=='[')){
+                pos=_skipCssBrackets(sel,len,pos);
+                continue;
+            }
+            if(pos==len || sel[pos]==','){
+                uint32_t spec=_selectorSpecificity(sel+start,pos-start);
+                if(spec>max)
+                    max=spec;
+                start=pos+1;
+            }
+            ++pos;
+        }
+        return max;
+    }
+};
+
+libhtmlpp::CssStylesheet::CssStylesheet(){
+}
+
+libhtmlpp::CssStylesheet::~CssStylesheet(){
+}
+
+void libhtmlpp::CssStylesheet::clear(){
+    _Source.clear();
+    _Rules.clear();
+    _Selectors.clear();
+    _Declarations.clear();
+}
+
+void libhtmlpp::CssStylesheet::parse(const char *data,size_t size){
+    if(size>0xfffffff0){
+        HTMLException excp;
+        excp[HTMLException::Error] << "CssStylesheet: stylesheet is bigger than 4GB!";
+        throw excp;
+    }
+    clear();
+    _Source.assign(data,data+size);
+    CssBuilder builder(this);
+    builder.parse(_Source.data(),_Source.size());
+}
+
+void libhtmlpp::CssStylesheet::parse(const char *data){
+    parse(data,strlen(data));
+}
+
+void libhtmlpp::CssStylesheet::loadFile(const char *path){
+    std::ifstream fs(path,std::ios::binary);
+
+    if(!fs.is_open()){
+        HTMLException excp;
+        excp[HTMLException::Critical] << "CssStylesheet: can't open " << path;
+        throw excp;
+    }
+
+    std::vector<char> data;
+    char tmp[HTML_BLOCKSIZE];
+    while (fs.good()) {
+        fs.read(tmp,HTML_BLOCKSIZE);
+        data.insert(data.end(),tmp,tmp+fs.gcount());
+    }
+    parse(data.data(),data.size());
+}
+
+const char *libhtmlpp::CssStylesheet::data() const{
+    return _Source.data();
+}
+
+size_t libhtmlpp::CssStylesheet::size() const{
+    return _Source.size();
+}
+
+std::string libhtmlpp::CssStylesheet::getText(const Span &span) const{
+    if((size_t)span.Offset+span.Size>_Source.size())
+        return std::string();
+    return std::string(_Source.data()+span.Offset,span.Size);
+}
+
+size_t libhtmlpp::CssStylesheet::getRuleCount() const{
+    return _Rules.size();
+}
+
+const libhtmlpp::CssStylesheet::Rule *libhtmlpp::CssStylesheet::getRules() const{
+    return _Rules.data();
+}
+
+const libhtmlpp::CssStylesheet::Selector *libhtmlpp::CssStylesheet::getSelectors() const{
+    return _Selectors.data();
+}
+
+const libhtmlpp::CssStylesheet::Declaration *libhtmlpp::CssStylesheet::getDeclarations() const{
+    return _Declarations.data();
+}
+
+uint32_t libhtmlpp::CssStylesheet::getSpecificity(const char *selector,size_t len){
+    return _selectorSpecificity(selector,len);
+}
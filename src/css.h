@@ -1 +1,232 @@
- 
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#pragma once
+
+namespace libhtmlpp {
+
+    /*
+     * tokenizer after css syntax level 3. Tokens point into the buffer, a
+     * token that touches the end of a buffer that isn't the last block is
+     * returned as Incomplete, so the caller can wait for more data.
+     */
+    class CssTokenizer {
+    public:
+        enum TokenType {
+            Ident=0,Function,AtKeyword,Hash,String,BadString,Url,BadUrl,Delim,
+            Number,Percentage,Dimension,Whitespace,CDO,CDC,Colon,Semicolon,Comma,
+            LeftSquare,RightSquare,LeftParen,RightParen,LeftCurly,RightCurly,
+            Comment,Incomplete,End
+        };
+
+        struct Token {
+            int         Type;
+            const char *Data;
+            size_t      Size;
+        };
+
+        CssTokenizer(const char *data,size_t size,bool last=true);
+
+        //returns false for End and Incomplete
+        bool   next(Token &token);
+
+        size_t getPosition() const;
+        void   setPosition(size_t pos);
+    private:
+        bool   _name(size_t pos) const;
+        bool   _escape(size_t pos) const;
+        bool   _identStart(size_t pos) const;
+        bool   _numberStart(size_t pos) const;
+        size_t _consumeName(size_t pos) const;
+
+        const char *_Data;
+        size_t      _Size;
+        size_t      _Pos;
+        bool        _Last;
+    };
+
+    /*
+     * streaming css parser, the input can be fed in blocks and only an
+     * unfinished rule is kept between two feed() calls. Grouping at-rules
+     * like @media are reported with onBlockStart()/onBlockEnd() around
+     * their rules, so a whole framework inside @media isn't buffered.
+     * All pointers are only valid during the callback.
+     */
+    class CssParser {
+    public:
+        struct Declaration {
+            const char *Property;
+            size_t      PropertySize;
+            //value without !important and surrounding whitespace
+            const char *Value;
+            size_t      ValueSize;
+            bool        Important;
+        };
+
+        CssParser();
+        virtual ~CssParser();
+
+        void feed(const char *data,size_t size);
+        void finish();
+        void reset();
+
+        //parses a complete stylesheet, pointers point into data
+        void parse(const char *data,size_t size);
+        void loadFile(const char *path);
+    protected:
+        virtual void onRule(const char *selector,size_t slen,
+                            const Declaration *decls,size_t dcount);
+        //statements like @import and at-rules with declarations like @font-face
+        virtual void onAtRule(const char *name,size_t nlen,const char *prelude,size_t plen,
+                              const Declaration *decls,size_t dcount);
+        virtual void onBlockStart(const char *name,size_t nlen,const char *prelude,size_t plen);
+        virtual void onBlockEnd();
+        virtual void onEnd();
+    private:
+        size_t _scan(const char *data,size_t size,bool last);
+        bool   _declarations(CssTokenizer &tok);
+
+        std::vector<char>        _Pending;
+        std::vector<Declaration> _Decls;
+        size_t                   _Depth;
+    };
+
+    /*
+     * streaming css minifier. Comments not starting with !, whitespace
+     * that doesn't separate tokens, the last semicolon of a block and leading
+     * zeros like 0.5 get dropped in one pass over the tokens. Strings, urls
+     * and the operators in calc() are kept as they are. The output can be
+     * taken and cleared between two feed() calls.
+     */
+    class CssMinifier {
+    public:
+        CssMinifier();
+        ~CssMinifier();
+
+        void        feed(const char *data,size_t size);
+        void        finish();
+        //forgets the state and the output
+        void        reset();
+
+        //minifies a complete stylesheet
+        void        minify(const char *data,size_t size);
+
+        const char *data() const;
+        size_t      size() const;
+        void        clear();
+    private:
+        size_t _scan(const char *data,size_t size,bool last);
+        void   _token(const CssTokenizer::Token &token);
+        void   _flush(const CssTokenizer::Token &token);
+
+        std::vector<char> _Pending;
+        std::vector<char> _Output;
+        //one entry per open block, true if it holds declarations
+        std::vector<bool> _Blocks;
+        size_t            _Parens;
+        //tokens of the current statement and if it is an at-rule with rules
+        size_t            _Count;
+        bool              _Grouping;
+        //last written token, Whitespace at the begin of the output
+        int               _Prev;
+        char              _PrevChar;
+        bool              _Space;
+        bool              _Semicolon;
+    };
+
+    /*
+     * parsed stylesheet with a flat rule table. Selectors and declarations
+     * are spans into the copy of the source, rules inside grouping
+     * at-rules point to them with Parent.
+     */
+    class CssStylesheet {
+    public:
+        enum RuleType {StyleRule=0,AtRule=1,BlockRule=2};
+
+        static const uint32_t NoRule=0xffffffff;
+
+        struct Span {
+            uint32_t Offset;
+            uint32_t Size;
+        };
+
+        struct Selector {
+            Span     Text;
+            //ids << 20 | classes,attributes,pseudo classes << 10 | types
+            uint32_t Specificity;
+        };
+
+        struct Declaration {
+            Span     Property;
+            Span     Value;
+            uint32_t Important;
+        };
+
+        struct Rule {
+            uint32_t Type;
+            uint32_t Parent;
+            //at-rule name without @
+            Span     Name;
+            Span     Prelude;
+            uint32_t FirstSelector;
+            uint32_t SelectorCount;
+            uint32_t FirstDeclaration;
+            uint32_t DeclarationCount;
+        };
+
+        CssStylesheet();
+        ~CssStylesheet();
+
+        void               parse(const char *data,size_t size);
+        void               parse(const char *data);
+        void               loadFile(const char *path);
+        void               clear();
+
+        const char        *data() const;
+        size_t             size() const;
+        std::string        getText(const Span &span) const;
+
+        size_t             getRuleCount() const;
+        const Rule        *getRules() const;
+        const Selector    *getSelectors() const;
+        const Declaration *getDeclarations() const;
+
+        static uint32_t    getSpecificity(const char *selector,size_t len);
+    private:
+        std::vector<char>        _Source;
+        std::vector<Rule>        _Rules;
+        std::vector<Selector>    _Selectors;
+        std::vector<Declaration> _Declarations;
+        friend class CssBuilder;
+    };
+};
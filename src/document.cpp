@@ -0,0 +1,401 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+
+#include "exception.h"
+#include "names.h"
+#include "document.h"
+
+const uint32_t libhtmlpp::HtmlDocument::NoNode;
+
+libhtmlpp::HtmlDocument::HtmlDocument(){
+    _FirstAttributes.push_back(0);
+    _RootNode=nullptr;
+}
+
+libhtmlpp::HtmlDocument::~HtmlDocument(){
+    _delete(_RootNode);
+}
+
+void libhtmlpp::HtmlDocument::clear(){
+    _delete(_RootNode);
+    _RootNode=nullptr;
+    _Types.clear();
+    _Tags.clear();
+    _Parents.clear();
+    _NextSiblings.clear();
+    _SubtreeEnds.clear();
+    _Data.clear();
+    _FirstAttributes.assign(1,0);
+    _Attributes.clear();
+    _AttributeKeys.clear();
+    _Pool.clear();
+}
+
+uint32_t libhtmlpp::HtmlDocument::_addString(const char *src,size_t size){
+    if(_Pool.size()+size>0xffffffff){
+        HTMLException excp;
+        throw excp[HTMLException::Error] << "HtmlDocument: document too large!";
+    }
+    uint32_t pos=_Pool.size();
+    _Pool.insert(_Pool.end(),src,src+size);
+    return pos;
+}
+
+void libhtmlpp::HtmlDocument::create(const Element *el){
+    //open elements with children and the sibling to go on with after them
+    std::vector<uint32_t>       open;
+    std::vector<const Element*> resume;
+    std::unordered_map<std::string,uint32_t> names;
+
+    //tag names and attribute keys repeat a lot, store them only once
+    auto addName = [this,&names](const char *src,size_t size){
+        Span span;
+        span.Size=size;
+        std::string name(src,size);
+        auto it=names.find(name);
+        if(it!=names.end()){
+            span.Offset=it->second;
+            return span;
+        }
+        span.Offset=_addString(src,size);
+        names[name]=span.Offset;
+        return span;
+    };
+
+    //el may be part of the tree of the last build(), it goes after the copy
+    Element *built=_RootNode;
+    _RootNode=nullptr;
+    clear();
+    _RootNode=built;
+
+    uint32_t prev=NoNode;
+    while(el){
+        if(_Types.size()>=NoNode){
+            HTMLException excp;
+            throw excp[HTMLException::Error] << "HtmlDocument: document too large!";
+        }
+        uint32_t idx=_Types.size();
+        Span data;
+        int tag=-1;
+
+        switch(el->_Type){
+            case HtmlEl:{
+                const HtmlElement *hel=(const HtmlElement*)el;
+                data=addName(hel->_TagName.data(),hel->_TagName.size());
+                tag=HtmlNames::getTag(hel->_TagName.data(),hel->_TagName.size());
+                for(HtmlElement::Attributes *curattr=hel->_firstAttr; curattr; curattr=curattr->_nextAttr){
+                    Attribute attr;
+                    attr.Key=addName(curattr->_Key.data(),curattr->_Key.size());
+                    attr.Value.Offset=_addString(curattr->_Value.data(),curattr->_Value.size());
+                    attr.Value.Size=curattr->_Value.size();
+                    _Attributes.push_back(attr);
+                    _AttributeKeys.push_back(HtmlNames::getAttribute(curattr->_Key.data(),curattr->_Key.size()));
+                }
+            }break;
+            case TextEl:
+                data.Offset=_addString(((const TextElement*)el)->_Text.data(),((const TextElement*)el)->_Text.size());
+                data.Size=((const TextElement*)el)->_Text.size();
+                break;
+            case CommentEl:
+                data.Offset=_addString(((const CommentElement*)el)->_Comment.data(),((const CommentElement*)el)->_Comment.size());
+                data.Size=((const CommentElement*)el)->_Comment.size();
+                break;
+            default:
+                HTMLException excp;
+                excp[HTMLException::Error] << "Unkown Elementtype";
+                throw excp;
+        }
+
+        _Types.push_back(el->_Type);
+        _Tags.push_back(tag);
+        _Parents.push_back(open.empty() ? NoNode : open.back());
+        _NextSiblings.push_back(NoNode);
+        _SubtreeEnds.push_back(idx+1);
+        _Data.push_back(data);
+        _FirstAttributes.push_back(_Attributes.size());
+
+        if(prev!=NoNode)
+            _NextSiblings[prev]=idx;
+
+        if(el->_Type==HtmlEl && ((const HtmlElement*)el)->_children()){
+            open.push_back(idx);
+            resume.push_back(el->_nextElement);
+            el=((const HtmlElement*)el)->_children();
+            prev=NoNode;
+            continue;
+        }
+
+        prev=idx;
+        el=el->_nextElement;
+        while(!el && !open.empty()){
+            prev=open.back();
+            _SubtreeEnds[prev]=_Types.size();
+            el=resume.back();
+            open.pop_back();
+            resume.pop_back();
+        }
+    }
+
+    _delete(_RootNode);
+    _RootNode=nullptr;
+}
+
+libhtmlpp::Element *libhtmlpp::HtmlDocument::build(){
+    struct Open {
+        uint32_t     End;
+        HtmlElement *Node;
+        Element     *LastChild;
+    };
+
+    std::vector<Open> open;
+    Element *first=nullptr,*top=nullptr;
+
+    _delete(_RootNode);
+    _RootNode=nullptr;
+
+    try{
+        for(uint32_t i=0; i<_Types.size(); ++i){
+            while(!open.empty() && open.back().End<=i)
+                open.pop_back();
+
+            const char *data=_Pool.data()+_Data[i].Offset;
+            Element *el;
+            switch(_Types[i]){
+                case HtmlEl:{
+                    HtmlElement *hel=new HtmlElement();
+                    hel->_TagName.assign(data,data+_Data[i].Size);
+                    for(uint32_t a=_FirstAttributes[i]; a<_FirstAttributes[i+1]; ++a){
+                        const Attribute &attr=_Attributes[a];
+                        hel->setAttribute(_Pool.data()+attr.Key.Offset,attr.Key.Size,
+                                          _Pool.data()+attr.Value.Offset,attr.Value.Size);
+                    }
+                    el=hel;
+                }break;
+                case TextEl:
+                    el=new TextElement();
+                    ((TextElement*)el)->_Text.assign(data,data+_Data[i].Size);
+                    break;
+                default:
+                    el=new CommentElement();
+                    ((CommentElement*)el)->_Comment.assign(data,data+_Data[i].Size);
+                    break;
+            }
+
+            if(open.empty()){
+                if(top){
+                    top->_nextElement=el;
+                    el->_prevElement=top;
+                }else{
+                    first=el;
+                }
+                top=el;
+            }else{
+                Open &parent=open.back();
+                el->_parentElement=parent.Node;
+                if(parent.LastChild){
+                    parent.LastChild->_nextElement=el;
+                    el->_prevElement=parent.LastChild;
+                }else{
+                    parent.Node->_childElement=el;
+                }
+                parent.LastChild=el;
+            }
+
+            if(_SubtreeEnds[i]>i+1)
+                open.push_back({_SubtreeEnds[i],(HtmlElement*)el,nullptr});
+        }
+    }catch(...){
+        _delete(first);
+        throw;
+    }
+    _RootNode=first;
+    return first;
+}
+
+void libhtmlpp::HtmlDocument::print(HtmlString &output) const{
+    const char *pool=_Pool.data();
+    std::vector<uint32_t> open;
+
+    for(uint32_t i=0; i<_Types.size(); ++i){
+        while(!open.empty() && _SubtreeEnds[open.back()]<=i){
+            const Span &name=_Data[open.back()];
+            output.append("</",2);
+            output.append(pool+name.Offset,name.Size);
+            output.push_back('>');
+            open.pop_back();
+        }
+
+        const Span &data=_Data[i];
+        switch(_Types[i]){
+            case HtmlEl:
+                output.push_back('<');
+                output.append(pool+data.Offset,data.Size);
+                for(uint32_t a=_FirstAttributes[i]; a<_FirstAttributes[i+1]; ++a){
+                    const Attribute &attr=_Attributes[a];
+                    output.push_back(' ');
+                    output.append(pool+attr.Key.Offset,attr.Key.Size);
+                    if(attr.Value.Size){
+                        output.append("=\"",2);
+                        output.append(pool+attr.Value.Offset,attr.Value.Size);
+                        output.push_back('"');
+                    }
+                }
+                if(_SubtreeEnds[i]>i+1){
+                    output.push_back('>');
+                    open.push_back(i);
+                }else if(!HtmlNames::isVoid(pool+data.Offset,data.Size)){
+                    output.append("></",3);
+                    output.append(pool+data.Offset,data.Size);
+                    output.push_back('>');
+                }else if(_NextSiblings[i]!=NoNode){
+                    output.push_back('>');
+                }else{
+                    output.append(" />",3);
+                }
+                break;
+            case TextEl:
+                output.append(pool+data.Offset,data.Size);
+                break;
+            case CommentEl:
+                output.append("<!--",4);
+                output.append(pool+data.Offset,data.Size);
+                output.append("-->",3);
+                break;
+        }
+    }
+
+    while(!open.empty()){
+        const Span &name=_Data[open.back()];
+        output.append("</",2);
+        output.append(pool+name.Offset,name.Size);
+        output.push_back('>');
+        open.pop_back();
+    }
+}
+
+size_t libhtmlpp::HtmlDocument::getNodeCount() const{
+    return _Types.size();
+}
+
+const uint8_t *libhtmlpp::HtmlDocument::getTypes() const{
+    return _Types.data();
+}
+
+const int16_t *libhtmlpp::HtmlDocument::getTags() const{
+    return _Tags.data();
+}
+
+const uint32_t *libhtmlpp::HtmlDocument::getParents() const{
+    return _Parents.data();
+}
+
+const uint32_t *libhtmlpp::HtmlDocument::getNextSiblings() const{
+    return _NextSiblings.data();
+}
+
+const uint32_t *libhtmlpp::HtmlDocument::getSubtreeEnds() const{
+    return _SubtreeEnds.data();
+}
+
+const libhtmlpp::HtmlDocument::Span *libhtmlpp::HtmlDocument::getData() const{
+    return _Data.data();
+}
+
+const uint32_t *libhtmlpp::HtmlDocument::getFirstAttributes() const{
+    return _FirstAttributes.data();
+}
+
+const libhtmlpp::HtmlDocument::Attribute *libhtmlpp::HtmlDocument::getAttributes() const{
+    return _Attributes.data();
+}
+
+const int16_t *libhtmlpp::HtmlDocument::getAttributeKeys() const{
+    return _AttributeKeys.data();
+}
+
+const char *libhtmlpp::HtmlDocument::getPool() const{
+    return _Pool.data();
+}
+
+std::string libhtmlpp::HtmlDocument::getText(const Span &span) const{
+    return std::string(_Pool.data()+span.Offset,span.Size);
+}
+
+const libhtmlpp::HtmlDocument::Span *libhtmlpp::HtmlDocument::getAttribute(uint32_t node,const char *key) const{
+    size_t klen=strlen(key);
+    for(uint32_t a=_FirstAttributes[node]; a<_FirstAttributes[node+1]; ++a){
+        const Attribute &attr=_Attributes[a];
+        if(attr.Key.Size==klen && memcmp(_Pool.data()+attr.Key.Offset,key,klen)==0)
+            return &attr.Value;
+    }
+    return nullptr;
+}
+
+uint32_t libhtmlpp::HtmlDocument::getElementbyTag(const char *tag,uint32_t start) const{
+    size_t tlen=strlen(tag),count=_Types.size();
+    int id=HtmlNames::getTag(tag,tlen);
+
+    //known names only compare the tag column
+    if(id>=0){
+        const int16_t *tags=_Tags.data();
+        for(size_t i=start; i<count; ++i){
+            if(tags[i]==id)
+                return i;
+        }
+        return NoNode;
+    }
+
+    for(size_t i=start; i<count; ++i){
+        if(_Types[i]==HtmlEl && _Tags[i]<0 &&
+           HtmlNames::equals(_Pool.data()+_Data[i].Offset,_Data[i].Size,tag,tlen))
+            return i;
+    }
+    return NoNode;
+}
+
+uint32_t libhtmlpp::HtmlDocument::getElementbyID(const char *id,uint32_t start) const{
+    static const int key=HtmlNames::getAttribute("id");
+    size_t ilen=strlen(id);
+    if(start>=_Types.size())
+        return NoNode;
+
+    //scans the key column, the node of a match is found by bisection
+    const int16_t *keys=_AttributeKeys.data();
+    for(size_t a=_FirstAttributes[start]; a<_Attributes.size(); ++a){
+        const Span &value=_Attributes[a].Value;
+        if(keys[a]!=key || value.Size!=ilen || memcmp(_Pool.data()+value.Offset,id,ilen)!=0)
+            continue;
+        return std::upper_bound(_FirstAttributes.begin(),_FirstAttributes.end(),a)-_FirstAttributes.begin()-1;
+    }
+    return NoNode;
+}
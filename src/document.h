@@ -0,0 +1,109 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "html.h"
+
+#pragma once
+
+namespace libhtmlpp {
+
+    /*
+     * read optimized copy of a tree. The nodes are in document order and
+     * every property is its own column, so a search only touches the
+     * columns it needs and a traversal is a linear scan. The subtree of
+     * node i are the nodes from i+1 to SubtreeEnd[i], tag names, attribute
+     * keys and text are spans into one shared pool. Tags and AttributeKeys
+     * hold the HtmlNames ids, -1 for text, comments and unknown names.
+     */
+    class HtmlDocument {
+    public:
+        static const uint32_t NoNode=0xffffffff;
+
+        struct Span {
+            uint32_t Offset;
+            uint32_t Size;
+        };
+
+        struct Attribute {
+            Span Key;
+            Span Value;
+        };
+
+        HtmlDocument();
+        ~HtmlDocument();
+
+        /*copies el, its following siblings and all children*/
+        void             create(const Element *el);
+        void             clear();
+
+        /*builds the mutable tree, it lives until the next create(), build() or clear()*/
+        Element         *build();
+        void             print(HtmlString &output) const;
+
+        size_t           getNodeCount() const;
+        const uint8_t   *getTypes() const;
+        const int16_t   *getTags() const;
+        const uint32_t  *getParents() const;
+        const uint32_t  *getNextSiblings() const;
+        const uint32_t  *getSubtreeEnds() const;
+        //tag name for elements, text for text and comments
+        const Span      *getData() const;
+        //attributes of node i are FirstAttributes[i] to FirstAttributes[i+1]
+        const uint32_t  *getFirstAttributes() const;
+        const Attribute *getAttributes() const;
+        const int16_t   *getAttributeKeys() const;
+        const char      *getPool() const;
+        std::string      getText(const Span &span) const;
+
+        //value of an attribute of node, nullptr if it doesn't have it
+        const Span      *getAttribute(uint32_t node,const char *key) const;
+
+        //first element at or after start in document order, NoNode if none.
+        //Matches like the lookups of HtmlElement
+        uint32_t         getElementbyTag(const char *tag,uint32_t start=0) const;
+        uint32_t         getElementbyID(const char *id,uint32_t start=0) const;
+    private:
+        uint32_t         _addString(const char *src,size_t size);
+
+        std::vector<uint8_t>   _Types;
+        std::vector<int16_t>   _Tags;
+        std::vector<uint32_t>  _Parents;
+        std::vector<uint32_t>  _NextSiblings;
+        std::vector<uint32_t>  _SubtreeEnds;
+        std::vector<Span>      _Data;
+        std::vector<uint32_t>  _FirstAttributes;
+        std::vector<Attribute> _Attributes;
+        std::vector<int16_t>   _AttributeKeys;
+        std::vector<char>      _Pool;
+        Element               *_RootNode;
+    };
+};
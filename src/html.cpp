@@ -31,13 +31,27 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <stdarg.h>
 
 #include <algorithm>
+#include <atomic>
 #include <fstream>
+#include <memory>
 #include <stack>
+#include <unordered_map>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #include "utils.h"
 #include "html.h"
 #include "config.h"
+#include "charset.h"
+#include "css.h"
 #include "encode.h"
+#include "names.h"
+#include "tablegrid.h"
+#include "tablewriter.h"
+#include "text.h"
+#include "tokenizer.h"
 
 #define HTMLTAG_OPEN '<'
 #define HTMLTAG_TERMINATE '/'
@@ -50,36 +64,739 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 namespace libhtmlpp {
 
-    class DocElements {
-    public:
-        libhtmlpp::Element*     element;
-        bool                    terminator;
-        class DocElements*      nextel;
-        class DocElements*      prevel;
-        long                    spos;
-        long                    epos;
-
-        DocElements() {
-            nextel = nullptr;
-            prevel = nullptr;
-            element = nullptr;
-            terminator = false;
-            spos = 0;
-            epos = 0;
-        }
-
-        ~DocElements() {
-            nextel=nullptr;
-            element=nullptr;
-            prevel=nullptr;
+    //open element on the stack of the tree builder and of validate()
+    struct OpenElement {
+        HtmlElement *Node;
+        Element     *LastChild;
+        int          Tag;
+        //byte offset of the start tag
+        size_t       Offset;
+        //next open element below with the same tag, -1 if none
+        long         PrevSame;
+        //nearest scope boundary like table or td at or below, -1 if none
+        long         Scope;
+    };
+
+    /*
+     * open elements with the rules for implied end tags, shared by the tree
+     * builder and validate(). Last holds the topmost open element for every
+     * tag id, so an end tag finds the element it closes without searching
+     * the stack. Defined after BuilderTable.
+     */
+    struct TagStack {
+        std::vector<OpenElement>             Open;
+        std::vector<long>                    Last;
+        //ids for tag names HtmlNames doesn't know, valid during one parse
+        std::unordered_map<std::string,int>  Unknown;
+        //parseLazy() pushes token indexes as Offset, close() stores Token there
+        long                                *Ends;
+        long                                 Token;
+
+        void reset();
+        int  tagid(const char *name,size_t nlen,bool add);
+        long scope() const;
+        //open element an end tag closes, -1 for a stray end tag
+        long find(int tag) const;
+        void push(int tag,HtmlElement *node,size_t offset);
+
+        //pops the elements down to idx, fn gets every one that needed an end tag
+        template<typename Fn> void close(long idx,Fn fn);
+        void close(long idx);
+        //closes the elements a new start tag can't be part of
+        template<typename Fn> void implied(int tag,Fn fn);
+    };
+
+    /*
+     * scratch memory used while parsing, every thread keeps its own arena
+     * so batch workers and repeated parse() calls reuse the same buffers
+     * instead of allocating a token table and a builder stack for every
+     * document. Tokens holds three entries per tag: start, terminator and
+     * end position.
+     */
+    struct ParseArena {
+        std::vector<long>                    Tokens;
+        TagStack                             Stack;
+    };
+
+    static thread_local ParseArena Arena;
+
+    /*
+     * copy of a document parsed by parseLazy() with its tokens. Ends holds
+     * for every start tag the token its element is closed at, the element
+     * itself for tags without content. Every element with children not
+     * built yet holds a reference.
+     */
+    struct LazySource {
+        std::vector<char> Data;
+        std::vector<long> Tokens;
+        std::vector<long> Ends;
+        size_t            Refs;
+    };
+
+    static void _release(LazySource *source){
+        if(--source->Refs==0)
+            delete source;
+    }
+
+    //elements whose content is text up to their end tag
+    static const char *RawTextTags[]={"script","style","textarea",nullptr};
+
+    //tag name at pos followed by the end of the name
+    static inline bool _tagNameAt(const char *data,size_t size,size_t pos,const char *name,size_t nlen){
+        if(pos+nlen>size || !HtmlTokenizer::isName(data+pos,nlen,name))
+            return false;
+        if(pos+nlen==size)
+            return true;
+        char c=data[pos+nlen];
+        return c=='>' || c=='/' || c==' ' || c=='\t' || c=='\n' || c=='\r' || c=='\f';
+    }
+
+    static inline bool _endTagAt(const char *data,size_t size,size_t pos,const char *name,size_t nlen){
+        return _tagNameAt(data,size,pos+2,name,nlen);
+    }
+
+    //position of the end tag of a raw text element, size if there is none
+    static size_t _rawTextEnd(const char *data,size_t size,size_t pos,const char *name){
+        size_t nlen=strlen(name);
+#ifdef __SSE2__
+        const __m128i lt=_mm_set1_epi8('<'),sl=_mm_set1_epi8('/');
+        for(; pos+17<=size; pos+=16){
+            __m128i a=_mm_loadu_si128((const __m128i*)(data+pos));
+            __m128i b=_mm_loadu_si128((const __m128i*)(data+pos+1));
+            int mask=_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a,lt),_mm_cmpeq_epi8(b,sl)));
+            while(mask){
+                size_t cur=pos+__builtin_ctz(mask);
+                if(_endTagAt(data,size,cur,name,nlen))
+                    return cur;
+                mask&=mask-1;
+            }
+        }
+#endif
+        for(; pos+1<size; ++pos){
+            if(data[pos]=='<' && data[pos+1]=='/' && _endTagAt(data,size,pos,name,nlen))
+                return pos;
+        }
+        return size;
+    }
+
+    //position of the > that ends a comment, size if there is none
+    static size_t _commentEnd(const char *data,size_t size,size_t pos){
+        while(pos<size){
+            const char *gt=(const char*)memchr(data+pos,'>',size-pos);
+            if(!gt)
+                break;
+            pos=gt-data;
+            if(data[pos-1]=='-' && data[pos-2]=='-')
+                return pos;
+            ++pos;
+        }
+        return size;
+    }
+
+    //end of the text of a comment token, the empty <!--> has no -- before >
+    static inline long _commentTextEnd(const long *token){
+        return token[2]-2>token[0]+4 ? token[2]-2 : token[0]+4;
+    }
+
+    /*
+     * finds the tags of a document and calls fn(start,terminator,end) for
+     * every tag and comment, terminator is the position of the / of an end
+     * tag or -1. Comments end at -->, quoted attribute values and the text
+     * of raw text elements are skipped. Returns the position of an
+     * unterminated tag or comment at the end, size if there is none.
+     */
+    template<typename Fn>
+    static size_t _scanTags(const char *data,size_t size,Fn fn){
+        bool open=false;
+        bool pterm=false;
+        long spos=-1,tpos=-1;
+        for(size_t ii=0; ii<size; ++ii){
+            switch(data[ii]){
+                case HTMLTAG_OPEN:
+                    if(!open){
+                        //comments end at -->, the > and < inside don't count,
+                        //<!--> and <!---> are empty comments like in browsers
+                        if(ii+4<size && data[ii+1]=='!' && data[ii+2]=='-' && data[ii+3]=='-'){
+                            size_t end=data[ii+4]=='>' ? ii+4 :
+                                       ii+5<size && data[ii+4]=='-' && data[ii+5]=='>' ? ii+5 :
+                                       _commentEnd(data,size,ii+6);
+                            if(end==size)
+                                return ii;
+                            fn(ii,-1,end);
+                            ii=end;
+                            break;
+                        }
+                        open = true;
+                        pterm = true;
+                        spos = ii;
+                        tpos = -1;
+                    }
+                    break;
+                case HTMLTAG_TERMINATE:
+                    if(pterm==true)
+                        tpos=ii;
+                    break;
+                case '=':
+                    pterm=false;
+                    if(open){
+                        //quoted values may hold < and >
+                        size_t vpos=ii+1;
+                        while(vpos<size && (data[vpos]==' ' || data[vpos]=='\t' || data[vpos]=='\n' || data[vpos]=='\r'))
+                            ++vpos;
+                        if(vpos<size && (data[vpos]=='"' || data[vpos]=='\'')){
+                            const char *quote=(const char*)memchr(data+vpos+1,data[vpos],size-vpos-1);
+                            ii=quote ? quote-data : size;
+                        }
+                    }
+                    break;
+                case HTMLTAG_CLOSE:
+                    if(open){
+                        fn(spos,tpos,ii);
+                        open = false;
+
+                        //script, style and textarea hold text up to their end tag
+                        if(tpos==-1 && data[ii-1]!='/'){
+                            for(size_t i=0; RawTextTags[i]; ++i){
+                                size_t nlen=strlen(RawTextTags[i]);
+                                if(_tagNameAt(data,size,spos+1,RawTextTags[i],nlen)){
+                                    ii=_rawTextEnd(data,size,ii+1,RawTextTags[i])-1;
+                                    break;
+                                }
+                            }
+                        }
+                    }
+                    break;
+                case ' ':
+                    break;
+                default:
+                    pterm=false;
+                    break;
+            }
+        }
+        return open ? (size_t)spos : size;
+    }
+
+    //character classes and states of the attribute tokenizer in _serialelize
+    enum AttributeClass {AttrOther=0,AttrSpace,AttrSlash,AttrEquals,AttrClose,AttrDQuote,AttrSQuote};
+    enum AttributeState {BeforeName=0,Name,AfterName,BeforeValue,DQValue,SQValue,UnquotedValue};
+    enum AttributeAction {
+        AttrKeyEnd=1,AttrBoolean=2,AttrValue=4,AttrKeyStart=8,AttrValueStart=16
+    };
+
+    /*
+     * transitions after the attribute syntax of html: double quoted, single
+     * quoted, unquoted and boolean attributes, the actions run in the order
+     * of AttributeAction. A > ends the tag in every state outside quotes.
+     */
+    struct AttributeTable {
+        struct Transition {
+            unsigned char State;
+            unsigned char Action;
+        };
+
+        unsigned char Class[256];
+        Transition    Next[7][7];
+
+        AttributeTable(){
+            memset(Class,AttrOther,sizeof(Class));
+            Class[(unsigned char)' ']=Class[(unsigned char)'\t']=AttrSpace;
+            Class[(unsigned char)'\n']=Class[(unsigned char)'\r']=Class[(unsigned char)'\f']=AttrSpace;
+            Class[(unsigned char)'/']=AttrSlash;
+            Class[(unsigned char)'=']=AttrEquals;
+            Class[(unsigned char)'>']=AttrClose;
+            Class[(unsigned char)'"']=AttrDQuote;
+            Class[(unsigned char)'\'']=AttrSQuote;
+
+            //                 Other                          Space                     Slash                          Equals                      Close                       DQuote                         SQuote
+            set(BeforeName,   {Name,AttrKeyStart},           {BeforeName,0},           {BeforeName,0},                {Name,AttrKeyStart},        {BeforeName,0},             {Name,AttrKeyStart},           {Name,AttrKeyStart});
+            set(Name,         {Name,0},                      {AfterName,AttrKeyEnd},   {BeforeName,AttrKeyEnd|AttrBoolean},{BeforeValue,AttrKeyEnd},{BeforeName,AttrKeyEnd|AttrBoolean},{Name,0},            {Name,0});
+            set(AfterName,    {Name,AttrBoolean|AttrKeyStart},{AfterName,0},           {BeforeName,AttrBoolean},      {BeforeValue,0},            {BeforeName,AttrBoolean},   {Name,AttrBoolean|AttrKeyStart},{Name,AttrBoolean|AttrKeyStart});
+            set(BeforeValue,  {UnquotedValue,AttrValueStart},{BeforeValue,0},          {UnquotedValue,AttrValueStart},{UnquotedValue,AttrValueStart},{BeforeName,AttrBoolean},{DQValue,AttrValueStart},     {SQValue,AttrValueStart});
+            set(DQValue,      {DQValue,0},                   {DQValue,0},              {DQValue,0},                   {DQValue,0},                {DQValue,0},                {BeforeName,AttrValue},        {DQValue,0});
+            set(SQValue,      {SQValue,0},                   {SQValue,0},              {SQValue,0},                   {SQValue,0},                {SQValue,0},                {SQValue,0},                   {BeforeName,AttrValue});
+            set(UnquotedValue,{UnquotedValue,0},             {BeforeName,AttrValue},   {UnquotedValue,0},             {UnquotedValue,0},          {BeforeName,AttrValue},     {UnquotedValue,0},             {UnquotedValue,0});
+        }
+
+        void set(int state,Transition other,Transition space,Transition slash,Transition equals,
+                 Transition close,Transition dquote,Transition squote){
+            Next[state][AttrOther]=other;
+            Next[state][AttrSpace]=space;
+            Next[state][AttrSlash]=slash;
+            Next[state][AttrEquals]=equals;
+            Next[state][AttrClose]=close;
+            Next[state][AttrDQuote]=dquote;
+            Next[state][AttrSQuote]=squote;
+        }
+    };
+
+    static const AttributeTable &_attributeTable(){
+        static AttributeTable table;
+        return table;
+    }
+
+    //end of the tag name that starts at pos
+    static inline size_t _nameEnd(const char *data,size_t pos,size_t end){
+        const AttributeTable &tbl=_attributeTable();
+        while(pos<end && tbl.Class[(unsigned char)data[pos]]!=AttrSpace &&
+              data[pos]!='/' && data[pos]!='>')
+            ++pos;
+        return pos;
+    }
+
+    //true if data holds only whitespace
+    static inline bool _blank(const char *data,size_t len){
+        const AttributeTable &tbl=_attributeTable();
+        for(size_t i=0; i<len; ++i){
+            if(tbl.Class[(unsigned char)data[i]]!=AttrSpace)
+                return false;
+        }
+        return true;
+    }
+
+    /*
+     * runs the attribute tokenizer over the tag in from pos, the end of the
+     * tag name, and calls add(key,klen,value,vlen) for every attribute in
+     * the order they appear, value is nullptr for boolean attributes.
+     * Returns true if the tag ends in />.
+     */
+    template<typename Fn>
+    static bool _scanAttributes(const char *in,size_t len,size_t pos,Fn add){
+        const AttributeTable &tbl=_attributeTable();
+        size_t kst=0,ket=0,vst=0;
+        int state=BeforeName;
+
+        for(size_t i=pos; i<len; ++i){
+            int cls=tbl.Class[(unsigned char)in[i]];
+            const AttributeTable::Transition &tr=tbl.Next[state][cls];
+
+            if(tr.Action & AttrKeyEnd)
+                ket=i;
+            if(tr.Action & AttrBoolean)
+                add(in+kst,ket-kst,nullptr,0);
+            if(tr.Action & AttrValue)
+                add(in+kst,ket-kst,in+vst,i-vst);
+            if(tr.Action & AttrKeyStart)
+                kst=i;
+            if(tr.Action & AttrValueStart)
+                vst=(cls==AttrDQuote || cls==AttrSQuote) ? i+1 : i;
+
+            if(cls==AttrClose && state!=DQValue && state!=SQValue){
+                //only a slash right before > closes the tag, <a href=/x/> doesn't
+                return state==BeforeName && in[i-1]=='/';
+            }
+            state=tr.State;
+        }
+
+        //input without > like an unfinished tag at the end of the document
+        switch(state){
+            case Name:
+                add(in+kst,len-kst,nullptr,0);
+                break;
+            case AfterName:
+            case BeforeValue:
+                add(in+kst,ket-kst,nullptr,0);
+                break;
+            case DQValue:
+            case SQValue:
+            case UnquotedValue:
+                add(in+kst,ket-kst,in+vst,len-vst);
+                break;
+        }
+        return false;
+    }
+
+    //attributes HtmlLinkExtractor reports, the links of a tag come in this order
+    enum LinkAttribute {LinkHref=0,LinkSrc,LinkSrcset,LinkAction,LinkAttributeCount};
+
+    static const char *LinkAttributeNames[]={"href","src","srcset","action",nullptr};
+
+    struct LinkTag {
+        const char   *Tag;
+        unsigned char Attributes;
+    };
+
+    //tags with urls, base only sets the url the others are resolved against
+    static const LinkTag LinkTags[]={
+        {"a",1<<LinkHref},{"area",1<<LinkHref},{"link",1<<LinkHref},{"base",1<<LinkHref},
+        {"img",1<<LinkSrc|1<<LinkSrcset},{"source",1<<LinkSrc|1<<LinkSrcset},
+        {"script",1<<LinkSrc},{"iframe",1<<LinkSrc},{"frame",1<<LinkSrc},{"embed",1<<LinkSrc},
+        {"track",1<<LinkSrc},{"audio",1<<LinkSrc},{"video",1<<LinkSrc},{"input",1<<LinkSrc},
+        {"form",1<<LinkAction},{nullptr,0}
+    };
+
+    //LinkAttribute mask for every tag id and the HtmlNames ids of the attributes
+    struct LinkTable {
+        unsigned char Mask[HTML_MAXNAMES];
+        int           Attribute[LinkAttributeCount];
+        int           Base;
+
+        LinkTable(){
+            memset(Mask,0,sizeof(Mask));
+            for(size_t i=0; LinkTags[i].Tag; ++i)
+                Mask[HtmlNames::getTag(LinkTags[i].Tag)]=LinkTags[i].Attributes;
+            for(size_t i=0; LinkAttributeNames[i]; ++i)
+                Attribute[i]=HtmlNames::getAttribute(LinkAttributeNames[i]);
+            Base=HtmlNames::getTag("base");
+        }
+    };
+
+    static const LinkTable &_linkTable(){
+        static LinkTable table;
+        return table;
+    }
+
+    //positions of the parts of an url, every part ends where the next starts
+    struct UrlParts {
+        //the colon after the scheme, 0 without scheme
+        size_t SchemeEnd;
+        bool   Authority;
+        //start of // or of the path if there is no authority
+        size_t AuthorityStart;
+        size_t PathStart;
+        //the ? and the # belong to the query and the fragment
+        size_t QueryStart;
+        size_t FragmentStart;
+    };
+
+    static void _urlParts(const char *url,size_t len,UrlParts &parts){
+        parts.SchemeEnd=0;
+        if(len && ((url[0]|0x20)>='a' && (url[0]|0x20)<='z')){
+            size_t i=1;
+            while(i<len && (((url[i]|0x20)>='a' && (url[i]|0x20)<='z') ||
+                  (url[i]>='0' && url[i]<='9') || url[i]=='+' || url[i]=='-' || url[i]=='.'))
+                ++i;
+            if(i<len && url[i]==':')
+                parts.SchemeEnd=i;
+        }
+        size_t pos=parts.SchemeEnd ? parts.SchemeEnd+1 : 0;
+        parts.AuthorityStart=pos;
+        parts.Authority=pos+1<len && url[pos]=='/' && url[pos+1]=='/';
+        if(parts.Authority){
+            pos+=2;
+            while(pos<len && url[pos]!='/' && url[pos]!='?' && url[pos]!='#')
+                ++pos;
+        }
+        parts.PathStart=pos;
+        while(pos<len && url[pos]!='?' && url[pos]!='#')
+            ++pos;
+        parts.QueryStart=pos;
+        while(pos<len && url[pos]!='#')
+            ++pos;
+        parts.FragmentStart=pos;
+    }
+
+    static inline bool _pathPrefix(const char *path,size_t len,const char *prefix,size_t plen){
+        return len>=plen && memcmp(path,prefix,plen)==0;
+    }
+
+    //remove_dot_segments of rfc 3986 in place, returns the new length
+    static size_t _removeDots(char *path,size_t len){
+        size_t rd=0,wr=0;
+        auto pop=[path,&wr](){
+            while(wr>0 && path[wr-1]!='/')
+                --wr;
+            if(wr>0)
+                --wr;
+        };
+        while(rd<len){
+            const char *cur=path+rd;
+            size_t left=len-rd;
+            if(_pathPrefix(cur,left,"../",3)){
+                rd+=3;
+            }else if(_pathPrefix(cur,left,"./",2) || _pathPrefix(cur,left,"/./",3)){
+                rd+=2;
+            }else if(left==2 && cur[0]=='/' && cur[1]=='.'){
+                path[++rd]='/';
+            }else if(_pathPrefix(cur,left,"/../",4)){
+                rd+=3;
+                pop();
+            }else if(left==3 && _pathPrefix(cur,left,"/..",3)){
+                rd+=2;
+                path[rd]='/';
+                pop();
+            }else if((left==1 && cur[0]=='.') || (left==2 && cur[0]=='.' && cur[1]=='.')){
+                rd=len;
+            }else{
+                //the first segment with its leading slash
+                do{
+                    path[wr++]=path[rd++];
+                }while(rd<len && path[rd]!='/');
+            }
+        }
+        return wr;
+    }
+
+    static inline bool _urlSpace(char c){
+        return c==' ' || c=='\t' || c=='\n' || c=='\r' || c=='\f';
+    }
+
+    enum BuilderFlags {ClosesP=1,ScopeBoundary=2,OptionalEnd=4,Heading=8,TableScope=16};
+
+    //start tags that close an open p
+    static const char *ClosePTags[]={
+        "address","article","aside","blockquote","center","dd","details","dialog",
+        "dir","div","dl","dt","fieldset","figcaption","figure","footer","form",
+        "h1","h2","h3","h4","h5","h6","header","hgroup","hr","li","listing",
+        "main","menu","nav","ol","p","plaintext","pre","search","section",
+        "summary","table","ul","xmp",nullptr
+    };
+
+    //elements an end tag can't close elements outside of
+    static const char *ScopeTags[]={
+        "applet","caption","html","marquee","object","table","td","template","th",nullptr
+    };
+
+    //end tags of these close open cells, only a table limits them
+    static const char *TableTags[]={
+        "caption","colgroup","table","tbody","td","tfoot","th","thead","tr",nullptr
+    };
+
+    //elements that may be closed without end tag
+    static const char *OptionalEndTags[]={
+        "body","caption","colgroup","dd","dt","head","html","li","optgroup","option",
+        "p","rb","rp","rt","rtc","tbody","td","tfoot","th","thead","tr",nullptr
+    };
+
+    struct BuilderTable {
+        unsigned char Flags[HTML_MAXNAMES];
+        int P,Li,Ol,Ul,Dd,Dt,Dl,Td,Th,Tr,Table,Thead,Tbody,Tfoot,Option,Optgroup;
+
+        BuilderTable(){
+            memset(Flags,0,sizeof(Flags));
+            auto set=[this](const char **names,int flag){
+                for(size_t i=0; names[i]; ++i)
+                    Flags[HtmlNames::getTag(names[i])]|=flag;
+            };
+            set(ClosePTags,ClosesP);
+            set(ScopeTags,ScopeBoundary);
+            set(OptionalEndTags,OptionalEnd);
+            set(TableTags,TableScope);
+            const char *headings[]={"h1","h2","h3","h4","h5","h6",nullptr};
+            set(headings,Heading);
+            P=HtmlNames::getTag("p");
+            Li=HtmlNames::getTag("li");
+            Ol=HtmlNames::getTag("ol");
+            Ul=HtmlNames::getTag("ul");
+            Dd=HtmlNames::getTag("dd");
+            Dt=HtmlNames::getTag("dt");
+            Dl=HtmlNames::getTag("dl");
+            Td=HtmlNames::getTag("td");
+            Th=HtmlNames::getTag("th");
+            Tr=HtmlNames::getTag("tr");
+            Table=HtmlNames::getTag("table");
+            Thead=HtmlNames::getTag("thead");
+            Tbody=HtmlNames::getTag("tbody");
+            Tfoot=HtmlNames::getTag("tfoot");
+            Option=HtmlNames::getTag("option");
+            Optgroup=HtmlNames::getTag("optgroup");
+        }
+
+        //ids of unknown tags start at HTML_MAXNAMES and have no flags
+        bool is(int tag,int flag) const{
+            return tag<HTML_MAXNAMES && (Flags[tag]&flag);
         }
     };
+
+    static const BuilderTable &_builderTable(){
+        static BuilderTable table;
+        return table;
+    }
+
+    void TagStack::reset(){
+        Open.clear();
+        Last.assign(HTML_MAXNAMES,-1);
+        Unknown.clear();
+        Ends=nullptr;
+        Token=0;
+    }
+
+    int TagStack::tagid(const char *name,size_t nlen,bool add){
+        int id=HtmlNames::getTag(name,nlen);
+        if(id>=0)
+            return id;
+        std::string lower(name,nlen);
+        for(char &c : lower)
+            c=(c>='A' && c<='Z') ? c|0x20 : c;
+        auto it=Unknown.find(lower);
+        if(it!=Unknown.end())
+            return it->second;
+        if(!add)
+            return -1;
+        id=Last.size();
+        Unknown.insert({lower,id});
+        Last.push_back(-1);
+        return id;
+    }
+
+    long TagStack::scope() const{
+        return Open.empty() ? -1L : Open.back().Scope;
+    }
+
+    long TagStack::find(int tag) const{
+        const BuilderTable &tbl=_builderTable();
+        if(tag<0)
+            return -1;
+        long limit=scope();
+        if(tbl.is(tag,TableScope))
+            limit=tag==tbl.Table ? 0 : Last[tbl.Table];
+        return Last[tag]<limit ? -1 : Last[tag];
+    }
+
+    void TagStack::push(int tag,HtmlElement *node,size_t offset){
+        OpenElement cur;
+        cur.Node=node;
+        cur.LastChild=nullptr;
+        cur.Tag=tag;
+        cur.Offset=offset;
+        cur.PrevSame=Last[tag];
+        cur.Scope=_builderTable().is(tag,ScopeBoundary) ? (long)Open.size() : scope();
+        Last[tag]=Open.size();
+        Open.push_back(cur);
+    }
+
+    template<typename Fn>
+    void TagStack::close(long idx,Fn fn){
+        const BuilderTable &tbl=_builderTable();
+        while((long)Open.size()>idx){
+            const OpenElement &cur=Open.back();
+            if(!tbl.is(cur.Tag,OptionalEnd))
+                fn(cur);
+            if(Ends)
+                Ends[cur.Offset]=Token;
+            Last[cur.Tag]=cur.PrevSame;
+            Open.pop_back();
+        }
+    }
+
+    void TagStack::close(long idx){
+        close(idx,[](const OpenElement&){});
+    }
+
+    template<typename Fn>
+    void TagStack::implied(int tag,Fn fn){
+        const BuilderTable &tbl=_builderTable();
+        const std::vector<long> &last=Last;
+        if(tbl.is(tag,ClosesP) && last[tbl.P]>scope())
+            close(last[tbl.P],fn);
+        if(tag==tbl.Li){
+            if(last[tbl.Li]>std::max(scope(),std::max(last[tbl.Ol],last[tbl.Ul])))
+                close(last[tbl.Li],fn);
+        }else if(tag==tbl.Dd || tag==tbl.Dt){
+            long idx=std::max(last[tbl.Dd],last[tbl.Dt]);
+            if(idx>std::max(scope(),last[tbl.Dl]))
+                close(idx,fn);
+        }else if(tag==tbl.Td || tag==tbl.Th){
+            long idx=std::max(last[tbl.Td],last[tbl.Th]);
+            if(idx>std::max(last[tbl.Tr],last[tbl.Table]))
+                close(idx,fn);
+        }else if(tag==tbl.Tr){
+            long idx=last[tbl.Tr];
+            if(idx>std::max(std::max(last[tbl.Table],last[tbl.Thead]),std::max(last[tbl.Tbody],last[tbl.Tfoot])))
+                close(idx,fn);
+        }else if(tag==tbl.Thead || tag==tbl.Tbody || tag==tbl.Tfoot){
+            long idx=std::max(std::max(last[tbl.Thead],last[tbl.Tbody]),last[tbl.Tfoot]);
+            if(idx>last[tbl.Table])
+                close(idx,fn);
+        }else if(tag==tbl.Option || tag==tbl.Optgroup){
+            if(!Open.empty() && Open.back().Tag==tbl.Option)
+                close(Open.size()-1);
+            if(tag==tbl.Optgroup && !Open.empty() && Open.back().Tag==tbl.Optgroup)
+                close(Open.size()-1);
+        }else if(tbl.is(tag,Heading) && !Open.empty() && tbl.is(Open.back().Tag,Heading)){
+            close(Open.size()-1,fn);
+        }
+    }
+
+    static void _throwFrozen(){
+        HTMLException excp;
+        excp[HTMLException::Error] << "frozen html can't be modified!";
+        throw excp;
+    }
+
+    static Element *_newElement(int type){
+        switch(type){
+            case HtmlEl:
+                return new HtmlElement();
+            case TextEl:
+                return new TextElement();
+            case CommentEl:
+                return new CommentElement();
+        }
+        HTMLException excp;
+        excp[HTMLException::Error] << "Unkown Elementtype";
+        throw excp;
+    }
+
+    void _delete(libhtmlpp::Element *el){
+        while(el){
+            if(el->_Type==HtmlEl && ((HtmlElement*)el)->_childElement){
+                Element *child=((HtmlElement*)el)->_childElement,*last=child;
+                ((HtmlElement*)el)->_childElement=nullptr;
+                while(last->_nextElement)
+                    last=last->_nextElement;
+                last->_nextElement=el->_nextElement;
+                el->_nextElement=child;
+            }
+            Element *next=el->_nextElement;
+            el->_nextElement=nullptr;
+            delete el;
+            el=next;
+        }
+    }
+
+    //the first element of a parsed document that has a tag, leading text is skipped
+    HtmlElement *_firstHtml(Element *el){
+        while(el && el->getType()!=HtmlEl)
+            el=el->nextElement();
+        return (HtmlElement*)el;
+    }
+
+    static inline Element *_firstChild(const Element *el){
+        return el->getType()==HtmlEl ? ((const HtmlElement*)el)->childElement() : nullptr;
+    }
+
+    /*
+     * walks el, its following siblings and all children over the links.
+     * enter returns an ElementVisitor::Action, leave runs after the children
+     * of an element, false if one of them stopped the walk.
+     */
+    template<typename Enter,typename Leave>
+    static bool _walk(Element *el,Enter enter,Leave leave){
+        Element *boundary=el ? el->parentElement() : nullptr;
+        while(el){
+            int action=enter(el);
+            if(action==ElementVisitor::Stop)
+                return false;
+            //skipped children of a lazy element aren't built
+            Element *child=action==ElementVisitor::Continue ? _firstChild(el) : nullptr;
+            if(child){
+                el=child;
+                continue;
+            }
+            for(;;){
+                if(leave(el)==ElementVisitor::Stop)
+                    return false;
+                if(el->nextElement()){
+                    el=el->nextElement();
+                    break;
+                }
+                el=el->parentElement();
+                if(el==boundary)
+                    return true;
+            }
+        }
+        return true;
+    }
+
+    static inline int _noLeave(Element*){
+        return ElementVisitor::Continue;
+    }
 };
 
 libhtmlpp::HtmlString::HtmlString(){
-    _HTable=nullptr;
-    _HTableSize=0;
     _RootNode=nullptr;
+    _Frozen=false;
+    _Errors=ParseErrors();
 }
 
 libhtmlpp::HtmlString::HtmlString(const char* str) : HtmlString(){
@@ -91,17 +808,19 @@ libhtmlpp::HtmlString::HtmlString(std::string& str) : HtmlString(){
 }
 
 libhtmlpp::HtmlString::~HtmlString(){
-    if(_HTable){
-        for(size_t i=0; i<_HTableSize; ++i){
-            delete[] _HTable[i];
-        }
-    }
-    delete[]   _HTable;
-    delete     _RootNode;
+    _delete(_RootNode);
 }
 
 libhtmlpp::HtmlString::HtmlString(const libhtmlpp::HtmlString& str) : HtmlString() {
-    std::copy(str._Data.begin(),str._Data.end(),std::insert_iterator<std::vector<char>>(_Data,_Data.begin()));
+    _Data=str._Data;
+}
+
+libhtmlpp::HtmlString::HtmlString(libhtmlpp::HtmlString&& str) noexcept : HtmlString() {
+    _Data.swap(str._Data);
+    _CStr.swap(str._CStr);
+    std::swap(_RootNode,str._RootNode);
+    std::swap(_Frozen,str._Frozen);
+    std::swap(_Errors,str._Errors);
 }
 
 libhtmlpp::HtmlString::HtmlString(const libhtmlpp::HtmlString* str) : HtmlString(){
@@ -110,10 +829,14 @@ libhtmlpp::HtmlString::HtmlString(const libhtmlpp::HtmlString* str) : HtmlString
 
 
 void libhtmlpp::HtmlString::append(const char* src, size_t srcsize){
-   std::copy(src,src+srcsize,std::insert_iterator<std::vector<char>>(_Data,_Data.end()));
+   if(_Frozen)
+       _throwFrozen();
+   _Data.insert(_Data.end(),src,src+srcsize);
 }
 
 void libhtmlpp::HtmlString::push_back(const char src){
+   if(_Frozen)
+       _throwFrozen();
    _Data.push_back(src);
 }
 
@@ -127,20 +850,15 @@ void libhtmlpp::HtmlString::append(libhtmlpp::HtmlString& hstring) {
 }
 
 void libhtmlpp::HtmlString::insert(size_t pos, char src){
+    if(_Frozen)
+        _throwFrozen();
     _Data.at(pos)=src;
 }
 
 void libhtmlpp::HtmlString::clear(){
-    if(_HTable){
-        for(size_t i=0; i<_HTableSize; ++i){
-            delete[] _HTable[i];
-        }
-    }
-    delete[]   _HTable;
-    delete     _RootNode;
-
-    _HTable=nullptr;
-    _HTableSize=0;
+    if(_Frozen)
+        _throwFrozen();
+    _delete(_RootNode);
     _RootNode=nullptr;
     _Data.clear();
 }
@@ -179,6 +897,15 @@ libhtmlpp::HtmlString& libhtmlpp::HtmlString::operator=(const libhtmlpp::HtmlStr
     return *this;
 }
 
+libhtmlpp::HtmlString& libhtmlpp::HtmlString::operator=(libhtmlpp::HtmlString&& src) noexcept{
+    _Data.swap(src._Data);
+    _CStr.swap(src._CStr);
+    std::swap(_RootNode,src._RootNode);
+    std::swap(_Frozen,src._Frozen);
+    std::swap(_Errors,src._Errors);
+    return *this;
+}
+
 const char libhtmlpp::HtmlString::operator[](size_t pos) const{
     return _Data.at(pos);
 }
@@ -234,343 +961,680 @@ const size_t libhtmlpp::HtmlString::size() const{
 }
 
 const char * libhtmlpp::HtmlString::c_str(){
+    if(_Frozen)
+        return _CStr.data();
     _CStr=_Data;
     _CStr.push_back('\0');
     return _CStr.data();
 }
 
+const char * libhtmlpp::HtmlString::data() const{
+    return _Data.data();
+}
+
+void libhtmlpp::HtmlString::freeze(){
+    if(_Frozen)
+        return;
+    _CStr=_Data;
+    _CStr.push_back('\0');
+    if(_RootNode)
+        libhtmlpp::freeze(_RootNode);
+    _Frozen=true;
+}
+
+bool libhtmlpp::HtmlString::isFrozen() const{
+    return _Frozen;
+}
+
 libhtmlpp::HtmlElement* libhtmlpp::HtmlString::parse() {
-    HTMLException excp;
+    if(_Frozen)
+        _throwFrozen();
     _parseTree();
     long pos = 0;
-    if(_RootNode)
-        delete _RootNode;
-    _RootNode = (HtmlElement*)_buildTree(pos);
-    return _RootNode;
+    _delete(_RootNode);
+    _RootNode=nullptr;
+    _RootNode = _buildTree(pos);
+    return _firstHtml(_RootNode);
 }
 
-bool libhtmlpp::HtmlString::validate(std::string *err){
-    try{
-        _parseTree();
-        long pos = 0;
-        HtmlElement *el=(HtmlElement*)_buildTree(pos);
-        if(el){
-            delete el;
-            return true;
-        }
-    }catch(HTMLException &e){
-        *err=e.what();
-    }
-    return false;
+const libhtmlpp::HtmlString::ParseErrors &libhtmlpp::HtmlString::getParseErrors() const{
+    return _Errors;
 }
 
-libhtmlpp::Element* libhtmlpp::HtmlString::_buildtreenode(libhtmlpp::DocElements *firstel,libhtmlpp::DocElements *lastel){
+bool libhtmlpp::HtmlString::validate(std::vector<Diagnostic> &diagnostics){
+    const char *data=_Data.data();
+    size_t size=_Data.size();
 
-    struct cpyel {
-        cpyel(){
+    diagnostics.clear();
+    _Errors=ParseErrors();
 
-        };
+    TagStack &stack=Arena.Stack;
+    stack.reset();
 
-        cpyel(const cpyel &src){
-            start=src.start;
-            end=src.end;
-        };
+    //start of the current tag, the end of the document after the last one
+    size_t cur=0;
 
-        libhtmlpp::DocElements *start;
-        libhtmlpp::DocElements *end;
+    auto misnested=[this,&diagnostics,&cur](const OpenElement &el){
+        ++_Errors.MisnestedTags;
+        diagnostics.push_back({Diagnostic::MisnestedTag,cur,el.Offset});
     };
 
-    std::stack<cpyel> cpylist;
+    size_t unterminated=_scanTags(data,size,[&](long spos,long tpos,long epos){
+        cur=spos;
+        if(tpos!=-1){
+            size_t nend=_nameEnd(data,tpos+1,epos);
+            long idx=stack.find(stack.tagid(data+tpos+1,nend-tpos-1,false));
+            if(idx<0){
+                ++_Errors.StrayEndTags;
+                diagnostics.push_back({Diagnostic::StrayEndTag,cur,Diagnostic::npos});
+            }else{
+                stack.close(idx+1,misnested);
+                stack.close(idx);
+            }
+            return;
+        }
+        if(data[spos+1]=='!' && data[spos+2]=='-' && data[spos+3]=='-')
+            return;
 
-    DocElements *prev=nullptr;
-    DocElements *start=firstel;
-    DocElements *next=firstel->nextel;
-    DocElements *end=lastel;
+        size_t st=spos;
+        while(st<(size_t)epos && (data[st]=='<' || data[st]==' ' || data[st]=='\t' ||
+              data[st]=='\n' || data[st]=='\r' || data[st]=='\f'))
+            ++st;
+        size_t et=_nameEnd(data,st,epos);
+        if(et==st){
+            diagnostics.push_back({Diagnostic::MissingTagName,cur,Diagnostic::npos});
+            return;
+        }
 
-    Element* first=start->element;
+        int tag=stack.tagid(data+st,et-st,true);
+        stack.implied(tag,misnested);
 
-    auto checkterminator = [](DocElements *termel, DocElements *end){
-        int i=0;
+        //only tags ending in /> need the attribute tokenizer to find out if they close
+        bool selfclosing=data[epos-1]=='/' && _serialelize(data+spos,epos-spos+1,nullptr);
+        if(!selfclosing && !HtmlNames::isVoid(data+st,et-st))
+            stack.push(tag,nullptr,spos);
+    });
 
-        if(((Element*)(termel->element))->getType()!=HtmlEl)
-            return (DocElements*) nullptr;
+    if(unterminated<size)
+        diagnostics.push_back({Diagnostic::UnterminatedTag,unterminated,Diagnostic::npos});
 
-        for (DocElements* curcel=termel->nextel; curcel; curcel=curcel->nextel) {
+    cur=size;
+    stack.close(0,[this,&diagnostics,&cur](const OpenElement &el){
+        ++_Errors.UnclosedElements;
+        diagnostics.push_back({Diagnostic::UnclosedElement,cur,el.Offset});
+    });
 
-            if (curcel->element && curcel->element->_Type==HtmlEl && !curcel->terminator &&
-                *((HtmlElement*)curcel->element) == ((HtmlElement*)termel->element)) {
-                ++i;
-            }
+    return diagnostics.empty();
+}
 
-            if (curcel->element && curcel->element->_Type==HtmlEl && curcel->terminator &&
-                *((HtmlElement*)curcel->element) == ((HtmlElement*)termel->element)) {
-                if(i==0){
-                    return curcel;
-                }else{
-                    --i;
-                }
+bool libhtmlpp::HtmlString::validate(std::string *err){
+    std::vector<Diagnostic> diagnostics;
+    if(validate(diagnostics))
+        return true;
+    size_t malformed=diagnostics.size()-_Errors.StrayEndTags-_Errors.MisnestedTags-_Errors.UnclosedElements;
+    *err=std::to_string(_Errors.StrayEndTags)+" stray end tags, "+
+         std::to_string(_Errors.MisnestedTags)+" misnested tags, "+
+         std::to_string(_Errors.UnclosedElements)+" unclosed elements";
+    if(malformed)
+        *err+=", "+std::to_string(malformed)+" malformed tags";
+    return false;
+}
+
+libhtmlpp::Element* libhtmlpp::HtmlString::_buildTree(long& pos) {
+    const std::vector<long> &tokens=Arena.Tokens;
+    size_t tcount=tokens.size()/3;
+
+    _Errors=ParseErrors();
+
+    TagStack &stack=Arena.Stack;
+    std::vector<OpenElement> &open=stack.Open;
+    stack.reset();
+
+    Element *first=nullptr,*top=nullptr;
+
+    //text in front of the first tag, whitespace there doesn't render
+    size_t lead=tcount ? tokens[0] : _Data.size();
+    if(!_blank(_Data.data(),lead)){
+        TextElement *text=new TextElement();
+        text->_Text.assign(_Data.begin(),_Data.begin()+lead);
+        first=top=text;
+    }
+
+    auto append=[&open,&first,&top](Element *el){
+        if(open.empty()){
+            el->_parentElement=nullptr;
+            if(top){
+                top->_nextElement=el;
+                el->_prevElement=top;
+            }else{
+                first=el;
             }
-            if(curcel==end)
-                break;
+            top=el;
+            return;
+        }
+        OpenElement &cur=open.back();
+        el->_parentElement=cur.Node;
+        if(cur.LastChild){
+            cur.LastChild->_nextElement=el;
+            el->_prevElement=cur.LastChild;
+        }else{
+            cur.Node->_childElement=el;
         }
-        return (DocElements*) nullptr;
+        cur.LastChild=el;
+    };
+
+    auto misnested=[this](const OpenElement&){
+        ++_Errors.MisnestedTags;
     };
 
-NEXTDOCEL:
-    DocElements *parent=checkterminator(start,end);
+    for(size_t i = 0; i < tcount; ++i) {
+        const long *token=&tokens[i*3];
 
-    if(prev && !start->terminator){
-        start->element->_prevElement=prev->element;
-    }
+        if(token[1] != -1){
+            //end tag, closes the element of the same name and everything inside
+            size_t nend=_nameEnd(_Data.data(),token[1]+1,token[2]);
+            long idx=stack.find(stack.tagid(_Data.data()+token[1]+1,nend-token[1]-1,false));
+            if(idx<0){
+                ++_Errors.StrayEndTags;
+            }else{
+                stack.close(idx+1,misnested);
+                stack.close(idx);
+            }
+        }else if((size_t)token[0]+3<_Data.size() && _Data[token[0]+1]=='!' &&
+                 _Data[token[0]+2]=='-' && _Data[token[0]+3]=='-'){
+            CommentElement *comment=new CommentElement();
+            comment->_Comment.assign(_Data.begin()+token[0]+4,_Data.begin()+_commentTextEnd(token));
+            append(comment);
+        }else{
+            HtmlElement *node=new HtmlElement();
+            bool selfclosing=_serialelize(_Data.data()+token[0],token[2]-token[0]+1,node);
 
-    if(parent && parent!=next){
-        ((HtmlElement*)(start->element))->_childElement=next->element;
-        cpyel childel;
-        childel.start=next;
-        childel.end=parent;
-        cpylist.push(childel);
-        next=parent;
-    }
+            int tag=stack.tagid(node->_TagName.data(),node->_TagName.size(),true);
+            stack.implied(tag,misnested);
 
-    if(!next){
-        HTMLException e;
-        e[HTMLException::Critical] << "Html Dom Incorrect!";
-        throw e;
-    }
+            append(node);
 
-    while(next!=end){
-        if(!next->terminator){
-            start->element->_nextElement=next->element;
-            prev=start;
-            start=next;
-            next=next->nextel;
-            goto NEXTDOCEL;
+            //void elements, <!DOCTYPE> and <x /> have no content
+            if(!selfclosing && !HtmlNames::isVoid(node->_TagName.data(),node->_TagName.size()))
+                stack.push(tag,node,token[0]);
         }
-        next=next->nextel;
-    };
 
-    if(!cpylist.empty()){
-        cpyel childel(cpylist.top());
-        prev=nullptr;
-        start=childel.start;
-        end=childel.end;
-        next=childel.start->nextel;
-        cpylist.pop();
-        goto NEXTDOCEL;
-    }
+        size_t epos = i+1 < tcount ? tokens[(i+1)*3] :  _Data.size();
+        size_t spos = token[2]+1;
 
-    while(lastel){
-        DocElements *prev=lastel->prevel;
-        lastel->prevel=nullptr;
-        if(!lastel->terminator)
-            lastel->element=nullptr;
-        delete lastel;
-        lastel=prev;
+        if(int(epos - spos) > 0){
+            TextElement *text=new TextElement();
+            text->_Text.assign(_Data.begin()+spos,_Data.begin()+epos);
+            append(text);
+        }
     }
 
-    firstel=nullptr;
+    stack.close(0,[this](const OpenElement&){
+        ++_Errors.UnclosedElements;
+    });
 
+    //nullptr if there is nothing to build, like a document of stray end tags
     return first;
 }
 
-libhtmlpp::Element* libhtmlpp::HtmlString::_buildTree(long& pos) {
-    DocElements *firstEl = nullptr, *lastEl = nullptr;
-
-    auto addelement = [](DocElements **first,DocElements **last){
-        if (!*first) {
-            *first = new DocElements;
-            (*last) = (*first);
-        } else {
-            (*last)->nextel = new DocElements;
-            (*last)->nextel->prevel = *last;
-            (*last) = (*last)->nextel;
-        }
+libhtmlpp::HtmlElement* libhtmlpp::HtmlString::parseLazy(){
+    if(_Frozen)
+        _throwFrozen();
+    _parseTree();
+    _delete(_RootNode);
+    _RootNode=nullptr;
+    _Errors=ParseErrors();
+
+    std::unique_ptr<LazySource> source(new LazySource());
+    //the tokens stay with the tree, the next parse grows a new table
+    source->Data=_Data;
+    source->Tokens.swap(Arena.Tokens);
+    source->Refs=0;
+
+    const char *data=source->Data.data();
+    const long *tokens=source->Tokens.data();
+    long tcount=source->Tokens.size()/3;
+    std::vector<long> &ends=source->Ends;
+    ends.resize(tcount);
+
+    //the tag balance of _buildTree without nodes, elements are only pushed with their token
+    TagStack &stack=Arena.Stack;
+    stack.reset();
+    stack.Ends=ends.data();
+
+    auto misnested=[this](const OpenElement&){
+        ++_Errors.MisnestedTags;
     };
 
-    for(size_t i = 0; i < _HTableSize; ++i) {
-        if(_HTable[i][0] == -1){
+    for(long i=0; i<tcount; ++i){
+        const long *token=&tokens[i*3];
+        stack.Token=i;
+        ends[i]=i;
+
+        if(token[1]!=-1){
+            size_t nend=_nameEnd(data,token[1]+1,token[2]);
+            long idx=stack.find(stack.tagid(data+token[1]+1,nend-token[1]-1,false));
+            if(idx<0){
+                ++_Errors.StrayEndTags;
+            }else{
+                stack.close(idx+1,misnested);
+                stack.close(idx);
+            }
             continue;
         }
+        if((size_t)token[0]+3<source->Data.size() && data[token[0]+1]=='!' &&
+           data[token[0]+2]=='-' && data[token[0]+3]=='-')
+            continue;
 
-        addelement(&firstEl,&lastEl);
+        size_t st=token[0];
+        while(st<(size_t)token[2] && (data[st]=='<' || _attributeTable().Class[(unsigned char)data[st]]==AttrSpace))
+            ++st;
+        size_t et=_nameEnd(data,st,token[2]);
 
-        lastEl->spos = _HTable[i][0];
-        lastEl->epos = _HTable[i][2];
+        int tag=stack.tagid(data+st,et-st,true);
+        stack.implied(tag,misnested);
 
-        if (_HTable[i][1] != -1){
-            lastEl->terminator = true;
-        }
+        bool selfclosing=data[token[2]-1]=='/' && _serialelize(data+token[0],token[2]-token[0]+1,nullptr);
+        if(!selfclosing && !HtmlNames::isVoid(data+st,et-st))
+            stack.push(tag,nullptr,i);
+    }
 
+    stack.Token=tcount;
+    stack.close(0,[this](const OpenElement&){
+        ++_Errors.UnclosedElements;
+    });
+    stack.Ends=nullptr;
 
-        bool comment = false;
+    Element *first=_buildLazy(source.get(),nullptr,-1,tcount);
+    if(source->Refs)
+        source.release();
 
-        if((size_t)lastEl->spos+3<_Data.size()){
-            if(_Data.at(lastEl->spos)=='<' && _Data.at(lastEl->spos+1)=='!' &&
-                _Data.at(lastEl->spos+2)=='-' && _Data.at(lastEl->spos+3)=='-')
-                comment=true;
-        }
+    _RootNode=first;
+    return _firstHtml(_RootNode);
+}
 
-        if(!comment){
-            std::vector<char> el;
-            std::copy(_Data.begin()+lastEl->spos,_Data.begin()+(lastEl->epos+1),std::inserter<std::vector<char>>(el,el.begin()));
-            lastEl->element=new HtmlElement();
+libhtmlpp::Element* libhtmlpp::HtmlString::_buildLazy(LazySource *source,HtmlElement *parent,long first,long end){
+    const char *data=source->Data.data();
+    const long *tokens=source->Tokens.data();
+    long tcount=source->Tokens.size()/3;
 
-            _serialelize(el,(HtmlElement*)lastEl->element);
+    Element *head=nullptr,*last=nullptr;
+
+    auto append=[parent,&head,&last](Element *el){
+        el->_parentElement=parent;
+        if(last){
+            last->_nextElement=el;
+            el->_prevElement=last;
         }else{
-            lastEl->element=new CommentElement();
-            std::copy(_Data.begin()+lastEl->spos+4,_Data.begin()+lastEl->epos-2,
-                        std::inserter<std::vector<char>>(((CommentElement*) lastEl->element)->_Comment,((CommentElement*) lastEl->element)->_Comment.begin()));
+            head=el;
         }
+        last=el;
+    };
 
-        size_t epos = i+1 < _HTableSize ? _HTable[i+1][0] :  _Data.size();
+    //text between token i and the next one, -1 for the text in front of the first tag
+    auto text=[&](long i){
+        size_t spos=i>=0 ? tokens[i*3+2]+1 : 0;
+        size_t epos=i+1<tcount ? tokens[(i+1)*3] : source->Data.size();
+        if(epos<=spos || (i<0 && _blank(data,epos)))
+            return;
+        TextElement *el=new TextElement();
+        el->_Text.assign(data+spos,data+epos);
+        append(el);
+    };
 
-        size_t spos = _HTable[i][2]+1;
+    /*
+     * the tokens up to end are children of parent or inside of them. A child
+     * holds the tokens up to the one it is closed at, that one is an end
+     * tag or a start tag that comes next on this level.
+     */
+    text(first);
+    long i=first+1;
+    while(i<end){
+        const long *token=&tokens[i*3];
+        if(token[1]!=-1){
+            text(i++);
+            continue;
+        }
+        if((size_t)token[0]+3<source->Data.size() && data[token[0]+1]=='!' &&
+           data[token[0]+2]=='-' && data[token[0]+3]=='-'){
+            CommentElement *comment=new CommentElement();
+            comment->_Comment.assign(data+token[0]+4,data+_commentTextEnd(token));
+            append(comment);
+            text(i++);
+            continue;
+        }
 
-        if(int(epos - spos) > 0){
-            addelement(&firstEl,&lastEl);
-            lastEl->element=new TextElement();
-            lastEl->spos = spos;
-            lastEl->epos = epos;
+        HtmlElement *node=new HtmlElement();
+        append(node);
+        _serialelize(data+token[0],token[2]-token[0]+1,node);
 
-            std::copy(_Data.begin()+lastEl->spos,_Data.begin()+lastEl->epos,
-                        std::inserter<std::vector<char>>(((TextElement*) lastEl->element)->_Text,((TextElement*) lastEl->element)->_Text.begin()));
+        long close=source->Ends[i];
+        if(close==i){
+            text(i++);
+            continue;
         }
+        //elements without content stay built
+        size_t cend=close<tcount ? tokens[close*3] : source->Data.size();
+        if(close>i+1 || cend>(size_t)token[2]+1){
+            node->_Lazy=source;
+            node->_LazyToken=i;
+            ++source->Refs;
+        }
+        i=close;
     }
-
-    return _buildtreenode(firstEl,lastEl);
+    return head;
 }
 
-void libhtmlpp::HtmlString::_serialelize(std::vector<char> in, libhtmlpp::HtmlElement *out) {
-    size_t st=0,et=0;
+void libhtmlpp::HtmlElement::_materialize() const{
+    LazySource *source=_Lazy;
+    HtmlElement *self=(HtmlElement*)this;
+    _Lazy=nullptr;
+    self->_childElement=HtmlString::_buildLazy(source,self,_LazyToken,source->Ends[_LazyToken]);
+    _release(source);
+}
 
-    for (size_t i = 0; i < in.size(); ++i) {
-        switch (in[i]) {
-            case '<':
-                continue;
-            case '/':
-                continue;
-            case ' ':
-                continue;
-            default:
-                st=i;
-                goto GETTAGEND;
-        }
+bool libhtmlpp::HtmlElement::_mayContainTag(const char *tag,size_t len) const{
+    if(!_Lazy || !len)
+        return true;
+    const std::vector<long> &tokens=_Lazy->Tokens;
+    long close=_Lazy->Ends[_LazyToken];
+    const char *cur=_Lazy->Data.data()+tokens[_LazyToken*3+2]+1;
+    const char *end=_Lazy->Data.data()+((size_t)close<tokens.size()/3 ? tokens[close*3] : _Lazy->Data.size());
+    while((cur=(const char*)memchr(cur,'<',end-cur))){
+        ++cur;
+        while(cur<end && _attributeTable().Class[(unsigned char)*cur]==AttrSpace)
+            ++cur;
+        if((size_t)(end-cur)>=len && HtmlNames::equals(cur,len,tag,len))
+            return true;
     }
+    return false;
+}
 
-    GETTAGEND:
-    for(et=st; et<in.size(); ++et){
-        if(in[et]==' ' || in[et]=='/' || in[et]=='>' ){
-            break;
-        }
+bool libhtmlpp::HtmlElement::_mayContain(const char *str,size_t len) const{
+    if(!_Lazy || !len)
+        return true;
+    const std::vector<long> &tokens=_Lazy->Tokens;
+    long close=_Lazy->Ends[_LazyToken];
+    const char *cur=_Lazy->Data.data()+tokens[_LazyToken*3+2]+1;
+    const char *end=_Lazy->Data.data()+((size_t)close<tokens.size()/3 ? tokens[close*3] : _Lazy->Data.size());
+    while((size_t)(end-cur)>=len){
+        cur=(const char*)memchr(cur,str[0],end-cur-len+1);
+        if(!cur)
+            return false;
+        if(memcmp(cur,str,len)==0)
+            return true;
+        ++cur;
     }
+    return false;
+}
 
-    std::vector<char> tag;
-
-    std::copy(in.begin()+st,in.begin()+et,std::insert_iterator<std::vector<char>>(tag,tag.begin()) );
-    tag.push_back('\0');
+bool libhtmlpp::HtmlString::_serialelize(const char *in,size_t len,libhtmlpp::HtmlElement *out) {
+    const AttributeTable &tbl=_attributeTable();
 
-    out->setTagname(tag.data());
+    size_t st=0;
+    while(st<len && (in[st]=='<' || tbl.Class[(unsigned char)in[st]]==AttrSpace))
+        ++st;
+    size_t et=_nameEnd(in,st,len);
 
-    if (!out) {
+    if(et==st) {
         HTMLException excp;
         throw excp[HTMLException::Critical] << "no tag in element found!";
     }
+    if(out)
+        out->_TagName.assign(in+st,in+et);
 
-    int startpos =-1,vst=-1;
-    bool value=false;
-    std::vector<char> key;
-
-    while(et < in.size()) {
-        if(in[et]==' ' || in[et]=='>' || in[et]=='=') {
-            if(startpos!=-1 && !value){
-                std::copy(in.begin()+startpos,in.begin()+et,std::insert_iterator<std::vector<char>>(key,key.begin()) );
-                out->setAttribute(key.data(),key.size(),nullptr,0);
-                startpos=-1;
-            }
-            if(in[et]=='='){
-                value=true;
-            }
-        }else if(in[et]=='\"') {
-            if( vst==-1 ){
-                vst=et;
-            }else if(!key.empty() && value){
-                std::vector<char> val;
-                ++vst;
-                std::copy(in.begin()+vst,in.begin()+et,std::insert_iterator<std::vector<char>>(val,val.begin()) );
-                out->setAttribute(key.data(),key.size(),val.data(),val.size());
-                key.clear();
-                vst=-1;
-                value=false;
-            }
+    //adds an attribute, the first of duplicated attributes wins like in browsers.
+    //Values are kept raw, quotes inside single quoted values become entities.
+    auto add=[out](const char *key,size_t klen,const char *value,size_t vlen){
+        if(!out)
+            return;
+        for(HtmlElement::Attributes *cur=out->_firstAttr; cur; cur=cur->_nextAttr){
+            if(cur->_Key.size()==klen && memcmp(cur->_Key.data(),key,klen)==0)
+                return;
+        }
+        HtmlElement::Attributes *attr=new HtmlElement::Attributes();
+        attr->_Key.assign(key,key+klen);
+        const char *quote=vlen ? (const char*)memchr(value,'"',vlen) : nullptr;
+        if(!quote){
+            attr->_Value.assign(value,value+vlen);
         }else{
-            if(startpos==-1 && !value){
-                startpos=et;
+            for(size_t i=0; i<vlen; ++i){
+                if(value[i]=='"')
+                    attr->_Value.insert(attr->_Value.end(),"&quot;","&quot;"+6);
+                else
+                    attr->_Value.push_back(value[i]);
             }
-        };
-        ++et;
-    }
+        }
+        if(out->_lastAttr)
+            out->_lastAttr->_nextAttr=attr;
+        else
+            out->_firstAttr=attr;
+        out->_lastAttr=attr;
+    };
+
+    return _scanAttributes(in,len,et,add);
 }
 
 void libhtmlpp::HtmlString::_parseTree(){
- HTMLException excp;
-    if(_HTable){
-        for(size_t i=0; i< _HTableSize; ++i){
-            delete[] _HTable[i];
+    std::vector<long> &tokens=Arena.Tokens;
+    tokens.clear();
+
+    const char *data=_Data.data();
+    _scanTags(data,_Data.size(),[&tokens,data](long spos,long tpos,long epos){
+        //a < without tag name like <> stays in the text around it
+        if(tpos==-1 && data[spos+1]!='!'){
+            size_t st=spos+1;
+            while(st<(size_t)epos && _attributeTable().Class[(unsigned char)data[st]]==AttrSpace)
+                ++st;
+            if(_nameEnd(data,st,epos)==st)
+                return;
+        }
+        tokens.push_back(spos);
+        tokens.push_back(tpos);
+        tokens.push_back(epos);
+    });
+}
+
+libhtmlpp::HtmlLinkExtractor::HtmlLinkExtractor(){
+}
+
+libhtmlpp::HtmlLinkExtractor::~HtmlLinkExtractor(){
+}
+
+void libhtmlpp::HtmlLinkExtractor::onLink(int tag,int attribute,const char *url,size_t ulen){
+}
+
+void libhtmlpp::HtmlLinkExtractor::extract(const char *data,size_t size,const char *url){
+    const LinkTable &links=_linkTable();
+    const AttributeTable &tbl=_attributeTable();
+
+    _Base.assign(url ? url : "");
+    _Pending.clear();
+    bool based=false;
+
+    _scanTags(data,size,[&](long spos,long tpos,long epos){
+        //end tags, comments and <!DOCTYPE>
+        if(tpos!=-1 || data[spos+1]=='!')
+            return;
+
+        size_t st=spos;
+        while(st<(size_t)epos && (data[st]=='<' || tbl.Class[(unsigned char)data[st]]==AttrSpace))
+            ++st;
+        size_t et=_nameEnd(data,st,epos);
+        int tag=HtmlNames::getTag(data+st,et-st);
+        if(tag<0 || !links.Mask[tag])
+            return;
+
+        //the first of duplicated attributes wins like in the tree
+        const char *values[LinkAttributeCount]={};
+        size_t vlens[LinkAttributeCount];
+        _scanAttributes(data+spos,epos-spos+1,et-spos,
+                        [&](const char *key,size_t klen,const char *value,size_t vlen){
+            int attr=HtmlNames::getAttribute(key,klen);
+            for(int i=0; i<LinkAttributeCount; ++i){
+                if(attr==links.Attribute[i] && (links.Mask[tag] & (1<<i)) && !values[i]){
+                    values[i]=value ? value : key;
+                    vlens[i]=vlen;
+                }
+            }
+        });
+
+        if(tag==links.Base){
+            if(based || !values[LinkHref])
+                return;
+            //the base is resolved against the page itself, an empty one is the page
+            const char *href=values[LinkHref];
+            size_t hlen=vlens[LinkHref];
+            if(memchr(href,'&',hlen)){
+                _Decoded.clear();
+                HtmlDecode(href,hlen,&_Decoded);
+                href=_Decoded.data();
+                hlen=_Decoded.size();
+            }
+            if(_resolve(href,hlen))
+                _Base=_Url;
+            based=true;
+            for(const PendingLink &link : _Pending)
+                _link(link.Tag,link.Attribute,data+link.Offset,link.Size);
+            _Pending.clear();
+            return;
         }
-        delete[] _HTable;
+
+        for(int i=0; i<LinkAttributeCount; ++i){
+            if(!values[i] || !vlens[i])
+                continue;
+            if(based)
+                _link(tag,i,values[i],vlens[i]);
+            else
+                _Pending.push_back({tag,i,(size_t)(values[i]-data),vlens[i]});
+        }
+    });
+
+    for(const PendingLink &link : _Pending)
+        _link(link.Tag,link.Attribute,data+link.Offset,link.Size);
+    _Pending.clear();
+}
+
+void libhtmlpp::HtmlLinkExtractor::_link(int tag,int attribute,const char *value,size_t vlen){
+    if(memchr(value,'&',vlen)){
+        _Decoded.clear();
+        HtmlDecode(value,vlen,&_Decoded);
+        value=_Decoded.data();
+        vlen=_Decoded.size();
     }
 
-    size_t closetag = 0;
-    for (size_t i = 0; i < _Data.size(); ++i) {
-        switch (_Data[i]) {
-            case HTMLTAG_CLOSE:
-                ++closetag;
-            break;
-        default:
+    int id=_linkTable().Attribute[attribute];
+    if(attribute!=LinkSrcset){
+        _emit(tag,id,value,vlen);
+        return;
+    }
+
+    //candidates are an url and descriptors up to a comma outside of parentheses
+    size_t i=0;
+    while(i<vlen){
+        while(i<vlen && (_urlSpace(value[i]) || value[i]==','))
+            ++i;
+        size_t ust=i;
+        while(i<vlen && !_urlSpace(value[i]))
+            ++i;
+        size_t uet=i;
+        bool descriptors=true;
+        while(uet>ust && value[uet-1]==','){
+            --uet;
+            descriptors=false;
+        }
+        if(uet>ust)
+            _emit(tag,id,value+ust,uet-ust);
+        if(!descriptors)
+            continue;
+        int parens=0;
+        while(i<vlen && (value[i]!=',' || parens)){
+            if(value[i]=='(')
+                ++parens;
+            else if(value[i]==')' && parens)
+                --parens;
+            ++i;
+        }
+    }
+}
+
+void libhtmlpp::HtmlLinkExtractor::_emit(int tag,int attribute,const char *ref,size_t rlen){
+    if(_resolve(ref,rlen))
+        onLink(tag,attribute,_Url.data(),_Url.size());
+}
+
+bool libhtmlpp::HtmlLinkExtractor::_resolve(const char *ref,size_t rlen){
+    while(rlen && (unsigned char)*ref<=' '){
+        ++ref;
+        --rlen;
+    }
+    while(rlen && (unsigned char)ref[rlen-1]<=' ')
+        --rlen;
+    if(!rlen)
+        return false;
+
+    //browsers ignore tabs and newlines in urls
+    for(size_t i=0; i<rlen; ++i){
+        if(ref[i]=='\t' || ref[i]=='\n' || ref[i]=='\r'){
+            _Ref.clear();
+            for(size_t ii=0; ii<rlen; ++ii){
+                if(ref[ii]!='\t' && ref[ii]!='\n' && ref[ii]!='\r')
+                    _Ref.push_back(ref[ii]);
+            }
+            ref=_Ref.data();
+            rlen=_Ref.size();
             break;
         }
     }
 
-    _HTableSize = closetag;
+    _Url.clear();
+    resolve(_Base.data(),_Base.size(),ref,rlen,_Url);
+    return true;
+}
 
-    _HTable = new long*[_HTableSize];
-    for (size_t is = 0; is < _HTableSize; is++) {
-        _HTable[is] = new long[3];
-        _HTable[is][0] = -1;
-        _HTable[is][1] = -1;
-        _HTable[is][2] = -1;
+void libhtmlpp::HtmlLinkExtractor::resolve(const char *base,size_t blen,const char *ref,size_t rlen,
+                                          std::string &out){
+    UrlParts rp,bp;
+    _urlParts(ref,rlen,rp);
+    _urlParts(base,blen,bp);
+
+    if(!rp.SchemeEnd && !bp.SchemeEnd){
+        out.append(ref,rlen);
+        return;
     }
 
-    bool open=false;
-    bool pterm=false;
-    size_t ip=0;
-    for(size_t ii=0; ii<_Data.size(); ++ii){
-        switch(_Data[ii]){
-            case HTMLTAG_OPEN:
-                if(!open){
-                    open = true;
-                    pterm = true;
-                    _HTable[ip][0] = ii;
-                }
-                break;
-            case HTMLTAG_TERMINATE:
-                if(pterm==true)
-                    _HTable[ip][1]=ii;
-                break;
-            case HTMLTAG_CLOSE:
-                if(open){
-                    _HTable[ip][2] = ii;
-                    ++ip;
-                    open = false;
-                }
-                break;
-            case ' ':
-                break;
-            default:
-                pterm=false;
-                break;
+    size_t pstart;
+    if(rp.SchemeEnd){
+        out.append(ref,rp.PathStart);
+        pstart=out.size();
+    }else if(rp.Authority){
+        out.append(base,bp.SchemeEnd+1).append(ref,rp.PathStart);
+        pstart=out.size();
+    }else if(rp.PathStart==rp.QueryStart){
+        //only a query or a fragment, the path of the base stays as it is
+        out.append(base,bp.QueryStart);
+        if(rp.QueryStart==rp.FragmentStart)
+            out.append(base+bp.QueryStart,bp.FragmentStart-bp.QueryStart);
+        out.append(ref+rp.QueryStart,rlen-rp.QueryStart);
+        return;
+    }else{
+        out.append(base,bp.PathStart);
+        pstart=out.size();
+        if(ref[rp.PathStart]!='/'){
+            //relative paths start in the directory of the base
+            if(bp.Authority && bp.PathStart==bp.QueryStart){
+                out.push_back('/');
+            }else{
+                size_t dir=bp.QueryStart;
+                while(dir>bp.PathStart && base[dir-1]!='/')
+                    --dir;
+                out.append(base+bp.PathStart,dir-bp.PathStart);
+            }
         }
     }
+    out.append(ref+rp.PathStart,rp.QueryStart-rp.PathStart);
+    out.resize(pstart+_removeDots(&out[pstart],out.size()-pstart));
+    out.append(ref+rp.QueryStart,rlen-rp.QueryStart);
 }
 
 void libhtmlpp::HtmlEncode(const char* input, std::string &output){
@@ -580,27 +1644,115 @@ void libhtmlpp::HtmlEncode(const char* input, std::string &output){
 }
 
 void libhtmlpp::HtmlEncode(const char* input, HtmlString* output){
-    size_t ilen=strlen(input);
+    HtmlEncode(input,strlen(input),output);
+}
+
+void libhtmlpp::HtmlEncode(const char* input,size_t ilen, HtmlString* output){
+    //index of the replacement in HtmlSigns for every byte, -1 if unchanged
+    static const struct SignTable {
+        signed char sign[256];
+        SignTable(){
+            memset(sign,-1,sizeof(sign));
+            for(size_t ii=0; HtmlSigns[ii][0]; ++ii)
+                sign[(unsigned char)HtmlSigns[ii][0][0]]=ii;
+        }
+    } table;
+
+    size_t start=0;
     for(size_t i=0; i<ilen; ++i){
-        size_t ii=0;
-        bool changed=false;
-        while(HtmlSigns[ii][0]){
-            if(input[i]==HtmlSigns[ii][0][0]){
-                output->append(HtmlSigns[ii][1]);
-                changed=true;
+        signed char ii=table.sign[(unsigned char)input[i]];
+        if(ii<0)
+            continue;
+        output->append(input+start,i-start);
+        output->append(HtmlSigns[(size_t)ii][1]);
+        start=i+1;
+    }
+    output->append(input+start,ilen-start);
+}
+
+
+void libhtmlpp::HtmlDecode(const char* input,size_t ilen, HtmlString* output){
+    size_t start=0;
+    for(size_t i=0; i<ilen; ++i){
+        if(input[i]!='&')
+            continue;
+
+        const char *end=(const char*)memchr(input+i,';',std::min<size_t>(ilen-i,12));
+        if(!end)
+            continue;
+        const char *ent=input+i+1;
+        size_t elen=end-ent;
+
+        char utf8[4];
+        size_t ulen=0;
+
+        if(elen>1 && ent[0]=='#'){
+            unsigned long cp=0;
+            bool valid=true;
+            if(ent[1]=='x' || ent[1]=='X'){
+                valid=elen>2;
+                for(size_t ii=2; ii<elen && valid; ++ii){
+                    char c=ent[ii];
+                    if(c>='0' && c<='9')
+                        cp=cp*16+(c-'0');
+                    else if((c|0x20)>='a' && (c|0x20)<='f')
+                        cp=cp*16+((c|0x20)-'a'+10);
+                    else
+                        valid=false;
+                }
+            }else{
+                for(size_t ii=1; ii<elen && valid; ++ii){
+                    if(ent[ii]>='0' && ent[ii]<='9')
+                        cp=cp*10+(ent[ii]-'0');
+                    else
+                        valid=false;
+                }
+            }
+            if(!valid || cp==0 || cp>0x10FFFF || (cp>=0xD800 && cp<=0xDFFF))
+                continue;
+            if(cp<0x80){
+                utf8[ulen++]=cp;
+            }else if(cp<0x800){
+                utf8[ulen++]=0xC0|(cp>>6);
+                utf8[ulen++]=0x80|(cp&0x3F);
+            }else if(cp<0x10000){
+                utf8[ulen++]=0xE0|(cp>>12);
+                utf8[ulen++]=0x80|((cp>>6)&0x3F);
+                utf8[ulen++]=0x80|(cp&0x3F);
+            }else{
+                utf8[ulen++]=0xF0|(cp>>18);
+                utf8[ulen++]=0x80|((cp>>12)&0x3F);
+                utf8[ulen++]=0x80|((cp>>6)&0x3F);
+                utf8[ulen++]=0x80|(cp&0x3F);
+            }
+        }else if(elen==4 && memcmp(ent,"nbsp",4)==0){
+            utf8[ulen++]=(char)0xC2;
+            utf8[ulen++]=(char)0xA0;
+        }else{
+            for(size_t ii=0; HtmlSigns[ii][0]; ++ii){
+                if(strlen(HtmlSigns[ii][1])==elen+2 && memcmp(HtmlSigns[ii][1]+1,ent,elen)==0){
+                    utf8[ulen++]=HtmlSigns[ii][0][0];
+                    break;
+                }
             }
-            ++ii;
+            if(ulen==0)
+                continue;
         }
-        if(!changed)
-            output->push_back(input[i]);
+
+        output->append(input+start,i-start);
+        output->append(utf8,ulen);
+        i=end-input;
+        start=i+1;
     }
+    output->append(input+start,ilen-start);
 }
 
-
 libhtmlpp::HtmlElement::HtmlElement(const char *tagname) : Element(){
     _childElement=nullptr;
     _firstAttr=nullptr;
     _lastAttr=nullptr;
+    _Lazy=nullptr;
+    _LazyToken=0;
     _Type=HtmlEl;
     std::copy(tagname,tagname+strlen(tagname),std::insert_iterator<std::vector<char>>(_TagName,_TagName.begin()) );
 }
@@ -609,6 +1761,8 @@ libhtmlpp::HtmlElement::HtmlElement() : Element() {
     _childElement=nullptr;
     _firstAttr=nullptr;
     _lastAttr=nullptr;
+    _Lazy=nullptr;
+    _LazyToken=0;
     _Type=HtmlEl;
 }
 
@@ -621,6 +1775,9 @@ libhtmlpp::HtmlElement::HtmlElement(const libhtmlpp::HtmlElement* hel) : HtmlEle
 }
 
 libhtmlpp::HtmlElement::~HtmlElement(){
+    if(_Lazy)
+        _release(_Lazy);
+    _delete(_childElement);
     Attributes *cura=_firstAttr;
     while(cura){
         Attributes *next=cura->_nextAttr;
@@ -631,44 +1788,51 @@ libhtmlpp::HtmlElement::~HtmlElement(){
 }
 
 void libhtmlpp::HtmlElement::setTagname(const char* name){
-    std::copy(name,name+strlen(name),std::insert_iterator<std::vector<char>>(_TagName,_TagName.begin()) );
+    if(_Frozen)
+        _throwFrozen();
+    _TagName.assign(name,name+strlen(name));
+    _markDirty();
 }
 
-const char* libhtmlpp::HtmlElement::getTagname(){
+const char* libhtmlpp::HtmlElement::getTagname() const{
+    if(_Frozen)
+        return _CStr.data();
     _CStr=_TagName;
     _CStr.push_back('\0');
     return _CStr.data();
 }
 
 void libhtmlpp::HtmlElement::insertChild(libhtmlpp::Element* el){
-    if(_childElement){
-        delete _childElement;
-        _childElement=nullptr;
-    }
-    if(el->getType()==HtmlEl)
-        _childElement=new HtmlElement;
-    else if(el->getType()==TextEl)
-        _childElement=new TextElement;
+    if(_Frozen)
+        _throwFrozen();
+    if(_Lazy){
+        _release(_Lazy);
+        _Lazy=nullptr;
+    }
+    _delete(_childElement);
+    _childElement=nullptr;
+    _childElement=_newElement(el->getType());
+    _childElement->_parentElement=this;
     _copy(_childElement,el);
+    _markDirty();
 }
 
 void libhtmlpp::HtmlElement::appendChild(libhtmlpp::Element* el){
-    if(_childElement){
+    if(_Frozen)
+        _throwFrozen();
+    if(_children()){
         Element *curel=_childElement,*prev=nullptr;
         do{
             prev=curel;
             curel=curel->nextElement();
         }while(curel);
 
-        if(el->getType()==HtmlEl)
-            curel=new HtmlElement;
-        else if(el->getType()==TextEl)
-            curel=new TextElement;
-        if(prev){
-            prev->_nextElement=curel;
-            curel->_prevElement=prev;
-        }
+        curel=_newElement(el->getType());
+        curel->_parentElement=this;
+        prev->_nextElement=curel;
+        curel->_prevElement=prev;
         _copy(curel,el);
+        prev->_markDirty();
     }else{
         insertChild(el);
     }
@@ -712,6 +1876,9 @@ namespace libhtmlpp {
         const libhtmlpp::Element* prev=nullptr;
         if(!src || !dest)
             return;
+        if(dest->_Frozen)
+            _throwFrozen();
+        dest->_markDirty();
         struct cpyel {
             cpyel(){
 
@@ -732,7 +1899,11 @@ namespace libhtmlpp {
 
 NEWEL:
         if(src->getType()==libhtmlpp::HtmlEl && dest->getType()==libhtmlpp::HtmlEl){
-            ((libhtmlpp::HtmlElement*)dest)->setTagname(((libhtmlpp::HtmlElement*)src)->getTagname());
+            if(((libhtmlpp::HtmlElement*)dest)->_Lazy){
+                _release(((libhtmlpp::HtmlElement*)dest)->_Lazy);
+                ((libhtmlpp::HtmlElement*)dest)->_Lazy=nullptr;
+            }
+            ((libhtmlpp::HtmlElement*)dest)->_TagName=((libhtmlpp::HtmlElement*)src)->_TagName;
             for(libhtmlpp::HtmlElement::Attributes *cattr=((libhtmlpp::HtmlElement*)src)->_firstAttr; cattr; cattr=cattr->_nextAttr){
                 if(!cattr->_Value.empty())
                     ((libhtmlpp::HtmlElement*)dest)->setAttribute(cattr->_Key.data(),cattr->_Key.size(),cattr->_Value.data(),cattr->_Value.size());
@@ -740,17 +1911,12 @@ NEWEL:
                     ((libhtmlpp::HtmlElement*)dest)->setAttribute(cattr->_Key.data(),cattr->_Key.size(),nullptr,0);
             }
 
-            if(((libhtmlpp::HtmlElement*)src)->_childElement){
-                if(((libhtmlpp::HtmlElement*)src)->_childElement->getType()==HtmlEl){
-                    ((libhtmlpp::HtmlElement*)dest)->_childElement= new HtmlElement;
-                }else if(((libhtmlpp::HtmlElement*)src)->_childElement->getType()==TextEl){
-                    ((libhtmlpp::HtmlElement*)dest)->_childElement = new TextElement;
-                }else if(((libhtmlpp::HtmlElement*)src)->_childElement->getType()==CommentEl){
-                    ((libhtmlpp::HtmlElement*)dest)->_childElement = new CommentElement;
-                }
+            if(((libhtmlpp::HtmlElement*)src)->_children()){
+                ((libhtmlpp::HtmlElement*)dest)->_childElement=_newElement(((libhtmlpp::HtmlElement*)src)->_children()->getType());
+                ((libhtmlpp::HtmlElement*)dest)->_childElement->_parentElement=dest;
                 cpyel childel;
                 childel.destin=((libhtmlpp::HtmlElement*)dest)->_childElement;;
-                childel.source=((libhtmlpp::HtmlElement*)src)->_childElement;
+                childel.source=((libhtmlpp::HtmlElement*)src)->_children();
                 cpylist.push(childel);
             }
         }else if(src->getType()==libhtmlpp::TextEl && dest->getType()== libhtmlpp::TextEl){
@@ -765,12 +1931,8 @@ NEWEL:
         Element* next=src->nextElement();
 
         if(next){
-            if(next->getType()==HtmlEl)
-                dest->_nextElement= new HtmlElement();
-            else if(next->getType()==TextEl)
-                dest->_nextElement= new TextElement();
-            else if(next->getType()==CommentEl)
-                dest->_nextElement= new CommentElement();
+            dest->_nextElement=_newElement(next->getType());
+            dest->_nextElement->_parentElement=dest->_parentElement;
              prev=dest;
              src=next;
              dest=dest->_nextElement;
@@ -791,46 +1953,193 @@ NEWEL:
 };
 
 void libhtmlpp::Element::insertBefore(libhtmlpp::Element* el){
-    if(el->getType()==HtmlEl){
-        HtmlElement *nel=new HtmlElement();
-        _copy(nel,el);
+    if(_Frozen)
+        _throwFrozen();
+
+    if(!_prevElement && !_parentElement){
+        HTMLException excp;
+        excp[HTMLException::Error] << "insertBefore: can't insert before the first element of a document!";
+        throw excp;
+    }
+
+    Element *nel=_newElement(el->getType()),*last=nel;
+    nel->_parentElement=_parentElement;
+    _copy(nel,el);
+
+    while(last->_nextElement)
+        last=last->_nextElement;
+
+    nel->_prevElement=_prevElement;
+    if(_prevElement){
         _prevElement->_nextElement=nel;
-    }else if(el->getType()==TextEl){
-        TextElement *txt= new TextElement;
-        _copy(txt,el);
-        _prevElement->_nextElement=txt;
+    }else{
+        ((HtmlElement*)_parentElement)->_childElement=nel;
+        _parentElement->_markDirty();
     }
-    Element *nexel=_prevElement->_nextElement,*prev=nullptr;
+    last->_nextElement=this;
+    _prevElement=last;
+}
+
+void libhtmlpp::Element::insertAfter(libhtmlpp::Element* el){
+    if(_Frozen)
+        _throwFrozen();
+
+    Element *nel=_newElement(el->getType()),*last=nel;
+    nel->_parentElement=_parentElement;
+    _copy(nel,el);
+
+    while(last->_nextElement)
+        last=last->_nextElement;
+
+    last->_nextElement=_nextElement;
+    if(_nextElement)
+        _nextElement->_prevElement=last;
+    _nextElement=nel;
+    nel->_prevElement=this;
+    _markDirty();
+}
+
+namespace libhtmlpp {
+    static void _unlink(Element *el){
+        if(el->isFrozen() || (el->parentElement() && el->parentElement()->isFrozen()))
+            _throwFrozen();
 
-    while(nexel){
-        prev=nexel;
-        nexel=nexel->nextElement();
+        if(!el->prevElement() && !el->parentElement()){
+            HTMLException excp;
+            excp[HTMLException::Error] << "detach: can't detach the first element of a document!";
+            throw excp;
+        }
     }
+};
 
-    nexel=this;
-    _prevElement=prev;
+libhtmlpp::Element *libhtmlpp::Element::detach(){
+    _unlink(this);
+
+    if(_prevElement){
+        _prevElement->_nextElement=_nextElement;
+        _prevElement->_markDirty();
+    }else{
+        ((HtmlElement*)_parentElement)->_childElement=_nextElement;
+        _parentElement->_markDirty();
+    }
+    if(_nextElement)
+        _nextElement->_prevElement=_prevElement;
+
+    _prevElement=nullptr;
+    _nextElement=nullptr;
+    _parentElement=nullptr;
+    return this;
 }
 
-void libhtmlpp::Element::insertAfter(libhtmlpp::Element* el){
-    Element *nexel=nullptr,*prev=_nextElement;
+void libhtmlpp::Element::remove(){
+    _delete(detach());
+}
 
-    if(el->getType()==HtmlEl){
-        _nextElement= new HtmlElement;
+libhtmlpp::Element *libhtmlpp::Element::replaceWith(Element* el){
+    _unlink(this);
 
-    }else if(el->getType()==TextEl){
-        _nextElement= new TextElement;
+    Element *nel=_newElement(el->getType()),*last=nel;
+    nel->_parentElement=_parentElement;
+    try{
+        _copy(nel,el);
+    }catch(...){
+        _delete(nel);
+        throw;
     }
 
-    _copy(_nextElement,el);
+    while(last->_nextElement)
+        last=last->_nextElement;
+
+    nel->_prevElement=_prevElement;
+    if(_prevElement)
+        _prevElement->_nextElement=nel;
+    else
+        ((HtmlElement*)_parentElement)->_childElement=nel;
+    last->_nextElement=_nextElement;
+    if(_nextElement)
+        _nextElement->_prevElement=last;
+
+    _prevElement=nullptr;
+    _nextElement=nullptr;
+    _parentElement=nullptr;
+    _delete(this);
+    return nel;
+}
+
+namespace libhtmlpp {
+    #define NODEPOOL_BUCKETS 4
+    #define NODEPOOL_MAX     65536
+
+    /*
+     * deleted nodes of a thread by size. Filters that remove elements and
+     * insert others, and repeated parse() calls, take their nodes from here
+     * instead of the heap. Every list keeps at most NODEPOOL_MAX nodes.
+     */
+    struct NodePool {
+        struct Bucket {
+            size_t Size;
+            void  *Free;
+            size_t Count;
+        };
+
+        Bucket Buckets[NODEPOOL_BUCKETS];
+
+        ~NodePool();
+    };
 
-    nexel=_nextElement;
+    static thread_local NodePool Pool;
+    //nodes deleted in destructors running after the pool of the thread go to the heap
+    static thread_local bool     PoolDestroyed=false;
 
-    while(nexel){
-        nexel=nexel->nextElement();
+    NodePool::~NodePool(){
+        for(size_t i=0; i<NODEPOOL_BUCKETS; ++i){
+            while(Buckets[i].Free){
+                void *next=*(void**)Buckets[i].Free;
+                ::operator delete(Buckets[i].Free);
+                Buckets[i].Free=next;
+            }
+        }
+        PoolDestroyed=true;
     }
 
-    nexel=prev;
+    static inline NodePool::Bucket *_bucket(size_t size){
+        if(PoolDestroyed)
+            return nullptr;
+        for(size_t i=0; i<NODEPOOL_BUCKETS; ++i){
+            NodePool::Bucket &bucket=Pool.Buckets[i];
+            if(bucket.Size==size)
+                return &bucket;
+            if(bucket.Size==0){
+                bucket.Size=size;
+                return &bucket;
+            }
+        }
+        return nullptr;
+    }
+};
 
+void *libhtmlpp::Element::operator new(size_t size){
+    NodePool::Bucket *bucket=_bucket(size);
+    if(bucket && bucket->Free){
+        void *node=bucket->Free;
+        bucket->Free=*(void**)node;
+        --bucket->Count;
+        return node;
+    }
+    return ::operator new(size);
+}
+
+void libhtmlpp::Element::operator delete(void *ptr,size_t size){
+    if(!ptr)
+        return;
+    NodePool::Bucket *bucket=_bucket(size);
+    if(!bucket || bucket->Count>=NODEPOOL_MAX){
+        ::operator delete(ptr);
+        return;
+    }
+    *(void**)ptr=bucket->Free;
+    bucket->Free=ptr;
+    ++bucket->Count;
 }
 
 libhtmlpp::Element& libhtmlpp::Element::operator=(const Element &hel){
@@ -851,22 +2160,48 @@ libhtmlpp::Element *libhtmlpp::Element::prevElement() const{
     return _prevElement;
 }
 
+libhtmlpp::Element *libhtmlpp::Element::parentElement() const{
+    return _parentElement;
+}
+
+void libhtmlpp::Element::_markDirty(){
+    for(Element *curel=this; curel && !curel->_Dirty; curel=curel->_parentElement){
+        curel->_Dirty=true;
+    }
+}
+
 int libhtmlpp::Element::getType() const{
     return _Type;
 }
 
+bool libhtmlpp::Element::isFrozen() const{
+    return _Frozen;
+}
+
 libhtmlpp::Element::Element(){
     _prevElement=nullptr;
     _nextElement=nullptr;
+    _parentElement=nullptr;
     _firstElement=nullptr;
     _Type=-1;
+    _Frozen=false;
+    _Dirty=false;
+    _RenderId=0;
+    _RenderOffset=0;
+    _RenderSize=0;
 }
 
 libhtmlpp::Element::Element(const libhtmlpp::Element& el){
     _prevElement=nullptr;
     _nextElement=nullptr;
+    _parentElement=nullptr;
     _firstElement=nullptr;
     _Type=-1;
+    _Frozen=false;
+    _Dirty=false;
+    _RenderId=0;
+    _RenderOffset=0;
+    _RenderSize=0;
     _copy(this,&el);
 }
 
@@ -905,11 +2240,15 @@ libhtmlpp::TextElement & libhtmlpp::TextElement::operator=(const libhtmlpp::Elem
 }
 
 void libhtmlpp::TextElement::setText(const char* txt){
-    std::copy(txt,txt+strlen(txt),
-              std::insert_iterator<std::vector<char>>(_Text,_Text.begin()));
+    if(_Frozen)
+        _throwFrozen();
+    _Text.assign(txt,txt+strlen(txt));
+    _markDirty();
 }
 
-const char * libhtmlpp::TextElement::getText(){
+const char * libhtmlpp::TextElement::getText() const{
+    if(_Frozen)
+        return _CStr.data();
     _CStr=_Text;
     _CStr.push_back('\0');
     return _CStr.data();
@@ -938,11 +2277,15 @@ libhtmlpp::CommentElement & libhtmlpp::CommentElement::operator=(const libhtmlpp
 }
 
 void libhtmlpp::CommentElement::setComment(const char* txt){
-    std::copy(txt,txt+strlen(txt),
-              std::insert_iterator<std::vector<char>>(_Comment,_Comment.begin()));
+    if(_Frozen)
+        _throwFrozen();
+    _Comment.assign(txt,txt+strlen(txt));
+    _markDirty();
 }
 
-const char * libhtmlpp::CommentElement::getComment(){
+const char * libhtmlpp::CommentElement::getComment() const{
+    if(_Frozen)
+        return _CStr.data();
     _CStr=_Comment;
     _CStr.push_back('\0');
     return _CStr.data();
@@ -950,6 +2293,7 @@ const char * libhtmlpp::CommentElement::getComment(){
 
 
 libhtmlpp::HtmlPage::HtmlPage(){
+    _Encoding=HtmlCharset::Unknown;
 }
 
 libhtmlpp::HtmlPage::~HtmlPage(){
@@ -971,34 +2315,49 @@ libhtmlpp::HtmlElement *libhtmlpp::HtmlPage::loadFile(const char* path){
         data.append(tmp,fs.gcount());
     }
     fs.close();
-    _CheckHeader(data);
-    libhtmlpp::HtmlElement *el=loadString(data);
-    return el;
+    _load(data.data(),data.size());
+    _CheckHeader(_Page);
+    return _Page.parse();
 }
 
 libhtmlpp::HtmlElement *libhtmlpp::HtmlPage::loadString(const std::string &src){
-    _Page=src.c_str();
+    _load(src.data(),src.size());
     return _Page.parse();
 }
 
 libhtmlpp::HtmlElement *libhtmlpp::HtmlPage::loadString(const char *src){
-    _Page=src;
+    _load(src,strlen(src));
     return _Page.parse();
 }
 
 libhtmlpp::HtmlElement *libhtmlpp::HtmlPage::loadString(const HtmlString &node){
+    _load(node.data(),node.size());
     return _Page.parse();
 }
 
 libhtmlpp::HtmlElement *libhtmlpp::HtmlPage::loadString(const HtmlString *node){
-    return _Page.parse();
+    return loadString(*node);
+}
+
+int libhtmlpp::HtmlPage::getEncoding() const{
+    return _Encoding;
+}
+
+void libhtmlpp::HtmlPage::_load(const char *data,size_t size){
+    HtmlCharsetDecoder decoder;
+    _Page.clear();
+    decoder.decode(data,size,_Page);
+    _Encoding=decoder.getEncoding();
 }
 
 void libhtmlpp::HtmlPage::saveFile(const char* path){
     HtmlString data;
     std::ofstream fs;
 
-    print(_Page.parse(),data);
+    if(!_Page._RootNode)
+        _Page.parse();
+    if(_Page._RootNode)
+        print(_Page._RootNode,data);
 
     try{
         fs.open(path);
@@ -1053,161 +2412,691 @@ void libhtmlpp::HtmlPage::_CheckHeader(const HtmlString &page){
 }
 
 void libhtmlpp::print(Element* el, HtmlString &output) {
-
-    std::stack<libhtmlpp::Element*> cpylist;
-
-PRINTNEXTEL:
-    switch(el->_Type){
-        case HtmlEl:{
-            output.append("<");
-            output.append(((HtmlElement*) el)->getTagname());
-            for (HtmlElement::Attributes* curattr = ((HtmlElement*) el)->_firstAttr; curattr; curattr = curattr->_nextAttr) {
-                output.append(" ");
-                output.append(curattr->_Key.data(),curattr->_Key.size());
-                if(!curattr->_Value.empty()){
-                    output.append("=\"");
-                    output.append(curattr->_Value.data(),curattr->_Value.size());
-                    output.append("\"");
+    auto enter=[&output](Element *el){
+        switch(el->_Type){
+            case HtmlEl:{
+                HtmlElement *hel=(HtmlElement*)el;
+                output.append("<");
+                output.append(hel->_TagName.data(),hel->_TagName.size());
+                for (HtmlElement::Attributes* curattr = hel->_firstAttr; curattr; curattr = curattr->_nextAttr) {
+                    output.append(" ");
+                    output.append(curattr->_Key.data(),curattr->_Key.size());
+                    if(!curattr->_Value.empty()){
+                        output.append("=\"");
+                        output.append(curattr->_Value.data(),curattr->_Value.size());
+                        output.append("\"");
+                    }
                 }
-            }
-            if(((HtmlElement*) el)->_childElement || el->_nextElement ){
-                output.append(">");
-            }else{
-                output.append(" />");
-            }
-            if (((HtmlElement*) el)->_childElement) {
-                cpylist.push(el);
-                el=((HtmlElement*) el)->_childElement;
-                goto PRINTNEXTEL;
-            }
+                if(hel->_children()){
+                    output.append(">");
+                }else if(!HtmlNames::isVoid(hel->_TagName.data(),hel->_TagName.size())){
+                    output.append("></");
+                    output.append(hel->_TagName.data(),hel->_TagName.size());
+                    output.append(">");
+                }else if(el->_nextElement){
+                    output.append(">");
+                }else{
+                    output.append(" />");
+                }
+            }break;
+            case TextEl:
+                output.append(((TextElement*)el)->_Text.data(),((TextElement*)el)->_Text.size());
+                break;
+            case CommentEl:
+                output.append("<!--");
+                output.append(((CommentElement*)el)->_Comment.data(),((CommentElement*)el)->_Comment.size());
+                output.append("-->");
+                break;
+            default:
+                HTMLException excp;
+                excp[HTMLException::Error] << "Unkown Elementtype";
+                throw excp;
+        }
+        return (int)ElementVisitor::Continue;
+    };
 
-            if (el->_nextElement) {
-                el=el->_nextElement;
-                goto PRINTNEXTEL;
-            }
+    //end tags of the elements with children on the way up
+    auto leave=[&output](Element *el){
+        if(el->_Type==HtmlEl && ((HtmlElement*)el)->_children()){
+            output.append("</");
+            output.append(((HtmlElement*)el)->_TagName.data(),((HtmlElement*)el)->_TagName.size());
+            output.append(">");
+        }
+        return (int)ElementVisitor::Continue;
+    };
 
-            while(!cpylist.empty()){
-                el=cpylist.top();
+    _walk(el,enter,leave);
+}
 
-                output.append("</");
-                output.append(((HtmlElement*) el)->getTagname());
-                output.append(">");
+namespace libhtmlpp {
+    //whitespace next to these elements doesn't render
+    static const char *BlockElements[]={
+        "address","article","aside","blockquote","body","br","caption","dd",
+        "details","dialog","div","dl","dt","fieldset","figcaption","figure",
+        "footer","form","h1","h2","h3","h4","h5","h6","header","hgroup","hr",
+        "li","main","nav","ol","option","p","pre","section","table","tbody",
+        "td","tfoot","th","thead","title","tr","ul",nullptr
+    };
 
-                cpylist.pop();
-                if(el->_nextElement){
-                    el=el->_nextElement;
-                    goto PRINTNEXTEL;
-                }
-            }
-        }break;
+    //elements with only elements as rendered content
+    static const char *ElementOnlyElements[]={
+        "colgroup","datalist","dl","head","html","ol","optgroup","select",
+        "table","tbody","tfoot","thead","tr","ul",nullptr
+    };
 
-        case TextEl :{
-            output.append(((TextElement*)el)->_Text.data(),((TextElement*)el)->_Text.size());
+    static const char *PreserveElements[]={
+        "pre","script","style","textarea",nullptr
+    };
 
-            if (el->_nextElement) {
-                el=el->_nextElement;
-                goto PRINTNEXTEL;
-            }
+    static const char *BooleanAttributes[]={
+        "allowfullscreen","async","autofocus","autoplay","checked","controls",
+        "default","defer","disabled","formnovalidate","hidden","inert","ismap",
+        "itemscope","loop","multiple","muted","nomodule","novalidate","open",
+        "playsinline","readonly","required","reversed","selected",nullptr
+    };
+
+    static const char *_nameIn(const std::vector<char> &name,const char **list){
+        for(size_t i=0; list[i]; ++i){
+            if(HtmlTokenizer::isName(name.data(),name.size(),list[i]))
+                return list[i];
+        }
+        return nullptr;
+    }
 
-            while(!cpylist.empty()){
-                el=cpylist.top();
+    static inline bool _htmlSpace(char c){
+        return c==' ' || c=='\t' || c=='\n' || c=='\r' || c=='\f';
+    }
+};
 
-                output.append("</");
-                output.append(((HtmlElement*) el)->_TagName.data(),((HtmlElement*) el)->_TagName.size());
-                output.append(">");
+void libhtmlpp::print(Element* el, HtmlString &output, bool minify) {
+    if(!minify){
+        print(el,output);
+        return;
+    }
 
-                cpylist.pop();
-                if(el->_nextElement){
-                    el=el->_nextElement;
-                    goto PRINTNEXTEL;
+    std::vector<HtmlElement*> parents;
+    CssMinifier css;
+    size_t preserve=0;
+    //the output ends with whitespace of a text
+    bool space=false;
+
+    //true if whitespace between a text and its sibling doesn't render
+    auto boundary=[](const Element *sibling,const HtmlElement *parent){
+        if(sibling)
+            return sibling->_Type==HtmlEl &&
+                _nameIn(((const HtmlElement*)sibling)->_TagName,BlockElements);
+        return !parent || _nameIn(parent->_TagName,BlockElements);
+    };
+
+    for(;;){
+        switch(el->_Type){
+            case HtmlEl:{
+                HtmlElement *hel=(HtmlElement*)el;
+                output.append("<",1);
+                output.append(hel->_TagName.data(),hel->_TagName.size());
+                for (HtmlElement::Attributes* curattr = hel->_firstAttr; curattr; curattr = curattr->_nextAttr) {
+                    output.append(" ",1);
+                    output.append(curattr->_Key.data(),curattr->_Key.size());
+                    const std::vector<char> &value=curattr->_Value;
+                    if(value.empty())
+                        continue;
+                    const char *boolean=_nameIn(curattr->_Key,BooleanAttributes);
+                    if(boolean && HtmlTokenizer::isName(value.data(),value.size(),boolean))
+                        continue;
+                    bool quote=false;
+                    for(size_t i=0; i<value.size() && !quote; ++i){
+                        char c=value[i];
+                        quote=_htmlSpace(c) || c=='"' || c=='\'' || c=='=' || c=='<' || c=='>' || c=='`';
+                    }
+                    if(quote){
+                        output.append("=\"",2);
+                        output.append(value.data(),value.size());
+                        output.append("\"",1);
+                    }else{
+                        output.append("=",1);
+                        output.append(value.data(),value.size());
+                    }
+                }
+                output.append(">",1);
+                space=false;
+
+                if(hel->_children()){
+                    parents.push_back(hel);
+                    if(_nameIn(hel->_TagName,PreserveElements))
+                        ++preserve;
+                    el=hel->_children();
+                    continue;
                 }
-            }
-        }break;
-        case CommentEl: {
-            output.append("<!--");
-            output.append(((CommentElement*)el)->_Comment.data(),((CommentElement*)el)->_Comment.size());
-            output.append("-->");
-
-            if (el->_nextElement) {
-                el=el->_nextElement;
-                goto PRINTNEXTEL;
-            }
 
-            while(!cpylist.empty()){
-                el=cpylist.top();
+                //void elements and <!DOCTYPE html> get no end tag
+                if(!HtmlNames::isVoid(hel->_TagName.data(),hel->_TagName.size())){
+                    output.append("</",2);
+                    output.append(hel->_TagName.data(),hel->_TagName.size());
+                    output.append(">",1);
+                }
+            }break;
+
+            case TextEl:{
+                const std::vector<char> &text=((TextElement*)el)->_Text;
+                HtmlElement *parent=(HtmlElement*)el->_parentElement;
+
+                if(preserve){
+                    if(parent && HtmlTokenizer::isName(parent->_TagName.data(),parent->_TagName.size(),"style")){
+                        css.minify(text.data(),text.size());
+                        output.append(css.data(),css.size());
+                    }else{
+                        output.append(text.data(),text.size());
+                    }
+                    space=false;
+                    break;
+                }
 
-                output.append("</");
-                output.append(((HtmlElement*) el)->_TagName.data(),((HtmlElement*) el)->_TagName.size());
-                output.append(">");
+                //dropped comments don't count as siblings
+                const Element *prev=el->_prevElement,*next=el->_nextElement;
+                while(prev && prev->_Type==CommentEl)
+                    prev=prev->_prevElement;
+                while(next && next->_Type==CommentEl)
+                    next=next->_nextElement;
+
+                bool elementonly=!parent || _nameIn(parent->_TagName,ElementOnlyElements);
+                bool skip=space || elementonly || boundary(prev,parent);
+                bool trail=elementonly || boundary(next,parent);
+                bool pending=false;
+
+                const char *txt=text.data();
+                size_t len=text.size(),i=0;
+                while(i<len){
+                    if(_htmlSpace(txt[i])){
+                        while(i<len && _htmlSpace(txt[i]))
+                            ++i;
+                        pending=true;
+                        continue;
+                    }
+                    size_t start=i;
+                    while(i<len && !_htmlSpace(txt[i]))
+                        ++i;
+                    if(pending && !skip)
+                        output.append(" ",1);
+                    output.append(txt+start,i-start);
+                    pending=false;
+                    skip=false;
+                    space=false;
+                }
 
-                cpylist.pop();
-                if(el->_nextElement){
-                    el=el->_nextElement;
-                    goto PRINTNEXTEL;
+                if(pending && !skip && !trail){
+                    output.append(" ",1);
+                    space=true;
                 }
-            }
-        }break;
-        default:
-            HTMLException excp;
-            excp[HTMLException::Error] << "Unkown Elementtype";
-            throw excp;
-            break;
-    }
-}
+            }break;
+
+            case CommentEl:{
+                //conditional comments are read by old browsers
+                const std::vector<char> &com=((CommentElement*)el)->_Comment;
+                if((com.size()>=3 && memcmp(com.data(),"[if",3)==0) ||
+                    (com.size()>=9 && memcmp(com.data()+com.size()-9,"<![endif]",9)==0)){
+                    output.append("<!--",4);
+                    output.append(com.data(),com.size());
+                    output.append("-->",3);
+                    space=false;
+                }
+            }break;
 
-libhtmlpp::HtmlElement *libhtmlpp::HtmlElement::getElementbyID(const char *id) const{
-    std::stack <Element*> childs;
-    const Element *curel=this;
-SEARCHBYID:
-    if(curel->getType()==HtmlEl){
-        if(((HtmlElement*)curel)->_childElement){
-            childs.push(((HtmlElement*)curel)->_childElement);
+            default:
+                HTMLException excp;
+                excp[HTMLException::Error] << "Unkown Elementtype";
+                throw excp;
+                break;
         }
-        const char *key=((HtmlElement*)curel)->getAtributte("id");
-        if(key && strcmp(key,id)==0){
-            return (HtmlElement*)curel;
+
+        while(!el->_nextElement){
+            if(parents.empty())
+                return;
+            HtmlElement *parent=parents.back();
+            parents.pop_back();
+            if(_nameIn(parent->_TagName,PreserveElements))
+                --preserve;
+            output.append("</",2);
+            output.append(parent->_TagName.data(),parent->_TagName.size());
+            output.append(">",1);
+            space=false;
+            el=parent;
         }
+        el=el->_nextElement;
     }
+}
+
+namespace libhtmlpp {
+    //every renderer gets its own id so elements know whose output they are in
+    static std::atomic<unsigned long> RenderIds(0);
+};
+
+libhtmlpp::HtmlRenderer::HtmlRenderer(){
+    _Id=++RenderIds;
+    _Root=nullptr;
+}
+
+libhtmlpp::HtmlRenderer::~HtmlRenderer(){
+}
+
+void libhtmlpp::HtmlRenderer::reset(){
+    _Id=++RenderIds;
+    _Root=nullptr;
+    _Last.clear();
+}
+
+const char *libhtmlpp::HtmlRenderer::data() const{
+    return _Last.data();
+}
 
-    if(curel->nextElement()){
-        curel=curel->nextElement();
-        goto SEARCHBYID;
+size_t libhtmlpp::HtmlRenderer::size() const{
+    return _Last.size();
+}
+
+void libhtmlpp::HtmlRenderer::render(Element* el,HtmlString &output){
+    render(el);
+    output.append(_Last.data(),_Last.size());
+}
+
+void libhtmlpp::HtmlRenderer::render(Element* el){
+    struct OpenEl {
+        HtmlElement *element;
+        size_t       start;
+        size_t       parentstart;
+        size_t       parentold;
+    };
+
+    //the spans live in the elements, a frozen tree is shared read-only
+    if(el && el->_Frozen){
+        HTMLException excp;
+        excp[HTMLException::Error] << "HtmlRenderer: frozen html can't be rendered, use print()!";
+        throw excp;
     }
 
-    if(!childs.empty()){
-        curel=childs.top();
-        childs.pop();
-        goto SEARCHBYID;
+    //the spans of the last output only belong to the tree rendered last
+    if(el!=_Root){
+        _Id=++RenderIds;
+        _Root=el;
     }
 
-    return nullptr;
+    std::stack<OpenEl> openlist;
+    std::vector<char> &out=_Current;
+
+    //start of the parent span in the new and in the last output
+    size_t parentstart=0,parentold=0;
+
+    auto append = [&out](const char *src,size_t size){
+        out.insert(out.end(),src,src+size);
+    };
+
+    auto finish = [&out,&parentstart,this](Element *el,size_t start){
+        el->_RenderOffset=start-parentstart;
+        el->_RenderSize=out.size()-start;
+        el->_RenderId=_Id;
+        el->_Dirty=false;
+    };
+
+    out.clear();
+
+    while(el){
+        size_t start=out.size();
+
+        if(!el->_Dirty && el->_RenderId==_Id &&
+           parentold+el->_RenderOffset+el->_RenderSize<=_Last.size()){
+            size_t old=parentold+el->_RenderOffset;
+            append(_Last.data()+old,el->_RenderSize);
+            el->_RenderOffset=start-parentstart;
+        }else{
+            switch(el->_Type){
+                case HtmlEl:{
+                    HtmlElement *hel=(HtmlElement*)el;
+                    append("<",1);
+                    append(hel->_TagName.data(),hel->_TagName.size());
+                    for (HtmlElement::Attributes* curattr = hel->_firstAttr; curattr; curattr = curattr->_nextAttr) {
+                        append(" ",1);
+                        append(curattr->_Key.data(),curattr->_Key.size());
+                        if(!curattr->_Value.empty()){
+                            append("=\"",2);
+                            append(curattr->_Value.data(),curattr->_Value.size());
+                            append("\"",1);
+                        }
+                    }
+                    if(hel->_children()){
+                        append(">",1);
+                    }else if(!HtmlNames::isVoid(hel->_TagName.data(),hel->_TagName.size())){
+                        append("></",3);
+                        append(hel->_TagName.data(),hel->_TagName.size());
+                        append(">",1);
+                    }else if(el->_nextElement){
+                        append(">",1);
+                    }else{
+                        append(" />",3);
+                    }
+                    if(hel->_children()){
+                        OpenEl oel;
+                        oel.element=hel;
+                        oel.start=start;
+                        oel.parentstart=parentstart;
+                        oel.parentold=parentold;
+                        openlist.push(oel);
+                        parentold= el->_RenderId==_Id ? parentold+el->_RenderOffset : 0;
+                        parentstart=start;
+                        el=hel->_children();
+                        continue;
+                    }
+                }break;
+                case TextEl:
+                    append(((TextElement*)el)->_Text.data(),((TextElement*)el)->_Text.size());
+                    break;
+                case CommentEl:
+                    append("<!--",4);
+                    append(((CommentElement*)el)->_Comment.data(),((CommentElement*)el)->_Comment.size());
+                    append("-->",3);
+                    break;
+                default:
+                    HTMLException excp;
+                    excp[HTMLException::Error] << "Unkown Elementtype";
+                    throw excp;
+            }
+            finish(el,start);
+        }
+
+        el=el->_nextElement;
+        while(!el && !openlist.empty()){
+            OpenEl oel=openlist.top();
+            openlist.pop();
+            append("</",2);
+            append(oel.element->_TagName.data(),oel.element->_TagName.size());
+            append(">",1);
+            parentstart=oel.parentstart;
+            parentold=oel.parentold;
+            finish(oel.element,oel.start);
+            el=oel.element->_nextElement;
+        }
+    }
+
+    _Last.swap(_Current);
 }
 
-libhtmlpp::HtmlElement *libhtmlpp::HtmlElement::getElementbyTag(const char *tag) const{
-    std::stack <Element*> childs;
-    const Element *curel=this;
-SEARCHBYTAG:
-    if(curel->getType()==HtmlEl){
-        if(((HtmlElement*)curel)->_childElement){
-            childs.push(((HtmlElement*)curel)->_childElement);
+void libhtmlpp::freeze(Element* el){
+    _walk(el,[](Element *el){
+        switch(el->_Type){
+            case HtmlEl:{
+                HtmlElement *hel=(HtmlElement*)el;
+                hel->_CStr=hel->_TagName;
+                hel->_CStr.push_back('\0');
+                for(HtmlElement::Attributes *curattr=hel->_firstAttr; curattr; curattr=curattr->_nextAttr){
+                    curattr->_CStr=curattr->_Value;
+                    curattr->_CStr.push_back('\0');
+                }
+            }break;
+            case TextEl:
+                ((TextElement*)el)->_CStr=((TextElement*)el)->_Text;
+                ((TextElement*)el)->_CStr.push_back('\0');
+                break;
+            case CommentEl:
+                ((CommentElement*)el)->_CStr=((CommentElement*)el)->_Comment;
+                ((CommentElement*)el)->_CStr.push_back('\0');
+                break;
         }
-        const char *tname=((HtmlElement*)curel)->getTagname();
-        if(tname && strcmp(tname,tag)==0){
-            return (HtmlElement*)curel;
+        el->_Frozen=true;
+        return (int)ElementVisitor::Continue;
+    },_noLeave);
+}
+
+libhtmlpp::PreOrderIterator::PreOrderIterator(){
+    _Current=nullptr;
+    _Boundary=nullptr;
+    _Skip=false;
+}
+
+libhtmlpp::PreOrderIterator::PreOrderIterator(Element *el){
+    _Current=el;
+    _Boundary=el ? el->parentElement() : nullptr;
+    _Skip=false;
+}
+
+libhtmlpp::Element &libhtmlpp::PreOrderIterator::operator*() const{
+    return *_Current;
+}
+
+libhtmlpp::Element *libhtmlpp::PreOrderIterator::operator->() const{
+    return _Current;
+}
+
+libhtmlpp::PreOrderIterator &libhtmlpp::PreOrderIterator::operator++(){
+    if(!_Current)
+        return *this;
+    Element *el=_Current,*child=_Skip ? nullptr : _firstChild(el);
+    _Skip=false;
+    if(child){
+        _Current=child;
+        return *this;
+    }
+    while(!el->nextElement()){
+        el=el->parentElement();
+        if(el==_Boundary){
+            _Current=nullptr;
+            return *this;
         }
     }
+    _Current=el->nextElement();
+    return *this;
+}
+
+libhtmlpp::PreOrderIterator libhtmlpp::PreOrderIterator::operator++(int){
+    PreOrderIterator it=*this;
+    ++*this;
+    return it;
+}
+
+bool libhtmlpp::PreOrderIterator::operator==(const PreOrderIterator &it) const{
+    return _Current==it._Current;
+}
+
+bool libhtmlpp::PreOrderIterator::operator!=(const PreOrderIterator &it) const{
+    return _Current!=it._Current;
+}
 
-    if(curel->nextElement()){
-        curel=curel->nextElement();
-        goto SEARCHBYTAG;
+void libhtmlpp::PreOrderIterator::skipChildren(){
+    _Skip=true;
+}
+
+namespace libhtmlpp {
+    //first element in post order of the subtree of el
+    static inline Element *_deepestFirst(Element *el){
+        for(Element *child=el ? _firstChild(el) : nullptr; child; child=_firstChild(el))
+            el=child;
+        return el;
     }
+};
 
-    if(!childs.empty()){
-        curel=childs.top();
-        childs.pop();
-        goto SEARCHBYTAG;
+libhtmlpp::PostOrderIterator::PostOrderIterator(){
+    _Current=nullptr;
+    _Boundary=nullptr;
+}
+
+libhtmlpp::PostOrderIterator::PostOrderIterator(Element *el){
+    _Current=_deepestFirst(el);
+    _Boundary=el ? el->parentElement() : nullptr;
+}
+
+libhtmlpp::Element &libhtmlpp::PostOrderIterator::operator*() const{
+    return *_Current;
+}
+
+libhtmlpp::Element *libhtmlpp::PostOrderIterator::operator->() const{
+    return _Current;
+}
+
+libhtmlpp::PostOrderIterator &libhtmlpp::PostOrderIterator::operator++(){
+    if(!_Current)
+        return *this;
+    if(_Current->nextElement()){
+        _Current=_deepestFirst(_Current->nextElement());
+    }else{
+        _Current=_Current->parentElement();
+        if(_Current==_Boundary)
+            _Current=nullptr;
     }
-    return nullptr;
+    return *this;
+}
+
+libhtmlpp::PostOrderIterator libhtmlpp::PostOrderIterator::operator++(int){
+    PostOrderIterator it=*this;
+    ++*this;
+    return it;
+}
+
+bool libhtmlpp::PostOrderIterator::operator==(const PostOrderIterator &it) const{
+    return _Current==it._Current;
+}
+
+bool libhtmlpp::PostOrderIterator::operator!=(const PostOrderIterator &it) const{
+    return _Current!=it._Current;
+}
+
+libhtmlpp::ChildIterator::ChildIterator(){
+    _Current=nullptr;
+}
+
+libhtmlpp::ChildIterator::ChildIterator(Element *el){
+    _Current=el ? _firstChild(el) : nullptr;
+}
+
+libhtmlpp::Element &libhtmlpp::ChildIterator::operator*() const{
+    return *_Current;
+}
+
+libhtmlpp::Element *libhtmlpp::ChildIterator::operator->() const{
+    return _Current;
+}
+
+libhtmlpp::ChildIterator &libhtmlpp::ChildIterator::operator++(){
+    if(_Current)
+        _Current=_Current->nextElement();
+    return *this;
+}
+
+libhtmlpp::ChildIterator libhtmlpp::ChildIterator::operator++(int){
+    ChildIterator it=*this;
+    ++*this;
+    return it;
+}
+
+bool libhtmlpp::ChildIterator::operator==(const ChildIterator &it) const{
+    return _Current==it._Current;
+}
+
+bool libhtmlpp::ChildIterator::operator!=(const ChildIterator &it) const{
+    return _Current!=it._Current;
+}
+
+libhtmlpp::ElementRange<libhtmlpp::PreOrderIterator> libhtmlpp::preOrder(Element *el){
+    return ElementRange<PreOrderIterator>(PreOrderIterator(el));
+}
+
+libhtmlpp::ElementRange<libhtmlpp::PostOrderIterator> libhtmlpp::postOrder(Element *el){
+    return ElementRange<PostOrderIterator>(PostOrderIterator(el));
+}
+
+libhtmlpp::ElementRange<libhtmlpp::ChildIterator> libhtmlpp::children(Element *el){
+    return ElementRange<ChildIterator>(ChildIterator(el));
+}
+
+libhtmlpp::ElementVisitor::~ElementVisitor(){
+}
+
+int libhtmlpp::ElementVisitor::enter(Element *el){
+    return Continue;
+}
+
+int libhtmlpp::ElementVisitor::leave(Element *el){
+    return Continue;
+}
+
+bool libhtmlpp::visit(Element *el,ElementVisitor &visitor){
+    return _walk(el,[&visitor](Element *el){
+        return visitor.enter(el);
+    },[&visitor](Element *el){
+        return visitor.leave(el);
+    });
+}
+
+libhtmlpp::Element *libhtmlpp::HtmlElement::childElement() const{
+    return _children();
+}
+
+void libhtmlpp::HtmlElement::getTextContent(HtmlString &output) const{
+    if(_children())
+        printText(_childElement,output);
+}
+
+void libhtmlpp::printText(Element* el, HtmlString &output){
+    HtmlTextWriter writer(output);
+    auto tag=[](Element *el){
+        const std::vector<char> &name=((HtmlElement*)el)->_TagName;
+        return HtmlNames::getTag(name.data(),name.size());
+    };
+    _walk(el,[&writer,&tag](Element *el){
+        switch(el->_Type){
+            case HtmlEl:{
+                int id=tag(el);
+                if(HtmlTextWriter::isSkipped(id))
+                    return (int)ElementVisitor::SkipChildren;
+                if(HtmlTextWriter::isBlock(id))
+                    writer.block();
+            }break;
+            case TextEl:
+                writer.text(((TextElement*)el)->_Text.data(),((TextElement*)el)->_Text.size());
+                writer.flush();
+                break;
+        }
+        return (int)ElementVisitor::Continue;
+    },[&writer,&tag](Element *el){
+        //block() on enter already separates elements without children
+        if(el->_Type==HtmlEl && ((HtmlElement*)el)->_children() && HtmlTextWriter::isBlock(tag(el)))
+            writer.block();
+        return (int)ElementVisitor::Continue;
+    });
+}
+
+libhtmlpp::HtmlElement *libhtmlpp::HtmlElement::getElementbyID(const char *id) const{
+    HtmlElement *found=nullptr;
+    //values keep their entities, so an id with & can't be looked for in the source
+    size_t vlen=strlen(id),ilen=strchr(id,'&') ? 0 : vlen;
+    _walk((Element*)this,[id,vlen,ilen,&found](Element *el){
+        if(el->getType()!=HtmlEl)
+            return (int)ElementVisitor::Continue;
+        //names are case insensitive like in HtmlDocument, values aren't
+        for(Attributes *curattr=((HtmlElement*)el)->_firstAttr; curattr; curattr=curattr->_nextAttr){
+            if(HtmlNames::equals(curattr->_Key.data(),curattr->_Key.size(),"id",2) &&
+               curattr->_Value.size()==vlen && memcmp(curattr->_Value.data(),id,vlen)==0){
+                found=(HtmlElement*)el;
+                return (int)ElementVisitor::Stop;
+            }
+        }
+        //lazy subtrees without the id in their source stay unbuilt
+        return ((HtmlElement*)el)->_mayContain(id,ilen) ? (int)ElementVisitor::Continue
+                                                        : (int)ElementVisitor::SkipChildren;
+    },_noLeave);
+    return found;
+}
+
+libhtmlpp::HtmlElement *libhtmlpp::HtmlElement::getElementbyTag(const char *tag) const{
+    HtmlElement *found=nullptr;
+    size_t tlen=strlen(tag);
+    _walk((Element*)this,[tag,tlen,&found](Element *el){
+        if(el->getType()!=HtmlEl)
+            return (int)ElementVisitor::Continue;
+        const std::vector<char> &name=((HtmlElement*)el)->_TagName;
+        if(!HtmlNames::equals(name.data(),name.size(),tag,tlen)){
+            return ((HtmlElement*)el)->_mayContainTag(tag,tlen) ? (int)ElementVisitor::Continue
+                                                                : (int)ElementVisitor::SkipChildren;
+        }
+        found=(HtmlElement*)el;
+        return (int)ElementVisitor::Stop;
+    },_noLeave);
+    return found;
 }
 
 void libhtmlpp::HtmlElement::setAttribute(const char* name, const char* value) {
@@ -1220,6 +3109,9 @@ void libhtmlpp::HtmlElement::setAttribute(const char* name, const char* value) {
 void libhtmlpp::HtmlElement::setAttribute(const char* name,size_t nlen, const char* value,size_t vlen) {
     Attributes* cattr = nullptr;
 
+    if(_Frozen)
+        _throwFrozen();
+
     for (Attributes* curattr = _firstAttr; curattr; curattr=curattr->_nextAttr) {
         if(curattr->_Key.size() == nlen){
             if ( memcmp(curattr->_Key.data(),name,curattr->_Key.size()) ==0 ) {
@@ -1239,9 +3131,10 @@ void libhtmlpp::HtmlElement::setAttribute(const char* name,size_t nlen, const ch
         std::copy(name,name+nlen,std::insert_iterator<std::vector<char>>(cattr->_Key,cattr->_Key.begin()) );
     }
     if(vlen>0)
-        std::copy(value,value+vlen,std::insert_iterator<std::vector<char>>(cattr->_Value ,cattr->_Value .begin()) );
+        cattr->_Value.assign(value,value+vlen);
     else
         cattr->_Value.clear();
+    _markDirty();
 }
 
 void libhtmlpp::HtmlElement::setIntAttribute(const char* name, int value) {
@@ -1250,11 +3143,37 @@ void libhtmlpp::HtmlElement::setIntAttribute(const char* name, int value) {
     setAttribute(name,buf);
 }
 
+void libhtmlpp::HtmlElement::delAttribute(const char* name) {
+    if(_Frozen)
+        _throwFrozen();
+
+    size_t nlen=strlen(name);
+    Attributes *prev=nullptr;
+    for (Attributes* curattr = _firstAttr; curattr; curattr = curattr->_nextAttr) {
+        if(curattr->_Key.size() == nlen && memcmp(curattr->_Key.data(),name,nlen) == 0){
+            if(prev)
+                prev->_nextAttr=curattr->_nextAttr;
+            else
+                _firstAttr=curattr->_nextAttr;
+            if(_lastAttr==curattr)
+                _lastAttr=prev;
+            curattr->_nextAttr=nullptr;
+            delete curattr;
+            _markDirty();
+            return;
+        }
+        prev=curattr;
+    }
+}
+
 const char* libhtmlpp::HtmlElement::getAtributte(const char* name) const{
+    size_t nlen=strlen(name);
     for (Attributes* curattr = _firstAttr; curattr; curattr = curattr->_nextAttr) {
-        if(curattr->_Key.size() > strlen(name))
-            return nullptr;
-        if ( memcmp(curattr->_Key.data(),name,curattr->_Key.size()) == 0 ) {
+        if(curattr->_Key.size() != nlen)
+            continue;
+        if ( memcmp(curattr->_Key.data(),name,nlen) == 0 ) {
+            if(_Frozen)
+                return curattr->_CStr.data();
             curattr->_CStr=curattr->_Value;
             curattr->_CStr.push_back('\0');
             return curattr->_CStr.data();
@@ -1263,8 +3182,9 @@ const char* libhtmlpp::HtmlElement::getAtributte(const char* name) const{
     return nullptr;
 }
 
-int libhtmlpp::HtmlElement::getIntAtributte(const char* name) {
-    return atoi(getAtributte(name));
+int libhtmlpp::HtmlElement::getIntAtributte(const char* name) const{
+    const char *value=getAtributte(name);
+    return value ? atoi(value) : 0;
 }
 
 libhtmlpp::HtmlElement::Attributes::Attributes() {
@@ -1275,156 +3195,275 @@ libhtmlpp::HtmlElement::Attributes::~Attributes() {
 }
 
 libhtmlpp::HtmlTable::HtmlTable(){
-    _firstRow=nullptr;
-    _lastRow=nullptr;
 }
 
 libhtmlpp::HtmlTable::~HtmlTable(){
-    Row *next=_firstRow,*curel=nullptr;
-    while(next){
-        curel=next->_nextRow;
-        next->_nextRow=nullptr;
-        delete next;
-        next=curel;
-    }
 }
 
-libhtmlpp::HtmlTable::Row &libhtmlpp::HtmlTable::operator<<(const libhtmlpp::HtmlTable::Row row){
-    if(_firstRow){
-        _lastRow->_nextRow=new Row(row);
-        _lastRow=_lastRow->_nextRow;
-    }else{
-        _firstRow= new Row(row);
-        _lastRow=_firstRow;
-    }
-    ++_count;
-    return *_lastRow;
+libhtmlpp::HtmlTable::Row &libhtmlpp::HtmlTable::operator<<(const libhtmlpp::HtmlTable::Row &row){
+    _Rows.push_back(row);
+    return _Rows.back();
 }
 
 libhtmlpp::HtmlTable::Row & libhtmlpp::HtmlTable::operator[](size_t pos){
-    if(!_firstRow || _count<pos){
+    if(pos>=_Rows.size()){
         libhtmlpp::HTMLException exp;
         exp[HTMLException::Error] << "HtmlTable: Row at this position won't exists !";
         throw exp;
     }
-    size_t cpos=0;
-    Row *curel=nullptr;
-    for(curel=_firstRow; curel; curel=curel->_nextRow){
-        if(cpos==pos)
-            return *curel;
-        ++cpos;
-    }
-    return *curel;
+    return _Rows[pos];
+}
+
+size_t libhtmlpp::HtmlTable::getRows() const{
+    return _Rows.size();
 }
 
 void libhtmlpp::HtmlTable::insert(libhtmlpp::HtmlElement* element){
     element->setTagname("table");
-    for(Row *crow=_firstRow; crow; crow=crow->_nextRow){
-        HtmlElement hrow("tr");
 
-        for(Column *ccol=crow->_firstColumn; ccol; ccol=ccol->_nextColumn ){
-            HtmlString buf;
-            buf << "<td>";
-            buf << ccol->Data.c_str();
-            buf << "</td>";
-            hrow.appendChild(buf.parse());
+    Element *lastrow=element->_children();
+    while(lastrow && lastrow->_nextElement)
+        lastrow=lastrow->_nextElement;
+
+    HtmlString buf;
+
+    auto addrow=[&](const Row &row,const char *celltag){
+        HtmlElement *tr=new HtmlElement("tr");
+        tr->_parentElement=element;
+        tr->_prevElement=lastrow;
+        if(lastrow)
+            lastrow->_nextElement=tr;
+        else
+            element->_childElement=tr;
+        lastrow=tr;
+
+        Element *lastcell=nullptr;
+        for(const Column &col : row._Columns){
+            HtmlElement *td=new HtmlElement(celltag);
+            td->_parentElement=tr;
+            td->_prevElement=lastcell;
+            if(lastcell)
+                lastcell->_nextElement=td;
+            else
+                tr->_childElement=td;
+            lastcell=td;
+
+            buf.clear();
+            HtmlEncode(col.Data.data(),col.Data.size(),&buf);
+            TextElement *txt=new TextElement();
+            txt->_Text.assign(buf.data(),buf.data()+buf.size());
+            txt->_parentElement=td;
+            td->_childElement=txt;
         }
+    };
 
-        element->appendChild(&hrow);
-    }
+    if(!_header._Columns.empty())
+        addrow(_header,"th");
+
+    for(const Row &row : _Rows)
+        addrow(row,"td");
+
+    element->_markDirty();
 }
 
 void libhtmlpp::HtmlTable::parse(libhtmlpp::HtmlElement* element){
+    HtmlElement *table=element;
+    if(!table || table->_TagName.size()!=5 || memcmp(table->_TagName.data(),"table",5)!=0)
+        table=element ? element->getElementbyTag("table") : nullptr;
+
+    if(!table){
+        libhtmlpp::HTMLException exp;
+        exp[HTMLException::Error] << "HtmlTable: no table found !";
+        throw exp;
+    }
+
+    _Rows.clear();
+    _header.clear();
+
+    TableGrid grid;
+    std::stack<Element*> textlist;
+
+    auto istag=[](const Element *el,const char *tag){
+        return el->_Type==HtmlEl && HtmlTokenizer::isName(((HtmlElement*)el)->_TagName.data(),
+                                                             ((HtmlElement*)el)->_TagName.size(),tag);
+    };
+
+    //the first attribute of that name like HtmlTableReader, 1 if there is none
+    auto span=[](const HtmlElement *cell,const char *name){
+        for(HtmlElement::Attributes *curattr=cell->_firstAttr; curattr; curattr=curattr->_nextAttr){
+            if(!curattr->_Value.empty() && HtmlTokenizer::isName(curattr->_Key.data(),curattr->_Key.size(),name))
+                return TableGrid::parseSpan(curattr->_Value.data(),curattr->_Value.size());
+        }
+        return (size_t)1;
+    };
+
+    auto addrow=[&](HtmlElement *tr,bool head){
+        bool allth=true;
+        grid.beginRow();
+        for(Element *cell=tr->_children(); cell; cell=cell->_nextElement){
+            bool th=istag(cell,"th");
+            if(!th && !istag(cell,"td"))
+                continue;
+            allth&=th;
+
+            HtmlElement *hcell=(HtmlElement*)cell;
+            HtmlString &data=grid.beginCell(span(hcell,"colspan"),span(hcell,"rowspan"));
+
+            //text of all children, nested tables are left out
+            if(hcell->_children())
+                textlist.push(hcell->_children());
+            while(!textlist.empty()){
+                Element *curel=textlist.top();
+                textlist.pop();
+                if(curel->_nextElement)
+                    textlist.push(curel->_nextElement);
+                if(curel->_Type==TextEl){
+                    HtmlDecode(((TextElement*)curel)->_Text.data(),((TextElement*)curel)->_Text.size(),&data);
+                }else if(curel->_Type==HtmlEl && ((HtmlElement*)curel)->_children() && !istag(curel,"table")){
+                    textlist.push(((HtmlElement*)curel)->_children());
+                }
+            }
+            grid.endCell();
+        }
+
+        if(grid.cells()==0)
+            return;
+
+        Row &row=grid.endRow();
+        if((head || allth) && _header._Columns.empty() && _Rows.empty())
+            _header=row;
+        else
+            _Rows.push_back(row);
+    };
+
+    for(Element *curel=table->_children(); curel; curel=curel->_nextElement){
+        if(istag(curel,"tr")){
+            addrow((HtmlElement*)curel,false);
+        }else if(istag(curel,"thead") || istag(curel,"tbody") || istag(curel,"tfoot")){
+            bool head=istag(curel,"thead");
+            for(Element *tr=((HtmlElement*)curel)->_children(); tr; tr=tr->_nextElement){
+                if(istag(tr,"tr"))
+                    addrow((HtmlElement*)tr,head);
+            }
+        }
+    }
+}
+
+void libhtmlpp::HtmlTable::print(HtmlString &output) const{
+    output.append("<table>");
+    if(!_header._Columns.empty()){
+        output.append("<tr>");
+        for(const Column &col : _header._Columns){
+            output.append("<th>");
+            HtmlEncode(col.Data.data(),col.Data.size(),&output);
+            output.append("</th>");
+        }
+        output.append("</tr>");
+    }
+    for(const Row &row : _Rows){
+        output.append("<tr>");
+        for(const Column &col : row._Columns){
+            output.append("<td>");
+            HtmlEncode(col.Data.data(),col.Data.size(),&output);
+            output.append("</td>");
+        }
+        output.append("</tr>");
+    }
+    output.append("</table>");
+}
+
+void libhtmlpp::HtmlTable::write(std::ostream &output,int format) const{
+    HtmlTableWriter writer(output,format);
+    if(!_header._Columns.empty())
+        writer.setHeader(_header);
+    for(const Row &row : _Rows)
+        writer.writeRow(row);
+    writer.finish();
 }
 
 void libhtmlpp::HtmlTable::setHeader(int count,...){
     va_list args;
     va_start(args,count);
 
+    _header.clear();
     for (int i = 0; i < count; ++i) {
         _header << va_arg(args, const char*);
     }
 
+    va_end(args);
 }
 
 void libhtmlpp::HtmlTable::deleteRow(size_t pos){
-    Row *drow=&(*this)[pos];
-    try{
-        Row *prev=&(*this)[pos-1];
-        prev->_nextRow=drow->_nextRow;
-    }catch(...){}
-    drow->_nextRow=nullptr;
-    --_count;
-    delete drow;
+    //throws if the row doesn't exist
+    (*this)[pos];
+    _Rows.erase(_Rows.begin()+pos);
 }
 
 libhtmlpp::HtmlTable::Column::Column(){
-    _nextColumn=nullptr;
 }
 
 libhtmlpp::HtmlTable::Column::Column(const libhtmlpp::HtmlTable::Column& col){
-     _nextColumn=nullptr;
     Data = col.Data;
 }
 
+libhtmlpp::HtmlTable::Column::Column(libhtmlpp::HtmlTable::Column&& col) noexcept : Data(std::move(col.Data)){
+}
+
 libhtmlpp::HtmlTable::Column::Column(const libhtmlpp::HtmlString &data){
-     _nextColumn=nullptr;
     Data=data;
 }
 
 libhtmlpp::HtmlTable::Column::~Column(){
 }
 
+libhtmlpp::HtmlTable::Column& libhtmlpp::HtmlTable::Column::operator=(const libhtmlpp::HtmlTable::Column& col){
+    Data=col.Data;
+    return *this;
+}
+
+libhtmlpp::HtmlTable::Column& libhtmlpp::HtmlTable::Column::operator=(libhtmlpp::HtmlTable::Column&& col) noexcept{
+    Data=std::move(col.Data);
+    return *this;
+}
+
 libhtmlpp::HtmlTable::Row::Row(){
-    _firstColumn=nullptr;
-    _lastColumn=nullptr;
-    _nextRow=nullptr;
-    _count=0;
 }
 
 libhtmlpp::HtmlTable::Row::~Row(){
-    Column *cnext=_firstColumn,*ccurel=nullptr;
-    while(cnext){
-        ccurel=cnext->_nextColumn;
-        cnext->_nextColumn=nullptr;
-        delete cnext;
-        cnext=ccurel;
-    }
 }
 
 libhtmlpp::HtmlTable::Row::Row(const libhtmlpp::HtmlTable::Row& row){
-    _firstColumn=nullptr;
-    _lastColumn=nullptr;
-    _nextRow=nullptr;
-    _count=0;
+    _Columns=row._Columns;
+}
 
-    for(Column *curel=row._firstColumn; curel; curel=curel->_nextColumn){
-        *this << curel->Data;
-    }
+libhtmlpp::HtmlTable::Row::Row(libhtmlpp::HtmlTable::Row&& row) noexcept{
+    _Columns.swap(row._Columns);
+}
+
+libhtmlpp::HtmlTable::Row& libhtmlpp::HtmlTable::Row::operator=(const libhtmlpp::HtmlTable::Row& row){
+    _Columns=row._Columns;
+    return *this;
+}
+
+libhtmlpp::HtmlTable::Row& libhtmlpp::HtmlTable::Row::operator=(libhtmlpp::HtmlTable::Row&& row) noexcept{
+    _Columns.swap(row._Columns);
+    return *this;
 }
 
 libhtmlpp::HtmlTable::Row& libhtmlpp::HtmlTable::Row::operator<<(Column &col){
-    if(_firstColumn){
-        _lastColumn->_nextColumn=new Column(col);
-        _lastColumn=_lastColumn->_nextColumn;
-    }else{
-        _firstColumn= new Column(col);
-        _lastColumn=_firstColumn;
-    }
-    ++_count;
+    _Columns.push_back(col);
     return *this;
 }
 
 libhtmlpp::HtmlTable::Row &libhtmlpp::HtmlTable::Row::operator<<(libhtmlpp::HtmlString value){
-    Column col(value);
-    *this << col;
+    _Columns.emplace_back();
+    _Columns.back().Data.append(value.data(),value.size());
     return *this;
 }
 
 libhtmlpp::HtmlTable::Row &libhtmlpp::HtmlTable::Row::operator<<(const char* value){
-    HtmlString buf;
-    buf << value;
-    *this << buf;
+    _Columns.emplace_back();
+    _Columns.back().Data.append(value);
     return  *this;
 }
 
@@ -1435,40 +3474,33 @@ libhtmlpp::HtmlTable::Row & libhtmlpp::HtmlTable::Row::operator<<(int value){
 }
 
 libhtmlpp::HtmlTable::Column & libhtmlpp::HtmlTable::Row::operator[](size_t pos){
-    if(!_firstColumn || _count<pos){
+    if(pos>=_Columns.size()){
         libhtmlpp::HTMLException exp;
         exp[HTMLException::Error] << "HtmlTable: Column at this position won't exists !";
         throw exp;
     }
-    size_t cpos=0;
-    Column *curel=nullptr;
-    for(curel=_firstColumn; curel; curel=curel->_nextColumn){
-        if(cpos==pos)
-            return *curel;
-        ++cpos;
+    return _Columns[pos];
+}
+
+const libhtmlpp::HtmlTable::Column & libhtmlpp::HtmlTable::Row::operator[](size_t pos) const{
+    if(pos>=_Columns.size()){
+        libhtmlpp::HTMLException exp;
+        exp[HTMLException::Error] << "HtmlTable: Column at this position won't exists !";
+        throw exp;
     }
-    return *curel;
+    return _Columns[pos];
+}
+
+size_t libhtmlpp::HtmlTable::Row::getColumns() const{
+    return _Columns.size();
 }
 
 void libhtmlpp::HtmlTable::Row::delColumn(size_t pos){
-    Column *dcol=&(*this)[pos];
-    try{
-        Column *prev=&(*this)[pos-1];
-        prev->_nextColumn=dcol->_nextColumn;
-    }catch(...){}
-    dcol->_nextColumn=nullptr;
-    --_count;
-    delete dcol;
+    //throws if the column doesn't exist
+    (*this)[pos];
+    _Columns.erase(_Columns.begin()+pos);
 }
 
 void libhtmlpp::HtmlTable::Row::clear(){
-    Column *cnext=_firstColumn,*ccurel=nullptr;
-    while(cnext){
-        ccurel=cnext;
-        cnext=cnext->_nextColumn;
-        delete ccurel;
-    }
-    _firstColumn = nullptr;
-    _lastColumn = nullptr;
-    _count = 0;
+    _Columns.clear();
 }
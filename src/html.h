@@ -27,6 +27,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <sys/types.h>
 
+#include <iosfwd>
+#include <iterator>
 #include <string>
 #include <cstring>
 #include <vector>
@@ -34,9 +36,9 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
 namespace libhtmlpp {
-    class DocElements;
     class HtmlElement;
     class HtmlString;
+    struct LazySource;
 
     enum ElementType{
         TextEl=0,
@@ -55,24 +57,63 @@ namespace libhtmlpp {
         void insertAfter(Element* el);
         void insertBefore(Element* el);
 
+        /*
+         * unlinks the element with its children in O(1), the caller owns it
+         * afterwards. The first element of a document can't be detached.
+         */
+        Element*       detach();
+        //detaches and deletes the element and its children
+        void           remove();
+        //puts a copy of el and its following siblings in place of this, returns the copy
+        Element*       replaceWith(Element* el);
+
+        //nodes come from a free list of the thread, deleted nodes go back to it
+        static void*   operator new(size_t size);
+        static void    operator delete(void *ptr,size_t size);
+
         Element& operator=(const Element &hel);
         Element& operator=(const Element *hel);
 
         Element*       nextElement() const;
         Element*       prevElement() const;
+        Element*       parentElement() const;
 
         int            getType() const;
+        bool           isFrozen() const;
     protected:
+        //marks the element and all parents for HtmlRenderer
+        void          _markDirty();
+
         Element*      _prevElement;
         Element*      _nextElement;
+        Element*      _parentElement;
         Element*      _firstElement;
         int           _Type;
+        bool          _Frozen;
+
+        //span of the element in the last output of HtmlRenderer _RenderId,
+        //the offset is relative to the span of the parent element
+        bool          _Dirty;
+        unsigned long _RenderId;
+        size_t        _RenderOffset;
+        size_t        _RenderSize;
 
         friend class HtmlElement;
         friend class TextElement;
         friend class HtmlString;
+        friend class HtmlTemplate;
+        friend class HtmlSnapshot;
+        friend class HtmlDocument;
+        friend class HtmlRenderer;
+        friend class HtmlPatch;
+        friend class HtmlTable;
+        friend class CssCascade;
         friend void  print(Element* el, HtmlString &output);
+        friend void  print(Element* el, HtmlString &output, bool minify);
+        friend void  printText(Element* el, HtmlString &output);
         friend void _copy(libhtmlpp::Element *dest,const libhtmlpp::Element *src);
+        friend void _delete(libhtmlpp::Element *el);
+        friend void freeze(Element *el);
     };
 
     class HtmlElement : public Element {
@@ -95,16 +136,26 @@ namespace libhtmlpp {
 
         void         setIntAttribute(const char* name, int value);
 
+        void         delAttribute(const char* name);
+
         const char*  getAtributte(const char* name) const;
 
-        int          getIntAtributte(const char* name);
+        int          getIntAtributte(const char* name) const;
 
         void         insertChild(Element* el);
         void         appendChild(Element* el);
 
         void         setTagname(const char *name);
-        const char  *getTagname();
+        const char  *getTagname() const;
+
+        Element     *childElement() const;
 
+        //appends the text of the children like HtmlTextWriter writes it, script,
+        //style, template and comments are left out
+        void         getTextContent(HtmlString &output) const;
+
+        //first match in document order in the element, its following siblings and their children,
+        //tag names and the id key are case insensitive, the id value isn't
         HtmlElement *getElementbyID(const char *id) const;
         HtmlElement *getElementbyTag(const char *tag) const;
     protected:
@@ -121,18 +172,45 @@ namespace libhtmlpp {
         };
 
     private:
+        //the children, built first if the element comes from HtmlString::parseLazy()
+        Element*       _children() const{
+            if(_Lazy)
+                _materialize();
+            return _childElement;
+        }
+        void           _materialize() const;
+        //false if a lazy element can't hold str, so a search can skip it
+        bool           _mayContain(const char *str,size_t len) const;
+        //like _mayContain for a start tag, the name is case insensitive
+        bool           _mayContainTag(const char *tag,size_t len) const;
+
         //if text tagname must be zero
         std::vector<char> _TagName;
-        std::vector<char> _CStr;
+        mutable std::vector<char> _CStr;
 
         //if text Attributes must be zero
         Attributes*    _firstAttr;
         Attributes*    _lastAttr;
 
+        //document and start tag token of children not built yet, nullptr if built
+        mutable LazySource *_Lazy;
+        mutable long        _LazyToken;
+
+        friend class Element;
         friend class HtmlString;
         friend class HtmlTable;
+        friend class HtmlTemplate;
+        friend class HtmlSnapshot;
+        friend class HtmlDocument;
+        friend class HtmlRenderer;
+        friend class HtmlPatch;
+        friend class CssCascade;
         friend void  print(Element* el, HtmlString &output);
+        friend void  print(Element* el, HtmlString &output, bool minify);
+        friend void  printText(Element* el, HtmlString &output);
         friend void _copy(libhtmlpp::Element *dest,const libhtmlpp::Element *src);
+        friend void _delete(libhtmlpp::Element *el);
+        friend void freeze(Element *el);
     };
 
     class TextElement : public Element{
@@ -144,15 +222,25 @@ namespace libhtmlpp {
         TextElement& operator=(const Element &hel);
         TextElement& operator=(const Element *hel);
 
-        const char *getText();
+        const char *getText() const;
         void        setText(const char *txt);
 
     protected:
         std::vector<char> _Text;
-        std::vector<char> _CStr;
+        mutable std::vector<char> _CStr;
         friend class HtmlString;
+        friend class HtmlTable;
+        friend class CssCascade;
+        friend class HtmlTemplate;
+        friend class HtmlSnapshot;
+        friend class HtmlDocument;
+        friend class HtmlRenderer;
+        friend class HtmlPatch;
         friend void  print(Element* el, HtmlString &output);
+        friend void  print(Element* el, HtmlString &output, bool minify);
+        friend void  printText(Element* el, HtmlString &output);
         friend void _copy(libhtmlpp::Element *dest,const libhtmlpp::Element *src);
+        friend void freeze(Element *el);
     };
 
     class CommentElement : public Element{
@@ -164,24 +252,194 @@ namespace libhtmlpp {
         CommentElement& operator=(const Element &hel);
         CommentElement& operator=(const Element *hel);
 
-        const char *getComment();
+        const char *getComment() const;
         void        setComment(const char *txt);
 
     protected:
         std::vector<char> _Comment;
-        std::vector<char> _CStr;
+        mutable std::vector<char> _CStr;
         friend class HtmlString;
+        friend class HtmlTemplate;
+        friend class HtmlSnapshot;
+        friend class HtmlDocument;
+        friend class HtmlRenderer;
+        friend class HtmlPatch;
         friend void  print(Element* el, HtmlString &output);
+        friend void  print(Element* el, HtmlString &output, bool minify);
+        friend void  printText(Element* el, HtmlString &output);
         friend void _copy(libhtmlpp::Element *dest,const libhtmlpp::Element *src);
+        friend void freeze(Element *el);
     };
 
     void print(Element* el, HtmlString &output);
 
+    /*
+     * prints like print(), with minify set comments except conditional
+     * ones are dropped, whitespace in text collapses to one space and
+     * disappears next to block elements, boolean attributes lose their
+     * value and values without spaces or quotes lose the quotes. Text in
+     * pre, textarea and script is kept, style text runs through CssMinifier.
+     */
+    void print(Element* el, HtmlString &output, bool minify);
+
+    //appends the text of el, its following siblings and all children like getTextContent()
+    void printText(Element* el, HtmlString &output);
+
+    /*
+     * freezes el, its following siblings and all their children.
+     * Getters on a frozen element never touch internal buffers, so a frozen
+     * tree can be traversed, searched and printed from many threads at the
+     * same time without locking. Every modification of a frozen element
+     * throws an HTMLException, copies of a frozen tree are not frozen.
+     */
+    void freeze(Element *el);
+
+    /*
+     * iterators over the sibling and parent links, they keep no stack and
+     * allocate nothing. PreOrderIterator and PostOrderIterator walk el, its
+     * following siblings and all their children like print() does,
+     * ChildIterator walks the direct children of an element. Removing the
+     * current element invalidates an iterator.
+     */
+    class PreOrderIterator {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef Element                   value_type;
+        typedef std::ptrdiff_t            difference_type;
+        typedef Element*                  pointer;
+        typedef Element&                  reference;
+
+        PreOrderIterator();
+        explicit PreOrderIterator(Element *el);
+
+        Element          &operator*() const;
+        Element          *operator->() const;
+        PreOrderIterator &operator++();
+        PreOrderIterator  operator++(int);
+        bool              operator==(const PreOrderIterator &it) const;
+        bool              operator!=(const PreOrderIterator &it) const;
+
+        //the next increment goes past the children of the current element
+        void              skipChildren();
+    private:
+        Element *_Current;
+        Element *_Boundary;
+        bool     _Skip;
+    };
+
+    class PostOrderIterator {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef Element                   value_type;
+        typedef std::ptrdiff_t            difference_type;
+        typedef Element*                  pointer;
+        typedef Element&                  reference;
+
+        PostOrderIterator();
+        explicit PostOrderIterator(Element *el);
+
+        Element           &operator*() const;
+        Element           *operator->() const;
+        PostOrderIterator &operator++();
+        PostOrderIterator  operator++(int);
+        bool               operator==(const PostOrderIterator &it) const;
+        bool               operator!=(const PostOrderIterator &it) const;
+    private:
+        Element *_Current;
+        Element *_Boundary;
+    };
+
+    class ChildIterator {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef Element                   value_type;
+        typedef std::ptrdiff_t            difference_type;
+        typedef Element*                  pointer;
+        typedef Element&                  reference;
+
+        ChildIterator();
+        //starts at the first child of el
+        explicit ChildIterator(Element *el);
+
+        Element       &operator*() const;
+        Element       *operator->() const;
+        ChildIterator &operator++();
+        ChildIterator  operator++(int);
+        bool           operator==(const ChildIterator &it) const;
+        bool           operator!=(const ChildIterator &it) const;
+    private:
+        Element *_Current;
+    };
+
+    //begin and end for range based for loops
+    template<typename Iterator>
+    class ElementRange {
+    public:
+        ElementRange(Iterator begin) : _Begin(begin){}
+        Iterator begin() const { return _Begin; }
+        Iterator end() const { return Iterator(); }
+    private:
+        Iterator _Begin;
+    };
+
+    ElementRange<PreOrderIterator>  preOrder(Element *el);
+    ElementRange<PostOrderIterator> postOrder(Element *el);
+    ElementRange<ChildIterator>     children(Element *el);
+
+    /*
+     * callbacks for visit(). enter() runs before the children of an element
+     * and can skip them or stop the walk, leave() runs after the children
+     * and for skipped elements too.
+     */
+    class ElementVisitor {
+    public:
+        enum Action {Continue=0,SkipChildren=1,Stop=2};
+
+        virtual ~ElementVisitor();
+        virtual int enter(Element *el);
+        virtual int leave(Element *el);
+    };
+
+    //walks el, its following siblings and all children, false if the visitor stopped
+    bool visit(Element *el,ElementVisitor &visitor);
+
+    /*
+     * prints like print() but keeps the last output. Elements remember
+     * their span in that output and get marked dirty by every change, so
+     * the next render() copies unchanged subtrees from the last output and
+     * only serializes changed elements again. Rendering writes into the
+     * elements, so a tree can have only one renderer at a time, a second
+     * one throws its cache away on every render. Frozen trees are shared
+     * read-only and get refused, print() them instead. Rendering another
+     * tree with the same renderer serializes everything again.
+     */
+    class HtmlRenderer {
+    public:
+        HtmlRenderer();
+        ~HtmlRenderer();
+
+        void        render(Element *el);
+        void        render(Element *el,HtmlString &output);
+
+        const char *data() const;
+        size_t      size() const;
+
+        //forget the last output, the next render serializes everything
+        void        reset();
+    private:
+        std::vector<char> _Last;
+        std::vector<char> _Current;
+        unsigned long     _Id;
+        //element _Last was rendered from, another one starts a new cache
+        Element          *_Root;
+    };
+
     class HtmlString {
     public:
         HtmlString();
         HtmlString(const HtmlString &str);
         HtmlString(const HtmlString *str);
+        HtmlString(HtmlString &&str) noexcept;
         HtmlString(const char *str);
         HtmlString(std::string &str);
         ~HtmlString();
@@ -199,6 +457,7 @@ namespace libhtmlpp {
         HtmlString& operator=(const char* src);
         HtmlString& operator=(std::string *src);
         HtmlString& operator=(const HtmlString& src);
+        HtmlString& operator=(HtmlString&& src) noexcept;
         const char  operator[](size_t pos) const;
 
         HtmlString& operator<<(const char* src);
@@ -214,24 +473,160 @@ namespace libhtmlpp {
         void               clear();
         bool               empty();
         const char *       c_str();
+        //the characters without terminating zero
+        const char *       data() const;
+        /*
+         * malformed markup parse() recovered from. Void elements, implied
+         * end tags like <p> closed by <div> and optional end tags are html
+         * and don't count.
+         */
+        struct ParseErrors {
+            //end tags without an open element in scope, they are ignored
+            size_t StrayEndTags;
+            //elements that need an end tag but got closed by another tag
+            size_t MisnestedTags;
+            //elements that need an end tag and were still open at the end
+            size_t UnclosedElements;
+        };
+
+        /*
+         * builds the tree like browsers do, misnested and missing end tags
+         * are repaired in one linear pass and counted in getParseErrors().
+         * Malformed input never throws and tags without a name like <> are
+         * dropped. Returns the first element with a tag, text or comments in
+         * front of it are its previous siblings. nullptr if the document has
+         * no element like "hello" or "</p>".
+         */
         HtmlElement*       parse();
+        /*
+         * parses like parse(), but only builds the elements at the top. The
+         * children of an element are built on the first access through
+         * childElement(), iterators, queries or print(), unvisited subtrees
+         * only cost their tokens and a copy of the document. A lazy tree
+         * isn't safe to read from many threads before freeze(), which
+         * builds all of it.
+         */
+        HtmlElement*       parseLazy();
+        const ParseErrors &getParseErrors() const;
+
+        struct Diagnostic {
+            enum DiagnosticType {
+                StrayEndTag=0,MisnestedTag,UnclosedElement,
+                //a < without > or a comment without --> at the end
+                UnterminatedTag,
+                //tags like <> that parse() drops
+                MissingTagName
+            };
+            static const size_t npos=(size_t)-1;
+
+            int    Type;
+            //byte offset of the tag, the end of the document for UnclosedElement
+            size_t Offset;
+            //byte offset of the start tag that wasn't closed right, npos if none
+            size_t StartTag;
+        };
+
+        /*
+         * checks the tag balance like parse() without building a tree, only
+         * the open elements are kept. The diagnostics are in document order
+         * and getParseErrors() gets the same counters as parse().
+         */
+        bool               validate(std::vector<Diagnostic> &diagnostics);
+        //false and a summary of the diagnostics in err
         bool               validate(std::string *err);
+
+        /*
+         * freezes the string and the tree returned by the last parse().
+         * Afterwards c_str() is safe to call from many threads and every
+         * modification or reparse throws an HTMLException.
+         */
+        void               freeze();
+        bool               isFrozen() const;
     private:
         void               _parseTree();
-        void               _serialelize(std::vector<char> in, HtmlElement* out);
+        //reads the tag name and attributes of one tag, true for <x />
+        static bool        _serialelize(const char *in,size_t len,HtmlElement* out);
         Element*           _buildTree(long& pos);
-        Element*           _buildtreenode(DocElements *firstel,DocElements *lastel);
+        //builds the children of the tokens between first and end of a lazy parse
+        static Element*    _buildLazy(LazySource *source,HtmlElement *parent,long first,long end);
         std::vector<char>  _Data;
         std::vector<char>  _CStr;
-        long**             _HTable;
-        size_t             _HTableSize;
-        HtmlElement*       _RootNode;
+        Element*           _RootNode;
+        bool               _Frozen;
+        ParseErrors        _Errors;
+        friend class HtmlPage;
+        friend class HtmlElement;
+        friend class HtmlPatch;
+        friend class HtmlTemplate;
         friend void HtmlEncode(const char *input,HtmlString *output);
     };
 
     void HtmlEncode(const char *input,HtmlString *output);
+    void HtmlEncode(const char *input,size_t ilen,HtmlString *output);
     void HtmlEncode(const char *input,std::string &output);
 
+    /*
+     * replaces the entities written by HtmlEncode, &nbsp; and numeric
+     * character references with their utf-8 characters, unknown entities
+     * are copied unchanged
+     */
+    void HtmlDecode(const char *input,size_t ilen,HtmlString *output);
+
+    /*
+     * finds the urls in href, src, srcset and action of a document without
+     * building a tree. Only tags that link or load something like a, img,
+     * script and form are read, with the tag scanner and attribute tokenizer
+     * of HtmlString::parse(), so the links are the same as in the tree.
+     * Attribute names are compared case insensitive. Values are decoded,
+     * trimmed, srcset is split into its candidates and every url is resolved
+     * against the first <base href> and the url of the page. Links in front
+     * of the base are kept as offsets and reported once it is known.
+     */
+    class HtmlLinkExtractor {
+    public:
+        HtmlLinkExtractor();
+        virtual ~HtmlLinkExtractor();
+
+        //data has to stay valid during the call, url is the page or nullptr
+        void        extract(const char *data,size_t size,const char *url=nullptr);
+
+        /*
+         * resolves ref against the absolute url base after rfc 3986 and
+         * appends the result to out. ref is appended unchanged if base has
+         * no scheme.
+         */
+        static void resolve(const char *base,size_t blen,const char *ref,size_t rlen,
+                            std::string &out);
+    protected:
+        //tag and attribute are HtmlNames ids, url is only valid during the call
+        virtual void onLink(int tag,int attribute,const char *url,size_t ulen);
+    private:
+        struct PendingLink {
+            int    Tag;
+            int    Attribute;
+            size_t Offset;
+            size_t Size;
+        };
+
+        void        _link(int tag,int attribute,const char *value,size_t vlen);
+        void        _emit(int tag,int attribute,const char *ref,size_t rlen);
+        //trims ref and resolves it into _Url, false if it is empty
+        bool        _resolve(const char *ref,size_t rlen);
+
+        std::string              _Base;
+        std::string              _Ref;
+        std::string              _Url;
+        HtmlString               _Decoded;
+        std::vector<PendingLink> _Pending;
+    };
+
+    /*
+     * loadFile() and loadString() convert the page to utf-8 with
+     * HtmlCharsetDecoder before parsing. Without a byte order mark or a
+     * meta charset a page that isn't valid utf-8 in its first 1024 bytes
+     * is read as windows-1252, invalid sequences of a utf-8 page become
+     * U+FFFD.
+     */
     class HtmlPage {
     public:
         HtmlPage();
@@ -242,64 +637,96 @@ namespace libhtmlpp {
         HtmlElement *loadString(const char *src);
         HtmlElement *loadString(const HtmlString &node);
         HtmlElement *loadString(const HtmlString *node);
+        //HtmlCharset::Encoding the last page was loaded from
+        int          getEncoding() const;
     private:
         void         _CheckHeader(const HtmlString& page);
+        void         _load(const char *data,size_t size);
         HtmlString   _Page;
+        int          _Encoding;
     };
 
+    /*
+     * rows and columns are stored in vectors, so operator[] is O(1), but
+     * references from operator[] and operator<< are only valid until the
+     * next row or column is added or deleted. Cells hold plain text that
+     * is escaped when the table is printed or inserted into a tree.
+     */
     class HtmlTable {
     public:
+        enum Format {Csv=0,Tsv=1,Json=2};
+
         HtmlTable();
         ~HtmlTable();
 
         class Column {
         public:
-            HtmlString  Data;
-        private:
             Column();
             Column(const Column &col);
+            Column(Column &&col) noexcept;
             Column(const HtmlString &data);
             ~Column();
 
-            Column      *_nextColumn;
-            friend class HtmlTable;
+            Column& operator=(const Column &col);
+            Column& operator=(Column &&col) noexcept;
+
+            HtmlString  Data;
         };
 
         class Row {
         public:
             Row();
             Row(const Row &row);
+            Row(Row &&row) noexcept;
             ~Row();
 
+            Row& operator=(const Row &row);
+            Row& operator=(Row &&row) noexcept;
+
             Row& operator<<(Column &col);
             Row& operator<<(HtmlString  value);
             Row& operator<<(const char* value);
             Row& operator<<(int value);
 
             Column& operator[](size_t pos);
+            const Column& operator[](size_t pos) const;
+
+            size_t getColumns() const;
 
             void delColumn(size_t pos);
             void clear();
         private:
-            Column *_firstColumn;
-            Column *_lastColumn;
-            Row    *_nextRow;
-            size_t  _count;
+            std::vector<Column> _Columns;
             friend class HtmlTable;
         };
 
-        Row& operator<<(const Row row);
+        Row& operator<<(const Row &row);
         Row& operator[](size_t pos);
 
+        size_t getRows() const;
+
+        /*appends the table as tr and td elements to element*/
         void insert(HtmlElement *element);
+
+        /*
+         * replaces the table with the rows of element or the first table
+         * below it. Cells get the decoded text without surrounding
+         * whitespace, a cell with colspan or rowspan is repeated in every
+         * column and row it covers. The first row in thead or of th cells
+         * becomes the header. HtmlTableReader does the same for streams.
+         */
         void parse(HtmlElement *element);
 
+        /*writes the table markup straight to output without building a dom*/
+        void print(HtmlString &output) const;
+
+        /*writes header and rows as Csv, Tsv or Json, see HtmlTableWriter*/
+        void write(std::ostream &output,int format) const;
+
         void setHeader(int count,...);
         void deleteRow(size_t pos);
     private:
-        Row     *_firstRow;
-        Row     *_lastRow;
-        Row      _header;
-        size_t   _count;
+        std::vector<Row> _Rows;
+        Row              _header;
     };
 };
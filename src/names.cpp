@@ -0,0 +1,209 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <stdint.h>
+#include <string.h>
+
+#include "names.h"
+
+namespace libhtmlpp {
+    static const char *TagNames[]={
+        "a","abbr","acronym","address","applet","area","article","aside","audio",
+        "b","base","basefont","bdi","bdo","big","blink","blockquote","body","br",
+        "button","canvas","caption","center","cite","code","col","colgroup","data",
+        "datalist","dd","del","details","dfn","dialog","dir","div","dl","dt","em",
+        "embed","fieldset","figcaption","figure","font","footer","form","frame",
+        "frameset","h1","h2","h3","h4","h5","h6","head","header","hgroup","hr",
+        "html","i","iframe","image","img","input","ins","kbd","keygen","label",
+        "legend","li","link","listing","main","map","mark","marquee","math","menu",
+        "meta","meter","nav","nobr","noembed","noframes","noscript","object","ol",
+        "optgroup","option","output","p","param","picture","plaintext","pre",
+        "progress","q","rb","rp","rt","rtc","ruby","s","samp","script","search",
+        "section","select","slot","small","source","span","strike","strong",
+        "style","sub","summary","sup","svg","table","tbody","td","template",
+        "textarea","tfoot","th","thead","time","title","tr","track","tt","u",
+        "ul","var","video","wbr","xmp",nullptr
+    };
+
+    static const char *VoidTags[]={
+        "area","base","basefont","br","col","embed","frame","hr","image","img",
+        "input","keygen","link","meta","param","source","track","wbr",nullptr
+    };
+
+    static const char *AttributeNames[]={
+        "abbr","accept","accept-charset","accesskey","action","align","alink",
+        "allow","allowfullscreen","alt","async","autocapitalize","autocomplete",
+        "autofocus","autoplay","axis","background","bgcolor","border",
+        "cellpadding","cellspacing","char","charoff","charset","checked","cite",
+        "class","clear","color","cols","colspan","compact","content",
+        "contenteditable","controls","coords","crossorigin","data","datetime",
+        "decoding","default","defer","dir","dirname","disabled","download",
+        "draggable","enctype","enterkeyhint","face","for","form","formaction",
+        "formenctype","formmethod","formnovalidate","formtarget","frame",
+        "frameborder","headers","height","hidden","high","href","hreflang",
+        "hspace","http-equiv","id","inert","inputmode","integrity","is","ismap",
+        "itemid","itemprop","itemref","itemscope","itemtype","kind","label",
+        "lang","list","loading","longdesc","loop","low","marginheight",
+        "marginwidth","max","maxlength","media","method","min","minlength",
+        "multiple","muted","name","nomodule","nonce","noshade","novalidate",
+        "nowrap","open","optimum","pattern","ping","placeholder","playsinline",
+        "popover","poster","preload","readonly","referrerpolicy","rel",
+        "required","rev","reversed","role","rows","rowspan","rules","sandbox",
+        "scope","scrolling","selected","shape","size","sizes","slot","span",
+        "spellcheck","src","srcdoc","srclang","srcset","start","step","style",
+        "summary","tabindex","target","text","title","translate","type",
+        "usemap","valign","value","vspace","width","wrap","xmlns",nullptr
+    };
+
+    #define NAMES_HASHSIZE 1024
+
+    static inline uint8_t _lower(char c){
+        return (c>='A' && c<='Z') ? c|0x20 : c;
+    }
+
+    /*
+     * open addressing table from the hash of the lower case name to id+1,
+     * built once on first use
+     */
+    class NameTable {
+    public:
+        NameTable(const char **names){
+            memset(_Slots,0,sizeof(_Slots));
+            for(_Count=0; names[_Count]; ++_Count){
+                size_t len=strlen(names[_Count]);
+                uint32_t slot=hash(names[_Count],len);
+                while(_Slots[slot])
+                    slot=(slot+1)&(NAMES_HASHSIZE-1);
+                _Slots[slot]=_Count+1;
+            }
+            _Names=names;
+        }
+
+        static inline uint32_t hash(const char *name,size_t nlen){
+            uint32_t h=2166136261u;
+            for(size_t i=0; i<nlen; ++i)
+                h=(h^_lower(name[i]))*16777619u;
+            return (h^(h>>15))&(NAMES_HASHSIZE-1);
+        }
+
+        int find(const char *name,size_t nlen) const {
+            if(nlen==0 || nlen>16)
+                return -1;
+            for(uint32_t slot=hash(name,nlen); _Slots[slot]; slot=(slot+1)&(NAMES_HASHSIZE-1)){
+                const char *cmp=_Names[_Slots[slot]-1];
+                size_t i=0;
+                while(i<nlen && cmp[i] && _lower(name[i])==(uint8_t)cmp[i])
+                    ++i;
+                if(i==nlen && cmp[i]=='\0')
+                    return _Slots[slot]-1;
+            }
+            return -1;
+        }
+
+        const char **_Names;
+        size_t       _Count;
+        uint16_t     _Slots[NAMES_HASHSIZE];
+    };
+
+    static const NameTable &_tags(){
+        static NameTable table(TagNames);
+        return table;
+    }
+
+    static const NameTable &_attributes(){
+        static NameTable table(AttributeNames);
+        return table;
+    }
+
+    static const bool *_voids(){
+        static struct VoidTable {
+            VoidTable(){
+                memset(Void,0,sizeof(Void));
+                for(size_t i=0; VoidTags[i]; ++i)
+                    Void[_tags().find(VoidTags[i],strlen(VoidTags[i]))]=true;
+            }
+            bool Void[HTML_MAXNAMES];
+        } table;
+        return table.Void;
+    }
+};
+
+int libhtmlpp::HtmlNames::getTag(const char *name,size_t nlen){
+    return _tags().find(name,nlen);
+}
+
+int libhtmlpp::HtmlNames::getTag(const char *name){
+    return _tags().find(name,strlen(name));
+}
+
+int libhtmlpp::HtmlNames::getAttribute(const char *name,size_t nlen){
+    return _attributes().find(name,nlen);
+}
+
+int libhtmlpp::HtmlNames::getAttribute(const char *name){
+    return _attributes().find(name,strlen(name));
+}
+
+const char *libhtmlpp::HtmlNames::getTagName(int id){
+    if(id<0 || (size_t)id>=_tags()._Count)
+        return nullptr;
+    return TagNames[id];
+}
+
+const char *libhtmlpp::HtmlNames::getAttributeName(int id){
+    if(id<0 || (size_t)id>=_attributes()._Count)
+        return nullptr;
+    return AttributeNames[id];
+}
+
+size_t libhtmlpp::HtmlNames::getTagCount(){
+    return _tags()._Count;
+}
+
+size_t libhtmlpp::HtmlNames::getAttributeCount(){
+    return _attributes()._Count;
+}
+
+bool libhtmlpp::HtmlNames::isVoid(int tag){
+    return tag>=0 && tag<HTML_MAXNAMES && _voids()[tag];
+}
+
+bool libhtmlpp::HtmlNames::isVoid(const char *name,size_t nlen){
+    if(nlen>0 && (name[0]=='!' || name[0]=='?'))
+        return true;
+    return isVoid(getTag(name,nlen));
+}
+
+bool libhtmlpp::HtmlNames::equals(const char *name,size_t nlen,const char *cmp,size_t clen){
+    if(nlen!=clen)
+        return false;
+    for(size_t i=0; i<nlen; ++i){
+        if(_lower(name[i])!=_lower(cmp[i]))
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,62 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <stddef.h>
+
+#pragma once
+
+//upper bound of the tag and attribute ids, policies keep bitsets of this size
+#define HTML_MAXNAMES 256
+
+namespace libhtmlpp {
+
+    /*
+     * interned tag and attribute names of html. The ids are the positions
+     * in static sorted tables and stay the same between builds of the same
+     * version, the lookup is case insensitive and returns -1 for names
+     * that aren't known, like custom elements and event handlers.
+     */
+    class HtmlNames {
+    public:
+        static int         getTag(const char *name,size_t nlen);
+        static int         getTag(const char *name);
+        static int         getAttribute(const char *name,size_t nlen);
+        static int         getAttribute(const char *name);
+
+        static const char *getTagName(int id);
+        static const char *getAttributeName(int id);
+        static size_t      getTagCount();
+        static size_t      getAttributeCount();
+
+        //elements without content and end tag like br and img
+        static bool        isVoid(int tag);
+        //void elements by name, <!DOCTYPE> and <?xml ?> count as void too
+        static bool        isVoid(const char *name,size_t nlen);
+        //compares two names case insensitive like html does
+        static bool        equals(const char *name,size_t nlen,const char *cmp,size_t clen);
+    };
+};
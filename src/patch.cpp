@@ -0,0 +1,550 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <string.h>
+
+#include <algorithm>
+#include <stack>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "exception.h"
+#include "patch.h"
+
+namespace libhtmlpp {
+
+    static bool _compatible(const Element *oldel,const Element *newel){
+        if(oldel->getType()!=newel->getType())
+            return false;
+        if(oldel->getType()!=HtmlEl)
+            return true;
+        return *((HtmlElement*)oldel)==(HtmlElement*)newel;
+    }
+
+    static const char *_id(const Element *el){
+        if(el->getType()!=HtmlEl)
+            return nullptr;
+        return ((HtmlElement*)el)->getAtributte("id");
+    }
+
+    static Element *_at(Element *first,size_t pos){
+        Element *curel=first;
+        while(curel && pos>0){
+            curel=curel->nextElement();
+            --pos;
+        }
+        if(!curel){
+            HTMLException excp;
+            excp[HTMLException::Error] << "HtmlPatch: path doesn't match the document!";
+            throw excp;
+        }
+        return curel;
+    }
+
+    static Element *_clone(const Element *el){
+        Element *nel;
+        switch(el->getType()){
+            case HtmlEl:
+                nel=new HtmlElement();
+                break;
+            case TextEl:
+                nel=new TextElement();
+                break;
+            default:
+                nel=new CommentElement();
+        }
+        _copy(nel,el);
+        return nel;
+    }
+
+    static void _throwFrozen(){
+        HTMLException excp;
+        excp[HTMLException::Error] << "frozen html can't be modified!";
+        throw excp;
+    }
+
+    static void _appendJson(HtmlString &output,const char *src,size_t size){
+        const char hex[]="0123456789abcdef";
+        output.push_back('"');
+        for(size_t i=0; i<size; ++i){
+            switch(src[i]){
+                case '"':
+                    output.append("\\\"");
+                    break;
+                case '\\':
+                    output.append("\\\\");
+                    break;
+                case '\n':
+                    output.append("\\n");
+                    break;
+                case '\r':
+                    output.append("\\r");
+                    break;
+                case '\t':
+                    output.append("\\t");
+                    break;
+                default:
+                    if((unsigned char)src[i]<0x20){
+                        output.append("\\u00");
+                        output.push_back(hex[(unsigned char)src[i]>>4]);
+                        output.push_back(hex[src[i]&0xf]);
+                    }else{
+                        output.push_back(src[i]);
+                    }
+            }
+        }
+        output.push_back('"');
+    }
+};
+
+libhtmlpp::HtmlPatch::HtmlPatch(){
+}
+
+libhtmlpp::HtmlPatch::~HtmlPatch(){
+    clear();
+}
+
+void libhtmlpp::HtmlPatch::clear(){
+    for(size_t i=0; i<_Operations.size(); ++i){
+        _delete(_Operations[i].Node);
+    }
+    _Operations.clear();
+}
+
+size_t libhtmlpp::HtmlPatch::size() const{
+    return _Operations.size();
+}
+
+const libhtmlpp::HtmlPatch::Operation &libhtmlpp::HtmlPatch::operator[](size_t pos) const{
+    return _Operations[pos];
+}
+
+libhtmlpp::HtmlPatch::Operation &libhtmlpp::HtmlPatch::_addOperation(int type,const std::vector<size_t> &path){
+    _Operations.emplace_back();
+    Operation &op=_Operations.back();
+    op.Type=type;
+    op.Path=path;
+    op.Node=nullptr;
+    return op;
+}
+
+bool libhtmlpp::HtmlPatch::_equal(const Element *oldel,const Element *newel){
+    std::stack<std::pair<const Element*,const Element*>> pending;
+    pending.push({oldel,newel});
+    while(!pending.empty()){
+        const Element *oel=pending.top().first,*nel=pending.top().second;
+        pending.pop();
+        if(!_compatible(oel,nel))
+            return false;
+        switch(oel->getType()){
+            case HtmlEl:{
+                HtmlElement::Attributes *oattr=((HtmlElement*)oel)->_firstAttr,
+                                        *nattr=((HtmlElement*)nel)->_firstAttr;
+                for(; oattr && nattr; oattr=oattr->_nextAttr,nattr=nattr->_nextAttr){
+                    if(oattr->_Key!=nattr->_Key || oattr->_Value!=nattr->_Value)
+                        return false;
+                }
+                if(oattr || nattr)
+                    return false;
+                const Element *ochild=((HtmlElement*)oel)->_children(),
+                              *nchild=((HtmlElement*)nel)->_children();
+                for(; ochild && nchild; ochild=ochild->nextElement(),nchild=nchild->nextElement())
+                    pending.push({ochild,nchild});
+                if(ochild || nchild)
+                    return false;
+            }break;
+            case TextEl:
+                if(((TextElement*)oel)->_Text!=((TextElement*)nel)->_Text)
+                    return false;
+                break;
+            case CommentEl:
+                if(((CommentElement*)oel)->_Comment!=((CommentElement*)nel)->_Comment)
+                    return false;
+                break;
+        }
+    }
+    return true;
+}
+
+void libhtmlpp::HtmlPatch::create(const Element *oldel,const Element *newel){
+    struct Children {
+        const Element       *Old;
+        const Element       *New;
+        std::vector<size_t>  Path;
+    };
+
+    std::stack<Children> childlist;
+    std::vector<const Element*> olds,news;
+    std::vector<long> match,lis,pred;
+    std::vector<bool> used,equal;
+    std::vector<size_t> unkeyed,nunkeyed;
+    std::unordered_map<std::string,size_t> keys;
+
+    clear();
+    childlist.push({oldel,newel,std::vector<size_t>()});
+
+    while(!childlist.empty()){
+        Children cur=childlist.top();
+        childlist.pop();
+
+        olds.clear();
+        news.clear();
+        for(const Element *curel=cur.Old; curel; curel=curel->nextElement())
+            olds.push_back(curel);
+        for(const Element *curel=cur.New; curel; curel=curel->nextElement())
+            news.push_back(curel);
+
+        //match by id first
+        keys.clear();
+        unkeyed.clear();
+        nunkeyed.clear();
+        used.assign(olds.size(),false);
+        match.assign(news.size(),-1);
+        equal.assign(news.size(),false);
+        for(size_t i=0; i<olds.size(); ++i){
+            const char *id=_id(olds[i]);
+            if(id)
+                keys.emplace(id,i);
+            else
+                unkeyed.push_back(i);
+        }
+
+        for(size_t i=0; i<news.size(); ++i){
+            const char *id=_id(news[i]);
+            if(!id){
+                nunkeyed.push_back(i);
+                continue;
+            }
+            auto key=keys.find(id);
+            if(key==keys.end() || used[key->second] || !_compatible(olds[key->second],news[i]))
+                continue;
+            match[i]=key->second;
+            used[key->second]=true;
+        }
+
+        /*
+         * equal children without id at the begin and the end stay where
+         * they are, so an insert in front doesn't shift every text. The
+         * rest is matched in order with the next child of the same tag
+         * within a few children, which keeps long lists linear.
+         */
+        size_t count=std::min(unkeyed.size(),nunkeyed.size()),front=0,back=0;
+        while(front<count && _equal(olds[unkeyed[front]],news[nunkeyed[front]])){
+            match[nunkeyed[front]]=unkeyed[front];
+            used[unkeyed[front]]=true;
+            equal[nunkeyed[front]]=true;
+            ++front;
+        }
+        while(front+back<count && _equal(olds[unkeyed[unkeyed.size()-1-back]],news[nunkeyed[nunkeyed.size()-1-back]])){
+            match[nunkeyed[nunkeyed.size()-1-back]]=unkeyed[unkeyed.size()-1-back];
+            used[unkeyed[unkeyed.size()-1-back]]=true;
+            equal[nunkeyed[nunkeyed.size()-1-back]]=true;
+            ++back;
+        }
+
+        size_t upos=front;
+        for(size_t i=front; i<nunkeyed.size()-back; ++i){
+            for(size_t j=upos; j<unkeyed.size()-back && j<upos+16; ++j){
+                if(_compatible(olds[unkeyed[j]],news[nunkeyed[i]])){
+                    match[nunkeyed[i]]=unkeyed[j];
+                    used[unkeyed[j]]=true;
+                    upos=j+1;
+                    break;
+                }
+            }
+        }
+
+        //keep the longest run of matches in old order, the rest is moved
+        lis.clear();
+        pred.assign(news.size(),-1);
+        for(size_t i=0; i<news.size(); ++i){
+            if(match[i]<0)
+                continue;
+            size_t lo=0,hi=lis.size();
+            while(lo<hi){
+                size_t mid=(lo+hi)/2;
+                if(match[lis[mid]]<match[i])
+                    lo=mid+1;
+                else
+                    hi=mid;
+            }
+            if(lo>0)
+                pred[i]=lis[lo-1];
+            if(lo==lis.size())
+                lis.push_back(i);
+            else
+                lis[lo]=i;
+        }
+
+        std::vector<bool> keep(news.size(),false);
+        for(long i=lis.empty() ? -1 : lis.back(); i>=0; i=pred[i])
+            keep[i]=true;
+
+        for(size_t i=0; i<news.size(); ++i){
+            if(match[i]>=0 && !keep[i]){
+                used[match[i]]=false;
+                match[i]=-1;
+            }
+        }
+
+        //remove from the back so the indexes in front stay valid
+        std::vector<size_t> path=cur.Path;
+        path.push_back(0);
+        for(size_t i=olds.size(); i>0; --i){
+            if(used[i-1])
+                continue;
+            path.back()=i-1;
+            _addOperation(Remove,path);
+        }
+
+        for(size_t i=0; i<news.size(); ++i){
+            path.back()=i;
+            const Element *nel=news[i];
+
+            if(match[i]<0){
+                Operation &op=_addOperation(Insert,path);
+                switch(nel->getType()){
+                    case HtmlEl:{
+                        HtmlElement *hel=new HtmlElement();
+                        op.Node=hel;
+                        hel->_TagName=((HtmlElement*)nel)->_TagName;
+                        for(HtmlElement::Attributes *cattr=((HtmlElement*)nel)->_firstAttr; cattr; cattr=cattr->_nextAttr){
+                            hel->setAttribute(cattr->_Key.data(),cattr->_Key.size(),cattr->_Value.data(),cattr->_Value.size());
+                        }
+                        if(((HtmlElement*)nel)->_children()){
+                            const Element *child=((HtmlElement*)nel)->_children();
+                            if(child->getType()==HtmlEl)
+                                hel->_childElement=new HtmlElement();
+                            else if(child->getType()==TextEl)
+                                hel->_childElement=new TextElement();
+                            else
+                                hel->_childElement=new CommentElement();
+                            hel->_childElement->_parentElement=hel;
+                            _copy(hel->_childElement,child);
+                        }
+                    }break;
+                    case TextEl:
+                        op.Node=new TextElement();
+                        ((TextElement*)op.Node)->_Text=((TextElement*)nel)->_Text;
+                        break;
+                    case CommentEl:
+                        op.Node=new CommentElement();
+                        ((CommentElement*)op.Node)->_Comment=((CommentElement*)nel)->_Comment;
+                        break;
+                }
+                continue;
+            }
+
+            //nothing to do for the equal children at the begin and the end
+            if(equal[i])
+                continue;
+
+            const Element *oel=olds[match[i]];
+            switch(nel->getType()){
+                case HtmlEl:{
+                    HtmlElement *ohel=(HtmlElement*)oel,*nhel=(HtmlElement*)nel;
+                    for(HtmlElement::Attributes *nattr=nhel->_firstAttr; nattr; nattr=nattr->_nextAttr){
+                        HtmlElement::Attributes *oattr=ohel->_firstAttr;
+                        while(oattr && oattr->_Key!=nattr->_Key)
+                            oattr=oattr->_nextAttr;
+                        if(oattr && oattr->_Value==nattr->_Value)
+                            continue;
+                        Operation &op=_addOperation(SetAttribute,path);
+                        op.Key=nattr->_Key;
+                        op.Value=nattr->_Value;
+                    }
+                    for(HtmlElement::Attributes *oattr=ohel->_firstAttr; oattr; oattr=oattr->_nextAttr){
+                        HtmlElement::Attributes *nattr=nhel->_firstAttr;
+                        while(nattr && nattr->_Key!=oattr->_Key)
+                            nattr=nattr->_nextAttr;
+                        if(nattr)
+                            continue;
+                        _addOperation(DelAttribute,path).Key=oattr->_Key;
+                    }
+                    if(ohel->_children() || nhel->_children())
+                        childlist.push({ohel->_children(),nhel->_children(),path});
+                }break;
+                case TextEl:
+                    if(((TextElement*)oel)->_Text!=((TextElement*)nel)->_Text)
+                        _addOperation(SetText,path).Value=((TextElement*)nel)->_Text;
+                    break;
+                case CommentEl:
+                    if(((CommentElement*)oel)->_Comment!=((CommentElement*)nel)->_Comment)
+                        _addOperation(SetText,path).Value=((CommentElement*)nel)->_Comment;
+                    break;
+            }
+        }
+    }
+}
+
+void libhtmlpp::HtmlPatch::apply(Element *el) const{
+    _apply(&el,false);
+}
+
+libhtmlpp::Element *libhtmlpp::HtmlPatch::apply(HtmlString &doc) const{
+    if(doc._Frozen)
+        _throwFrozen();
+    Element *root=doc._RootNode;
+    try{
+        _apply(&root,true);
+    }catch(HTMLException &e){
+        doc._RootNode=root;
+        throw;
+    }
+    doc._RootNode=root;
+    return root;
+}
+
+void libhtmlpp::HtmlPatch::_apply(Element **root,bool movable) const{
+    for(size_t i=0; i<_Operations.size(); ++i){
+        const Operation &op=_Operations[i];
+        //head is the link to the first child, in the parent or the document
+        Element **head=root;
+        HtmlElement *parent=nullptr;
+
+        for(size_t lvl=0; lvl+1<op.Path.size(); ++lvl){
+            Element *curel=_at(*head,op.Path[lvl]);
+            if(curel->getType()!=HtmlEl){
+                HTMLException excp;
+                excp[HTMLException::Error] << "HtmlPatch: path doesn't match the document!";
+                throw excp;
+            }
+            parent=(HtmlElement*)curel;
+            parent->_children();
+            head=&parent->_childElement;
+        }
+
+        size_t pos=op.Path.back();
+
+        if(pos==0 && !parent && !movable && (op.Type==Insert ? *head!=nullptr : op.Type==Remove)){
+            HTMLException excp;
+            excp[HTMLException::Error] << "HtmlPatch: the first element of a document can only be replaced through the HtmlString!";
+            throw excp;
+        }
+
+        switch(op.Type){
+            case Insert:
+                if(pos>0){
+                    _at(*head,pos-1)->insertAfter(op.Node);
+                }else{
+                    if((parent && parent->_Frozen) || (*head && (*head)->_Frozen))
+                        _throwFrozen();
+                    Element *nel=_clone(op.Node);
+                    nel->_parentElement=parent;
+                    nel->_nextElement=*head;
+                    if(*head)
+                        (*head)->_prevElement=nel;
+                    *head=nel;
+                    if(parent)
+                        parent->_markDirty();
+                }
+                break;
+            case Remove:{
+                Element *target=_at(*head,pos);
+                if(target->_Frozen || (parent && parent->_Frozen))
+                    _throwFrozen();
+                Element *prev=target->_prevElement,*next=target->_nextElement;
+                if(prev){
+                    prev->_nextElement=next;
+                    prev->_markDirty();
+                }else{
+                    *head=next;
+                    if(parent)
+                        parent->_markDirty();
+                }
+                if(next)
+                    next->_prevElement=prev;
+                target->_prevElement=nullptr;
+                target->_nextElement=nullptr;
+                _delete(target);
+            }break;
+            case SetAttribute:{
+                Element *target=_at(*head,pos);
+                if(target->getType()==HtmlEl)
+                    ((HtmlElement*)target)->setAttribute(op.Key.data(),op.Key.size(),op.Value.data(),op.Value.size());
+            }break;
+            case DelAttribute:{
+                Element *target=_at(*head,pos);
+                if(target->getType()==HtmlEl)
+                    ((HtmlElement*)target)->delAttribute(std::string(op.Key.data(),op.Key.size()).c_str());
+            }break;
+            case SetText:{
+                Element *target=_at(*head,pos);
+                std::string value(op.Value.data(),op.Value.size());
+                if(target->getType()==TextEl)
+                    ((TextElement*)target)->setText(value.c_str());
+                else if(target->getType()==CommentEl)
+                    ((CommentElement*)target)->setComment(value.c_str());
+            }break;
+        }
+    }
+}
+
+void libhtmlpp::HtmlPatch::print(HtmlString &output) const{
+    const char types[]={'i','r','a','d','t'};
+
+    output.push_back('[');
+    for(size_t i=0; i<_Operations.size(); ++i){
+        const Operation &op=_Operations[i];
+        if(i>0)
+            output.push_back(',');
+        output.append("[\"");
+        output.push_back(types[op.Type]);
+        output.append("\",[");
+        for(size_t lvl=0; lvl<op.Path.size(); ++lvl){
+            if(lvl>0)
+                output.push_back(',');
+            output << (unsigned long)op.Path[lvl];
+        }
+        output.push_back(']');
+        switch(op.Type){
+            case Insert:{
+                HtmlString node;
+                libhtmlpp::print(op.Node,node);
+                output.push_back(',');
+                _appendJson(output,node.c_str(),node.size());
+            }break;
+            case SetAttribute:
+                output.push_back(',');
+                _appendJson(output,op.Key.data(),op.Key.size());
+                output.push_back(',');
+                _appendJson(output,op.Value.data(),op.Value.size());
+                break;
+            case DelAttribute:
+                output.push_back(',');
+                _appendJson(output,op.Key.data(),op.Key.size());
+                break;
+            case SetText:
+                output.push_back(',');
+                _appendJson(output,op.Value.data(),op.Value.size());
+                break;
+        }
+        output.push_back(']');
+    }
+    output.push_back(']');
+}
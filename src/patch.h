@@ -0,0 +1,96 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <vector>
+
+#include "html.h"
+
+#pragma once
+
+namespace libhtmlpp {
+
+    /*
+     * list of operations that turns one tree into another. create() matches
+     * children by their id attribute, children without id that are equal at
+     * the begin and the end of a list stay, the rest is matched in order by
+     * tag name. Matched children that changed their order are removed and
+     * inserted again. Every operation addresses its node by the child indexes from
+     * the first element of the document, the operations have to be applied
+     * in order because every path is valid after the operations before it.
+     * print() writes the list as json for clients that patch their own dom:
+     *
+     *   [["i",[1,0,3],"<li>new</li>"],["r",[1,0,5]],
+     *    ["a",[1,0],"class","on"],["d",[1,0],"hidden"],["t",[1,0,0,0],"42"]]
+     */
+    class HtmlPatch {
+    public:
+        enum OperationType {Insert=0,Remove=1,SetAttribute=2,DelAttribute=3,SetText=4};
+
+        struct Operation {
+            int                 Type;
+            std::vector<size_t> Path;
+            //attribute name for SetAttribute and DelAttribute
+            std::vector<char>   Key;
+            //attribute value for SetAttribute, text or comment for SetText
+            std::vector<char>   Value;
+            //copy of the inserted element with its children for Insert
+            Element            *Node;
+        };
+
+        HtmlPatch();
+        ~HtmlPatch();
+
+        /*compares oldel and newel with their following siblings and children*/
+        void             create(const Element *oldel,const Element *newel);
+
+        /*
+         * applies the operations to el, the first element of the old
+         * document. el itself can't be replaced, patches that insert in
+         * front of it or remove it throw, apply them to the HtmlString.
+         */
+        void             apply(Element *el) const;
+        /*
+         * applies the operations to the tree of the last doc.parse() and
+         * returns its first element, which may be a new one now
+         */
+        Element         *apply(HtmlString &doc) const;
+
+        size_t           size() const;
+        const Operation &operator[](size_t pos) const;
+
+        void             print(HtmlString &output) const;
+        void             clear();
+    private:
+        Operation       &_addOperation(int type,const std::vector<size_t> &path);
+        //compares two elements with their children, not their following siblings
+        static bool      _equal(const Element *oldel,const Element *newel);
+        //root points to the first element of the document, movable if it can change
+        void             _apply(Element **root,bool movable) const;
+
+        std::vector<Operation> _Operations;
+    };
+};
@@ -1 +1,462 @@
- 
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <string.h>
+
+#include <algorithm>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "exception.h"
+#include "request.h"
+#include "tokenizer.h"
+
+//a part with more header bytes is refused
+#define MULTIPART_MAXHEADERS 16384
+
+namespace libhtmlpp {
+    //length of the run without % and, if plus is set, without +
+    static size_t _urlPlain(const char *data,size_t size,bool plus){
+        if(!plus){
+            const char *pct=(const char*)memchr(data,'%',size);
+            return pct ? pct-data : size;
+        }
+        size_t i=0;
+#ifdef __SSE2__
+        const __m128i pct=_mm_set1_epi8('%'),plu=_mm_set1_epi8('+');
+        for(; i+16<=size; i+=16){
+            __m128i chunk=_mm_loadu_si128((const __m128i*)(data+i));
+            int mask=_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk,pct),_mm_cmpeq_epi8(chunk,plu)));
+            if(mask)
+                return i+__builtin_ctz(mask);
+        }
+#endif
+        for(; i<size; ++i){
+            if(data[i]=='%' || data[i]=='+')
+                break;
+        }
+        return i;
+    }
+
+    static inline int _urlHex(char c){
+        if(c>='0' && c<='9')
+            return c-'0';
+        c|=0x20;
+        if(c>='a' && c<='f')
+            return c-'a'+10;
+        return -1;
+    }
+
+    static const char *_mpFind(const char *data,size_t size,const char *pat,size_t plen){
+        if(size<plen)
+            return nullptr;
+        const char *end=data+size-plen+1;
+        for(const char *pos=data; pos<end; ++pos){
+            pos=(const char*)memchr(pos,pat[0],end-pos);
+            if(!pos)
+                return nullptr;
+            if(memcmp(pos,pat,plen)==0)
+                return pos;
+        }
+        return nullptr;
+    }
+
+    //first position from where the rest of the block could be the start of pat
+    static size_t _mpTail(const char *data,size_t pos,size_t size,const char *pat,size_t plen){
+        for(size_t p=size-pos>=plen ? size-plen+1 : pos; p<size; ++p){
+            const char *start=(const char*)memchr(data+p,pat[0],size-p);
+            if(!start)
+                return size;
+            p=start-data;
+            if(memcmp(start,pat,size-p)==0)
+                return p;
+        }
+        return size;
+    }
+
+    static inline bool _mpSpace(char c){
+        return c==' ' || c=='\t';
+    }
+
+    //value of a parameter like name="x" in a header value, name in lower case
+    static bool _mpParameter(const char *value,size_t vlen,const char *name,const char *&out,size_t &olen){
+        size_t i=0;
+        while(i<vlen){
+            //parameters start after a ; outside of quotes
+            bool quote=false;
+            while(i<vlen && (quote || value[i]!=';')){
+                if(value[i]=='"')
+                    quote=!quote;
+                else if(value[i]=='\\' && quote)
+                    ++i;
+                ++i;
+            }
+            if(i>=vlen)
+                return false;
+            ++i;
+            while(i<vlen && _mpSpace(value[i]))
+                ++i;
+
+            size_t key=i;
+            while(i<vlen && value[i]!='=' && value[i]!=';' && !_mpSpace(value[i]))
+                ++i;
+            size_t klen=i-key;
+            while(i<vlen && _mpSpace(value[i]))
+                ++i;
+            if(i>=vlen || value[i]!='=')
+                continue;
+            ++i;
+            while(i<vlen && _mpSpace(value[i]))
+                ++i;
+
+            size_t start=i,end;
+            if(i<vlen && value[i]=='"'){
+                start=++i;
+                while(i<vlen && value[i]!='"'){
+                    if(value[i]=='\\')
+                        ++i;
+                    ++i;
+                }
+                end=std::min(i,vlen);
+                if(i<vlen)
+                    ++i;
+            }else{
+                while(i<vlen && value[i]!=';' && !_mpSpace(value[i]))
+                    ++i;
+                end=i;
+            }
+
+            if(HtmlTokenizer::isName(value+key,klen,name)){
+                out=value+start;
+                olen=end-start;
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+size_t libhtmlpp::UrlDecode(char *data,size_t size,bool plus){
+    size_t in=_urlPlain(data,size,plus);
+    size_t out=in;
+
+    while(in<size){
+        char c=data[in];
+        if(c=='+' && plus){
+            data[out++]=' ';
+            ++in;
+        }else if(c=='%' && in+2<size && _urlHex(data[in+1])>=0 && _urlHex(data[in+2])>=0){
+            data[out++]=(char)(_urlHex(data[in+1])<<4 | _urlHex(data[in+2]));
+            in+=3;
+        }else{
+            data[out++]=c;
+            ++in;
+        }
+        size_t run=_urlPlain(data+in,size-in,plus);
+        memmove(data+out,data+in,run);
+        in+=run;
+        out+=run;
+    }
+    return out;
+}
+
+libhtmlpp::HtmlForm::HtmlForm(){
+}
+
+libhtmlpp::HtmlForm::~HtmlForm(){
+}
+
+void libhtmlpp::HtmlForm::parse(char *data,size_t size){
+    char *end=data+size;
+    while(data<end){
+        char *amp=(char*)memchr(data,'&',end-data);
+        if(!amp)
+            amp=end;
+        if(amp>data){
+            Field field;
+            char *eq=(char*)memchr(data,'=',amp-data);
+            field.Key=data;
+            field.KeySize=UrlDecode(data,(eq ? eq : amp)-data);
+            if(eq){
+                field.Value=eq+1;
+                field.ValueSize=UrlDecode(eq+1,amp-eq-1);
+            }else{
+                field.Value=amp;
+                field.ValueSize=0;
+            }
+            _Fields.push_back(field);
+        }
+        data=amp+1;
+    }
+}
+
+const libhtmlpp::HtmlForm::Field *libhtmlpp::HtmlForm::getField(const char *key) const{
+    size_t klen=strlen(key);
+    for(const Field &field : _Fields){
+        if(field.KeySize==klen && memcmp(field.Key,key,klen)==0)
+            return &field;
+    }
+    return nullptr;
+}
+
+size_t libhtmlpp::HtmlForm::size() const{
+    return _Fields.size();
+}
+
+const libhtmlpp::HtmlForm::Field &libhtmlpp::HtmlForm::operator[](size_t pos) const{
+    if(pos>=_Fields.size()){
+        HTMLException excp;
+        excp[HTMLException::Error] << "HtmlForm: field " << pos << " doesn't exist!";
+        throw excp;
+    }
+    return _Fields[pos];
+}
+
+void libhtmlpp::HtmlForm::clear(){
+    _Fields.clear();
+}
+
+libhtmlpp::HtmlMultipart::HtmlMultipart(){
+    _State=Preamble;
+}
+
+libhtmlpp::HtmlMultipart::HtmlMultipart(const char *boundary,size_t blen){
+    _State=Preamble;
+    setBoundary(boundary,blen);
+}
+
+libhtmlpp::HtmlMultipart::~HtmlMultipart(){
+}
+
+void libhtmlpp::HtmlMultipart::onPartBegin(const Part &part){
+}
+
+void libhtmlpp::HtmlMultipart::onPartData(const char *data,size_t size){
+}
+
+void libhtmlpp::HtmlMultipart::onPartEnd(){
+}
+
+void libhtmlpp::HtmlMultipart::onEnd(){
+}
+
+void libhtmlpp::HtmlMultipart::setBoundary(const char *boundary,size_t blen){
+    if(blen==0){
+        HTMLException excp;
+        excp[HTMLException::Error] << "HtmlMultipart: empty boundary!";
+        throw excp;
+    }
+    _Delimiter.assign({'\r','\n','-','-'});
+    _Delimiter.insert(_Delimiter.end(),boundary,boundary+blen);
+    reset();
+}
+
+void libhtmlpp::HtmlMultipart::setContentType(const char *contenttype,size_t len){
+    const char *boundary;
+    size_t blen;
+    if(!_mpParameter(contenttype,len,"boundary",boundary,blen)){
+        HTMLException excp;
+        excp[HTMLException::Error] << "HtmlMultipart: no boundary in content type!";
+        throw excp;
+    }
+    setBoundary(boundary,blen);
+}
+
+void libhtmlpp::HtmlMultipart::reset(){
+    _Pending.clear();
+    _Headers.clear();
+    _State=Preamble;
+}
+
+void libhtmlpp::HtmlMultipart::feed(const char *data,size_t size){
+    if(_Delimiter.empty()){
+        HTMLException excp;
+        excp[HTMLException::Error] << "HtmlMultipart: no boundary set!";
+        throw excp;
+    }
+
+    if(!_Pending.empty()){
+        //only the bytes needed to get past the kept ones are copied
+        size_t old=_Pending.size(),take=std::min(size,_Delimiter.size()+4);
+        _Pending.insert(_Pending.end(),data,data+take);
+        size_t used=_scan(_Pending.data(),_Pending.size(),false);
+        if(used<old){
+            //unfinished headers
+            _Pending.erase(_Pending.begin(),_Pending.begin()+used);
+            _Pending.insert(_Pending.end(),data+take,data+size);
+            used=_scan(_Pending.data(),_Pending.size(),false);
+            _Pending.erase(_Pending.begin(),_Pending.begin()+used);
+            return;
+        }
+        _Pending.clear();
+        data+=used-old;
+        size-=used-old;
+    }
+
+    size_t used=_scan(data,size,false);
+    _Pending.assign(data+used,data+size);
+}
+
+void libhtmlpp::HtmlMultipart::finish(){
+    std::vector<char> rest;
+    rest.swap(_Pending);
+    _scan(rest.data(),rest.size(),true);
+    _Headers.clear();
+    _State=Preamble;
+    onEnd();
+}
+
+size_t libhtmlpp::HtmlMultipart::_scan(const char *data,size_t size,bool last){
+    const char *delim=_Delimiter.data();
+    size_t dlen=_Delimiter.size(),pos=0;
+
+    auto error=[](const char *msg){
+        HTMLException excp;
+        excp[HTMLException::Error] << "HtmlMultipart: " << msg;
+        throw excp;
+    };
+
+    for(;;){
+        switch(_State){
+            case Preamble:{
+                //the first boundary doesn't need a line break before it
+                const char *hit=_mpFind(data+pos,size-pos,delim+2,dlen-2);
+                if(!hit)
+                    return last ? size : _mpTail(data,pos,size,delim+2,dlen-2);
+                pos=hit-data+dlen-2;
+                _State=Boundary;
+            }break;
+
+            case Boundary:{
+                size_t p=pos;
+                while(p<size && _mpSpace(data[p]))
+                    ++p;
+                if(size-p<2){
+                    if(last)
+                        error("data ends after a boundary!");
+                    return pos;
+                }
+                if(data[p]=='-' && data[p+1]=='-'){
+                    //the rest is an epilogue
+                    _State=Done;
+                    return size;
+                }
+                if(data[p]!='\r' || data[p+1]!='\n')
+                    error("boundary isn't followed by a line break!");
+                pos=p+2;
+                _State=Headers;
+            }break;
+
+            case Headers:{
+                const char *end;
+                size_t skip=4;
+                if(size-pos>=2 && data[pos]=='\r' && data[pos+1]=='\n'){
+                    end=data+pos;
+                    skip=2;
+                }else{
+                    end=_mpFind(data+pos,size-pos,"\r\n\r\n",4);
+                }
+                if(!end){
+                    if(size-pos>MULTIPART_MAXHEADERS)
+                        error("headers of a part are too big!");
+                    if(last)
+                        error("data ends in the headers of a part!");
+                    return pos;
+                }
+                _headers(data+pos,end-data-pos);
+                pos=end-data+skip;
+                _State=Body;
+            }break;
+
+            case Body:{
+                const char *hit=_mpFind(data+pos,size-pos,delim,dlen);
+                if(!hit){
+                    if(last)
+                        error("data ends inside a part!");
+                    size_t keep=_mpTail(data,pos,size,delim,dlen);
+                    if(keep>pos)
+                        onPartData(data+pos,keep-pos);
+                    return keep;
+                }
+                if(hit>data+pos)
+                    onPartData(data+pos,hit-data-pos);
+                onPartEnd();
+                pos=hit-data+dlen;
+                _State=Boundary;
+            }break;
+
+            default:
+                return size;
+        }
+    }
+}
+
+void libhtmlpp::HtmlMultipart::_headers(const char *data,size_t size){
+    Part part;
+    part.Name=nullptr;
+    part.NameSize=0;
+    part.Filename=nullptr;
+    part.FilenameSize=0;
+    part.ContentType=nullptr;
+    part.ContentTypeSize=0;
+
+    _Headers.clear();
+    size_t pos=0;
+    while(pos<size){
+        const char *eol=_mpFind(data+pos,size-pos,"\r\n",2);
+        size_t end=eol ? eol-data : size;
+        const char *colon=(const char*)memchr(data+pos,':',end-pos);
+        if(colon){
+            Header header;
+            header.Name=data+pos;
+            header.NameSize=colon-header.Name;
+            size_t vpos=colon-data+1,vend=end;
+            while(vpos<vend && _mpSpace(data[vpos]))
+                ++vpos;
+            while(vend>vpos && _mpSpace(data[vend-1]))
+                --vend;
+            header.Value=data+vpos;
+            header.ValueSize=vend-vpos;
+            _Headers.push_back(header);
+
+            if(HtmlTokenizer::isName(header.Name,header.NameSize,"content-disposition")){
+                _mpParameter(header.Value,header.ValueSize,"name",part.Name,part.NameSize);
+                _mpParameter(header.Value,header.ValueSize,"filename",part.Filename,part.FilenameSize);
+            }else if(HtmlTokenizer::isName(header.Name,header.NameSize,"content-type")){
+                part.ContentType=header.Value;
+                part.ContentTypeSize=header.ValueSize;
+            }
+        }
+        pos=end+2;
+    }
+
+    part.Headers=_Headers.data();
+    part.HeaderCount=_Headers.size();
+    onPartBegin(part);
+}
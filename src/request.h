@@ -1 +1,131 @@
- 
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <stddef.h>
+
+#include <string>
+#include <vector>
+
+#pragma once
+
+namespace libhtmlpp {
+
+    /*
+     * decodes %xx and, if plus is set, + to space in place and returns the
+     * new size. Malformed escapes are kept as they are.
+     */
+    size_t UrlDecode(char *data,size_t size,bool plus=true);
+
+    /*
+     * fields of application/x-www-form-urlencoded data like query strings
+     * and form bodies. parse() decodes every key and value in place where it
+     * is in the buffer, the fields point into it and aren't terminated.
+     * Every parse() appends, so the query string and the body of a request
+     * can end up in one form.
+     */
+    class HtmlForm {
+    public:
+        struct Field {
+            const char *Key;
+            size_t      KeySize;
+            const char *Value;
+            size_t      ValueSize;
+        };
+
+        HtmlForm();
+        ~HtmlForm();
+
+        void         parse(char *data,size_t size);
+
+        //first field with key, nullptr if there is none
+        const Field *getField(const char *key) const;
+
+        size_t       size() const;
+        const Field &operator[](size_t pos) const;
+        void         clear();
+    private:
+        std::vector<Field> _Fields;
+    };
+
+    /*
+     * streaming parser for multipart/form-data. Only the headers of a part
+     * and the last bytes of a block that could be the start of a boundary
+     * are kept between two feed() calls, the content of the parts is handed
+     * to onPartData() in pieces straight from the fed blocks. All pointers
+     * are only valid during the callback.
+     */
+    class HtmlMultipart {
+    public:
+        struct Header {
+            const char *Name;
+            size_t      NameSize;
+            const char *Value;
+            size_t      ValueSize;
+        };
+
+        struct Part {
+            const Header *Headers;
+            size_t        HeaderCount;
+            //name and filename of the Content-Disposition header
+            const char   *Name;
+            size_t        NameSize;
+            const char   *Filename;
+            size_t        FilenameSize;
+            const char   *ContentType;
+            size_t        ContentTypeSize;
+        };
+
+        HtmlMultipart();
+        //boundary without the leading dashes
+        HtmlMultipart(const char *boundary,size_t blen);
+        virtual ~HtmlMultipart();
+
+        void        setBoundary(const char *boundary,size_t blen);
+        //takes the boundary parameter of a Content-Type header value
+        void        setContentType(const char *contenttype,size_t len);
+
+        void        feed(const char *data,size_t size);
+        void        finish();
+        void        reset();
+    protected:
+        virtual void onPartBegin(const Part &part);
+        virtual void onPartData(const char *data,size_t size);
+        virtual void onPartEnd();
+        virtual void onEnd();
+    private:
+        size_t _scan(const char *data,size_t size,bool last);
+        void   _headers(const char *data,size_t size);
+
+        enum State {Preamble=0,Boundary,Headers,Body,Done};
+
+        //\r\n-- and the boundary
+        std::vector<char>   _Delimiter;
+        std::vector<char>   _Pending;
+        std::vector<Header> _Headers;
+        int                 _State;
+    };
+};
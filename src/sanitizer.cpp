@@ -0,0 +1,453 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <string.h>
+
+#include "exception.h"
+#include "sanitizer.h"
+
+namespace libhtmlpp {
+    //containers of scripts, styles, frames and foreign content
+    static const char *DropTags[]={
+        "applet","embed","frame","frameset","iframe","math","noembed","noframes",
+        "noscript","object","plaintext","script","style","svg","template",
+        "textarea","title","xmp",nullptr
+    };
+
+    //attributes holding urls, srcset holds a list of them
+    static const char *UrlAttributes[]={
+        "action","background","cite","data","formaction","href","longdesc",
+        "ping","poster","src","srcset",nullptr
+    };
+
+    static const char *BasicTags[]={
+        "a","abbr","b","blockquote","br","caption","cite","code","col","colgroup",
+        "dd","del","details","dfn","div","dl","dt","em","figcaption","figure",
+        "h1","h2","h3","h4","h5","h6","hr","i","img","ins","kbd","li","mark",
+        "ol","p","pre","q","rp","rt","ruby","s","samp","small","span","strike",
+        "strong","sub","summary","sup","table","tbody","td","tfoot","th",
+        "thead","time","tr","tt","u","ul","var",nullptr
+    };
+
+    //pairs of tag and attribute, nullptr as tag for all tags
+    static const char *BasicAttributes[][2]={
+        {nullptr,"title"},{nullptr,"lang"},{nullptr,"dir"},
+        {"a","href"},{"a","hreflang"},
+        {"img","src"},{"img","alt"},{"img","width"},{"img","height"},
+        {"td","colspan"},{"td","rowspan"},{"td","headers"},
+        {"th","colspan"},{"th","rowspan"},{"th","headers"},{"th","scope"},
+        {"col","span"},{"colgroup","span"},
+        {"ol","start"},{"ol","reversed"},{"ol","type"},{"li","value"},
+        {"blockquote","cite"},{"q","cite"},
+        {"del","cite"},{"del","datetime"},{"ins","cite"},{"ins","datetime"},
+        {"time","datetime"},{"details","open"},
+        {nullptr,nullptr}
+    };
+
+    static const char *StyleBlacklist[]={
+        "\\","expression","script:","behavior","binding","url(","@import",nullptr
+    };
+
+    static const HtmlPolicy::NameSet &_urlAttributes(){
+        static struct UrlTable {
+            UrlTable(){
+                for(size_t i=0; UrlAttributes[i]; ++i)
+                    Set.set(HtmlNames::getAttribute(UrlAttributes[i]));
+            }
+            HtmlPolicy::NameSet Set;
+        } table;
+        return table.Set;
+    }
+
+    static inline bool _schemeChar(char c){
+        return (c>='a' && c<='z') || (c>='0' && c<='9') || c=='+' || c=='-' || c=='.';
+    }
+};
+
+libhtmlpp::HtmlPolicy::HtmlPolicy(){
+    clear();
+}
+
+libhtmlpp::HtmlPolicy::~HtmlPolicy(){
+}
+
+int libhtmlpp::HtmlPolicy::_tag(const char *tag) const{
+    int id=HtmlNames::getTag(tag);
+    if(id<0){
+        HTMLException excp;
+        excp[HTMLException::Error] << "HtmlPolicy: unknown tag " << tag;
+        throw excp;
+    }
+    return id;
+}
+
+void libhtmlpp::HtmlPolicy::allowTag(const char *tag){
+    int id=_tag(tag);
+    _Tags.set(id);
+    _Drop.reset(id);
+}
+
+void libhtmlpp::HtmlPolicy::allowAttribute(const char *tag,const char *attr){
+    int id=HtmlNames::getAttribute(attr);
+    if(id<0){
+        HTMLException excp;
+        excp[HTMLException::Error] << "HtmlPolicy: unknown attribute " << attr;
+        throw excp;
+    }
+    if(!tag)
+        _Global.set(id);
+    else
+        _Attributes[_tag(tag)].set(id);
+}
+
+void libhtmlpp::HtmlPolicy::allowScheme(const char *scheme){
+    std::string lower;
+    for(const char *c=scheme; *c; ++c)
+        lower.push_back((*c>='A' && *c<='Z') ? *c|0x20 : *c);
+    _Schemes.push_back(lower);
+}
+
+void libhtmlpp::HtmlPolicy::dropContent(const char *tag){
+    int id=_tag(tag);
+    _Drop.set(id);
+    _Tags.reset(id);
+}
+
+void libhtmlpp::HtmlPolicy::clear(){
+    _Tags.reset();
+    _Drop.reset();
+    _Global.reset();
+    _Attributes.assign(HTML_MAXNAMES,NameSet());
+    _Schemes.clear();
+    for(size_t i=0; DropTags[i]; ++i)
+        _Drop.set(HtmlNames::getTag(DropTags[i]));
+}
+
+bool libhtmlpp::HtmlPolicy::isAllowed(int tag) const{
+    return tag>=0 && _Tags.test(tag);
+}
+
+bool libhtmlpp::HtmlPolicy::isAllowed(int tag,int attr) const{
+    return attr>=0 && (_Global.test(attr) || _Attributes[tag].test(attr));
+}
+
+bool libhtmlpp::HtmlPolicy::isDropped(int tag) const{
+    return tag>=0 && _Drop.test(tag);
+}
+
+bool libhtmlpp::HtmlPolicy::isScheme(const char *scheme,size_t slen) const{
+    for(const std::string &cur : _Schemes){
+        if(cur.size()==slen && memcmp(cur.data(),scheme,slen)==0)
+            return true;
+    }
+    return false;
+}
+
+libhtmlpp::HtmlPolicy libhtmlpp::HtmlPolicy::basic(){
+    HtmlPolicy policy;
+    for(size_t i=0; BasicTags[i]; ++i)
+        policy.allowTag(BasicTags[i]);
+    for(size_t i=0; BasicAttributes[i][1]; ++i)
+        policy.allowAttribute(BasicAttributes[i][0],BasicAttributes[i][1]);
+    policy.allowScheme("http");
+    policy.allowScheme("https");
+    policy.allowScheme("mailto");
+    return policy;
+}
+
+libhtmlpp::HtmlSanitizer::HtmlSanitizer(const HtmlPolicy &policy) : _Policy(policy){
+    _Drop=-1;
+    _DropDepth=0;
+}
+
+libhtmlpp::HtmlSanitizer::~HtmlSanitizer(){
+}
+
+void libhtmlpp::HtmlSanitizer::sanitize(const char *data,size_t size){
+    reset();
+    feed(data,size);
+    finish();
+}
+
+void libhtmlpp::HtmlSanitizer::reset(){
+    HtmlTokenizer::reset();
+    _Output.clear();
+    _Text.clear();
+    _Open.clear();
+    _Drop=-1;
+    _DropDepth=0;
+}
+
+const char *libhtmlpp::HtmlSanitizer::data() const{
+    return _Output.data();
+}
+
+size_t libhtmlpp::HtmlSanitizer::size() const{
+    return _Output.size();
+}
+
+void libhtmlpp::HtmlSanitizer::clear(){
+    _Output.clear();
+}
+
+void libhtmlpp::HtmlSanitizer::_write(const char *data,size_t size){
+    _Output.insert(_Output.end(),data,data+size);
+}
+
+void libhtmlpp::HtmlSanitizer::_escape(const char *data,size_t size,bool attr){
+    size_t start=0;
+    for(size_t i=0; i<size; ++i){
+        const char *rep;
+        switch(data[i]){
+            case '<':
+                rep="&lt;";
+                break;
+            case '>':
+                rep="&gt;";
+                break;
+            case '"':
+                if(!attr)
+                    continue;
+                rep="&quot;";
+                break;
+            case '\0':
+                rep="";
+                break;
+            case '&':{
+                //entities are kept, a bare & is escaped
+                size_t ii=i+1;
+                if(ii<size && data[ii]=='#')
+                    ++ii;
+                while(ii<size && ii<i+32 && (((data[ii]|0x20)>='a' && (data[ii]|0x20)<='z')
+                                             || (data[ii]>='0' && data[ii]<='9')))
+                    ++ii;
+                if(ii<size && data[ii]==';' && ii>i+1 && data[ii-1]!='#')
+                    continue;
+                rep="&amp;";
+                break;
+            }
+            default:
+                continue;
+        }
+        _write(data+start,i-start);
+        _write(rep,strlen(rep));
+        start=i+1;
+    }
+    _write(data+start,size-start);
+}
+
+bool libhtmlpp::HtmlSanitizer::_url(const char *value,size_t vlen){
+    _Decoded.clear();
+    HtmlDecode(value,vlen,&_Decoded);
+    const char *url=_Decoded.data();
+    size_t ulen=_Decoded.size();
+
+    size_t i=0;
+    while(i<ulen && (unsigned char)url[i]<=' ')
+        ++i;
+
+    //browsers ignore tabs and newlines in urls
+    char scheme[32];
+    size_t slen=0;
+    bool valid=true;
+    for(; i<ulen; ++i){
+        char c=url[i];
+        if(c=='\t' || c=='\n' || c=='\r')
+            continue;
+        if(c==':')
+            return valid && slen>0 && _Policy.isScheme(scheme,slen);
+        if(c=='/' || c=='?' || c=='#')
+            return true;
+        //an entity HtmlDecode doesn't know could hide the colon
+        if(c=='&')
+            return false;
+        if(c>='A' && c<='Z')
+            c|=0x20;
+        if(!_schemeChar(c) || slen==sizeof(scheme))
+            valid=false;
+        else
+            scheme[slen++]=c;
+    }
+    return true;
+}
+
+bool libhtmlpp::HtmlSanitizer::_style(const char *value,size_t vlen){
+    _Decoded.clear();
+    HtmlDecode(value,vlen,&_Decoded);
+    std::string lower;
+    for(size_t i=0; i<_Decoded.size(); ++i){
+        char c=_Decoded[i];
+        if(c==' ' || c=='\t' || c=='\n' || c=='\r' || c=='\f')
+            continue;
+        lower.push_back((c>='A' && c<='Z') ? c|0x20 : c);
+    }
+    //comments and escapes split the words, expr/**/ession() or \65xpression()
+    if(lower.find("/*")!=std::string::npos || lower.find('\\')!=std::string::npos)
+        return false;
+    for(size_t i=0; StyleBlacklist[i]; ++i){
+        if(lower.find(StyleBlacklist[i])!=std::string::npos)
+            return false;
+    }
+    return true;
+}
+
+void libhtmlpp::HtmlSanitizer::_flushText(){
+    if(_Text.empty())
+        return;
+    _escape(_Text.data(),_Text.size(),false);
+    _Text.clear();
+}
+
+void libhtmlpp::HtmlSanitizer::_close(size_t depth){
+    while(_Open.size()>depth){
+        const char *name=HtmlNames::getTagName(_Open.back());
+        _write("</",2);
+        _write(name,strlen(name));
+        _write(">",1);
+        _Open.pop_back();
+    }
+}
+
+void libhtmlpp::HtmlSanitizer::onStartTag(const char *name,size_t nlen,const Attribute *attrs,
+                                          size_t acount,bool selfclosing){
+    int tag=HtmlNames::getTag(name,nlen);
+
+    if(_Drop>=0){
+        if(tag==_Drop)
+            ++_DropDepth;
+        return;
+    }
+
+    if(_Policy.isDropped(tag)){
+        //browsers ignore the slash of <script/>, the content follows anyway
+        if(!HtmlNames::isVoid(tag)){
+            _Drop=tag;
+            _DropDepth=1;
+        }
+        return;
+    }
+
+    if(!_Policy.isAllowed(tag))
+        return;
+
+    _flushText();
+
+    const char *tname=HtmlNames::getTagName(tag);
+    _write("<",1);
+    _write(tname,strlen(tname));
+
+    static const int style=HtmlNames::getAttribute("style");
+    static const int srcset=HtmlNames::getAttribute("srcset");
+    const HtmlPolicy::NameSet &urls=_urlAttributes();
+
+    _Seen.reset();
+    for(size_t i=0; i<acount; ++i){
+        int attr=HtmlNames::getAttribute(attrs[i].Key,attrs[i].KeySize);
+        //the first of duplicated attributes wins like in browsers
+        if(!_Policy.isAllowed(tag,attr) || _Seen.test(attr))
+            continue;
+        _Seen.set(attr);
+
+        if(attrs[i].Value){
+            if(urls.test(attr)){
+                bool safe=true;
+                if(attr==srcset){
+                    //candidates are separated by commas, each one starts with its url
+                    const char *cur=attrs[i].Value,*end=cur+attrs[i].ValueSize;
+                    while(safe && cur<end){
+                        const char *comma=(const char*)memchr(cur,',',end-cur);
+                        const char *next=comma ? comma : end;
+                        while(cur<next && (*cur==' ' || *cur=='\t' || *cur=='\n' || *cur=='\r'))
+                            ++cur;
+                        const char *uend=cur;
+                        while(uend<next && *uend!=' ' && *uend!='\t' && *uend!='\n' && *uend!='\r')
+                            ++uend;
+                        safe=_url(cur,uend-cur);
+                        cur=next+1;
+                    }
+                }else{
+                    safe=_url(attrs[i].Value,attrs[i].ValueSize);
+                }
+                if(!safe)
+                    continue;
+            }else if(attr==style && !_style(attrs[i].Value,attrs[i].ValueSize)){
+                continue;
+            }
+        }
+
+        const char *aname=HtmlNames::getAttributeName(attr);
+        _write(" ",1);
+        _write(aname,strlen(aname));
+        if(attrs[i].Value){
+            _write("=\"",2);
+            _escape(attrs[i].Value,attrs[i].ValueSize,true);
+            _write("\"",1);
+        }
+    }
+
+    if(HtmlNames::isVoid(tag)){
+        _write(" />",3);
+        return;
+    }
+    _write(">",1);
+    _Open.push_back(tag);
+}
+
+void libhtmlpp::HtmlSanitizer::onEndTag(const char *name,size_t nlen){
+    int tag=HtmlNames::getTag(name,nlen);
+
+    if(_Drop>=0){
+        if(tag==_Drop && --_DropDepth==0)
+            _Drop=-1;
+        return;
+    }
+
+    if(!_Policy.isAllowed(tag))
+        return;
+
+    //closes the elements opened inside, end tags without start tag are dropped
+    for(size_t i=_Open.size(); i>0; --i){
+        if(_Open[i-1]==tag){
+            _flushText();
+            _close(i-1);
+            return;
+        }
+    }
+}
+
+void libhtmlpp::HtmlSanitizer::onText(const char *text,size_t tlen){
+    if(_Drop>=0)
+        return;
+    _Text.insert(_Text.end(),text,text+tlen);
+}
+
+void libhtmlpp::HtmlSanitizer::onEnd(){
+    _flushText();
+    _close(0);
+    _Drop=-1;
+    _DropDepth=0;
+}
@@ -0,0 +1,132 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <stddef.h>
+
+#include <bitset>
+#include <string>
+#include <vector>
+
+#include "html.h"
+#include "names.h"
+#include "tokenizer.h"
+
+#pragma once
+
+namespace libhtmlpp {
+
+    /*
+     * allowlist of tags, attributes and url schemes. The policy is kept as
+     * bitsets over the ids of HtmlNames, so checking a tag or attribute is
+     * one lookup. Names HtmlNames doesn't know, like event handlers, can't
+     * be allowed and throw an HTMLException.
+     */
+    class HtmlPolicy {
+    public:
+        typedef std::bitset<HTML_MAXNAMES> NameSet;
+
+        //allows nothing, script, style, iframe and the other containers
+        //of foreign content are dropped with their content
+        HtmlPolicy();
+        ~HtmlPolicy();
+
+        void allowTag(const char *tag);
+        //tag nullptr allows the attribute on all allowed tags
+        void allowAttribute(const char *tag,const char *attr);
+        //scheme for href, src and the other url attributes without ':',
+        //relative urls are always allowed
+        void allowScheme(const char *scheme);
+        //drops the element with its content instead of only its tags
+        void dropContent(const char *tag);
+        void clear();
+
+        bool isAllowed(int tag) const;
+        bool isAllowed(int tag,int attr) const;
+        bool isDropped(int tag) const;
+        bool isScheme(const char *scheme,size_t slen) const;
+
+        //formatting, lists, tables, links and images for user comments
+        static HtmlPolicy basic();
+    private:
+        int                      _tag(const char *tag) const;
+
+        NameSet                  _Tags;
+        NameSet                  _Drop;
+        NameSet                  _Global;
+        std::vector<NameSet>     _Attributes;
+        std::vector<std::string> _Schemes;
+    };
+
+    /*
+     * streaming sanitizer between the tokenizer and the output, the input
+     * is cleaned in one pass without building a dom. Tags and attributes
+     * outside the policy are dropped while the text is kept, urls with
+     * schemes outside the policy and comments are dropped. The output is
+     * balanced: end tags without start tag are dropped and open elements
+     * are closed at the end. Text and attribute values are escaped, so the
+     * output can't contain markup the policy doesn't allow. The output can
+     * be taken and cleared between two feed() calls.
+     */
+    class HtmlSanitizer : public HtmlTokenizer {
+    public:
+        HtmlSanitizer(const HtmlPolicy &policy);
+        ~HtmlSanitizer();
+
+        //sanitizes a complete document
+        void        sanitize(const char *data,size_t size);
+        //forgets the state and the output
+        void        reset();
+
+        const char *data() const;
+        size_t      size() const;
+        void        clear();
+    protected:
+        void onStartTag(const char *name,size_t nlen,const Attribute *attrs,
+                        size_t acount,bool selfclosing) override;
+        void onEndTag(const char *name,size_t nlen) override;
+        void onText(const char *text,size_t tlen) override;
+        void onEnd() override;
+    private:
+        void _flushText();
+        void _close(size_t depth);
+        void _write(const char *data,size_t size);
+        void _escape(const char *data,size_t size,bool attr);
+        bool _url(const char *value,size_t vlen);
+        bool _style(const char *value,size_t vlen);
+
+        HtmlPolicy             _Policy;
+        std::vector<char>      _Output;
+        //text is escaped in one piece, so entities split by feed() survive
+        std::vector<char>      _Text;
+        std::vector<int>       _Open;
+        //element dropped with its content and its nesting
+        int                    _Drop;
+        size_t                 _DropDepth;
+        HtmlPolicy::NameSet    _Seen;
+        HtmlString             _Decoded;
+    };
+};
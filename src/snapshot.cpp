@@ -0,0 +1,473 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <string.h>
+
+#include <fstream>
+#include <stack>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "config.h"
+
+#ifndef Windows
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "exception.h"
+#include "names.h"
+#include "snapshot.h"
+
+#define SNAPSHOT_BYTEORDER 0x01020304
+
+libhtmlpp::HtmlSnapshot::HtmlSnapshot(){
+    _Data=nullptr;
+    _Size=0;
+    _Map=nullptr;
+    _MapSize=0;
+    _Header=nullptr;
+    _Nodes=nullptr;
+    _Attributes=nullptr;
+    _Pool=nullptr;
+    _RootNode=nullptr;
+}
+
+libhtmlpp::HtmlSnapshot::~HtmlSnapshot(){
+    _clear();
+}
+
+void libhtmlpp::HtmlSnapshot::_clear(){
+    _delete(_RootNode);
+    _RootNode=nullptr;
+#ifndef Windows
+    if(_Map)
+        munmap(_Map,_MapSize);
+#endif
+    _Map=nullptr;
+    _MapSize=0;
+    _Buffer.clear();
+    _Data=nullptr;
+    _Size=0;
+    _Header=nullptr;
+    _Nodes=nullptr;
+    _Attributes=nullptr;
+    _Pool=nullptr;
+}
+
+void libhtmlpp::HtmlSnapshot::create(Element *el){
+    struct Pending {
+        Element  *element;
+        uint32_t  prev;
+    };
+
+    std::vector<Node>       nodes;
+    std::vector<Attribute>  attrs;
+    std::vector<char>       pool;
+    std::unordered_map<std::string,uint32_t> names;
+    std::stack<Pending>     pending;
+
+    auto addString = [&pool](const char *src,size_t size){
+        if(pool.size()+size>0xffffffff){
+            HTMLException excp;
+            throw excp[HTMLException::Error] << "HtmlSnapshot: document too large!";
+        }
+        uint32_t pos=pool.size();
+        pool.insert(pool.end(),src,src+size);
+        return pos;
+    };
+
+    //tag names and attribute keys repeat a lot, store them only once
+    auto addName = [&names,&addString](const char *src,size_t size){
+        std::string name(src,size);
+        auto it=names.find(name);
+        if(it!=names.end())
+            return it->second;
+        uint32_t pos=addString(src,size);
+        names[name]=pos;
+        return pos;
+    };
+
+    _clear();
+
+    uint32_t prev=NoNode;
+    while(el){
+        uint32_t idx=nodes.size();
+        Node node;
+        node.Type=el->_Type;
+        node.Data=0;
+        node.DataSize=0;
+        node.FirstAttr=attrs.size();
+        node.AttrCount=0;
+        node.Child=NoNode;
+        node.Next=NoNode;
+
+        if(prev!=NoNode)
+            nodes[prev].Next=idx;
+
+        switch(el->_Type){
+            case HtmlEl:{
+                HtmlElement *hel=(HtmlElement*)el;
+                node.Data=addName(hel->_TagName.data(),hel->_TagName.size());
+                node.DataSize=hel->_TagName.size();
+                for(HtmlElement::Attributes *curattr=hel->_firstAttr; curattr; curattr=curattr->_nextAttr){
+                    Attribute attr;
+                    attr.Key=addName(curattr->_Key.data(),curattr->_Key.size());
+                    attr.KeySize=curattr->_Key.size();
+                    attr.Value=addString(curattr->_Value.data(),curattr->_Value.size());
+                    attr.ValueSize=curattr->_Value.size();
+                    attrs.push_back(attr);
+                    ++node.AttrCount;
+                }
+            }break;
+            case TextEl:
+                node.Data=addString(((TextElement*)el)->_Text.data(),((TextElement*)el)->_Text.size());
+                node.DataSize=((TextElement*)el)->_Text.size();
+                break;
+            case CommentEl:
+                node.Data=addString(((CommentElement*)el)->_Comment.data(),((CommentElement*)el)->_Comment.size());
+                node.DataSize=((CommentElement*)el)->_Comment.size();
+                break;
+            default:
+                HTMLException excp;
+                excp[HTMLException::Error] << "Unkown Elementtype";
+                throw excp;
+        }
+
+        nodes.push_back(node);
+
+        if(el->_Type==HtmlEl && ((HtmlElement*)el)->_children()){
+            nodes[idx].Child=idx+1;
+            Pending next;
+            next.element=el->_nextElement;
+            next.prev=idx;
+            pending.push(next);
+            el=((HtmlElement*)el)->_children();
+            prev=NoNode;
+            continue;
+        }
+
+        prev=idx;
+        el=el->_nextElement;
+        while(!el && !pending.empty()){
+            el=pending.top().element;
+            prev=pending.top().prev;
+            pending.pop();
+        }
+    }
+
+    Header header;
+    memcpy(header.Magic,"HPSN",4);
+    header.ByteOrder=SNAPSHOT_BYTEORDER;
+    header.Version=Version;
+    header.NodeCount=nodes.size();
+    header.AttrCount=attrs.size();
+    header.PoolSize=pool.size();
+
+    _Buffer.resize(sizeof(Header)+nodes.size()*sizeof(Node)+attrs.size()*sizeof(Attribute)+pool.size());
+    char *out=_Buffer.data();
+    memcpy(out,&header,sizeof(Header));
+    out+=sizeof(Header);
+    memcpy(out,nodes.data(),nodes.size()*sizeof(Node));
+    out+=nodes.size()*sizeof(Node);
+    memcpy(out,attrs.data(),attrs.size()*sizeof(Attribute));
+    out+=attrs.size()*sizeof(Attribute);
+    memcpy(out,pool.data(),pool.size());
+
+    _Data=_Buffer.data();
+    _Size=_Buffer.size();
+    _check();
+}
+
+void libhtmlpp::HtmlSnapshot::_check(){
+    HTMLException excp;
+
+    if(_Size<sizeof(Header) || ((uintptr_t)_Data % alignof(Node))!=0){
+        throw excp[HTMLException::Error] << "HtmlSnapshot: broken snapshot!";
+    }
+
+    _Header=(const Header*)_Data;
+
+    if(memcmp(_Header->Magic,"HPSN",4)!=0 || _Header->ByteOrder!=SNAPSHOT_BYTEORDER){
+        throw excp[HTMLException::Error] << "HtmlSnapshot: no snapshot or wrong byte order!";
+    }
+
+    if(_Header->Version!=Version){
+        throw excp[HTMLException::Error] << "HtmlSnapshot: unsupported version " << (int)_Header->Version;
+    }
+
+    uint64_t expected=sizeof(Header)+(uint64_t)_Header->NodeCount*sizeof(Node)+
+                      (uint64_t)_Header->AttrCount*sizeof(Attribute)+_Header->PoolSize;
+    if(expected!=_Size){
+        throw excp[HTMLException::Error] << "HtmlSnapshot: broken snapshot!";
+    }
+
+    _Nodes=(const Node*)(_Data+sizeof(Header));
+    _Attributes=(const Attribute*)(_Nodes+_Header->NodeCount);
+    _Pool=(const char*)(_Attributes+_Header->AttrCount);
+
+    uint64_t psize=_Header->PoolSize;
+    for(uint32_t i=0; i<_Header->AttrCount; ++i){
+        const Attribute &attr=_Attributes[i];
+        if((uint64_t)attr.Key+attr.KeySize>psize || (uint64_t)attr.Value+attr.ValueSize>psize)
+            throw excp[HTMLException::Error] << "HtmlSnapshot: broken attribute!";
+    }
+
+    /*
+     * links only point forward, so a valid snapshot can't contain loops, and
+     * every node but the first is linked exactly once, so no subtree is
+     * shared between two parents and no node is unreachable
+     */
+    std::vector<uint8_t> linked(_Header->NodeCount,0);
+    for(uint32_t i=0; i<_Header->NodeCount; ++i){
+        const Node &node=_Nodes[i];
+        if(node.Type!=HtmlEl && node.Type!=TextEl && node.Type!=CommentEl)
+            throw excp[HTMLException::Error] << "HtmlSnapshot: unknown node type!";
+        if((uint64_t)node.Data+node.DataSize>psize ||
+           (uint64_t)node.FirstAttr+node.AttrCount>_Header->AttrCount)
+            throw excp[HTMLException::Error] << "HtmlSnapshot: broken node!";
+        if((node.Child!=NoNode && (node.Type!=HtmlEl || node.Child<=i || node.Child>=_Header->NodeCount)) ||
+           (node.Next!=NoNode && (node.Next<=i || node.Next>=_Header->NodeCount)))
+            throw excp[HTMLException::Error] << "HtmlSnapshot: broken node link!";
+        if((node.Child!=NoNode && linked[node.Child]++) || (node.Next!=NoNode && linked[node.Next]++))
+            throw excp[HTMLException::Error] << "HtmlSnapshot: node linked twice!";
+    }
+
+    for(uint32_t i=1; i<_Header->NodeCount; ++i){
+        if(!linked[i])
+            throw excp[HTMLException::Error] << "HtmlSnapshot: unreachable node!";
+    }
+}
+
+void libhtmlpp::HtmlSnapshot::load(const char *data,size_t size){
+    _clear();
+    if(((uintptr_t)data % alignof(Node))!=0){
+        _Buffer.assign(data,data+size);
+        data=_Buffer.data();
+    }
+    _Data=data;
+    _Size=size;
+    try{
+        _check();
+    }catch(HTMLException &e){
+        _clear();
+        throw;
+    }
+}
+
+void libhtmlpp::HtmlSnapshot::loadFile(const char *path){
+    HTMLException excp;
+    _clear();
+#ifndef Windows
+    int fd=open(path,O_RDONLY);
+    if(fd<0)
+        throw excp[HTMLException::Critical] << "HtmlSnapshot: can't open " << path;
+
+    struct stat st;
+    if(fstat(fd,&st)!=0 || st.st_size==0){
+        close(fd);
+        throw excp[HTMLException::Critical] << "HtmlSnapshot: can't read " << path;
+    }
+
+    void *map=mmap(nullptr,st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+    close(fd);
+
+    if(map==MAP_FAILED)
+        throw excp[HTMLException::Critical] << "HtmlSnapshot: can't map " << path;
+
+    _Map=map;
+    _MapSize=st.st_size;
+    _Data=(const char*)map;
+    _Size=st.st_size;
+#else
+    std::ifstream fs(path,std::ios::binary);
+    if(!fs.is_open())
+        throw excp[HTMLException::Critical] << "HtmlSnapshot: can't open " << path;
+    _Buffer.assign(std::istreambuf_iterator<char>(fs),std::istreambuf_iterator<char>());
+    _Data=_Buffer.data();
+    _Size=_Buffer.size();
+#endif
+    try{
+        _check();
+    }catch(HTMLException &e){
+        _clear();
+        throw;
+    }
+}
+
+void libhtmlpp::HtmlSnapshot::saveFile(const char *path) const{
+    std::ofstream fs(path,std::ios::binary | std::ios::trunc);
+    if(!fs.is_open()){
+        HTMLException excp;
+        throw excp[HTMLException::Critical] << "HtmlSnapshot: can't write " << path;
+    }
+    fs.write(_Data,_Size);
+}
+
+const char *libhtmlpp::HtmlSnapshot::data() const{
+    return _Data;
+}
+
+size_t libhtmlpp::HtmlSnapshot::size() const{
+    return _Size;
+}
+
+const libhtmlpp::HtmlSnapshot::Node *libhtmlpp::HtmlSnapshot::getNodes() const{
+    return _Nodes;
+}
+
+size_t libhtmlpp::HtmlSnapshot::getNodeCount() const{
+    return _Header ? _Header->NodeCount : 0;
+}
+
+const libhtmlpp::HtmlSnapshot::Attribute *libhtmlpp::HtmlSnapshot::getAttributes() const{
+    return _Attributes;
+}
+
+const char *libhtmlpp::HtmlSnapshot::getPool() const{
+    return _Pool;
+}
+
+void libhtmlpp::HtmlSnapshot::print(HtmlString &output) const{
+    if(!getNodeCount())
+        return;
+
+    std::vector<uint32_t> openlist;
+    uint32_t i=0;
+
+    while(i!=NoNode){
+        const Node &node=_Nodes[i];
+        switch(node.Type){
+            case HtmlEl:{
+                output.push_back('<');
+                output.append(_Pool+node.Data,node.DataSize);
+                for(uint32_t a=node.FirstAttr; a<node.FirstAttr+node.AttrCount; ++a){
+                    output.push_back(' ');
+                    output.append(_Pool+_Attributes[a].Key,_Attributes[a].KeySize);
+                    if(_Attributes[a].ValueSize){
+                        output.append("=\"",2);
+                        output.append(_Pool+_Attributes[a].Value,_Attributes[a].ValueSize);
+                        output.push_back('"');
+                    }
+                }
+                if(node.Child!=NoNode){
+                    output.push_back('>');
+                }else if(!HtmlNames::isVoid(_Pool+node.Data,node.DataSize)){
+                    output.append("></",3);
+                    output.append(_Pool+node.Data,node.DataSize);
+                    output.push_back('>');
+                }else if(node.Next!=NoNode){
+                    output.push_back('>');
+                }else{
+                    output.append(" />",3);
+                }
+                if(node.Child!=NoNode){
+                    openlist.push_back(i);
+                    i=node.Child;
+                    continue;
+                }
+            }break;
+            case TextEl:
+                output.append(_Pool+node.Data,node.DataSize);
+                break;
+            case CommentEl:
+                output.append("<!--",4);
+                output.append(_Pool+node.Data,node.DataSize);
+                output.append("-->",3);
+                break;
+        }
+
+        i=node.Next;
+        while(i==NoNode && !openlist.empty()){
+            const Node &parent=_Nodes[openlist.back()];
+            openlist.pop_back();
+            output.append("</",2);
+            output.append(_Pool+parent.Data,parent.DataSize);
+            output.push_back('>');
+            i=parent.Next;
+        }
+    }
+}
+
+libhtmlpp::HtmlElement *libhtmlpp::HtmlSnapshot::parse(){
+    _delete(_RootNode);
+    _RootNode=nullptr;
+
+    size_t count=getNodeCount();
+    if(!count)
+        return nullptr;
+
+    std::vector<Element*> elements(count);
+
+    for(size_t i=0; i<count; ++i){
+        const Node &node=_Nodes[i];
+        switch(node.Type){
+            case HtmlEl:{
+                HtmlElement *hel=new HtmlElement();
+                hel->_TagName.assign(_Pool+node.Data,_Pool+node.Data+node.DataSize);
+                for(uint32_t a=node.FirstAttr; a<node.FirstAttr+node.AttrCount; ++a){
+                    hel->setAttribute(_Pool+_Attributes[a].Key,_Attributes[a].KeySize,
+                                      _Pool+_Attributes[a].Value,_Attributes[a].ValueSize);
+                }
+                elements[i]=hel;
+            }break;
+            case TextEl:{
+                TextElement *text=new TextElement();
+                text->_Text.assign(_Pool+node.Data,_Pool+node.Data+node.DataSize);
+                elements[i]=text;
+            }break;
+            case CommentEl:{
+                CommentElement *comment=new CommentElement();
+                comment->_Comment.assign(_Pool+node.Data,_Pool+node.Data+node.DataSize);
+                elements[i]=comment;
+            }break;
+        }
+    }
+
+    for(size_t i=0; i<count; ++i){
+        const Node &node=_Nodes[i];
+        if(node.Child!=NoNode){
+            ((HtmlElement*)elements[i])->_childElement=elements[node.Child];
+            elements[node.Child]->_parentElement=elements[i];
+        }
+        if(node.Next!=NoNode){
+            elements[i]->_nextElement=elements[node.Next];
+            elements[node.Next]->_prevElement=elements[i];
+            elements[node.Next]->_parentElement=elements[i]->_parentElement;
+        }
+    }
+
+    //like HtmlString::parse() the first element with a tag, leading text stays in front
+    _RootNode=elements[0];
+    Element *first=_RootNode;
+    while(first && first->getType()!=HtmlEl)
+        first=first->nextElement();
+    return (HtmlElement*)first;
+}
@@ -0,0 +1,116 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "html.h"
+
+#pragma once
+
+namespace libhtmlpp {
+
+    /*
+     * binary snapshot of a parsed tree. The layout is a header, a flat
+     * node array in document order, an attribute table and a string pool.
+     * All links are indexes and all strings are offsets into the pool, so
+     * a snapshot can be used straight from a mmaped file. print() renders
+     * the snapshot without building a dom, parse() builds the dom on demand.
+     *
+     *   Header  | Node[NodeCount] | Attribute[AttrCount] | char[PoolSize]
+     */
+    class HtmlSnapshot {
+    public:
+        enum {Version=1};
+
+        struct Header {
+            char     Magic[4];
+            uint32_t ByteOrder;
+            uint32_t Version;
+            uint32_t NodeCount;
+            uint32_t AttrCount;
+            uint32_t PoolSize;
+        };
+
+        struct Node {
+            uint32_t Type;
+            //tag for HtmlEl, text for TextEl and CommentEl
+            uint32_t Data;
+            uint32_t DataSize;
+            uint32_t FirstAttr;
+            uint32_t AttrCount;
+            uint32_t Child;
+            uint32_t Next;
+        };
+
+        struct Attribute {
+            uint32_t Key;
+            uint32_t KeySize;
+            uint32_t Value;
+            uint32_t ValueSize;
+        };
+
+        static const uint32_t NoNode=0xffffffff;
+
+        HtmlSnapshot();
+        ~HtmlSnapshot();
+
+        /*serializes el, its following siblings and all children*/
+        void             create(Element *el);
+
+        /*data must stay valid as long as the snapshot is used*/
+        void             load(const char *data,size_t size);
+        void             loadFile(const char *path);
+        void             saveFile(const char *path) const;
+
+        const char      *data() const;
+        size_t           size() const;
+
+        const Node      *getNodes() const;
+        size_t           getNodeCount() const;
+        const Attribute *getAttributes() const;
+        const char      *getPool() const;
+
+        void             print(HtmlString &output) const;
+        HtmlElement     *parse();
+    private:
+        void             _clear();
+        void             _check();
+
+        std::vector<char> _Buffer;
+        const char       *_Data;
+        size_t            _Size;
+        void             *_Map;
+        size_t            _MapSize;
+        const Header     *_Header;
+        const Node       *_Nodes;
+        const Attribute  *_Attributes;
+        const char       *_Pool;
+        Element          *_RootNode;
+    };
+};
@@ -0,0 +1,170 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <vector>
+
+#include "html.h"
+
+#pragma once
+
+namespace libhtmlpp {
+
+    /*
+     * builds the rows of a table cell by cell, cells with colspan and
+     * rowspan are repeated in every column and row they cover. The row
+     * and its columns are reused for the next row to avoid allocations.
+     */
+    class TableGrid {
+    public:
+        TableGrid(){
+            _Col=0;
+            _Width=0;
+            _Start=0;
+            _Colspan=1;
+            _Rowspan=1;
+        }
+
+        void clear(){
+            _Spans.clear();
+            _Col=0;
+            _Width=0;
+        }
+
+        void beginRow(){
+            _Col=0;
+            _Width=0;
+        }
+
+        //returns the empty text buffer of the new cell
+        HtmlString &beginCell(size_t colspan,size_t rowspan){
+            _skipSpans(false);
+            _Start=_Col;
+            _Colspan=colspan<1 ? 1 : colspan>1000 ? 1000 : colspan;
+            _Rowspan=rowspan<1 ? 1 : rowspan>65534 ? 65534 : rowspan;
+            _Text.clear();
+            return _Text;
+        }
+
+        //stores the text without surrounding whitespace in the cell
+        void endCell(){
+            const char *text=_Text.data();
+            size_t start=0,end=_Text.size();
+            while(start<end && _space(text[start]))
+                ++start;
+            while(end>start && _space(text[end-1]))
+                --end;
+            HtmlString &cell=_cell(_Start);
+            cell.clear();
+            cell.append(text+start,end-start);
+
+            for(size_t i=1; i<_Colspan; ++i){
+                HtmlString &data=_cell(_Start+i);
+                data=_Row[_Start].Data;
+            }
+            if(_Rowspan>1){
+                if(_Spans.size()<_Start+_Colspan)
+                    _Spans.resize(_Start+_Colspan);
+                for(size_t i=0; i<_Colspan; ++i){
+                    _Spans[_Start+i].Rows=_Rowspan-1;
+                    _Spans[_Start+i].Text=_Row[_Start].Data;
+                }
+            }
+            _Col=_Start+_Colspan;
+        }
+
+        HtmlTable::Row &endRow(){
+            _skipSpans(true);
+            while(_Row.getColumns()>_Width)
+                _Row.delColumn(_Row.getColumns()-1);
+            return _Row;
+        }
+
+        size_t cells() const{
+            return _Width;
+        }
+
+        /*
+         * colspan and rowspan value like browsers read it, leading
+         * whitespace and digits. Missing, invalid, negative and zero
+         * values are 1.
+         */
+        static size_t parseSpan(const char *value,size_t vlen){
+            size_t pos=0,span=0;
+            while(pos<vlen && _space(value[pos]))
+                ++pos;
+            if(pos<vlen && value[pos]=='+')
+                ++pos;
+            for(; pos<vlen && value[pos]>='0' && value[pos]<='9' && span<100000; ++pos)
+                span=span*10+(value[pos]-'0');
+            return span<1 ? 1 : span;
+        }
+    private:
+        struct Span {
+            Span(){
+                Rows=0;
+            }
+            size_t     Rows;
+            HtmlString Text;
+        };
+
+        static bool _space(char c){
+            return c==' ' || c=='\t' || c=='\n' || c=='\r' || c=='\f';
+        }
+
+        HtmlString &_cell(size_t col){
+            while(_Row.getColumns()<=col)
+                _Row << "";
+            for(; _Width<=col; ++_Width)
+                _Row[_Width].Data.clear();
+            return _Row[col].Data;
+        }
+
+        //fills the columns still covered by a rowspan from the rows above
+        void _skipSpans(bool all){
+            while(_Col<_Spans.size()){
+                if(_Spans[_Col].Rows==0){
+                    if(!all)
+                        return;
+                    ++_Col;
+                    continue;
+                }
+                _cell(_Col)=_Spans[_Col].Text;
+                --_Spans[_Col].Rows;
+                ++_Col;
+            }
+        }
+
+        HtmlTable::Row    _Row;
+        HtmlString        _Text;
+        std::vector<Span> _Spans;
+        size_t            _Col;
+        size_t            _Width;
+        size_t            _Start;
+        size_t            _Colspan;
+        size_t            _Rowspan;
+    };
+};
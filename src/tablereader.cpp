@@ -0,0 +1,149 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include "tablegrid.h"
+#include "tablereader.h"
+
+namespace libhtmlpp {
+    static size_t _span(const HtmlTokenizer::Attribute *attrs,size_t acount,const char *name){
+        for(size_t i=0; i<acount; ++i){
+            if(!attrs[i].Value || !HtmlTokenizer::isName(attrs[i].Key,attrs[i].KeySize,name))
+                continue;
+            return TableGrid::parseSpan(attrs[i].Value,attrs[i].ValueSize);
+        }
+        return 1;
+    }
+};
+
+libhtmlpp::HtmlTableReader::HtmlTableReader(){
+    _Grid=new TableGrid();
+    _Depth=0;
+    _Tables=0;
+    _Colspan=1;
+    _Rowspan=1;
+    _InHead=false;
+    _InRow=false;
+    _InCell=false;
+    _AllTh=true;
+}
+
+libhtmlpp::HtmlTableReader::~HtmlTableReader(){
+    delete _Grid;
+}
+
+void libhtmlpp::HtmlTableReader::onStartTag(const char *name,size_t nlen,const Attribute *attrs,
+                                            size_t acount,bool selfclosing){
+    if(isName(name,nlen,"table")){
+        if(++_Depth==1)
+            _Grid->clear();
+        return;
+    }
+
+    if(_Depth!=1)
+        return;
+
+    if(isName(name,nlen,"td") || isName(name,nlen,"th")){
+        if(!_InRow){
+            _Grid->beginRow();
+            _InRow=true;
+            _AllTh=true;
+        }
+        _endCell();
+        _InCell=true;
+        _Cell.clear();
+        _Colspan=_span(attrs,acount,"colspan");
+        _Rowspan=_span(attrs,acount,"rowspan");
+        _AllTh&=(name[1]|0x20)=='h';
+    }else if(isName(name,nlen,"tr")){
+        _endRow();
+        _Grid->beginRow();
+        _InRow=true;
+        _AllTh=true;
+    }else if(isName(name,nlen,"thead")){
+        _endRow();
+        _InHead=true;
+    }else if(isName(name,nlen,"tbody") || isName(name,nlen,"tfoot")){
+        _endRow();
+        _InHead=false;
+    }
+}
+
+void libhtmlpp::HtmlTableReader::onEndTag(const char *name,size_t nlen){
+    if(isName(name,nlen,"table")){
+        if(_Depth==1){
+            _endRow();
+            _InHead=false;
+            ++_Tables;
+        }
+        if(_Depth>0)
+            --_Depth;
+        return;
+    }
+
+    if(_Depth!=1)
+        return;
+
+    if(isName(name,nlen,"td") || isName(name,nlen,"th")){
+        _endCell();
+    }else if(isName(name,nlen,"tr")){
+        _endRow();
+    }else if(isName(name,nlen,"thead")){
+        _endRow();
+        _InHead=false;
+    }
+}
+
+void libhtmlpp::HtmlTableReader::onText(const char *text,size_t tlen){
+    if(_Depth==1 && _InCell)
+        _Cell.insert(_Cell.end(),text,text+tlen);
+}
+
+void libhtmlpp::HtmlTableReader::onEnd(){
+    if(_Depth>0)
+        _endRow();
+    _Depth=0;
+    _InHead=false;
+}
+
+void libhtmlpp::HtmlTableReader::_endCell(){
+    if(!_InCell)
+        return;
+    HtmlString &data=_Grid->beginCell(_Colspan,_Rowspan);
+    HtmlDecode(_Cell.data(),_Cell.size(),&data);
+    _Grid->endCell();
+    _InCell=false;
+}
+
+void libhtmlpp::HtmlTableReader::_endRow(){
+    if(!_InRow)
+        return;
+    _endCell();
+    _InRow=false;
+    if(_Grid->cells()==0)
+        return;
+    onRow(_Tables,_Grid->endRow(),_InHead || _AllTh);
+}
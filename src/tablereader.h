@@ -0,0 +1,77 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <vector>
+
+#include "html.h"
+#include "tokenizer.h"
+
+#pragma once
+
+namespace libhtmlpp {
+    class TableGrid;
+
+    /*
+     * extracts the rows of all tables from a document that is fed in
+     * blocks, so tables of any size are read with bounded memory. Cells
+     * are decoded text, colspan and rowspan cells are repeated like in
+     * HtmlTable::parse(). Omitted </td>, </th> and </tr> are closed by
+     * the next cell or row. Nested tables are skipped.
+     */
+    class HtmlTableReader : public HtmlTokenizer {
+    public:
+        HtmlTableReader();
+        ~HtmlTableReader();
+    protected:
+        /*
+         * called for every row, table counts the tables in the document
+         * from 0. header is set for rows in thead and rows of th cells.
+         * The row is reused after the call.
+         */
+        virtual void onRow(size_t table,HtmlTable::Row &row,bool header)=0;
+
+        void onStartTag(const char *name,size_t nlen,const Attribute *attrs,
+                        size_t acount,bool selfclosing) override;
+        void onEndTag(const char *name,size_t nlen) override;
+        void onText(const char *text,size_t tlen) override;
+        void onEnd() override;
+    private:
+        void              _endCell();
+        void              _endRow();
+
+        TableGrid        *_Grid;
+        std::vector<char> _Cell;
+        size_t            _Depth;
+        size_t            _Tables;
+        size_t            _Colspan;
+        size_t            _Rowspan;
+        bool              _InHead;
+        bool              _InRow;
+        bool              _InCell;
+        bool              _AllTh;
+    };
+};
@@ -0,0 +1,241 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "config.h"
+#include "exception.h"
+#include "tablewriter.h"
+
+libhtmlpp::HtmlTableWriter::HtmlTableWriter(std::ostream &output,int format) : _Output(output){
+    if(format!=HtmlTable::Csv && format!=HtmlTable::Tsv && format!=HtmlTable::Json){
+        HTMLException excp;
+        excp[HTMLException::Error] << "HtmlTableWriter: unknown format!";
+        throw excp;
+    }
+    _Format=format;
+    _Rows=0;
+    _Finished=false;
+    _Buffer.reserve(HTML_BLOCKSIZE*2);
+    if(_Format==HtmlTable::Json)
+        _Buffer.push_back('[');
+}
+
+libhtmlpp::HtmlTableWriter::~HtmlTableWriter(){
+    if(!_Finished){
+        try{
+            finish();
+        }catch(...){
+        }
+    }
+}
+
+size_t libhtmlpp::HtmlTableWriter::getRows() const{
+    return _Rows;
+}
+
+void libhtmlpp::HtmlTableWriter::setHeader(const HtmlTable::Row &header){
+    if(_Rows>0 || !_Keys.empty()){
+        HTMLException excp;
+        excp[HTMLException::Error] << "HtmlTableWriter: header has to be set before the rows!";
+        throw excp;
+    }
+
+    for(size_t i=0; i<header.getColumns(); ++i)
+        _Keys.push_back(header[i].Data);
+
+    //json keeps the header as keys of every row object
+    if(_Format!=HtmlTable::Json && !_Keys.empty()){
+        for(size_t i=0; i<_Keys.size(); ++i){
+            if(i>0)
+                _Buffer.push_back(_Format==HtmlTable::Csv ? ',' : '\t');
+            _field(_Keys[i].data(),_Keys[i].size());
+        }
+        if(_Format==HtmlTable::Csv)
+            _Buffer.push_back('\r');
+        _Buffer.push_back('\n');
+    }
+}
+
+void libhtmlpp::HtmlTableWriter::writeRow(const HtmlTable::Row &row){
+    if(_Finished){
+        HTMLException excp;
+        excp[HTMLException::Error] << "HtmlTableWriter: writer is already finished!";
+        throw excp;
+    }
+
+    switch(_Format){
+        case HtmlTable::Csv:
+        case HtmlTable::Tsv:
+            for(size_t i=0; i<row.getColumns(); ++i){
+                if(i>0)
+                    _Buffer.push_back(_Format==HtmlTable::Csv ? ',' : '\t');
+                _field(row[i].Data.data(),row[i].Data.size());
+            }
+            if(_Format==HtmlTable::Csv)
+                _Buffer.push_back('\r');
+            _Buffer.push_back('\n');
+            break;
+        case HtmlTable::Json:
+            if(_Rows>0)
+                _Buffer.push_back(',');
+            _Buffer.push_back(_Keys.empty() ? '[' : '{');
+            for(size_t i=0; i<row.getColumns(); ++i){
+                if(i>0)
+                    _Buffer.push_back(',');
+                if(!_Keys.empty()){
+                    if(i<_Keys.size()){
+                        _field(_Keys[i].data(),_Keys[i].size());
+                    }else{
+                        char key[32];
+                        int klen=snprintf(key,sizeof(key),"%zu",i);
+                        _field(key,klen);
+                    }
+                    _Buffer.push_back(':');
+                }
+                _field(row[i].Data.data(),row[i].Data.size());
+            }
+            _Buffer.push_back(_Keys.empty() ? ']' : '}');
+            break;
+    }
+
+    ++_Rows;
+    if(_Buffer.size()>=HTML_BLOCKSIZE)
+        _flush();
+}
+
+void libhtmlpp::HtmlTableWriter::finish(){
+    if(_Finished)
+        return;
+    if(_Format==HtmlTable::Json)
+        _Buffer.push_back(']');
+    _Finished=true;
+    _flush();
+    _Output.flush();
+}
+
+void libhtmlpp::HtmlTableWriter::_flush(){
+    _Output.write(_Buffer.data(),_Buffer.size());
+    _Buffer.clear();
+    if(!_Output.good()){
+        HTMLException excp;
+        excp[HTMLException::Error] << "HtmlTableWriter: can't write output!";
+        throw excp;
+    }
+}
+
+void libhtmlpp::HtmlTableWriter::_field(const char *data,size_t size){
+    switch(_Format){
+        case HtmlTable::Csv:{
+            bool quote=false;
+            for(size_t i=0; i<size && !quote; ++i){
+                quote=data[i]==',' || data[i]=='"' || data[i]=='\n' || data[i]=='\r';
+            }
+            if(!quote){
+                _Buffer.insert(_Buffer.end(),data,data+size);
+                return;
+            }
+            _Buffer.push_back('"');
+            size_t start=0;
+            for(size_t i=0; i<size; ++i){
+                if(data[i]!='"')
+                    continue;
+                _Buffer.insert(_Buffer.end(),data+start,data+i+1);
+                _Buffer.push_back('"');
+                start=i+1;
+            }
+            _Buffer.insert(_Buffer.end(),data+start,data+size);
+            _Buffer.push_back('"');
+        }break;
+        case HtmlTable::Tsv:{
+            size_t start=0;
+            for(size_t i=0; i<size; ++i){
+                char esc;
+                switch(data[i]){
+                    case '\t':
+                        esc='t';
+                        break;
+                    case '\n':
+                        esc='n';
+                        break;
+                    case '\r':
+                        esc='r';
+                        break;
+                    case '\\':
+                        esc='\\';
+                        break;
+                    default:
+                        continue;
+                }
+                _Buffer.insert(_Buffer.end(),data+start,data+i);
+                _Buffer.push_back('\\');
+                _Buffer.push_back(esc);
+                start=i+1;
+            }
+            _Buffer.insert(_Buffer.end(),data+start,data+size);
+        }break;
+        case HtmlTable::Json:{
+            const char hex[]="0123456789abcdef";
+            size_t start=0;
+            _Buffer.push_back('"');
+            for(size_t i=0; i<size; ++i){
+                unsigned char c=data[i];
+                if(c>=0x20 && c!='"' && c!='\\')
+                    continue;
+                _Buffer.insert(_Buffer.end(),data+start,data+i);
+                _Buffer.push_back('\\');
+                switch(c){
+                    case '"':
+                        _Buffer.push_back('"');
+                        break;
+                    case '\\':
+                        _Buffer.push_back('\\');
+                        break;
+                    case '\n':
+                        _Buffer.push_back('n');
+                        break;
+                    case '\r':
+                        _Buffer.push_back('r');
+                        break;
+                    case '\t':
+                        _Buffer.push_back('t');
+                        break;
+                    default:
+                        _Buffer.push_back('u');
+                        _Buffer.push_back('0');
+                        _Buffer.push_back('0');
+                        _Buffer.push_back(hex[c>>4]);
+                        _Buffer.push_back(hex[c&0xf]);
+                }
+                start=i+1;
+            }
+            _Buffer.insert(_Buffer.end(),data+start,data+size);
+            _Buffer.push_back('"');
+        }break;
+    }
+}
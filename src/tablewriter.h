@@ -0,0 +1,69 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <ostream>
+#include <vector>
+
+#include "html.h"
+
+#pragma once
+
+namespace libhtmlpp {
+
+    /*
+     * writes table rows as csv, tsv or json into a stream. Rows are
+     * converted one by one through a small block buffer, so the memory
+     * used doesn't depend on the number of rows. Csv follows rfc 4180,
+     * tsv escapes tab, newline, carriage return and backslash with a
+     * backslash. Json is an array of objects keyed by the header or an
+     * array of arrays without header.
+     */
+    class HtmlTableWriter {
+    public:
+        HtmlTableWriter(std::ostream &output,int format);
+        ~HtmlTableWriter();
+
+        //has to be set before the first row
+        void   setHeader(const HtmlTable::Row &header);
+        void   writeRow(const HtmlTable::Row &row);
+
+        //ends the json array and flushes the buffer into the stream
+        void   finish();
+
+        size_t getRows() const;
+    private:
+        void   _field(const char *data,size_t size);
+        void   _flush();
+
+        std::ostream             &_Output;
+        int                       _Format;
+        std::vector<char>         _Buffer;
+        std::vector<HtmlString>   _Keys;
+        size_t                    _Rows;
+        bool                      _Finished;
+    };
+};
@@ -0,0 +1,298 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <string.h>
+
+#include <stack>
+
+#include "exception.h"
+#include "names.h"
+#include "template.h"
+
+libhtmlpp::HtmlTemplate::HtmlTemplate(){
+    _StaticStart=0;
+}
+
+libhtmlpp::HtmlTemplate::~HtmlTemplate(){
+}
+
+void libhtmlpp::HtmlTemplate::_clear(){
+    _Static.clear();
+    _Parts.clear();
+    _Slots.clear();
+    _StaticStart=0;
+}
+
+size_t libhtmlpp::HtmlTemplate::getSlots() const{
+    return _Slots.size();
+}
+
+long libhtmlpp::HtmlTemplate::getSlot(const char *name) const{
+    for(size_t i=0; i<_Slots.size(); ++i){
+        if(_Slots[i]==name)
+            return i;
+    }
+    return -1;
+}
+
+const char *libhtmlpp::HtmlTemplate::getSlotName(size_t slot) const{
+    if(slot>=_Slots.size())
+        return nullptr;
+    return _Slots[slot].c_str();
+}
+
+size_t libhtmlpp::HtmlTemplate::_addSlot(const char *name,size_t nlen){
+    for(size_t i=0; i<_Slots.size(); ++i){
+        if(_Slots[i].size()==nlen && memcmp(_Slots[i].data(),name,nlen)==0)
+            return i;
+    }
+    _Slots.push_back(std::string(name,nlen));
+    return _Slots.size()-1;
+}
+
+void libhtmlpp::HtmlTemplate::_appendStatic(const char *src,size_t size){
+    _Static.insert(_Static.end(),src,src+size);
+}
+
+void libhtmlpp::HtmlTemplate::_flushStatic(){
+    if(_Static.size()==_StaticStart)
+        return;
+    Part part;
+    part.Type=StaticPart;
+    part.Slot=0;
+    part.Offset=_StaticStart;
+    part.Size=_Static.size()-_StaticStart;
+    part.AltOffset=part.AltSize=part.Jump=0;
+    _Parts.push_back(part);
+    _StaticStart=_Static.size();
+}
+
+namespace libhtmlpp {
+    static const char *findPair(const char *src,size_t size,char sign){
+        const char *end=src+size;
+        while(src+1<end){
+            src=(const char*)memchr(src,sign,(end-src)-1);
+            if(!src)
+                return nullptr;
+            if(src[1]==sign)
+                return src;
+            ++src;
+        }
+        return nullptr;
+    }
+};
+
+void libhtmlpp::HtmlTemplate::_appendValue(const char *src,size_t size){
+    size_t pos=0;
+    while(pos<size){
+        const char *open=findPair(src+pos,size-pos,'{');
+        if(!open)
+            break;
+        size_t npos=(open-src)+2;
+        const char *close=findPair(src+npos,size-npos,'}');
+        if(!close)
+            break;
+
+        size_t nend=close-src;
+        while(npos<nend && src[npos]==' ')
+            ++npos;
+        while(nend>npos && src[nend-1]==' ')
+            --nend;
+
+        _appendStatic(src+pos,open-(src+pos));
+        _flushStatic();
+
+        Part part;
+        part.Type=PlaceholderPart;
+        part.Slot=_addSlot(src+npos,nend-npos);
+        part.Offset=part.Size=part.AltOffset=part.AltSize=part.Jump=0;
+        _Parts.push_back(part);
+
+        pos=(close-src)+2;
+    }
+    _appendStatic(src+pos,size-pos);
+}
+
+void libhtmlpp::HtmlTemplate::compile(HtmlString &page){
+    //from the first node, text in front of the first element is static markup too
+    page.parse();
+    compile(page._RootNode);
+}
+
+void libhtmlpp::HtmlTemplate::compile(Element *el){
+    struct OpenEl {
+        HtmlElement *element;
+        long         content;
+    };
+
+    std::stack<OpenEl> openlist;
+
+    _clear();
+
+    auto endContent = [this](long content){
+        if(content<0)
+            return;
+        _flushStatic();
+        _Parts[content].Jump=_Parts.size();
+    };
+
+    while(el){
+        switch(el->_Type){
+            case HtmlEl:{
+                HtmlElement *hel=(HtmlElement*)el;
+                HtmlElement::Attributes *id=nullptr;
+                long content=-1;
+
+                _appendStatic("<",1);
+                _appendStatic(hel->_TagName.data(),hel->_TagName.size());
+                for (HtmlElement::Attributes* curattr = hel->_firstAttr; curattr; curattr = curattr->_nextAttr) {
+                    _appendStatic(" ",1);
+                    _appendStatic(curattr->_Key.data(),curattr->_Key.size());
+                    if(!curattr->_Value.empty()){
+                        _appendStatic("=\"",2);
+                        _appendValue(curattr->_Value.data(),curattr->_Value.size());
+                        _appendStatic("\"",1);
+                    }
+                    //the key is case insensitive like in getElementbyID()
+                    if(!id && HtmlNames::equals(curattr->_Key.data(),curattr->_Key.size(),"id",2) &&
+                        !curattr->_Value.empty()){
+                        id=curattr;
+                    }
+                }
+
+                //a void element has no content to replace, use {{name}} in its attributes
+                if(id && !HtmlNames::isVoid(hel->_TagName.data(),hel->_TagName.size())){
+                    _flushStatic();
+                    Part part;
+                    part.Type=ContentPart;
+                    part.Slot=_addSlot(id->_Value.data(),id->_Value.size());
+                    part.Offset=part.Size=part.Jump=0;
+                    part.AltOffset=_Static.size();
+                    _appendStatic("</",2);
+                    _appendStatic(hel->_TagName.data(),hel->_TagName.size());
+                    _appendStatic(">",1);
+                    part.AltSize=_Static.size()-part.AltOffset;
+                    _StaticStart=_Static.size();
+                    content=_Parts.size();
+                    _Parts.push_back(part);
+                }
+
+                if(hel->_children()){
+                    _appendStatic(">",1);
+                }else if(!HtmlNames::isVoid(hel->_TagName.data(),hel->_TagName.size())){
+                    _appendStatic("></",3);
+                    _appendStatic(hel->_TagName.data(),hel->_TagName.size());
+                    _appendStatic(">",1);
+                }else if(el->_nextElement){
+                    _appendStatic(">",1);
+                }else{
+                    _appendStatic(" />",3);
+                }
+
+                if(hel->_children()){
+                    OpenEl oel;
+                    oel.element=hel;
+                    oel.content=content;
+                    openlist.push(oel);
+                    el=hel->_children();
+                    continue;
+                }
+                endContent(content);
+            }break;
+            case TextEl:
+                _appendValue(((TextElement*)el)->_Text.data(),((TextElement*)el)->_Text.size());
+                break;
+            case CommentEl:
+                _appendStatic("<!--",4);
+                _appendStatic(((CommentElement*)el)->_Comment.data(),((CommentElement*)el)->_Comment.size());
+                _appendStatic("-->",3);
+                break;
+            default:
+                HTMLException excp;
+                excp[HTMLException::Error] << "Unkown Elementtype";
+                throw excp;
+        }
+
+        if(el->_nextElement){
+            el=el->_nextElement;
+            continue;
+        }
+
+        el=nullptr;
+        while(!openlist.empty()){
+            OpenEl oel=openlist.top();
+            openlist.pop();
+
+            _appendStatic("</",2);
+            _appendStatic(oel.element->_TagName.data(),oel.element->_TagName.size());
+            _appendStatic(">",1);
+            endContent(oel.content);
+
+            if(oel.element->_nextElement){
+                el=oel.element->_nextElement;
+                break;
+            }
+        }
+    }
+    _flushStatic();
+}
+
+void libhtmlpp::HtmlTemplate::render(const std::vector<const char*> &values,HtmlString &output) const{
+    if(values.size()<_Slots.size()){
+        HTMLException excp;
+        excp[HTMLException::Error] << "HtmlTemplate: not enough values for all slots!";
+        throw excp;
+    }
+    render(values.data(),output);
+}
+
+void libhtmlpp::HtmlTemplate::render(const char * const *values,HtmlString &output) const{
+    const char *data=_Static.data();
+    size_t i=0;
+    while(i<_Parts.size()){
+        const Part &part=_Parts[i];
+        switch(part.Type){
+            case StaticPart:
+                output.append(data+part.Offset,part.Size);
+                break;
+            case PlaceholderPart:
+                if(values[part.Slot])
+                    HtmlEncode(values[part.Slot],strlen(values[part.Slot]),&output);
+                break;
+            case ContentPart:
+                if(values[part.Slot]){
+                    output.push_back('>');
+                    HtmlEncode(values[part.Slot],strlen(values[part.Slot]),&output);
+                    output.append(data+part.AltOffset,part.AltSize);
+                    i=part.Jump;
+                    continue;
+                }
+                break;
+        }
+        ++i;
+    }
+}
@@ -0,0 +1,91 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <string>
+#include <vector>
+
+#include "html.h"
+
+#pragma once
+
+namespace libhtmlpp {
+
+    /*
+     * template compiled once from a parsed page. Every element with an id
+     * becomes a slot that replaces the content of the element, void
+     * elements like <input> have no content and get no slot. Every
+     * {{name}} in a text or attribute value becomes a slot at that place.
+     * The markup between the slots is serialized once at compile time, so
+     * render() only writes static bytes and escaped values and never
+     * touches the dom. A compiled template is never modified by render(),
+     * so one template can be rendered from many threads at the same time.
+     */
+    class HtmlTemplate {
+    public:
+        HtmlTemplate();
+        ~HtmlTemplate();
+
+        void        compile(Element *el);
+        void        compile(HtmlString &page);
+
+        size_t      getSlots() const;
+        long        getSlot(const char *name) const;
+        const char *getSlotName(size_t slot) const;
+
+        /*
+         * values[slot] is the unescaped value of the slot or nullptr.
+         * Unset id slots keep the content of the page, unset
+         * placeholders are left empty.
+         */
+        void        render(const char * const *values,HtmlString &output) const;
+        void        render(const std::vector<const char*> &values,HtmlString &output) const;
+    private:
+        enum PartType {StaticPart,PlaceholderPart,ContentPart};
+
+        struct Part {
+            int     Type;
+            size_t  Slot;
+            size_t  Offset;
+            size_t  Size;
+            //closing tag and end of the replaced content for ContentPart
+            size_t  AltOffset;
+            size_t  AltSize;
+            size_t  Jump;
+        };
+
+        void              _clear();
+        size_t            _addSlot(const char *name,size_t nlen);
+        void              _appendStatic(const char *src,size_t size);
+        void              _appendValue(const char *src,size_t size);
+        void              _flushStatic();
+
+        std::vector<char> _Static;
+        std::vector<Part> _Parts;
+        std::vector<std::string> _Slots;
+        size_t            _StaticStart;
+    };
+};
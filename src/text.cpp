@@ -0,0 +1,248 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "names.h"
+#include "text.h"
+
+//longest entity HtmlDecode looks for, with & and ;
+#define TEXT_MAXENTITY 12
+
+namespace libhtmlpp {
+    //elements whose content isn't text of the page
+    static const char *SkippedTags[]={"script","style","template",nullptr};
+
+    //elements that separate words
+    static const char *TextBlockTags[]={
+        "address","article","aside","blockquote","body","br","caption","dd",
+        "details","dialog","div","dl","dt","fieldset","figcaption","figure",
+        "footer","form","h1","h2","h3","h4","h5","h6","head","header","hgroup",
+        "hr","html","li","main","nav","ol","option","p","pre","section",
+        "summary","table","tbody","td","tfoot","th","thead","title","tr","ul",
+        nullptr
+    };
+
+    enum TextClass {TextOther=0,TextSpace,TextEntity};
+
+    struct TextTable {
+        unsigned char Class[256];
+        unsigned char Flags[HTML_MAXNAMES];
+
+        enum {Skipped=1,Block=2};
+
+        TextTable(){
+            memset(Class,TextOther,sizeof(Class));
+            Class[(unsigned char)' ']=Class[(unsigned char)'\t']=TextSpace;
+            Class[(unsigned char)'\n']=Class[(unsigned char)'\r']=Class[(unsigned char)'\f']=TextSpace;
+            Class[(unsigned char)'&']=TextEntity;
+            memset(Flags,0,sizeof(Flags));
+            for(size_t i=0; SkippedTags[i]; ++i)
+                Flags[HtmlNames::getTag(SkippedTags[i])]|=Skipped;
+            for(size_t i=0; TextBlockTags[i]; ++i)
+                Flags[HtmlNames::getTag(TextBlockTags[i])]|=Block;
+        }
+    };
+
+    static const TextTable &_textTable(){
+        static TextTable table;
+        return table;
+    }
+};
+
+libhtmlpp::HtmlTextWriter::HtmlTextWriter(HtmlString &output) : _Output(output){
+    _Space=false;
+    _Started=false;
+}
+
+libhtmlpp::HtmlTextWriter::~HtmlTextWriter(){
+}
+
+bool libhtmlpp::HtmlTextWriter::isSkipped(int tag){
+    return tag>=0 && tag<HTML_MAXNAMES && (_textTable().Flags[tag] & TextTable::Skipped);
+}
+
+bool libhtmlpp::HtmlTextWriter::isBlock(int tag){
+    return tag>=0 && tag<HTML_MAXNAMES && (_textTable().Flags[tag] & TextTable::Block);
+}
+
+void libhtmlpp::HtmlTextWriter::reset(){
+    _Entity.clear();
+    _Space=false;
+    _Started=false;
+}
+
+void libhtmlpp::HtmlTextWriter::text(const char *data,size_t size){
+    if(_Entity.empty()){
+        _text(data,size,false);
+        return;
+    }
+    std::vector<char> pending;
+    pending.swap(_Entity);
+    pending.insert(pending.end(),data,data+size);
+    _text(pending.data(),pending.size(),false);
+}
+
+void libhtmlpp::HtmlTextWriter::flush(){
+    if(_Entity.empty())
+        return;
+    std::vector<char> pending;
+    pending.swap(_Entity);
+    _text(pending.data(),pending.size(),true);
+}
+
+void libhtmlpp::HtmlTextWriter::block(){
+    flush();
+    _Space=_Started;
+}
+
+void libhtmlpp::HtmlTextWriter::_write(const char *data,size_t size){
+    if(_Space){
+        _Output.push_back(' ');
+        _Space=false;
+    }
+    _Output.append(data,size);
+    _Started=true;
+}
+
+void libhtmlpp::HtmlTextWriter::_text(const char *data,size_t size,bool last){
+    const unsigned char *cls=_textTable().Class;
+    size_t i=0;
+    while(i<size){
+        size_t start=i;
+        while(i<size && cls[(unsigned char)data[i]]==TextOther)
+            ++i;
+        if(i>start)
+            _write(data+start,i-start);
+        if(i==size)
+            break;
+
+        if(cls[(unsigned char)data[i]]==TextSpace){
+            _Space=_Started;
+            ++i;
+            continue;
+        }
+
+        size_t rest=size-i;
+        const char *semi=(const char*)memchr(data+i,';',std::min<size_t>(rest,TEXT_MAXENTITY));
+        if(!semi){
+            //the rest of the entity may come with the next text
+            if(!last && rest<TEXT_MAXENTITY){
+                _Entity.assign(data+i,data+size);
+                return;
+            }
+            _write(data+i,1);
+            ++i;
+            continue;
+        }
+        if(_Space){
+            _Output.push_back(' ');
+            _Space=false;
+        }
+        HtmlDecode(data+i,semi-data-i+1,&_Output);
+        _Started=true;
+        i=semi-data+1;
+    }
+}
+
+libhtmlpp::HtmlTextExtractor::HtmlTextExtractor() : _Writer(_Output){
+    _Skip=-1;
+    _SkipDepth=0;
+}
+
+libhtmlpp::HtmlTextExtractor::~HtmlTextExtractor(){
+}
+
+void libhtmlpp::HtmlTextExtractor::extract(const char *data,size_t size){
+    reset();
+    feed(data,size);
+    finish();
+}
+
+void libhtmlpp::HtmlTextExtractor::reset(){
+    HtmlTokenizer::reset();
+    _Output.clear();
+    _Writer.reset();
+    _Skip=-1;
+    _SkipDepth=0;
+}
+
+const char *libhtmlpp::HtmlTextExtractor::data() const{
+    return _Output.data();
+}
+
+size_t libhtmlpp::HtmlTextExtractor::size() const{
+    return _Output.size();
+}
+
+void libhtmlpp::HtmlTextExtractor::clear(){
+    _Output.clear();
+}
+
+void libhtmlpp::HtmlTextExtractor::onStartTag(const char *name,size_t nlen,const Attribute *attrs,
+                                              size_t acount,bool selfclosing){
+    int tag=HtmlNames::getTag(name,nlen);
+    if(_Skip>=0){
+        if(tag==_Skip && !selfclosing)
+            ++_SkipDepth;
+        return;
+    }
+    if(HtmlTextWriter::isSkipped(tag) && !selfclosing){
+        _Writer.flush();
+        _Skip=tag;
+        _SkipDepth=1;
+        return;
+    }
+    if(HtmlTextWriter::isBlock(tag))
+        _Writer.block();
+    else
+        _Writer.flush();
+}
+
+void libhtmlpp::HtmlTextExtractor::onEndTag(const char *name,size_t nlen){
+    int tag=HtmlNames::getTag(name,nlen);
+    if(_Skip>=0){
+        if(tag==_Skip && --_SkipDepth==0)
+            _Skip=-1;
+        return;
+    }
+    if(HtmlTextWriter::isBlock(tag))
+        _Writer.block();
+    else
+        _Writer.flush();
+}
+
+void libhtmlpp::HtmlTextExtractor::onText(const char *text,size_t tlen){
+    if(_Skip<0)
+        _Writer.text(text,tlen);
+}
+
+void libhtmlpp::HtmlTextExtractor::onEnd(){
+    _Writer.flush();
+}
@@ -0,0 +1,103 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <stddef.h>
+
+#include <vector>
+
+#include "html.h"
+#include "tokenizer.h"
+
+#pragma once
+
+namespace libhtmlpp {
+
+    /*
+     * writes text like a search index wants it: entities are decoded,
+     * whitespace collapses to one space and there is no space at the begin
+     * and the end. An entity at the end of text() is kept until the next
+     * call, so text can come in pieces.
+     */
+    class HtmlTextWriter {
+    public:
+        //appends to output
+        HtmlTextWriter(HtmlString &output);
+        ~HtmlTextWriter();
+
+        void        text(const char *data,size_t size);
+        //writes an unfinished entity as it is
+        void        flush();
+        //begin or end of a block element like p or li, separates words
+        void        block();
+        void        reset();
+
+        //script, style and template have no text
+        static bool isSkipped(int tag);
+        static bool isBlock(int tag);
+    private:
+        void        _text(const char *data,size_t size,bool last);
+        void        _write(const char *data,size_t size);
+
+        HtmlString       &_Output;
+        std::vector<char> _Entity;
+        bool              _Space;
+        bool              _Started;
+    };
+
+    /*
+     * streaming text extraction between the tokenizer and the output, no
+     * dom is built. The text is the same as HtmlElement::getTextContent()
+     * returns for the parsed document. The output can be taken and cleared
+     * between two feed() calls.
+     */
+    class HtmlTextExtractor : public HtmlTokenizer {
+    public:
+        HtmlTextExtractor();
+        ~HtmlTextExtractor();
+
+        //extracts the text of a complete document
+        void        extract(const char *data,size_t size);
+        //forgets the state and the output
+        void        reset();
+
+        const char *data() const;
+        size_t      size() const;
+        void        clear();
+    protected:
+        void onStartTag(const char *name,size_t nlen,const Attribute *attrs,
+                        size_t acount,bool selfclosing) override;
+        void onEndTag(const char *name,size_t nlen) override;
+        void onText(const char *text,size_t tlen) override;
+        void onEnd() override;
+    private:
+        HtmlString     _Output;
+        HtmlTextWriter _Writer;
+        //skipped element the text is in, -1 if none
+        int            _Skip;
+        size_t         _SkipDepth;
+    };
+};
@@ -0,0 +1,337 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <string.h>
+
+#include <fstream>
+
+#include "config.h"
+#include "exception.h"
+#include "tokenizer.h"
+
+namespace libhtmlpp {
+    static const char *RawTags[]={"script","style","textarea",nullptr};
+
+    static inline bool _space(char c){
+        return c==' ' || c=='\t' || c=='\n' || c=='\r' || c=='\f';
+    }
+
+    static inline bool _alpha(char c){
+        return (c>='a' && c<='z') || (c>='A' && c<='Z');
+    }
+
+    static const char *_findEnd(const char *data,size_t size,const char *end,size_t elen){
+        while(size>=elen){
+            const char *pos=(const char*)memchr(data,end[0],size-elen+1);
+            if(!pos)
+                return nullptr;
+            if(memcmp(pos,end,elen)==0)
+                return pos;
+            size-=(pos-data)+1;
+            data=pos+1;
+        }
+        return nullptr;
+    }
+};
+
+libhtmlpp::HtmlTokenizer::HtmlTokenizer(){
+    _RawTag=nullptr;
+}
+
+libhtmlpp::HtmlTokenizer::~HtmlTokenizer(){
+}
+
+bool libhtmlpp::HtmlTokenizer::isName(const char *name,size_t nlen,const char *cmp){
+    size_t i=0;
+    for(; i<nlen; ++i){
+        char c=(name[i]>='A' && name[i]<='Z') ? name[i]|0x20 : name[i];
+        if(!cmp[i] || c!=cmp[i])
+            return false;
+    }
+    return cmp[i]=='\0';
+}
+
+void libhtmlpp::HtmlTokenizer::onStartTag(const char *name,size_t nlen,const Attribute *attrs,
+                                          size_t acount,bool selfclosing){
+}
+
+void libhtmlpp::HtmlTokenizer::onEndTag(const char *name,size_t nlen){
+}
+
+void libhtmlpp::HtmlTokenizer::onText(const char *text,size_t tlen){
+}
+
+void libhtmlpp::HtmlTokenizer::onComment(const char *text,size_t tlen){
+}
+
+void libhtmlpp::HtmlTokenizer::onEnd(){
+}
+
+void libhtmlpp::HtmlTokenizer::reset(){
+    _Pending.clear();
+    _RawTag=nullptr;
+}
+
+void libhtmlpp::HtmlTokenizer::feed(const char *data,size_t size){
+    if(_Pending.empty()){
+        size_t used=_scan(data,size,false);
+        _Pending.assign(data+used,data+size);
+    }else{
+        _Pending.insert(_Pending.end(),data,data+size);
+        size_t used=_scan(_Pending.data(),_Pending.size(),false);
+        _Pending.erase(_Pending.begin(),_Pending.begin()+used);
+    }
+
+    //an unterminated tag or comment ends like at the end of the input
+    if(_Pending.size()>HTML_MAXPENDING){
+        std::vector<char> rest;
+        rest.swap(_Pending);
+        _scan(rest.data(),rest.size(),true);
+    }
+}
+
+void libhtmlpp::HtmlTokenizer::finish(){
+    std::vector<char> rest;
+    rest.swap(_Pending);
+    if(!rest.empty())
+        _scan(rest.data(),rest.size(),true);
+    _RawTag=nullptr;
+    onEnd();
+}
+
+void libhtmlpp::HtmlTokenizer::loadFile(const char *path){
+    char tmp[HTML_BLOCKSIZE];
+    std::ifstream fs(path,std::ios::binary);
+
+    if(!fs.is_open()){
+        HTMLException excp;
+        excp[HTMLException::Critical] << "HtmlTokenizer: can't open " << path;
+        throw excp;
+    }
+
+    while (fs.good()) {
+        fs.read(tmp,HTML_BLOCKSIZE);
+        feed(tmp,fs.gcount());
+    }
+    finish();
+}
+
+size_t libhtmlpp::HtmlTokenizer::_scan(const char *data,size_t size,bool last){
+    size_t pos=0;
+
+    while(pos<size){
+        if(_RawTag){
+            size_t rlen=strlen(_RawTag);
+            size_t i=pos;
+            for(;;){
+                const char *lt=(const char*)memchr(data+i,'<',size-i);
+                if(!lt){
+                    onText(data+pos,size-pos);
+                    return size;
+                }
+                i=lt-data;
+                //the name has to end, </scriptx doesn't close script
+                if(size-i<rlen+3 && !last){
+                    if(i>pos)
+                        onText(data+pos,i-pos);
+                    return i;
+                }
+                if(size-i>=rlen+3 && data[i+1]=='/' && isName(data+i+2,rlen,_RawTag) &&
+                   (_space(data[i+2+rlen]) || data[i+2+rlen]=='/' || data[i+2+rlen]=='>')){
+                    if(i>pos)
+                        onText(data+pos,i-pos);
+                    pos=i;
+                    _RawTag=nullptr;
+                    break;
+                }
+                ++i;
+            }
+            continue;
+        }
+
+        if(data[pos]!='<'){
+            const char *lt=(const char*)memchr(data+pos,'<',size-pos);
+            size_t end=lt ? lt-data : size;
+            onText(data+pos,end-pos);
+            pos=end;
+            continue;
+        }
+
+        size_t rest=size-pos;
+        if(rest<4 && !last)
+            return pos;
+
+        char next=rest>1 ? data[pos+1] : '\0';
+
+        if(next=='!' && rest>=4 && data[pos+2]=='-' && data[pos+3]=='-'){
+            //<!--> and <!---> are empty comments
+            if(!last && (rest==4 || (rest==5 && data[pos+4]=='-')))
+                return pos;
+            if(rest>=5 && data[pos+4]=='>'){
+                onComment(data+pos+4,0);
+                pos+=5;
+                continue;
+            }
+            if(rest>=6 && data[pos+4]=='-' && data[pos+5]=='>'){
+                onComment(data+pos+4,0);
+                pos+=6;
+                continue;
+            }
+            const char *end=_findEnd(data+pos+4,size-pos-4,"-->",3);
+            if(!end){
+                if(!last)
+                    return pos;
+                onComment(data+pos+4,size-pos-4);
+                return size;
+            }
+            onComment(data+pos+4,end-(data+pos+4));
+            pos=(end-data)+3;
+            continue;
+        }
+
+        if(next=='!' || next=='?' || next=='/'){
+            const char *gt=(const char*)memchr(data+pos+1,'>',size-pos-1);
+            if(!gt){
+                if(!last)
+                    return pos;
+                onText(data+pos,rest);
+                return size;
+            }
+            if(next=='/'){
+                size_t nstart=pos+2,nend=nstart;
+                while(data+nend<gt && !_space(data[nend]) && data[nend]!='/')
+                    ++nend;
+                onEndTag(data+nstart,nend-nstart);
+            }
+            pos=(gt-data)+1;
+            continue;
+        }
+
+        if(!_alpha(next)){
+            onText(data+pos,1);
+            ++pos;
+            continue;
+        }
+
+        //find the end of the tag, > inside quoted values doesn't count
+        size_t i=pos+1,end=0;
+        while(i<size){
+            char c=data[i];
+            if(c=='>'){
+                end=i;
+                break;
+            }
+            ++i;
+            if(c=='='){
+                while(i<size && _space(data[i]))
+                    ++i;
+                if(i<size && (data[i]=='"' || data[i]=='\'')){
+                    const char *quote=(const char*)memchr(data+i+1,data[i],size-i-1);
+                    if(!quote){
+                        i=size;
+                        break;
+                    }
+                    i=(quote-data)+1;
+                }
+            }
+        }
+
+        if(!end){
+            if(!last)
+                return pos;
+            onText(data+pos,rest);
+            return size;
+        }
+
+        _tag(data+pos+1,end-pos-1);
+        pos=end+1;
+    }
+    return pos;
+}
+
+void libhtmlpp::HtmlTokenizer::_tag(const char *tag,size_t tlen){
+    size_t i=0;
+    while(i<tlen && !_space(tag[i]) && tag[i]!='/')
+        ++i;
+    size_t nlen=i;
+    bool selfclosing=false;
+
+    _Attrs.clear();
+    while(i<tlen){
+        if(_space(tag[i])){
+            ++i;
+            continue;
+        }
+        if(tag[i]=='/'){
+            if(i+1==tlen)
+                selfclosing=true;
+            ++i;
+            continue;
+        }
+
+        Attribute attr;
+        attr.Key=tag+i;
+        while(i<tlen && !_space(tag[i]) && tag[i]!='=' && tag[i]!='/')
+            ++i;
+        attr.KeySize=(tag+i)-attr.Key;
+        attr.Value=nullptr;
+        attr.ValueSize=0;
+
+        size_t vpos=i;
+        while(vpos<tlen && _space(tag[vpos]))
+            ++vpos;
+        if(vpos<tlen && tag[vpos]=='='){
+            ++vpos;
+            while(vpos<tlen && _space(tag[vpos]))
+                ++vpos;
+            if(vpos<tlen && (tag[vpos]=='"' || tag[vpos]=='\'')){
+                const char *quote=(const char*)memchr(tag+vpos+1,tag[vpos],tlen-vpos-1);
+                attr.Value=tag+vpos+1;
+                attr.ValueSize=quote ? quote-attr.Value : tlen-vpos-1;
+                i=quote ? (quote-tag)+1 : tlen;
+            }else{
+                attr.Value=tag+vpos;
+                while(vpos<tlen && !_space(tag[vpos]))
+                    ++vpos;
+                attr.ValueSize=(tag+vpos)-attr.Value;
+                i=vpos;
+            }
+        }
+        _Attrs.push_back(attr);
+    }
+
+    onStartTag(tag,nlen,_Attrs.data(),_Attrs.size(),selfclosing);
+
+    if(!selfclosing){
+        for(size_t ii=0; RawTags[ii]; ++ii){
+            if(isName(tag,nlen,RawTags[ii])){
+                _RawTag=RawTags[ii];
+                break;
+            }
+        }
+    }
+}
@@ -0,0 +1,85 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <stddef.h>
+
+#include <vector>
+
+#pragma once
+
+namespace libhtmlpp {
+
+    /*
+     * streaming tokenizer, the input can be fed in blocks of any size and
+     * only an unfinished tag or comment is kept between two feed() calls,
+     * so memory doesn't grow with the document. Subclasses override the
+     * callbacks they need, all pointers are only valid during the callback.
+     * A text run can be split into several onText() calls at block
+     * boundaries. Content of script, style and textarea is passed as text.
+     * An unfinished tag or comment longer than HTML_MAXPENDING is passed
+     * like at the end of the input.
+     */
+    class HtmlTokenizer {
+    public:
+        struct Attribute {
+            const char *Key;
+            size_t      KeySize;
+            //raw value without quotes, nullptr for attributes without value
+            const char *Value;
+            size_t      ValueSize;
+        };
+
+        HtmlTokenizer();
+        virtual ~HtmlTokenizer();
+
+        void feed(const char *data,size_t size);
+        //ends the input, an unfinished tag at the end is passed as text
+        void finish();
+        void reset();
+
+        //feeds the file in blocks of HTML_BLOCKSIZE and calls finish()
+        void loadFile(const char *path);
+
+        //case insensitive compare of a tag or attribute name with the lower case cmp
+        static bool isName(const char *name,size_t nlen,const char *cmp);
+    protected:
+        virtual void onStartTag(const char *name,size_t nlen,const Attribute *attrs,
+                                size_t acount,bool selfclosing);
+        virtual void onEndTag(const char *name,size_t nlen);
+        virtual void onText(const char *text,size_t tlen);
+        virtual void onComment(const char *text,size_t tlen);
+        virtual void onEnd();
+    private:
+        size_t                 _scan(const char *data,size_t size,bool last);
+        void                   _tag(const char *tag,size_t tlen);
+
+        std::vector<char>      _Pending;
+        std::vector<Attribute> _Attrs;
+        //set while inside script, style or textarea
+        const char            *_RawTag;
+    };
+};
@@ -0,0 +1,192 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <string.h>
+
+#include "cascade.h"
+#include "exception.h"
+
+#define Red     "\033[0;31m"
+#define Green   "\033[0;32m"
+#define NOCOLOR "\033[0m"
+
+#define BLOCKS 2500
+#define RULES  5000
+
+static int fail(const char *msg){
+    std::cout << msg << std::endl;
+    std::cout << Red << "Test not Passed!" << NOCOLOR << std::endl;
+    return -1;
+}
+
+static const char sheet[]=
+    "p { color: black; margin: 0 }\n"
+    ".intro { color: blue }\n"
+    "#main p.intro { color: green }\n"
+    "div > p { padding: 1px }\n"
+    "p + p { margin-top: 2px }\n"
+    "h1 ~ p { font-weight: bold }\n"
+    "li:first-child { color: red }\n"
+    "li:nth-child(2n) { color: gray }\n"
+    "li:last-child { border: 0 }\n"
+    "a[href^=\"https\"] { text-decoration: none }\n"
+    "a[target] { color: purple }\n"
+    "p:not(.intro) { font-size: 12px }\n"
+    ".important { color: orange !important }\n"
+    "@media (max-width: 600px) { p { color: pink } }\n"
+    "a:hover { color: red }\n"
+    "p::first-line { color: red }\n"
+    "td:empty { display: none }\n"
+    ":root { background: white }\n"
+    "h1 { font-family: \"Open Sans\", sans-serif }\n";
+
+static const char page[]=
+    "<html><body><div id=\"main\"><h1>Title</h1>"
+    "<p class=\"intro important\" style=\"color: yellow; padding: 3px\">Hello</p><p>World</p></div>"
+    "<ul><li>a</li><li>b</li><li>c</li></ul><a href=\"https://x\" target=\"_blank\">x</a>"
+    "<table><tr><td></td><td>1</td></tr></table></body></html>";
+
+static bool style(libhtmlpp::HtmlElement *el,const char *expected){
+    const char *value=el ? el->getAtributte("style") : nullptr;
+    if(!value)
+        value="";
+    if(strcmp(value,expected)==0)
+        return true;
+    std::cout << "got \"" << value << "\" expected \"" << expected << "\"" << std::endl;
+    return false;
+}
+
+int main(int argc,char *argv[]){
+    try{
+        libhtmlpp::CssStylesheet css;
+        css.parse(sheet);
+
+        libhtmlpp::CssCascade cascade;
+        cascade.addStylesheet(css);
+
+        libhtmlpp::HtmlString html;
+        html << page;
+        libhtmlpp::HtmlElement *root=html.parse();
+
+        libhtmlpp::HtmlElement *div=root->getElementbyID("main");
+        libhtmlpp::HtmlElement *intro=(libhtmlpp::HtmlElement*)div->getElementbyTag("p");
+        libhtmlpp::HtmlElement *world=(libhtmlpp::HtmlElement*)intro->nextElement();
+
+        std::vector<libhtmlpp::CssCascade::Property> props;
+        cascade.getStyle(world,props);
+        if(props.size()!=6 || props[3].Name!="margin-top" || props[3].Value!="2px")
+            return fail("wrong computed style");
+
+        cascade.inlineStyles(root);
+
+        if(!style(intro,"margin:0;font-weight:bold;padding:3px;color:orange !important"))
+            return fail("wrong style with id, classes, style attribute and !important");
+        if(!style(world,"color:black;margin:0;padding:1px;margin-top:2px;font-weight:bold;font-size:12px"))
+            return fail("wrong style with combinators and :not()");
+        if(!style(div->getElementbyTag("h1"),"font-family:&quot;Open Sans&quot;, sans-serif"))
+            return fail("wrong style with quotes");
+
+        libhtmlpp::HtmlElement *li=root->getElementbyTag("li");
+        if(!style(li,"color:red"))
+            return fail("wrong style for :first-child");
+        li=(libhtmlpp::HtmlElement*)li->nextElement();
+        if(!style(li,"color:gray"))
+            return fail("wrong style for :nth-child()");
+        li=(libhtmlpp::HtmlElement*)li->nextElement();
+        if(!style(li,"border:0"))
+            return fail("wrong style for :last-child");
+
+        if(!style(root->getElementbyTag("a"),"text-decoration:none;color:purple"))
+            return fail("wrong style for attribute selectors");
+
+        libhtmlpp::HtmlElement *td=root->getElementbyTag("td");
+        if(!style(td,"display:none") || !style((libhtmlpp::HtmlElement*)td->nextElement(),""))
+            return fail("wrong style for :empty");
+
+        if(!style(root,"background:white") || !style(root->getElementbyTag("body"),""))
+            return fail("wrong style for :root");
+
+        std::string big;
+        const char *colors[]={"#333","#0d6efd","red","rgba(0,0,0,.5)","inherit"};
+        for(int i=0; i<RULES; ++i){
+            int n=i/5;
+            switch(i%5){
+                case 0:
+                    big+=".c"+std::to_string(n)+" { color: "+colors[n%5]+"; padding: 1px }\n";
+                    break;
+                case 1:
+                    big+="#b"+std::to_string(n)+" span { font-weight: bold }\n";
+                    break;
+                case 2:
+                    big+="div.c"+std::to_string(n)+" > p { margin: 0 auto }\n";
+                    break;
+                case 3:
+                    big+="ul li.c"+std::to_string(n)+":nth-child(2n+1) { border: 1px solid }\n";
+                    break;
+                case 4:
+                    big+=".box .c"+std::to_string(n)+" a[href] { text-decoration: none }\n";
+                    break;
+            }
+        }
+        big+="p { line-height: 1.5 } span { color: gray } * { box-sizing: border-box }\n";
+
+        libhtmlpp::HtmlString doc;
+        doc << "<html><body>";
+        for(int i=0; i<BLOCKS; ++i){
+            int n=i%(RULES/5);
+            doc << "<div class=\"box c" << n << "\" id=\"b" << n << "\"><p class=\"c" << n
+                << "\">text <a href=\"/x\">link</a></p><span>more</span></div>";
+        }
+        doc << "</body></html>";
+        libhtmlpp::HtmlElement *docroot=doc.parse();
+
+        auto cstart=std::chrono::steady_clock::now();
+        libhtmlpp::CssStylesheet bigcss;
+        bigcss.parse(big.data(),big.size());
+        libhtmlpp::CssCascade bigcascade;
+        bigcascade.addStylesheet(bigcss);
+        std::chrono::duration<double> compiletime=std::chrono::steady_clock::now()-cstart;
+
+        auto istart=std::chrono::steady_clock::now();
+        bigcascade.inlineStyles(docroot);
+        std::chrono::duration<double> inlinetime=std::chrono::steady_clock::now()-istart;
+
+        libhtmlpp::HtmlElement *first=docroot->getElementbyID("b0");
+        if(!style(first,"box-sizing:border-box;color:#333;padding:1px"))
+            return fail("wrong style in the benchmark document");
+
+        std::cout << BLOCKS*6+2 << " nodes, " << bigcascade.getSelectorCount() << " selectors: compile "
+                  << compiletime.count()*1000 << " ms, inline " << inlinetime.count()*1000 << " ms" << std::endl;
+    }catch(libhtmlpp::HTMLException &exp){
+        return fail(exp.what());
+    }
+    std::cout << Green << "Test Passed!" << NOCOLOR << std::endl;
+    return 0;
+}
@@ -25,32 +25,227 @@ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 *******************************************************************************/
 
+#include <chrono>
 #include <iostream>
+#include <string>
+#include <string.h>
 
-#include "../src/html.h"
+#include "css.h"
+#include "exception.h"
 
 #define Red     "\033[0;31m"
 #define Green   "\033[0;32m"
 #define NOCOLOR "\033[0m"
 
-void *__dso_handle __attribute__((__visibility__("hidden"))) __attribute__((weak)) = nullptr;
+static int fail(const char *msg){
+    std::cout << msg << std::endl;
+    std::cout << Red << "Test not Passed!" << NOCOLOR << std::endl;
+    return -1;
+}
 
-int main(){
-    // libhtmlpp::HtmlTable table;
-    try{
-        // table.setAttribute("Style",":;(),+~'");
-        std::cout  << Green << "Test Passed!" << NOCOLOR << std::endl;
-    }catch(...){
-        std::cout   << Red << "Test not Passed!" << NOCOLOR << std::endl;
-        return -1;
+//writes every event of the parser into Text
+class CssRecorder : public libhtmlpp::CssParser {
+public:
+    CssRecorder(){
+        Rules=0;
+        Blocks=0;
+    }
+    std::string Text;
+    size_t      Rules;
+    size_t      Blocks;
+protected:
+    void onRule(const char *selector,size_t slen,const Declaration *decls,size_t dcount) override{
+        ++Rules;
+        Text.append(selector,slen);
+        _decls(decls,dcount);
+    }
+
+    void onAtRule(const char *name,size_t nlen,const char *prelude,size_t plen,
+                  const Declaration *decls,size_t dcount) override{
+        ++Rules;
+        Text+="@";
+        Text.append(name,nlen);
+        Text+=" ";
+        Text.append(prelude,plen);
+        if(decls)
+            _decls(decls,dcount);
+        else
+            Text+=";";
+    }
+
+    void onBlockStart(const char *name,size_t nlen,const char *prelude,size_t plen) override{
+        ++Blocks;
+        Text+="@";
+        Text.append(name,nlen);
+        Text+=" ";
+        Text.append(prelude,plen);
+        Text+="[";
     }
-    
+
+    void onBlockEnd() override{
+        Text+="]";
+    }
+private:
+    void _decls(const Declaration *decls,size_t dcount){
+        Text+="{";
+        for(size_t i=0; i<dcount; ++i){
+            Text.append(decls[i].Property,decls[i].PropertySize);
+            Text+=":";
+            Text.append(decls[i].Value,decls[i].ValueSize);
+            if(decls[i].Important)
+                Text+="!";
+            Text+=";";
+        }
+        Text+="}";
+    }
+};
+
+static const char sheet[]=
+    "@charset \"utf-8\";\n"
+    "@import url(\"base.css\") screen;\n"
+    "/* comment { with } braces */\n"
+    "a, .b > c:hover,\n #d::before { color: red; background: url(data:image/png;base64,AA==) !important }\n"
+    "@media (min-width: 100px) { .x{margin:0} @supports (display:grid) { .y{display:grid} } }\n"
+    "@font-face { font-family: \"F{}\"; src: url('f.woff') format(\"woff\") }\n"
+    "@keyframes spin { from { transform: rotate(0) } to { transform: rotate(360deg) } }\n"
+    ".e::after { content: \"}\"; }\n"
+    ".broken { color red; width: 1px }\n"
+    ".nest { color: blue; &:hover { color: green } padding: 1px }\n"
+    "<!-- .cdo { top: 0 } -->\n";
+
+static const char events[]=
+    "@charset \"utf-8\";"
+    "@import url(\"base.css\") screen;"
+    "a, .b > c:hover,\n #d::before{color:red;background:url(data:image/png;base64,AA==)!;}"
+    "@media (min-width: 100px)[.x{margin:0;}@supports (display:grid)[.y{display:grid;}]]"
+    "@font-face {font-family:\"F{}\";src:url('f.woff') format(\"woff\");}"
+    "@keyframes spin[from{transform:rotate(0);}to{transform:rotate(360deg);}]"
+    ".e::after{content:\"}\";}"
+    ".broken{width:1px;}"
+    ".nest{color:blue;padding:1px;}"
+    ".cdo{top:0;}";
+
+//something that looks like a css framework
+static void framework(std::string &css,size_t size){
+    const char *props[]={"color: #333","margin: 0 auto","padding: .5rem 1rem",
+                         "border: 1px solid rgba(0,0,0,.125)","display: flex",
+                         "background-image: url(\"data:image/svg+xml,%3csvg xmlns='http://www.w3.org/2000/svg'/%3e\")",
+                         "transition: color .15s ease-in-out,background-color .15s ease-in-out",
+                         "font-family: -apple-system,\"Segoe UI\",Roboto,sans-serif",
+                         "width: calc(100% - 2 * var(--gutter, 1.5rem))","z-index: 1050 !important"};
+    size_t i=0;
+    css+="/*! framework v1.0 */\n:root{--primary:#0d6efd;--gutter:1.5rem}\n";
+    while(css.size()<size){
+        if(i%50==0)
+            css+="@media (min-width: "+std::to_string(576+i%4*192)+"px) {\n";
+        css+=".btn-"+std::to_string(i)+", .btn-"+std::to_string(i)+":not(:disabled):hover > .icon::before, #nav-"
+            +std::to_string(i)+" [data-toggle=\"x\"] {\n";
+        for(size_t p=0; p<4; ++p)
+            css+="  "+std::string(props[(i+p*3)%10])+";\n";
+        css+="}\n";
+        if(i%50==49)
+            css+="}\n";
+        if(i%300==0)
+            css+="@keyframes fade-"+std::to_string(i)+" { 0% { opacity: 0 } 100% { opacity: 1 } }\n";
+        ++i;
+    }
+    if(i%50!=0)
+        css+="}\n";
+}
+
+int main(int argc,char *argv[]){
     try{
-        // table.setAttribute("Style", "\"");
-        std::cout   << Red << "Test not Passed!" << NOCOLOR<< std::endl;
-        return -1;
-    }catch(...){
-        std::cout   << Green << "Test Passed!" << NOCOLOR << std::endl;
+        const char tokens[]="a.b#c:hover{width:calc(100% - 2px);content:\"x\\\"y\";}@media url(x.png) -1.5e3em 50%";
+        libhtmlpp::CssTokenizer tok(tokens,sizeof(tokens)-1);
+        libhtmlpp::CssTokenizer::Token token;
+        std::string types;
+        const char names[]="ifahsSuUdnpDwCc:;,[]()<>/?.";
+        while(tok.next(token))
+            types+=names[token.Type];
+        if(types!="idih:i<i:fpwdwD);i:s;>awuwDwp")
+            return fail(types.c_str());
+
+        CssRecorder whole;
+        whole.parse(sheet,sizeof(sheet)-1);
+        if(whole.Text!=events)
+            return fail(whole.Text.c_str());
+
+        //the same events for every block size
+        for(size_t block=1; block<=17; ++block){
+            CssRecorder stream;
+            for(size_t pos=0; pos<sizeof(sheet)-1; pos+=block)
+                stream.feed(sheet+pos,std::min(block,sizeof(sheet)-1-pos));
+            stream.finish();
+            if(stream.Text!=events)
+                return fail(stream.Text.c_str());
+        }
+
+        libhtmlpp::CssStylesheet css;
+        css.parse(sheet);
+        const libhtmlpp::CssStylesheet::Rule *rules=css.getRules();
+        if(css.getRuleCount()!=15)
+            return fail("wrong rule count");
+        const libhtmlpp::CssStylesheet::Rule &first=rules[2];
+        if(first.Type!=libhtmlpp::CssStylesheet::StyleRule || first.SelectorCount!=3 || first.DeclarationCount!=2)
+            return fail("wrong style rule");
+        const libhtmlpp::CssStylesheet::Selector *sels=css.getSelectors()+first.FirstSelector;
+        if(css.getText(sels[2].Text)!="#d::before" || sels[1].Specificity!=(2<<10|1))
+            return fail("wrong selectors");
+        const libhtmlpp::CssStylesheet::Declaration *decls=css.getDeclarations()+first.FirstDeclaration;
+        if(css.getText(decls[1].Property)!="background" || !decls[1].Important || decls[0].Important)
+            return fail("wrong declarations");
+        if(rules[4].Parent!=3 || rules[6].Parent!=5 || rules[7].Parent!=libhtmlpp::CssStylesheet::NoRule
+            || css.getText(rules[5].Name)!="supports")
+            return fail("wrong rule parents");
+
+        struct {
+            const char *Selector;
+            uint32_t    Specificity;
+        } specs[]={
+            {"*",0},{"li",1},{"ul li",2},{"ul ol+li",3},{"h1 + *[rel=up]",1<<10|1},
+            {"ul ol li.red",1<<10|3},{"li.red.level",2<<10|1},{"#x34y",1<<20},
+            {"#s12:not(FOO)",1<<20|1},{".foo :is(.bar, #baz)",1<<20|1<<10},
+            {"a:where(#x, .y) b",2},{"a::before",2},{"a:before",2},{"svg|rect",1},
+            {"input:nth-child(2n+1)",1<<10|1}
+        };
+        for(auto &spec : specs){
+            uint32_t got=libhtmlpp::CssStylesheet::getSpecificity(spec.Selector,strlen(spec.Selector));
+            if(got!=spec.Specificity)
+                return fail(spec.Selector);
+        }
+
+        std::string big;
+        framework(big,4*1024*1024);
+        auto pstart=std::chrono::steady_clock::now();
+        css.parse(big.data(),big.size());
+        std::chrono::duration<double> parsetime=std::chrono::steady_clock::now()-pstart;
+
+        CssRecorder counter;
+        auto sstart=std::chrono::steady_clock::now();
+        for(size_t pos=0; pos<big.size(); pos+=65536){
+            counter.Text.clear();
+            counter.feed(big.data()+pos,std::min<size_t>(65536,big.size()-pos));
+        }
+        counter.finish();
+        std::chrono::duration<double> streamtime=std::chrono::steady_clock::now()-sstart;
+
+        if(counter.Rules+counter.Blocks!=css.getRuleCount())
+            return fail("stream and stylesheet differ");
+
+        std::cout << "framework css " << big.size()/1024 << " KB, " << css.getRuleCount() << " rules" << std::endl;
+        std::cout << "stylesheet: " << big.size()/parsetime.count()/1048576 << " MB/s" << std::endl;
+        std::cout << "stream:     " << big.size()/streamtime.count()/1048576 << " MB/s" << std::endl;
+
+        for(int i=1; i<argc; ++i){
+            auto fstart=std::chrono::steady_clock::now();
+            css.loadFile(argv[i]);
+            std::chrono::duration<double> filetime=std::chrono::steady_clock::now()-fstart;
+            std::cout << argv[i] << ": " << css.size()/1024 << " KB, " << css.getRuleCount() << " rules, "
+                      << css.size()/filetime.count()/1048576 << " MB/s" << std::endl;
+        }
+    }catch(libhtmlpp::HTMLException &exp){
+        return fail(exp.what());
     }
+    std::cout << Green << "Test Passed!" << NOCOLOR << std::endl;
     return 0;
 }
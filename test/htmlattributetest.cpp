@@ -0,0 +1,125 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <string.h>
+
+#include "html.h"
+#include "exception.h"
+
+#define Red     "\033[0;31m"
+#define Green   "\033[0;32m"
+#define NOCOLOR "\033[0m"
+
+#define BENCHSIZE (4*1024*1024)
+
+static int fail(const char *msg){
+    std::cout << msg << std::endl;
+    std::cout << Red << "Test not Passed!" << NOCOLOR << std::endl;
+    return -1;
+}
+
+static bool attr(libhtmlpp::HtmlElement *el,const char *name,const char *value){
+    const char *cur=el ? el->getAtributte(name) : nullptr;
+    if(!cur || strcmp(cur,value)!=0){
+        std::cout << name << "=" << (cur ? cur : "(none)") << " expected " << value << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static double parseSpeed(const std::string &page){
+    libhtmlpp::HtmlString doc(page.c_str());
+    auto start=std::chrono::steady_clock::now();
+    doc.parse();
+    std::chrono::duration<double> time=std::chrono::steady_clock::now()-start;
+    return page.size()/time.count()/1048576;
+}
+
+int main(int argc,char *argv[]){
+    try{
+        libhtmlpp::HtmlString html(
+            "<div><a id=a href=/x/y class='btn big' title=\"say 'hi'\" data-v='a \"q\"' disabled hidden=hidden x=>t</a>"
+            "<p id=p a=\"1\"b='2'c=3 d title = \"spaced\" id=dup>text</p>"
+            "<input id=i value=\"a>b<c\" name=q>"
+            "<span id=s data-a=1/><b id=inside>b</b></span>"
+            "<br id=br /><em id=em>e</em>"
+            "<ID id=upper A=\"1\" data-a=/></ID></div>");
+        libhtmlpp::HtmlElement *root=html.parse();
+
+        libhtmlpp::HtmlElement *a=root->getElementbyID("a");
+        if(!attr(a,"href","/x/y") || !attr(a,"class","btn big") || !attr(a,"title","say 'hi'") ||
+           !attr(a,"data-v","a &quot;q&quot;") || !attr(a,"disabled","") || !attr(a,"hidden","hidden") ||
+           !attr(a,"x",""))
+            return fail("wrong quoted, unquoted or boolean values");
+
+        libhtmlpp::HtmlElement *p=root->getElementbyID("p");
+        if(!attr(p,"a","1") || !attr(p,"b","2") || !attr(p,"c","3") || !attr(p,"d","") ||
+           !attr(p,"title","spaced") || !attr(p,"id","p"))
+            return fail("wrong attributes without spaces or duplicated ones");
+
+        if(!attr(root->getElementbyID("i"),"value","a>b<c") || !attr(root->getElementbyID("i"),"name","q"))
+            return fail("> inside a quoted value ended the tag");
+
+        libhtmlpp::HtmlElement *span=root->getElementbyID("s");
+        if(!attr(span,"data-a","1/") || !span->getElementbyID("inside"))
+            return fail("slash of an unquoted value closed the tag");
+
+        if(!root->getElementbyID("br") || !root->getElementbyID("em") || !attr(root->getElementbyID("upper"),"data-a","/"))
+            return fail("wrong self-closing tags");
+
+        const libhtmlpp::HtmlString::ParseErrors &errs=html.getParseErrors();
+        if(errs.StrayEndTags || errs.MisnestedTags || errs.UnclosedElements)
+            return fail("attributes confused the tree builder");
+
+        //printing quotes every value, the output has to parse to the same tree
+        libhtmlpp::HtmlString out,out2;
+        libhtmlpp::print(root,out);
+        libhtmlpp::HtmlString again(out);
+        libhtmlpp::print(again.parse(),out2);
+        if(std::string(out.c_str())!=out2.c_str())
+            return fail("printed attributes parse differently");
+
+        std::string minified,quoted;
+        while(minified.size()<BENCHSIZE){
+            minified+="<li class=item><a href=/p/123 data-id=123 rel=nofollow title='Item 123'>Item</a>"
+                      "<input type=checkbox checked><img src=/i/123.png alt=''></li>";
+            quoted+="<li class=\"item\"><a href=\"/p/123\" data-id=\"123\" rel=\"nofollow\" title=\"Item 123\">Item</a>"
+                    "<input type=\"checkbox\" checked><img src=\"/i/123.png\" alt=\"\"></li>";
+        }
+        minified="<ul>"+minified+"</ul>";
+        quoted="<ul>"+quoted+"</ul>";
+        std::cout << "minified markup: " << parseSpeed(minified) << " MB/s, quoted: "
+                  << parseSpeed(quoted) << " MB/s" << std::endl;
+    }catch(libhtmlpp::HTMLException &exp){
+        return fail(exp.what());
+    }
+    std::cout << Green << "Test Passed!" << NOCOLOR << std::endl;
+    return 0;
+}
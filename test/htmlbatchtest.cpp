@@ -0,0 +1,115 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <chrono>
+#include <iostream>
+#include <string.h>
+
+#include "html.h"
+#include "batch.h"
+#include "exception.h"
+
+#define Red     "\033[0;31m"
+#define Green   "\033[0;32m"
+#define NOCOLOR "\033[0m"
+
+#define DOCUMENTS 2000
+#define ROUNDS    5
+
+void buildDocuments(std::vector<libhtmlpp::HtmlString> &docs){
+    docs.clear();
+    docs.resize(DOCUMENTS);
+    for(size_t i=0; i<DOCUMENTS; ++i){
+        docs[i] << "<div id=\"mail" << (int)i << "\"><p class=\"body\">Hello <b>user "
+                << (int)i << "</b>, your order <span id=\"order\">" << (int)(i*7)
+                << "</span> has shipped.</p><!-- footer --><p>Regards</p></div>";
+    }
+    /*a document that can't be parsed must be reported without stopping the batch*/
+    docs[DOCUMENTS/2].freeze();
+}
+
+int main(int arc,char *argv[]){
+    try{
+        std::vector<libhtmlpp::HtmlString> seq,par;
+        buildDocuments(seq);
+        buildDocuments(par);
+
+        std::vector<std::string> expected(DOCUMENTS);
+        auto sstart=std::chrono::steady_clock::now();
+        for(int r=0; r<ROUNDS; ++r){
+            for(size_t i=0; i<DOCUMENTS; ++i){
+                try{
+                    libhtmlpp::HtmlString out;
+                    libhtmlpp::print(seq[i].parse(),out);
+                    expected[i]=out.c_str();
+                }catch(libhtmlpp::HTMLException &e){
+                    expected[i].clear();
+                }
+            }
+        }
+        std::chrono::duration<double> seqtime=std::chrono::steady_clock::now()-sstart;
+
+        libhtmlpp::HtmlBatch batch;
+        std::vector<libhtmlpp::HtmlElement*> roots;
+        std::vector<std::string> errs;
+        size_t failed=0;
+
+        auto pstart=std::chrono::steady_clock::now();
+        for(int r=0; r<ROUNDS; ++r){
+            failed=batch.parse(par,roots,&errs);
+        }
+        std::chrono::duration<double> partime=std::chrono::steady_clock::now()-pstart;
+
+        if(failed!=1 || roots[DOCUMENTS/2] || errs[DOCUMENTS/2].empty()){
+            std::cout << "broken document not reported" << std::endl;
+            std::cout << Red << "Test not Passed!" << NOCOLOR << std::endl;
+            return -1;
+        }
+
+        for(size_t i=0; i<DOCUMENTS; ++i){
+            if(!roots[i])
+                continue;
+            libhtmlpp::HtmlString out;
+            libhtmlpp::print(roots[i],out);
+            if(expected[i]!=out.c_str()){
+                std::cout << "document " << i << " differs from sequential parse" << std::endl;
+                std::cout << Red << "Test not Passed!" << NOCOLOR << std::endl;
+                return -1;
+            }
+        }
+
+        std::cout << "sequential: " << (DOCUMENTS*ROUNDS)/seqtime.count() << " docs/s" << std::endl;
+        std::cout << "batch(" << batch.threads() << " threads): "
+                  << (DOCUMENTS*ROUNDS)/partime.count() << " docs/s" << std::endl;
+        std::cout << Green << "Test Passed!" << NOCOLOR << std::endl;
+    }catch(libhtmlpp::HTMLException &exp){
+        std::cout << exp.what() << std::endl;
+        std::cout << Red << "Test not Passed!" << NOCOLOR << std::endl;
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,167 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "html.h"
+#include "charset.h"
+#include "exception.h"
+
+#define Red     "\033[0;31m"
+#define Green   "\033[0;32m"
+#define NOCOLOR "\033[0m"
+
+static int fail(const char *msg){
+    std::cout << msg << std::endl;
+    std::cout << Red << "Test not Passed!" << NOCOLOR << std::endl;
+    return -1;
+}
+
+struct Case {
+    std::string Input;
+    int         Encoding;
+    std::string Output;
+    size_t      Errors;
+};
+
+static const Case Cases[]={
+    {"<p>plain ascii</p>",libhtmlpp::HtmlCharset::Utf8,"<p>plain ascii</p>",0},
+    {"<p>caf\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80</p>",libhtmlpp::HtmlCharset::Utf8,
+     "<p>caf\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80</p>",0},
+    {"\xEF\xBB\xBF<p>bom</p>",libhtmlpp::HtmlCharset::Utf8,"<p>bom</p>",0},
+    {std::string("\xFF\xFE<\0p\0>\0\xE9\0\x3D\xD8\x00\xDE",14),libhtmlpp::HtmlCharset::Utf16LE,
+     "<p>\xC3\xA9\xF0\x9F\x98\x80",0},
+    {std::string("\xFE\xFF\0<\0p\0>\xD8\x3D\0x",12),libhtmlpp::HtmlCharset::Utf16BE,
+     "<p>\xEF\xBF\xBDx",1},
+    {"<meta charset=\"windows-1252\"><p>caf\xE9 \x80 \x93q\x94</p>",libhtmlpp::HtmlCharset::Windows1252,
+     "<meta charset=\"windows-1252\"><p>caf\xC3\xA9 \xE2\x82\xAC \xE2\x80\x9Cq\xE2\x80\x9D</p>",0},
+    {"<!-- <meta charset=utf-8> --><META http-equiv=Content-Type content='text/html; charset=ISO-8859-1'>\xFC",
+     libhtmlpp::HtmlCharset::Windows1252,
+     "<!-- <meta charset=utf-8> --><META http-equiv=Content-Type content='text/html; charset=ISO-8859-1'>\xC3\xBC",0},
+    {"<meta content='text/html; charset=latin1'><meta charset=utf-16>\xC3\xA9",libhtmlpp::HtmlCharset::Utf8,
+     "<meta content='text/html; charset=latin1'><meta charset=utf-16>\xC3\xA9",0},
+    {"<p>no meta, gr\xFC\xDF" "e</p>",libhtmlpp::HtmlCharset::Windows1252,"<p>no meta, gr\xC3\xBC\xC3\x9F" "e</p>",0},
+    {"<meta charset=utf-8>\xC3\x28 \xC0\xAF \xED\xA0\x80 \xF4\x90\x80\x80 \xE2\x82",libhtmlpp::HtmlCharset::Utf8,
+     "<meta charset=utf-8>\xEF\xBF\xBD( \xEF\xBF\xBD\xEF\xBF\xBD \xEF\xBF\xBD\xEF\xBF\xBD\xEF\xBF\xBD "
+     "\xEF\xBF\xBD\xEF\xBF\xBD\xEF\xBF\xBD\xEF\xBF\xBD \xEF\xBF\xBD",11},
+    {"",libhtmlpp::HtmlCharset::Utf8,"",0}
+};
+
+static std::string decoded(const std::string &input,size_t bsize,int &encoding,size_t &errors){
+    libhtmlpp::HtmlCharsetDecoder decoder;
+    libhtmlpp::HtmlString out;
+    if(bsize){
+        for(size_t i=0; i<input.size(); i+=bsize)
+            decoder.feed(input.data()+i,std::min(bsize,input.size()-i),out);
+        decoder.finish(out);
+    }else{
+        decoder.decode(input.data(),input.size(),out);
+    }
+    encoding=decoder.getEncoding();
+    errors=decoder.getErrors();
+    return std::string(out.data(),out.size());
+}
+
+int main(int argc,char *argv[]){
+    try{
+        for(size_t i=0; !Cases[i].Input.empty(); ++i){
+            //the whole input is below the sniffing size, so blocks detect the same
+            for(size_t bsize=0; bsize<=Cases[i].Input.size(); ++bsize){
+                int encoding;
+                size_t errors;
+                std::string out=decoded(Cases[i].Input,bsize,encoding,errors);
+                if(encoding!=Cases[i].Encoding || out!=Cases[i].Output || errors!=Cases[i].Errors){
+                    std::cout << "case " << i << " in blocks of " << bsize << ": "
+                              << libhtmlpp::HtmlCharset::getName(encoding) << " '" << out << "' "
+                              << errors << " errors" << std::endl;
+                    return fail("wrong decoded input");
+                }
+            }
+        }
+
+        if(libhtmlpp::HtmlCharset::getEncoding(" Latin1 ",8)!=libhtmlpp::HtmlCharset::Windows1252 ||
+           libhtmlpp::HtmlCharset::getEncoding("shift_jis",9)!=libhtmlpp::HtmlCharset::Unknown)
+            return fail("wrong encoding labels");
+
+        //the detected encoding holds for the blocks after the first 1024 bytes
+        std::string latin=std::string(2000,' ')+"\xE9";
+        int encoding;
+        size_t errors;
+        if(decoded(latin,100,encoding,errors)!=std::string(2000,' ')+"\xEF\xBF\xBD" || errors!=1)
+            return fail("late invalid byte of a utf-8 page");
+
+        libhtmlpp::HtmlPage page;
+        libhtmlpp::HtmlElement *root=page.loadString(std::string("<html><body><p title=\"\xE9t\xE9\">na\xEFve</p></body></html>"));
+        libhtmlpp::HtmlString out;
+        libhtmlpp::print(root,out);
+        if(page.getEncoding()!=libhtmlpp::HtmlCharset::Windows1252 ||
+           std::string(out.data(),out.size()).find("title=\"\xC3\xA9t\xC3\xA9\">na\xC3\xAFve")==std::string::npos)
+            return fail("latin-1 page not converted");
+
+        //an HtmlString goes through the decoder like the other overloads
+        libhtmlpp::HtmlString latinstr("<p>na\xEFve</p>"),utf8str("<p>na\xC3\xAFve</p>");
+        libhtmlpp::HtmlString strout;
+        libhtmlpp::print(page.loadString(latinstr),strout);
+        if(page.getEncoding()!=libhtmlpp::HtmlCharset::Windows1252 ||
+           std::string(strout.data(),strout.size())!="<p>na\xC3\xAFve</p>")
+            return fail("HtmlString page not converted");
+        if(!page.loadString(&utf8str) || page.getEncoding()!=libhtmlpp::HtmlCharset::Utf8)
+            return fail("encoding of the last HtmlString page not set");
+
+        std::string html="<!DOCTYPE html><html><head><meta charset=\"utf-8\"><title>t</title></head><body>";
+        while(html.size()<4*1024*1024){
+            html+="<div class=\"item\"><p>Gr\xC3\xBC\xC3\x9F" "e aus K\xC3\xB6ln, <b>\xE2\x82\xAC 5</b> "
+                  "<a href=\"/x\">links</a> &amp; \xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E\n"
+                  "<p>and an open paragraph<ul><li>one<li>two</ul><script>track(1<2)</script></div>\n";
+        }
+        html+="</body></html>";
+
+        libhtmlpp::HtmlString raw(html.c_str());
+        auto start=std::chrono::steady_clock::now();
+        raw.parse();
+        std::chrono::duration<double> tparse=std::chrono::steady_clock::now()-start;
+
+        libhtmlpp::HtmlCharsetDecoder decoder;
+        libhtmlpp::HtmlString converted;
+        start=std::chrono::steady_clock::now();
+        decoder.decode(html.data(),html.size(),converted);
+        std::chrono::duration<double> tdecode=std::chrono::steady_clock::now()-start;
+
+        if(converted.size()!=html.size() || memcmp(converted.data(),html.data(),html.size())!=0)
+            return fail("valid utf-8 changed");
+
+        std::cout << "parse: " << html.size()/tparse.count()/1048576 << " MB/s, decode: "
+                  << html.size()/tdecode.count()/1048576 << " MB/s, "
+                  << 100*tdecode.count()/tparse.count() << "% of the parse time" << std::endl;
+    }catch(libhtmlpp::HTMLException &exp){
+        return fail(exp.what());
+    }
+    std::cout << Green << "Test Passed!" << NOCOLOR << std::endl;
+    return 0;
+}
@@ -0,0 +1,174 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <string.h>
+
+#include "html.h"
+#include "document.h"
+#include "exception.h"
+
+#define Red     "\033[0;31m"
+#define Green   "\033[0;32m"
+#define NOCOLOR "\033[0m"
+
+#define ROUNDS 10
+
+typedef libhtmlpp::HtmlDocument Document;
+
+static int fail(const char *msg){
+    std::cout << msg << std::endl;
+    std::cout << Red << "Test not Passed!" << NOCOLOR << std::endl;
+    return -1;
+}
+
+template<typename Fn>
+static double measure(Fn fn){
+    auto start=std::chrono::steady_clock::now();
+    for(int i=0; i<ROUNDS; ++i)
+        fn();
+    std::chrono::duration<double> time=std::chrono::steady_clock::now()-start;
+    return time.count();
+}
+
+//the columns describe the same tree as the links
+static bool checkColumns(const Document &doc){
+    const uint32_t *parents=doc.getParents(),*next=doc.getNextSiblings(),*ends=doc.getSubtreeEnds();
+    for(uint32_t i=0; i<doc.getNodeCount(); ++i){
+        if(ends[i]<=i || ends[i]>doc.getNodeCount())
+            return false;
+        if(next[i]!=Document::NoNode && (next[i]!=ends[i] || parents[next[i]]!=parents[i]))
+            return false;
+        for(uint32_t c=i+1; c<ends[i]; c=ends[c]){
+            if(parents[c]!=i)
+                return false;
+        }
+    }
+    return true;
+}
+
+int main(int arc,char *argv[]){
+    if(arc<2)
+        return fail("usage: htmldocumenttest <html file>");
+
+    try{
+        libhtmlpp::HtmlPage page;
+        libhtmlpp::HtmlElement *index=page.loadFile(argv[1]);
+
+        libhtmlpp::HtmlString expected;
+        libhtmlpp::print(index,expected);
+
+        Document doc;
+        doc.create(index);
+        if(!checkColumns(doc))
+            return fail("columns don't match the tree");
+
+        libhtmlpp::HtmlString direct,built;
+        doc.print(direct);
+        if(strcmp(direct.c_str(),expected.c_str())!=0)
+            return fail("document print differs from print()");
+
+        libhtmlpp::print(doc.build(),built);
+        if(strcmp(built.c_str(),expected.c_str())!=0)
+            return fail("tree built from the document differs from print()");
+
+        //a copy of the built tree replaces it
+        doc.create(doc.build());
+        libhtmlpp::HtmlString rebuilt;
+        doc.print(rebuilt);
+        if(strcmp(rebuilt.c_str(),expected.c_str())!=0)
+            return fail("document created from its own tree differs");
+
+        libhtmlpp::HtmlString small("<div id=\"a\"><x-tag>t</x-tag><p class=c>one<br>two</p><!--c--></div><img src=\"i.png\">");
+        doc.create(small.parse());
+        uint32_t p=doc.getElementbyTag("p"),custom=doc.getElementbyTag("x-tag");
+        if(doc.getNodeCount()!=9 || p!=3 || custom!=1 || doc.getParents()[p]!=0 ||
+           doc.getSubtreeEnds()[p]!=7 || doc.getElementbyTag("p",p+1)!=Document::NoNode ||
+           doc.getElementbyID("a")!=0 || doc.getElementbyTag("IMG")!=8 ||
+           doc.getText(*doc.getAttribute(p,"class"))!="c" || doc.getAttribute(p,"id"))
+            return fail("wrong lookup");
+
+        //the document and the tree it was made of find the same elements
+        libhtmlpp::HtmlString mixed("<DIV><Span ID=\"x\">a</Span><custom-EL id=\"Y\">c</custom-EL><p>d</p></DIV>");
+        libhtmlpp::HtmlElement *mroot=mixed.parse();
+        doc.create(mroot);
+        const char *tags[]={"span","SPAN","div","Custom-El","custom-el","p","b",nullptr};
+        for(size_t i=0; tags[i]; ++i){
+            libhtmlpp::HtmlElement *tel=mroot->getElementbyTag(tags[i]);
+            uint32_t del=doc.getElementbyTag(tags[i]);
+            if((tel==nullptr)!=(del==Document::NoNode) ||
+               (tel && doc.getText(doc.getData()[del])!=tel->getTagname()))
+                return fail(tags[i]);
+        }
+        const char *ids[]={"x","X","Y","y",nullptr};
+        for(size_t i=0; ids[i]; ++i){
+            libhtmlpp::HtmlElement *tel=mroot->getElementbyID(ids[i]);
+            uint32_t del=doc.getElementbyID(ids[i]);
+            if((tel==nullptr)!=(del==Document::NoNode) ||
+               (tel && doc.getText(doc.getData()[del])!=tel->getTagname()))
+                return fail(ids[i]);
+        }
+        if(!mroot->getElementbyTag("SPAN") || !mroot->getElementbyID("x") || mroot->getElementbyID("X"))
+            return fail("tag names and id keys must be case insensitive, ids not");
+
+        std::string src="<html><body>";
+        for(int i=0; i<20000; ++i){
+            src+="<div class=\"item\"><p>Some <b>text</b> with <a href=\"/x\">links</a></p>"
+                 "<ul><li>one</li><li>two</li></ul><img src=\"a.png\"></div>";
+        }
+        src+="<span id=\"last\">end</span></body></html>";
+        libhtmlpp::HtmlString large(src.c_str());
+        libhtmlpp::HtmlElement *root=large.parse();
+        doc.create(root);
+        if(!checkColumns(doc))
+            return fail("columns don't match the large tree");
+
+        libhtmlpp::HtmlElement *found=nullptr;
+        uint32_t flat=Document::NoNode;
+        double ttree=measure([&](){ found=root->getElementbyID("last"); });
+        double tflat=measure([&](){ flat=doc.getElementbyID("last"); });
+        if(!found || flat==Document::NoNode || doc.getText(doc.getData()[flat])!="span")
+            return fail("last element not found");
+
+        libhtmlpp::HtmlString out1,out2;
+        double ptree=measure([&](){ out1.clear(); libhtmlpp::print(root,out1); });
+        double pflat=measure([&](){ out2.clear(); doc.print(out2); });
+        if(strcmp(out1.c_str(),out2.c_str())!=0)
+            return fail("large document print differs from print()");
+
+        std::cout << doc.getNodeCount() << " nodes, getElementbyID tree: " << ttree*1000/ROUNDS
+                  << " ms, flat: " << tflat*1000/ROUNDS << " ms" << std::endl;
+        std::cout << "print tree: " << ptree*1000/ROUNDS << " ms, flat: " << pflat*1000/ROUNDS
+                  << " ms" << std::endl;
+    }catch(libhtmlpp::HTMLException &exp){
+        return fail(exp.what());
+    }
+    std::cout << Green << "Test Passed!" << NOCOLOR << std::endl;
+    return 0;
+}
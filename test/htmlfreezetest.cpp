@@ -0,0 +1,117 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <string.h>
+
+#include "html.h"
+#include "exception.h"
+
+#define Red     "\033[0;31m"
+#define Green   "\033[0;32m"
+#define NOCOLOR "\033[0m"
+
+#define THREADS 8
+#define ROUNDS  200
+
+int main(int arc,char *argv[]){
+    libhtmlpp::HtmlString tpl;
+    tpl << "<html><head><title>template</title></head><body>"
+        << "<!-- cached template --><div id=\"content\" class=\"main\">"
+        << "<span id=\"user\">guest</span><p>static text</p></div></body></html>";
+
+    libhtmlpp::HtmlElement *root=nullptr;
+
+    try{
+        root=tpl.parse();
+        libhtmlpp::HtmlString expected;
+        libhtmlpp::print(root,expected);
+
+        tpl.freeze();
+
+        if(!root->isFrozen()){
+            std::cout << "root not frozen" << std::endl;
+            std::cout << Red << "Test not Passed!" << NOCOLOR << std::endl;
+            return -1;
+        }
+
+        std::string reference=expected.c_str();
+        std::string source=tpl.c_str();
+        std::atomic<int> errors(0);
+        std::vector<std::thread> workers;
+
+        for(int t=0; t<THREADS; ++t){
+            workers.push_back(std::thread([&]{
+                for(int r=0; r<ROUNDS; ++r){
+                    libhtmlpp::HtmlString out;
+                    libhtmlpp::print(root,out);
+                    if(reference!=out.c_str())
+                        ++errors;
+
+                    const libhtmlpp::HtmlElement *content=root->getElementbyID("content");
+                    if(!content || strcmp(content->getAtributte("class"),"main")!=0 ||
+                        strcmp(content->getTagname(),"div")!=0)
+                        ++errors;
+
+                    libhtmlpp::HtmlElement *user=root->getElementbyID("user");
+                    if(!user || strcmp(user->getTagname(),"span")!=0)
+                        ++errors;
+
+                    if(!root->getElementbyTag("title") || source!=tpl.c_str())
+                        ++errors;
+                }
+            }));
+        }
+
+        for(std::thread &worker : workers)
+            worker.join();
+
+        if(errors){
+            std::cout << errors << " inconsistent reads on frozen tree" << std::endl;
+            std::cout << Red << "Test not Passed!" << NOCOLOR << std::endl;
+            return -1;
+        }
+    }catch(libhtmlpp::HTMLException &exp){
+        std::cout << exp.what() << std::endl;
+        std::cout << Red << "Test not Passed!" << NOCOLOR << std::endl;
+        return -1;
+    }
+
+    try{
+        root->getElementbyID("user")->setAttribute("id","other");
+        std::cout << "frozen element modified" << std::endl;
+        std::cout << Red << "Test not Passed!" << NOCOLOR << std::endl;
+        return -1;
+    }catch(libhtmlpp::HTMLException &exp){
+    }
+
+    std::cout << Green << "Test Passed!" << NOCOLOR << std::endl;
+    return 0;
+}
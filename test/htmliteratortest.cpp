@@ -0,0 +1,172 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <stack>
+#include <string>
+
+#include "html.h"
+#include "exception.h"
+
+#define Red     "\033[0;31m"
+#define Green   "\033[0;32m"
+#define NOCOLOR "\033[0m"
+
+static int fail(const char *msg){
+    std::cout << msg << std::endl;
+    std::cout << Red << "Test not Passed!" << NOCOLOR << std::endl;
+    return -1;
+}
+
+//tag names and text of the visited elements
+static void name(libhtmlpp::Element &el,std::string &out){
+    if(!out.empty())
+        out+=' ';
+    if(el.getType()==libhtmlpp::HtmlEl)
+        out+=((libhtmlpp::HtmlElement&)el).getTagname();
+    else if(el.getType()==libhtmlpp::TextEl)
+        out+=std::string("#")+((libhtmlpp::TextElement&)el).getText();
+}
+
+//collects text, skips lists and stops at the element with id stop
+class TextVisitor : public libhtmlpp::ElementVisitor {
+public:
+    std::string Text;
+    size_t      Left=0;
+
+    int enter(libhtmlpp::Element *el) override{
+        if(el->getType()==libhtmlpp::TextEl)
+            Text+=((libhtmlpp::TextElement*)el)->getText();
+        if(el->getType()!=libhtmlpp::HtmlEl)
+            return Continue;
+        libhtmlpp::HtmlElement *hel=(libhtmlpp::HtmlElement*)el;
+        const char *id=hel->getAtributte("id");
+        if(id && strcmp(id,"stop")==0)
+            return Stop;
+        return strcmp(hel->getTagname(),"ul")==0 ? SkipChildren : Continue;
+    }
+
+    int leave(libhtmlpp::Element *el) override{
+        ++Left;
+        return Continue;
+    }
+};
+
+int main(int argc,char *argv[]){
+    try{
+        libhtmlpp::HtmlString html("<div id=\"a\"><p>x<b>y</b></p><ul><li>1</li></ul></div><span>z</span>");
+        libhtmlpp::HtmlElement *root=html.parse();
+
+        std::string pre,post,kids,skipped,inner;
+        for(libhtmlpp::Element &el : libhtmlpp::preOrder(root))
+            name(el,pre);
+        for(libhtmlpp::Element &el : libhtmlpp::postOrder(root))
+            name(el,post);
+        for(libhtmlpp::Element &el : libhtmlpp::children(root))
+            name(el,kids);
+        for(libhtmlpp::PreOrderIterator it(root); it!=libhtmlpp::PreOrderIterator(); ++it){
+            name(*it,skipped);
+            if(it->getType()==libhtmlpp::HtmlEl && strcmp(((libhtmlpp::HtmlElement&)*it).getTagname(),"p")==0)
+                it.skipChildren();
+        }
+        libhtmlpp::HtmlElement *p=root->getElementbyTag("p");
+        for(libhtmlpp::Element &el : libhtmlpp::preOrder(p))
+            name(el,inner);
+
+        if(pre!="div p #x b #y ul li #1 span #z")
+            return fail(("wrong pre order: "+pre).c_str());
+        if(post!="#x #y b p #1 li ul div #z span")
+            return fail(("wrong post order: "+post).c_str());
+        if(kids!="p ul")
+            return fail(("wrong children: "+kids).c_str());
+        if(skipped!="div p ul li #1 span #z")
+            return fail(("wrong skip: "+skipped).c_str());
+        if(inner!="p #x b #y ul li #1")
+            return fail(("walk leaves the parent: "+inner).c_str());
+
+        size_t texts=std::count_if(libhtmlpp::preOrder(root).begin(),libhtmlpp::preOrder(root).end(),
+                                   [](libhtmlpp::Element &el){ return el.getType()==libhtmlpp::TextEl; });
+        if(texts!=4)
+            return fail("count_if over pre order");
+
+        TextVisitor visitor;
+        if(!libhtmlpp::visit(root,visitor) || visitor.Text!="xyz" || visitor.Left!=8)
+            return fail("wrong visit");
+
+        libhtmlpp::HtmlString stopped("<p>a<b id=\"stop\">b</b>c</p>");
+        TextVisitor stopper;
+        if(libhtmlpp::visit(stopped.parse(),stopper) || stopper.Text!="a")
+            return fail("visitor didn't stop");
+
+        //lookups walk in document order
+        libhtmlpp::HtmlString order("<div><p id=\"x\">first</p></div><p id=\"x\">second</p>");
+        libhtmlpp::HtmlElement *orderroot=order.parse(),*first=orderroot->getElementbyTag("p");
+        if(!first || first!=orderroot->getElementbyID("x") ||
+           strcmp(((libhtmlpp::TextElement*)first->childElement())->getText(),"first")!=0)
+            return fail("lookup not in document order");
+
+        std::string src="<html><body>";
+        for(int i=0; i<20000; ++i){
+            src+="<div class=\"item\"><p>Some <b>text</b> with <a href=\"/x\">links</a></p>"
+                 "<ul><li>one</li><li>two</li></ul><img src=\"a.png\"></div>";
+        }
+        src+="</body></html>";
+        libhtmlpp::HtmlString large(src.c_str());
+        libhtmlpp::HtmlElement *doc=large.parse();
+
+        size_t nstack=0,niter=0;
+        auto start=std::chrono::steady_clock::now();
+        std::stack<libhtmlpp::Element*> childs;
+        for(libhtmlpp::Element *el=doc; el; ){
+            ++nstack;
+            if(el->getType()==libhtmlpp::HtmlEl && ((libhtmlpp::HtmlElement*)el)->childElement())
+                childs.push(((libhtmlpp::HtmlElement*)el)->childElement());
+            el=el->nextElement();
+            if(!el && !childs.empty()){
+                el=childs.top();
+                childs.pop();
+            }
+        }
+        std::chrono::duration<double> tstack=std::chrono::steady_clock::now()-start;
+
+        start=std::chrono::steady_clock::now();
+        for(libhtmlpp::PreOrderIterator it(doc),end; it!=end; ++it)
+            ++niter;
+        std::chrono::duration<double> titer=std::chrono::steady_clock::now()-start;
+
+        if(nstack!=niter)
+            return fail("iterator misses elements");
+        std::cout << niter << " elements, std::stack walk: " << tstack.count()*1000
+                  << " ms, iterator: " << titer.count()*1000 << " ms" << std::endl;
+    }catch(libhtmlpp::HTMLException &exp){
+        return fail(exp.what());
+    }
+    std::cout << Green << "Test Passed!" << NOCOLOR << std::endl;
+    return 0;
+}
@@ -0,0 +1,146 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "html.h"
+#include "exception.h"
+
+#define Red     "\033[0;31m"
+#define Green   "\033[0;32m"
+#define NOCOLOR "\033[0m"
+
+static int fail(const char *msg){
+    std::cout << msg << std::endl;
+    std::cout << Red << "Test not Passed!" << NOCOLOR << std::endl;
+    return -1;
+}
+
+static std::string print(libhtmlpp::Element *el){
+    libhtmlpp::HtmlString out;
+    libhtmlpp::print(el,out);
+    return out.c_str();
+}
+
+//markup the tree builder repairs, the lazy tree has to come out the same
+static const char *Cases[]={
+    "<!DOCTYPE html><html><head><title>t</title><meta charset=utf-8></head><body><p>a<p>b</body></html>",
+    "<div><p>one<div>two</div>three</p></div>tail",
+    "<ul><li>a<li>b<ul><li>c</ul><li>d</ul><dl><dt>x<dd>y<dt>z</dl>",
+    "<table><tr><td>1<td>2<tr><td>3</table><b><i>x</b>y</i>",
+    "<select><option>a<option>b<optgroup><option>c</select><h1>h<h2>g</h2>",
+    "<div>open <span>unclosed <em>deep",
+    "</stray><p>text</p></div><br><img src=x /><x-custom a=1>c</x-custom>",
+    "<script>if(a<b) document.write('<p>')</script><!-- <p> --><textarea><b></textarea>end",
+    "<p>a</p>\n<p>b</p>\n",
+    nullptr
+};
+
+int main(int argc,char *argv[]){
+    try{
+        for(size_t i=0; Cases[i]; ++i){
+            libhtmlpp::HtmlString eager(Cases[i]),lazy(Cases[i]);
+            std::string expected=print(eager.parse());
+            std::string got=print(lazy.parseLazy());
+            if(got!=expected){
+                std::cout << Cases[i] << std::endl << expected << std::endl << got << std::endl;
+                return fail("lazy tree differs");
+            }
+            const libhtmlpp::HtmlString::ParseErrors &e=eager.getParseErrors(),&l=lazy.getParseErrors();
+            if(e.StrayEndTags!=l.StrayEndTags || e.MisnestedTags!=l.MisnestedTags ||
+               e.UnclosedElements!=l.UnclosedElements)
+                return fail("lazy parse errors differ");
+        }
+
+        //the source of unbuilt children outlives the string they were parsed from
+        libhtmlpp::HtmlElement *part;
+        {
+            libhtmlpp::HtmlString html("<div><section id=\"s\"><p>kept <b>here</b></p></section><p>x</p></div>");
+            part=(libhtmlpp::HtmlElement*)html.parseLazy()->childElement()->detach();
+        }
+        if(print(part)!="<section id=\"s\"><p>kept <b>here</b></p></section>")
+            return fail("detached lazy element");
+        delete part;
+
+        libhtmlpp::HtmlString changed("<div><p>a</p></div><div><p>b</p></div>");
+        libhtmlpp::HtmlElement *croot=changed.parseLazy();
+        libhtmlpp::HtmlElement *second=(libhtmlpp::HtmlElement*)croot->nextElement();
+        libhtmlpp::HtmlElement copy(second);
+        if(print(&copy)!="<div><p>b</p></div>")
+            return fail("copy of a lazy element");
+        libhtmlpp::HtmlElement span("span");
+        croot->appendChild(&span);
+        second->insertChild(&span);
+        if(print(croot)!="<div><p>a</p><span></span></div><div><span></span></div>")
+            return fail("changed lazy elements");
+
+        //unbuilt subtrees are searched with case insensitive tag names
+        libhtmlpp::HtmlString upper("<div><p><SPAN>x</SPAN></p></div><div>< b>y</b></div>");
+        libhtmlpp::HtmlElement *uroot=upper.parseLazy();
+        if(!uroot->getElementbyTag("span") || !uroot->getElementbyTag("B"))
+            return fail("lazy tag lookup is case sensitive");
+
+        std::string page="<!DOCTYPE html><html><head><title>Big page</title><meta name=\"a\" content=\"b\"></head><body>";
+        for(size_t i=0; page.size()<4*1024*1024; ++i){
+            std::string n=std::to_string(i);
+            page+="<div class=\"item\" id=\"item"+n+"\"><p>Some <b>text</b> with <a href=\"/x\">links</a>\n"
+                  "<p>and an open paragraph<ul><li>one<li>two</ul><table><tr><td>"+n+"<td>cell</table></div>\n";
+        }
+        page+="<div id=\"footer\"><p>end</p></div></body></html>";
+
+        libhtmlpp::HtmlString eager(page.c_str());
+        auto start=std::chrono::steady_clock::now();
+        libhtmlpp::HtmlElement *eroot=eager.parse();
+        std::string etitle=print(eroot->getElementbyTag("title"));
+        std::string efooter=print(eroot->getElementbyID("footer"));
+        std::chrono::duration<double> teager=std::chrono::steady_clock::now()-start;
+
+        libhtmlpp::HtmlString lazy(page.c_str());
+        start=std::chrono::steady_clock::now();
+        libhtmlpp::HtmlElement *lroot=lazy.parseLazy();
+        std::string ltitle=print(lroot->getElementbyTag("title"));
+        std::string lfooter=print(lroot->getElementbyID("footer"));
+        std::chrono::duration<double> tlazy=std::chrono::steady_clock::now()-start;
+
+        if(ltitle!=etitle || ltitle.compare(0,23,"<title>Big page</title>")!=0 || lfooter!=efooter)
+            return fail("lazy lookups differ");
+        //the body is only built now
+        if(print(lroot)!=print(eroot))
+            return fail("lazy page differs");
+
+        std::cout << "title and footer with parse(): " << teager.count()*1000 << " ms, with parseLazy(): "
+                  << tlazy.count()*1000 << " ms" << std::endl;
+        if(tlazy.count()>teager.count())
+            return fail("lazy parse builds too much");
+    }catch(libhtmlpp::HTMLException &exp){
+        return fail(exp.what());
+    }
+    std::cout << Green << "Test Passed!" << NOCOLOR << std::endl;
+    return 0;
+}
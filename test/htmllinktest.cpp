@@ -0,0 +1,226 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "html.h"
+#include "names.h"
+#include "exception.h"
+
+#define Red     "\033[0;31m"
+#define Green   "\033[0;32m"
+#define NOCOLOR "\033[0m"
+
+static int fail(const char *msg){
+    std::cout << msg << std::endl;
+    std::cout << Red << "Test not Passed!" << NOCOLOR << std::endl;
+    return -1;
+}
+
+class LinkCollector : public libhtmlpp::HtmlLinkExtractor {
+public:
+    std::vector<std::string> Links;
+protected:
+    void onLink(int tag,int attribute,const char *url,size_t ulen){
+        Links.push_back(std::string(libhtmlpp::HtmlNames::getTagName(tag))+" "+
+                        libhtmlpp::HtmlNames::getAttributeName(attribute)+" "+
+                        std::string(url,ulen));
+    }
+};
+
+//examples of rfc 3986 5.4
+static const char *Resolves[][2]={
+    {"g:h","g:h"},{"g","http://a/b/c/g"},{"./g","http://a/b/c/g"},{"g/","http://a/b/c/g/"},
+    {"/g","http://a/g"},{"//g","http://g"},{"?y","http://a/b/c/d;p?y"},{"g?y","http://a/b/c/g?y"},
+    {"#s","http://a/b/c/d;p?q#s"},{"g#s","http://a/b/c/g#s"},{";x","http://a/b/c/;x"},
+    {".","http://a/b/c/"},{"./","http://a/b/c/"},{"..","http://a/b/"},{"../","http://a/b/"},
+    {"../g","http://a/b/g"},{"../..","http://a/"},{"../../g","http://a/g"},
+    {"../../../g","http://a/g"},{"/./g","http://a/g"},{"/../g","http://a/g"},
+    {"g.","http://a/b/c/g."},{".g","http://a/b/c/.g"},{"g..","http://a/b/c/g.."},
+    {"./../g","http://a/b/g"},{"./g/.","http://a/b/c/g/"},{"g/./h","http://a/b/c/g/h"},
+    {"g/../h","http://a/b/c/h"},{"g;x=1/./y","http://a/b/c/g;x=1/y"},
+    {"g;x=1/../y","http://a/b/c/y"},{"g?y/./x","http://a/b/c/g?y/./x"},
+    {"g#s/../x","http://a/b/c/g#s/../x"},{"http:g","http:g"},{nullptr,nullptr}
+};
+
+struct Case {
+    const char *Input;
+    const char *Links;
+};
+
+static const Case Cases[]={
+    {"<a href=\"a.html\">x</a><A HREF=b.html>y</A>",
+     "a href http://example.com/dir/a.html|a href http://example.com/dir/b.html"},
+    {"<img src=x.png><base href=\"/static/\"><base href=\"/other/\"><a href='../up?q=1#f'>",
+     "img src http://example.com/static/x.png|a href http://example.com/up?q=1#f"},
+    {"<img srcset=\"a.jpg 1x, b.jpg 2x,c.jpg\" src=\"d.jpg\"><source srcset=\"e.webp,, f.webp 100w\">",
+     "img src http://example.com/dir/d.jpg|img srcset http://example.com/dir/a.jpg|"
+     "img srcset http://example.com/dir/b.jpg|img srcset http://example.com/dir/c.jpg|"
+     "source srcset http://example.com/dir/e.webp|source srcset http://example.com/dir/f.webp"},
+    {"<a href=\" /x?a=1&amp;b=2 \"><a href='/t\n\tab'><a href='it\"s'>",
+     "a href http://example.com/x?a=1&b=2|a href http://example.com/tab|a href http://example.com/dir/it\"s"},
+    {"<script src=s.js>var a='<a href=no>';</script><!-- <a href=no> --><form action=\"//cdn.example.org/post\">",
+     "script src http://example.com/dir/s.js|form action http://cdn.example.org/post"},
+    {"<a href=first href=second><a href><a href=\"\"><div src=x><a title=x>",
+     "a href http://example.com/dir/first"},
+    {"<a href=\"HTTP://other.org/a/./b/../c\"><a href=\"?x\"><a href=#top><a href=mailto:me@example.com>",
+     "a href HTTP://other.org/a/c|a href http://example.com/dir/page.html?x|"
+     "a href http://example.com/dir/page.html#top|a href mailto:me@example.com"},
+    {"<base target=_blank><link rel=stylesheet href=style.css><base href=\"http://cdn.example.org\">",
+     "link href http://cdn.example.org/style.css"},
+    {nullptr,nullptr}
+};
+
+static std::string joined(const std::vector<std::string> &links){
+    std::string out;
+    for(const std::string &link : links){
+        if(!out.empty())
+            out+='|';
+        out+=link;
+    }
+    return out;
+}
+
+//the links of a page from a full parse and a walk over the tree
+static void domLinks(libhtmlpp::HtmlElement *root,const char *url,std::vector<std::string> &links){
+    static const char *tags[][2]={
+        {"a","href"},{"link","href"},{"img","src srcset"},{"script","src"},{"form","action"},{nullptr,nullptr}
+    };
+
+    std::string base=url;
+    for(libhtmlpp::Element &el : libhtmlpp::preOrder(root)){
+        if(el.getType()!=libhtmlpp::HtmlEl || strcmp(((libhtmlpp::HtmlElement&)el).getTagname(),"base")!=0)
+            continue;
+        const char *href=((libhtmlpp::HtmlElement&)el).getAtributte("href");
+        if(href){
+            std::string resolved;
+            libhtmlpp::HtmlLinkExtractor::resolve(url,strlen(url),href,strlen(href),resolved);
+            base=resolved;
+            break;
+        }
+    }
+
+    for(libhtmlpp::Element &el : libhtmlpp::preOrder(root)){
+        if(el.getType()!=libhtmlpp::HtmlEl)
+            continue;
+        libhtmlpp::HtmlElement &hel=(libhtmlpp::HtmlElement&)el;
+        for(size_t i=0; tags[i][0]; ++i){
+            if(strcmp(hel.getTagname(),tags[i][0])!=0)
+                continue;
+            std::string attrs=tags[i][1];
+            size_t pos=0;
+            while(pos<attrs.size()){
+                size_t end=attrs.find(' ',pos);
+                if(end==std::string::npos)
+                    end=attrs.size();
+                std::string attr=attrs.substr(pos,end-pos);
+                pos=end+1;
+                const char *value=hel.getAtributte(attr.c_str());
+                if(!value || !*value)
+                    continue;
+                libhtmlpp::HtmlString decoded;
+                libhtmlpp::HtmlDecode(value,strlen(value),&decoded);
+                //srcset candidates of the test page are an url and a descriptor
+                std::string urls(decoded.data(),decoded.size());
+                size_t upos=0;
+                while(upos<urls.size()){
+                    size_t cend=attr=="srcset" ? urls.find(',',upos) : std::string::npos;
+                    if(cend==std::string::npos)
+                        cend=urls.size();
+                    upos=urls.find_first_not_of(' ',upos);
+                    size_t uend=std::min(urls.find(' ',upos),cend);
+                    std::string resolved;
+                    libhtmlpp::HtmlLinkExtractor::resolve(base.data(),base.size(),urls.data()+upos,uend-upos,resolved);
+                    links.push_back(std::string(tags[i][0])+" "+attr+" "+resolved);
+                    upos=cend+1;
+                }
+            }
+        }
+    }
+}
+
+int main(int argc,char *argv[]){
+    try{
+        const char *rbase="http://a/b/c/d;p?q";
+        for(size_t i=0; Resolves[i][0]; ++i){
+            std::string out;
+            libhtmlpp::HtmlLinkExtractor::resolve(rbase,strlen(rbase),Resolves[i][0],strlen(Resolves[i][0]),out);
+            if(out!=Resolves[i][1]){
+                std::cout << Resolves[i][0] << " -> " << out << std::endl;
+                return fail("wrong resolved url");
+            }
+        }
+
+        const char *url="http://example.com/dir/page.html";
+        for(size_t i=0; Cases[i].Input; ++i){
+            LinkCollector links;
+            links.extract(Cases[i].Input,strlen(Cases[i].Input),url);
+            if(joined(links.Links)!=Cases[i].Links){
+                std::cout << Cases[i].Input << " -> " << joined(links.Links) << std::endl;
+                return fail("wrong links");
+            }
+        }
+
+        std::string page="<!DOCTYPE html><html><head><title>t</title>"
+                         "<link rel=\"stylesheet\" href=\"/css/site.css\"><base href=\"/shop/\"></head><body>";
+        for(size_t i=0; page.size()<4*1024*1024; ++i){
+            std::string n=std::to_string(i);
+            page+="<div class=\"item\"><p>Some <b>text</b> with <a href=\"item?id="+n+"&amp;ref=list\">a link</a>\n"
+                  "<img src=\"../img/"+n+".png\" srcset=\"../img/"+n+"@2x.png 2x, /img/"+n+"@3x.png 3x\" alt=\"\">"
+                  "<ul><li>one<li><a href=\"https://other.org/"+n+"#top\">two</a></ul>"
+                  "<form action=\"cart/add\"><input name=\"id\" value=\""+n+"\"></form>"
+                  "<script>track(1<2)</script></div>\n";
+        }
+        page+="<script src=\"/js/app.js\"></script></body></html>";
+
+        auto start=std::chrono::steady_clock::now();
+        libhtmlpp::HtmlString doc(page.c_str());
+        std::vector<std::string> dom;
+        domLinks(doc.parse(),url,dom);
+        std::chrono::duration<double> tdom=std::chrono::steady_clock::now()-start;
+
+        LinkCollector links;
+        start=std::chrono::steady_clock::now();
+        links.extract(page.data(),page.size(),url);
+        std::chrono::duration<double> textract=std::chrono::steady_clock::now()-start;
+
+        if(links.Links!=dom)
+            return fail("links of the page differ from the dom");
+
+        std::cout << links.Links.size() << " links in " << page.size() << " bytes" << std::endl;
+        std::cout << "parse and walk: " << page.size()/tdom.count()/1048576 << " MB/s, extractor: "
+                  << page.size()/textract.count()/1048576 << " MB/s" << std::endl;
+    }catch(libhtmlpp::HTMLException &exp){
+        return fail(exp.what());
+    }
+    std::cout << Green << "Test Passed!" << NOCOLOR << std::endl;
+    return 0;
+}
@@ -0,0 +1,205 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <string.h>
+
+#include "css.h"
+#include "html.h"
+#include "exception.h"
+
+#define Red     "\033[0;31m"
+#define Green   "\033[0;32m"
+#define NOCOLOR "\033[0m"
+
+#define ARTICLES 20000
+
+static int fail(const char *msg){
+    std::cout << msg << std::endl;
+    std::cout << Red << "Test not Passed!" << NOCOLOR << std::endl;
+    return -1;
+}
+
+static const char page[]=
+    "<!DOCTYPE html>\n"
+    "<html>\n"
+    "  <head>\n"
+    "    <meta charset=\"utf-8\" />\n"
+    "    <title> My   page </title>\n"
+    "    <style>\n"
+    "      body { margin : 0 ; color: #333 }\n"
+    "      .a > .b , .c { padding: 0.5em 1px ; }\n"
+    "    </style>\n"
+    "  </head>\n"
+    "  <body>\n"
+    "    <!-- navigation -->\n"
+    "    <div class=\"nav main\"  id=\"top\">\n"
+    "      <a href=\"/index.html\">Home</a>\n"
+    "      <a href=\"/about.html\" title=\"About us\">About</a>\n"
+    "    </div>\n"
+    "    <p>\n"
+    "      Some   <b>bold</b>  text\n"
+    "      and more.\n"
+    "    </p>\n"
+    "    <pre>  keep\n   this  </pre>\n"
+    "    <form><input type=\"checkbox\" checked=\"checked\" disabled=\"\" /> <input type=\"text\" value=\"a b\" /></form>\n"
+    "    <ul>\n"
+    "      <li>one</li>\n"
+    "      <li>two</li>\n"
+    "    </ul>\n"
+    "    <script>var  a = 1;   </script>\n"
+    "  </body>\n"
+    "</html>";
+
+static const char minified[]=
+    "<!DOCTYPE html><html><head><meta charset=utf-8><title>My page</title>"
+    "<style>body{margin:0;color:#333}.a>.b,.c{padding:.5em 1px}</style></head><body>"
+    "<div class=\"nav main\" id=top><a href=/index.html>Home</a> "
+    "<a href=/about.html title=\"About us\">About</a></div>"
+    "<p>Some <b>bold</b> text and more.</p><pre>  keep\n   this  </pre>"
+    "<form><input type=checkbox checked disabled> <input type=text value=\"a b\"></form>"
+    "<ul><li>one</li><li>two</li></ul><script>var  a = 1;   </script></body></html>";
+
+static const char css[]=
+    "/*! keep me */\n"
+    "@import url( \"a.css\" ) screen;\n"
+    "@media screen and (max-width : 600px) {\n"
+    "  a:hover , a :focus { color : red ! important ; width: calc( 100% - 2 * 0.5em ) ; }\n"
+    "}\n"
+    "/* drop */ .x::after { content: \" a  b \" ; margin: -0.25px 0 0 0; }\n"
+    "@font-face { font-family : \"X\" ; src : url(x.woff) }\n";
+
+static const char cssminified[]=
+    "/*! keep me */@import url(\"a.css\") screen;@media screen and (max-width:600px)"
+    "{a:hover,a :focus{color:red!important;width:calc(100% - 2 * .5em)}}"
+    ".x::after{content:\" a  b \";margin:-.25px 0 0 0}@font-face{font-family:\"X\";src:url(x.woff)}";
+
+int main(int argc,char *argv[]){
+    try{
+        libhtmlpp::HtmlString html;
+        html << page;
+        libhtmlpp::HtmlElement *root=html.parse();
+
+        libhtmlpp::HtmlString out;
+        libhtmlpp::print(root,out,true);
+        if(strcmp(out.c_str(),minified)!=0)
+            return fail(out.c_str());
+
+        libhtmlpp::HtmlString full;
+        libhtmlpp::print(root,full,false);
+        libhtmlpp::HtmlString plain;
+        libhtmlpp::print(root,plain);
+        if(strcmp(full.c_str(),plain.c_str())!=0)
+            return fail("print without minify differs from print()");
+
+        libhtmlpp::HtmlElement *body=root->getElementbyTag("body");
+        libhtmlpp::CommentElement cond;
+        cond.setComment("[if IE]><p>old</p><![endif]");
+        body->insertChild(&cond);
+        out.clear();
+        libhtmlpp::print(body,out,true);
+        if(strncmp(out.c_str(),"<body><!--[if IE]><p>old</p><![endif]-->",40)!=0)
+            return fail(out.c_str());
+
+        libhtmlpp::CssMinifier mini;
+        mini.minify(css,sizeof(css)-1);
+        if(std::string(mini.data(),mini.size())!=cssminified)
+            return fail(std::string(mini.data(),mini.size()).c_str());
+
+        //the same output for every block size
+        for(size_t block=1; block<=19; ++block){
+            libhtmlpp::CssMinifier stream;
+            for(size_t pos=0; pos<sizeof(css)-1; pos+=block)
+                stream.feed(css+pos,std::min(block,sizeof(css)-1-pos));
+            stream.finish();
+            if(std::string(stream.data(),stream.size())!=cssminified)
+                return fail(std::string(stream.data(),stream.size()).c_str());
+        }
+
+        libhtmlpp::HtmlString big;
+        big << "<!DOCTYPE html>\n<html>\n  <head>\n    <title>  news  </title>\n  </head>\n  <body>\n";
+        for(int i=0; i<ARTICLES; ++i){
+            big << "    <!-- article " << i << " -->\n"
+                << "    <div class=\"article\" id=\"a" << i << "\">\n"
+                << "      <h2 class=\"title\">  Headline number " << i << "  </h2>\n"
+                << "      <p>\n        Lorem ipsum   dolor sit amet,\n        consectetur <b>adipiscing</b> elit.\n      </p>\n"
+                << "      <input type=\"checkbox\" checked=\"checked\" />\n"
+                << "    </div>\n";
+        }
+        big << "  </body>\n</html>";
+        libhtmlpp::HtmlElement *bigroot=big.parse();
+
+        libhtmlpp::HtmlString normal;
+        libhtmlpp::print(bigroot,normal);
+
+        libhtmlpp::HtmlString small;
+        auto hstart=std::chrono::steady_clock::now();
+        libhtmlpp::print(bigroot,small,true);
+        std::chrono::duration<double> htmltime=std::chrono::steady_clock::now()-hstart;
+
+        if(small.size()>=normal.size())
+            return fail("minified html isn't smaller");
+
+        std::cout << "html: " << normal.size() << " -> " << small.size() << " bytes, "
+                  << (normal.size()-small.size())*100/normal.size() << "% saved, "
+                  << normal.size()/htmltime.count()/1048576 << " MB/s" << std::endl;
+
+        std::string sheet;
+        for(int i=0; sheet.size()<4*1024*1024; ++i){
+            sheet+="/* button " +std::to_string(i)+" */\n.btn-"+std::to_string(i)+" > .icon , .btn-"
+                +std::to_string(i)+":hover {\n  margin : 0 auto ;\n  padding: 0.5rem 1rem;\n"
+                "  width: calc( 100% - 2 * 0.75rem ) ;\n  color: #333 !important;\n}\n";
+        }
+        libhtmlpp::CssMinifier cssmini;
+        auto cstart=std::chrono::steady_clock::now();
+        for(size_t pos=0; pos<sheet.size(); pos+=65536){
+            cssmini.feed(sheet.data()+pos,std::min<size_t>(65536,sheet.size()-pos));
+        }
+        cssmini.finish();
+        std::chrono::duration<double> csstime=std::chrono::steady_clock::now()-cstart;
+
+        std::cout << "css:  " << sheet.size() << " -> " << cssmini.size() << " bytes, "
+                  << (sheet.size()-cssmini.size())*100/sheet.size() << "% saved, "
+                  << sheet.size()/csstime.count()/1048576 << " MB/s" << std::endl;
+
+        for(int i=1; i<argc; ++i){
+            libhtmlpp::CssStylesheet file;
+            file.loadFile(argv[i]);
+            auto fstart=std::chrono::steady_clock::now();
+            cssmini.minify(file.data(),file.size());
+            std::chrono::duration<double> filetime=std::chrono::steady_clock::now()-fstart;
+            std::cout << argv[i] << ": " << file.size() << " -> " << cssmini.size() << " bytes, "
+                      << file.size()/filetime.count()/1048576 << " MB/s" << std::endl;
+        }
+    }catch(libhtmlpp::HTMLException &exp){
+        return fail(exp.what());
+    }
+    std::cout << Green << "Test Passed!" << NOCOLOR << std::endl;
+    return 0;
+}
@@ -0,0 +1,183 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <chrono>
+#include <iostream>
+#include <string.h>
+
+#include "html.h"
+#include "patch.h"
+#include "exception.h"
+
+#define Red     "\033[0;31m"
+#define Green   "\033[0;32m"
+#define NOCOLOR "\033[0m"
+
+#define ROWS 2000
+
+static int fail(const char *msg){
+    std::cout << msg << std::endl;
+    std::cout << Red << "Test not Passed!" << NOCOLOR << std::endl;
+    return -1;
+}
+
+/*
+ * 2000 keyed rows with 5 nodes each plus an unkeyed list, the second
+ * version changes values and classes, drops, adds and moves rows
+ */
+static void page(libhtmlpp::HtmlString &out,bool changed){
+    out << "<!DOCTYPE html><html><head><title>stock</title></head><body><table>";
+    for(int i=0; i<ROWS; ++i){
+        int row=i;
+        if(changed){
+            if(i==100 || i==500 || i==1500)
+                continue;
+            if(i==10)
+                row=1000;
+            else if(i==1000)
+                row=10;
+        }
+        out << "<tr id=\"r" << row << "\"";
+        if(changed && row%400==0)
+            out << " class=\"up\"";
+        out << "><td>stock " << row << "</td><td>";
+        if(changed && row%97==0)
+            out << row*3;
+        else
+            out << row;
+        out << "</td></tr>";
+        if(changed && i%700==0)
+            out << "<tr id=\"n" << i << "\"><td>new " << i << "</td><td>0</td></tr>";
+    }
+    out << "</table><ul>";
+    for(int i=0; i<5; ++i){
+        out << "<li>" << (changed && i==3 ? "changed" : "item") << "</li>";
+    }
+    if(changed)
+        out << "<li>more</li>";
+    out << "</ul><!-- " << (changed ? "v2" : "v1") << " --></body></html>";
+}
+
+int main(int arc,char *argv[]){
+    try{
+        libhtmlpp::HtmlString oldpage,newpage;
+        page(oldpage,false);
+        page(newpage,true);
+
+        libhtmlpp::HtmlElement *oldroot=oldpage.parse();
+        libhtmlpp::HtmlElement *newroot=newpage.parse();
+
+        libhtmlpp::HtmlPatch patch;
+        auto start=std::chrono::steady_clock::now();
+        patch.create(oldroot,newroot);
+        std::chrono::duration<double> difftime=std::chrono::steady_clock::now()-start;
+
+        libhtmlpp::HtmlString wire;
+        patch.print(wire);
+
+        patch.apply(oldroot);
+
+        libhtmlpp::HtmlString patched,expected;
+        libhtmlpp::print(oldroot,patched);
+        libhtmlpp::print(newroot,expected);
+        if(patched.size()!=expected.size() || memcmp(patched.c_str(),expected.c_str(),expected.size())!=0)
+            return fail("patched tree differs from the new tree");
+
+        libhtmlpp::HtmlPatch same;
+        same.create(oldroot,newroot);
+        if(same.size()!=0)
+            return fail("patched tree still has differences");
+
+        libhtmlpp::HtmlElement div("div");
+        div.setAttribute("id","box");
+        div.setAttribute("hidden",nullptr);
+        libhtmlpp::HtmlElement div2("div");
+        div2.setAttribute("id","box");
+        div2.setAttribute("class","a\"b");
+        same.create(&div,&div2);
+        if(same.size()!=2 || same[0].Type!=libhtmlpp::HtmlPatch::SetAttribute
+            || same[1].Type!=libhtmlpp::HtmlPatch::DelAttribute)
+            return fail("attribute operations are wrong");
+        libhtmlpp::HtmlString json;
+        same.print(json);
+        if(strcmp(json.c_str(),"[[\"a\",[0],\"class\",\"a\\\"b\"],[\"d\",[0],\"hidden\"]]")!=0)
+            return fail(json.c_str());
+
+        /*edits of the first element of a document, old and new page*/
+        const char *toplevel[][2]={
+            {"<div>a</div>","<p>a</p>"},
+            {"<html><body>x</body></html>","<!DOCTYPE html><html><body>x</body></html>"},
+            {"<!DOCTYPE html><html><body>x</body></html>","<html><body>y</body></html>"},
+            {"<div id=\"a\">1</div><div id=\"b\">2</div><div id=\"c\">3</div>",
+             "<div id=\"c\">3</div><div id=\"a\">1</div><div id=\"b\">2</div>"},
+            {"hello<p>x</p>","<p>x</p>"},
+            {"<p>x</p>","hello<p>x</p>"}
+        };
+        for(size_t i=0; i<sizeof(toplevel)/sizeof(toplevel[0]); ++i){
+            libhtmlpp::HtmlString olddoc(toplevel[i][0]),newdoc(toplevel[i][1]);
+            libhtmlpp::HtmlPatch top;
+            libhtmlpp::Element *oldroot=olddoc.parse(),*newroot=newdoc.parse();
+            //text in front of the first element belongs to the page
+            while(oldroot->prevElement())
+                oldroot=oldroot->prevElement();
+            while(newroot->prevElement())
+                newroot=newroot->prevElement();
+            top.create(oldroot,newroot);
+            libhtmlpp::HtmlString topgot,topwant;
+            libhtmlpp::print(top.apply(olddoc),topgot);
+            libhtmlpp::print(newroot,topwant);
+            if(strcmp(topgot.c_str(),topwant.c_str())!=0){
+                std::cout << toplevel[i][0] << " -> " << topgot.c_str() << std::endl;
+                return fail("top level patch differs from the new page");
+            }
+        }
+
+        libhtmlpp::HtmlString firstold("<div>a</div>"),firstnew("<p>a</p>");
+        libhtmlpp::HtmlElement *firstroot=firstold.parse();
+        same.create(firstroot,firstnew.parse());
+        try{
+            same.apply(firstroot);
+            return fail("first element replaced without its HtmlString");
+        }catch(libhtmlpp::HTMLException &e){
+        }
+
+        libhtmlpp::HtmlString listold("<div><p>1</p><p>2</p></div>"),listnew("<div><p>0</p><p>1</p><p>2</p></div>");
+        same.create(listold.parse(),listnew.parse());
+        if(same.size()!=1 || same[0].Type!=libhtmlpp::HtmlPatch::Insert || same[0].Path.size()!=2
+            || same[0].Path[0]!=0 || same[0].Path[1]!=0)
+            return fail("insert in front isn't a single insert");
+
+        std::cout << "diff of 10k nodes: " << difftime.count()*1000 << " ms, "
+                  << patch.size() << " operations" << std::endl;
+        std::cout << "full rerender: " << expected.size() << " bytes" << std::endl;
+        std::cout << "patch:         " << wire.size() << " bytes" << std::endl;
+    }catch(libhtmlpp::HTMLException &exp){
+        return fail(exp.what());
+    }
+    std::cout << Green << "Test Passed!" << NOCOLOR << std::endl;
+    return 0;
+}
@@ -0,0 +1,147 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <string.h>
+
+#include "html.h"
+#include "exception.h"
+
+#define Red     "\033[0;31m"
+#define Green   "\033[0;32m"
+#define NOCOLOR "\033[0m"
+
+#define SCRIPTSIZE (400*1024)
+#define PAGES      32
+
+static int fail(const char *msg){
+    std::cout << msg << std::endl;
+    std::cout << Red << "Test not Passed!" << NOCOLOR << std::endl;
+    return -1;
+}
+
+//parses and prints again, raw text has to come back unchanged
+static std::string reprint(libhtmlpp::HtmlString &html){
+    libhtmlpp::HtmlString out;
+    libhtmlpp::print(html.parse(),out);
+    return out.c_str();
+}
+
+static bool clean(libhtmlpp::HtmlString &html){
+    const libhtmlpp::HtmlString::ParseErrors &errs=html.getParseErrors();
+    return errs.StrayEndTags==0 && errs.MisnestedTags==0 && errs.UnclosedElements==0;
+}
+
+int main(int argc,char *argv[]){
+    try{
+        const char *same[]={
+            "<div><script>if(a<b && c>d){x=\"</div><p>\";}</script><p>x</p></div>",
+            "<div><style>a>b{c:d}p<q{}</style><p>x</p></div>",
+            "<div><textarea><b>not bold</b></div></textarea></div>",
+            "<div><script>var s='</scriptx>'+'<\\/script>';</script></div>",
+            "<div><SCRIPT>a</b></SCRIPT></div>",
+            "<div><!-- <div> a > b <!-- --><p>x</p></div>",
+            "<div><!----><p>x</p></div>",
+            nullptr
+        };
+        for(size_t i=0; same[i]; ++i){
+            libhtmlpp::HtmlString html(same[i]);
+            std::string out=reprint(html);
+            if(out!=same[i]){
+                std::cout << same[i] << " -> " << out << std::endl;
+                return fail("raw text changed");
+            }
+            if(!clean(html))
+                return fail("raw text reported as broken markup");
+        }
+
+        libhtmlpp::HtmlString markup("<div><script>document.write('<span>x</span>')</script></div>");
+        if(markup.parse()->getElementbyTag("span"))
+            return fail("tag inside script parsed");
+
+        libhtmlpp::HtmlString spaced("<div><style>a</style\n><p>x</p></div>");
+        if(reprint(spaced)!="<div><style>a</style><p>x</p></div>" || !clean(spaced))
+            return fail("end tag with space not found");
+
+        libhtmlpp::HtmlString open("<div><script>var a=1<2;</div>");
+        if(reprint(open)!="<div><script>var a=1<2;</div></script></div>" ||
+           open.getParseErrors().UnclosedElements!=2)
+            return fail("unterminated script not recovered");
+
+        libhtmlpp::HtmlString selfclosing("<div><script src=\"a.js\" /><p>x</p></div>");
+        if(reprint(selfclosing)!="<div><script src=\"a.js\"></script><p>x</p></div>")
+            return fail("self-closing script swallowed the page");
+
+        //end tags and noise at every position around the 16 byte blocks
+        uint32_t seed=4711;
+        for(size_t size=0; size<100; ++size){
+            std::string body;
+            for(size_t i=0; i<size; ++i){
+                seed=seed*1103515245+12345;
+                const char noise[]="ab</<s/script<>\n";
+                body+=noise[(seed>>16)%(sizeof(noise)-1)];
+            }
+            if(body.find("</script")!=std::string::npos)
+                continue;
+            std::string doc="<p><script>"+body+"</script></p>";
+            libhtmlpp::HtmlString html(doc.c_str());
+            if(reprint(html)!=doc)
+                return fail("raw text split");
+        }
+
+        std::string page="<!DOCTYPE html><html><head><title>t</title><script>";
+        std::string code="for(var i=0;i<n&&a[i]>0;++i){s+='<li>'+a[i]+'</li>';}\n";
+        while(page.size()<SCRIPTSIZE)
+            page+=code;
+        page+="</script><style>p>a{color:red}</style></head><body><p>text</p></body></html>";
+
+        libhtmlpp::HtmlString doc(page.c_str());
+        auto start=std::chrono::steady_clock::now();
+        for(int i=0; i<PAGES; ++i)
+            doc.parse();
+        std::chrono::duration<double> time=std::chrono::steady_clock::now()-start;
+
+        std::string copy;
+        auto cstart=std::chrono::steady_clock::now();
+        for(int i=0; i<PAGES; ++i){
+            copy.assign(page.data(),page.size());
+            copy[i]='x';
+        }
+        std::chrono::duration<double> ctime=std::chrono::steady_clock::now()-cstart;
+
+        if(!clean(doc))
+            return fail("inline script page reported as broken");
+        std::cout << "inline code pages: " << page.size()*PAGES/time.count()/1048576 << " MB/s, memcpy "
+                  << page.size()*PAGES/ctime.count()/1048576 << " MB/s" << std::endl;
+    }catch(libhtmlpp::HTMLException &exp){
+        return fail(exp.what());
+    }
+    std::cout << Green << "Test Passed!" << NOCOLOR << std::endl;
+    return 0;
+}
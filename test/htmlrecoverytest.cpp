@@ -0,0 +1,196 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "html.h"
+#include "exception.h"
+
+#define Red     "\033[0;31m"
+#define Green   "\033[0;32m"
+#define NOCOLOR "\033[0m"
+
+static int fail(const char *msg){
+    std::cout << msg << std::endl;
+    std::cout << Red << "Test not Passed!" << NOCOLOR << std::endl;
+    return -1;
+}
+
+struct Case {
+    const char *Input;
+    const char *Output;
+    size_t      Stray;
+    size_t      Misnested;
+    size_t      Unclosed;
+};
+
+static const Case Cases[]={
+    {"<ul><li>a<li>b</ul>","<ul><li>a</li><li>b</li></ul>",0,0,0},
+    {"<div><p>one<p>two<div>three</div></div>","<div><p>one</p><p>two</p><div>three</div></div>",0,0,0},
+    {"<div><b>bold</div>after","<div><b>bold</b></div>after",0,1,0},
+    {"<div>x</span></div>","<div>x</div>",1,0,0},
+    {"<table><tr><td>1<td>2<tr><th>3</table>",
+     "<table><tr><td>1</td><td>2</td></tr><tr><th>3</th></tr></table>",0,0,0},
+    {"<table><thead><tr><td>h<tbody><tr><td>b</table>",
+     "<table><thead><tr><td>h</td></tr></thead><tbody><tr><td>b</td></tr></tbody></table>",0,0,0},
+    {"<div><table><tr><td></div>x</td></tr></table></div>",
+     "<div><table><tr><td>x</td></tr></table></div>",1,0,0},
+    {"<dl><dt>a<dd>b<dt>c</dl>","<dl><dt>a</dt><dd>b</dd><dt>c</dt></dl>",0,0,0},
+    {"<select><option>a<option>b<optgroup><option>c</select>",
+     "<select><option>a</option><option>b</option><optgroup><option>c</option></optgroup></select>",0,0,0},
+    {"<p>text<br>more<img src=\"a.png\"></p>","<p>text<br>more<img src=\"a.png\" /></p>",0,0,0},
+    {"<p>a<br />b<div/>c</p>","<p>a<br>b</p><div></div>c",1,0,0},
+    {"<!DOCTYPE html><html><body><span>x","<!DOCTYPE html><html><body><span>x</span></body></html>",0,0,1},
+    {"<h1>a<h2>b</h2>","<h1>a</h1><h2>b</h2>",0,1,0},
+    {"<ul><li>a<ul><li>b</ul><li>c</ul>","<ul><li>a<ul><li>b</li></ul></li><li>c</li></ul>",0,0,0},
+    {"<head><meta charset=\"utf-8\"><title>t</title></head>",
+     "<head><meta charset=\"utf-8\"><title>t</title></head>",0,0,0},
+    {"<div><custom-el>a<custom-el>b</custom-el></custom-el></div>",
+     "<div><custom-el>a<custom-el>b</custom-el></custom-el></div>",0,0,0},
+    {"<b>x</b>tail","<b>x</b>tail",0,0,0},
+    {"<div><script src=\"a.js\"></script><i></i>text</div>",
+     "<div><script src=\"a.js\"></script><i></i>text</div>",0,0,0},
+    {"  hello<p>x</p>","  hello<p>x</p>",0,0,0},
+    {"<!-->after<p>y</p>","<!---->after<p>y</p>",0,0,0},
+    {"a<!--->b<!-- c --><i>c</i>","a<!---->b<!-- c --><i>c</i>",0,0,0},
+    {"<>x</><b>y</b>","<>x<b>y</b>",1,0,0},
+    {nullptr,nullptr,0,0,0}
+};
+
+//parse() returns the first element, text in front of it are its previous siblings
+static libhtmlpp::Element *document(libhtmlpp::HtmlElement *root){
+    libhtmlpp::Element *first=root;
+    while(first && first->prevElement())
+        first=first->prevElement();
+    return first;
+}
+
+//parse time in seconds
+static double parseTime(libhtmlpp::HtmlString &doc){
+    auto start=std::chrono::steady_clock::now();
+    doc.parse();
+    std::chrono::duration<double> time=std::chrono::steady_clock::now()-start;
+    return time.count();
+}
+
+int main(int argc,char *argv[]){
+    try{
+        for(size_t i=0; Cases[i].Input; ++i){
+            libhtmlpp::HtmlString html(Cases[i].Input),out;
+            libhtmlpp::HtmlElement *root=html.parse();
+            if(!root || root->getType()!=libhtmlpp::HtmlEl)
+                return fail("parse() didn't return the first element");
+            libhtmlpp::print(document(root),out);
+            const libhtmlpp::HtmlString::ParseErrors &errs=html.getParseErrors();
+            if(std::string(out.c_str())!=Cases[i].Output){
+                std::cout << Cases[i].Input << " -> " << out.c_str() << std::endl;
+                return fail("wrong tree");
+            }
+            if(errs.StrayEndTags!=Cases[i].Stray || errs.MisnestedTags!=Cases[i].Misnested ||
+               errs.UnclosedElements!=Cases[i].Unclosed){
+                std::cout << Cases[i].Input << " -> " << errs.StrayEndTags << " "
+                          << errs.MisnestedTags << " " << errs.UnclosedElements << std::endl;
+                return fail("wrong error counters");
+            }
+
+            //the repaired output parses again without errors
+            libhtmlpp::HtmlString again(out),out2;
+            libhtmlpp::print(document(again.parse()),out2);
+            const libhtmlpp::HtmlString::ParseErrors &errs2=again.getParseErrors();
+            if(std::string(out2.c_str())!=out.c_str() || errs2.StrayEndTags || errs2.MisnestedTags ||
+               errs2.UnclosedElements)
+            {
+                std::cout << out.c_str() << " -> " << out2.c_str() << std::endl;
+                return fail("repaired output changes on the second parse");
+            }
+        }
+
+        //leading text stays in front of the element parseLazy() returns
+        libhtmlpp::HtmlString lazytext("hello<b>x</b>"),lazyout;
+        libhtmlpp::HtmlElement *lazyroot=lazytext.parseLazy();
+        if(!lazyroot || lazyroot->getType()!=libhtmlpp::HtmlEl || !lazyroot->prevElement())
+            return fail("parseLazy() didn't return the first element");
+        libhtmlpp::print(document(lazyroot),lazyout);
+        if(std::string(lazyout.c_str())!="hello<b>x</b>")
+            return fail("wrong lazy tree");
+
+        //nothing to build is no exception
+        const char *empty[]={"</p>","","\n  ","hello","a<!-- b -->",nullptr};
+        for(size_t i=0; empty[i]; ++i){
+            libhtmlpp::HtmlString html(empty[i]),lazy(empty[i]);
+            size_t stray=i==0 ? 1 : 0;
+            if(html.parse() || html.getParseErrors().StrayEndTags!=stray)
+                return fail("empty tree not reported as nullptr");
+            if(lazy.parseLazy() || lazy.getParseErrors().StrayEndTags!=stray)
+                return fail("empty lazy tree not reported as nullptr");
+        }
+
+        std::string err;
+        libhtmlpp::HtmlString good("<div><p>a<p>b</div>"),bad("<div><b>a</div></i>");
+        if(!good.validate(&err))
+            return fail("valid html not accepted");
+        if(bad.validate(&err) || err.empty())
+            return fail("broken html not reported");
+
+        //pathological documents that made the old builder quadratic, 4 times the
+        //input may not take much more than 4 times as long
+        auto build=[](size_t n,int kind){
+            std::string doc;
+            if(kind==2)
+                doc="<div><table><tr><td>";
+            for(size_t i=0; i<n; ++i)
+                doc+=kind==1 ? "<p><b><i>x</b>" : "<span>";
+            for(size_t i=0; i<n; ++i)
+                doc+=kind==0 ? "</span>" : "</div>";
+            return doc;
+        };
+        for(int kind=0; kind<3; ++kind){
+            libhtmlpp::HtmlString small(build(5000,kind).c_str()),large(build(20000,kind).c_str());
+            double tsmall=parseTime(small),tlarge=parseTime(large);
+            std::cout << "pathological " << kind << ": " << tlarge*1000 << " ms for 4 times "
+                      << tsmall*1000 << " ms" << std::endl;
+            if(tlarge>tsmall*16+0.05)
+                return fail("builder isn't linear");
+        }
+
+        std::string page="<!DOCTYPE html><html><head><meta charset=\"utf-8\"><title>t</title></head><body>";
+        while(page.size()<4*1024*1024){
+            page+="<div class=\"item\"><p>Some <b>text<br>with <a href=\"/x\">links</a>"
+                  "<p>and an open paragraph<ul><li>one<li>two</ul><img src=\"a.png\"></div>\n";
+        }
+        libhtmlpp::HtmlString doc(page.c_str());
+        double time=parseTime(doc);
+        std::cout << "parse: " << page.size()/time/1048576 << " MB/s, "
+                  << doc.getParseErrors().MisnestedTags << " misnested tags" << std::endl;
+    }catch(libhtmlpp::HTMLException &exp){
+        return fail(exp.what());
+    }
+    std::cout << Green << "Test Passed!" << NOCOLOR << std::endl;
+    return 0;
+}
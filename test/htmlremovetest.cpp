@@ -0,0 +1,153 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "html.h"
+#include "exception.h"
+
+#define Red     "\033[0;31m"
+#define Green   "\033[0;32m"
+#define NOCOLOR "\033[0m"
+
+static int fail(const char *msg){
+    std::cout << msg << std::endl;
+    std::cout << Red << "Test not Passed!" << NOCOLOR << std::endl;
+    return -1;
+}
+
+static std::string print(libhtmlpp::Element *el){
+    libhtmlpp::HtmlString out;
+    libhtmlpp::print(el,out);
+    return out.c_str();
+}
+
+static bool isTag(libhtmlpp::Element &el,const char *tag){
+    return el.getType()==libhtmlpp::HtmlEl && strcmp(((libhtmlpp::HtmlElement&)el).getTagname(),tag)==0;
+}
+
+//removes every element with the tag, the iterator moves on before the element goes
+static size_t strip(libhtmlpp::Element *root,const char *tag){
+    size_t count=0;
+    for(libhtmlpp::PreOrderIterator it(root),end; it!=end; ){
+        libhtmlpp::Element *el=&*it;
+        if(isTag(*el,tag)){
+            it.skipChildren();
+            ++it;
+            el->remove();
+            ++count;
+        }else{
+            ++it;
+        }
+    }
+    return count;
+}
+
+int main(int argc,char *argv[]){
+    try{
+        libhtmlpp::HtmlString html("<div><p id=\"a\">a</p><p id=\"b\">b</p><p id=\"c\">c</p></div><span>s</span>");
+        libhtmlpp::HtmlElement *root=html.parse();
+
+        root->getElementbyID("b")->remove();
+        if(print(root)!="<div><p id=\"a\">a</p><p id=\"c\">c</p></div><span>s</span>")
+            return fail("remove in the middle");
+        root->getElementbyID("a")->remove();
+        root->getElementbyID("c")->remove();
+        if(print(root)!="<div></div><span>s</span>")
+            return fail("remove of first and last child");
+
+        libhtmlpp::Element *span=root->getElementbyTag("span")->detach();
+        if(print(root)!="<div></div>" || print(span)!="<span>s</span>" ||
+           span->parentElement() || span->prevElement() || span->nextElement())
+            return fail("detach");
+
+        libhtmlpp::HtmlElement replacement("em");
+        replacement.setAttribute("class","new");
+        libhtmlpp::HtmlString two("<ul><li>1</li><li>2</li><li>3</li></ul>");
+        libhtmlpp::HtmlElement *list=two.parse();
+        libhtmlpp::Element *em=((libhtmlpp::HtmlElement*)list->childElement()->nextElement())->replaceWith(&replacement);
+        if(print(list)!="<ul><li>1</li><em class=\"new\"></em><li>3</li></ul>" || em->parentElement()!=list)
+            return fail("replaceWith");
+
+        //the node memory goes to the free list and comes back for the next node
+        libhtmlpp::Element *last=em->nextElement();
+        void *freed=(void*)last;
+        last->remove();
+        list->appendChild(span);
+        if((void*)em->nextElement()!=freed)
+            return fail("removed node not reused");
+        delete span;
+
+        try{
+            root->remove();
+            return fail("first element of the document removed");
+        }catch(libhtmlpp::HTMLException &e){
+        }
+
+        libhtmlpp::HtmlString frozen("<div><b>x</b></div>");
+        libhtmlpp::HtmlElement *froot=frozen.parse();
+        frozen.freeze();
+        try{
+            froot->childElement()->remove();
+            return fail("frozen element removed");
+        }catch(libhtmlpp::HTMLException &e){
+        }
+
+        std::string src="<html><body>";
+        for(int i=0; i<20000; ++i){
+            src+="<div class=\"item\"><script>track()</script><p>Some <b>text</b> with "
+                 "<a href=\"/x\">links</a></p><img src=\"ad.png\"></div>";
+        }
+        src+="</body></html>";
+
+        //in place against printing the kept elements and parsing them again
+        libhtmlpp::HtmlString doc(src.c_str());
+        libhtmlpp::HtmlElement *droot=doc.parse();
+        auto start=std::chrono::steady_clock::now();
+        size_t removed=strip(droot,"script")+strip(droot,"img");
+        std::chrono::duration<double> tremove=std::chrono::steady_clock::now()-start;
+
+        start=std::chrono::steady_clock::now();
+        libhtmlpp::HtmlString rebuilt(print(droot).c_str());
+        rebuilt.parse();
+        std::chrono::duration<double> trebuild=std::chrono::steady_clock::now()-start;
+
+        if(removed!=40000 || print(droot).find("<img")!=std::string::npos ||
+           print(droot).find("track")!=std::string::npos)
+            return fail("filter left elements");
+
+        std::cout << "removed " << removed << " elements in " << tremove.count()*1000
+                  << " ms, rebuilding takes " << trebuild.count()*1000 << " ms" << std::endl;
+    }catch(libhtmlpp::HTMLException &exp){
+        return fail(exp.what());
+    }
+    std::cout << Green << "Test Passed!" << NOCOLOR << std::endl;
+    return 0;
+}
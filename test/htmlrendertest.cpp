@@ -0,0 +1,147 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <chrono>
+#include <iostream>
+#include <string.h>
+
+#include "html.h"
+#include "exception.h"
+
+#define Red     "\033[0;31m"
+#define Green   "\033[0;32m"
+#define NOCOLOR "\033[0m"
+
+#define WIDGETS 2000
+#define EDITS   200
+
+static int fail(const char *msg){
+    std::cout << msg << std::endl;
+    std::cout << Red << "Test not Passed!" << NOCOLOR << std::endl;
+    return -1;
+}
+
+static bool same(libhtmlpp::Element *root,libhtmlpp::HtmlRenderer &renderer){
+    libhtmlpp::HtmlString full;
+    libhtmlpp::print(root,full);
+    return full.size()==renderer.size() && memcmp(full.c_str(),renderer.data(),full.size())==0;
+}
+
+int main(int arc,char *argv[]){
+    try{
+        libhtmlpp::HtmlString page;
+        page << "<!DOCTYPE html><html><head><title>dashboard</title></head><body>";
+        for(int i=0; i<WIDGETS; ++i){
+            page << "<div id=\"w" << i << "\" class=\"widget\"><h2>Widget " << i
+                 << "</h2><span id=\"v" << i << "\">0</span><!-- w" << i << " --></div>\n";
+        }
+        page << "</body></html>";
+
+        libhtmlpp::HtmlElement *root=page.parse();
+        libhtmlpp::HtmlRenderer renderer;
+
+        renderer.render(root);
+        if(!same(root,renderer))
+            return fail("first render differs from print()");
+
+        libhtmlpp::HtmlElement *value=root->getElementbyID("v10");
+        value->setAttribute("class","alert");
+        renderer.render(root);
+        if(!same(root,renderer))
+            return fail("render after setAttribute differs from print()");
+
+        libhtmlpp::TextElement txt;
+        txt.setText("4711");
+        value->insertChild(&txt);
+        renderer.render(root);
+        if(!same(root,renderer))
+            return fail("render after insertChild differs from print()");
+
+        libhtmlpp::HtmlElement badge("b");
+        badge.setAttribute("class","new");
+        value->insertAfter(&badge);
+        root->getElementbyID("w0")->setAttribute("class","widget first");
+        root->getElementbyID("v1999")->insertBefore(&badge);
+        renderer.render(root);
+        if(!same(root,renderer))
+            return fail("render after insertAfter/insertBefore differs from print()");
+
+        renderer.render(root);
+        if(!same(root,renderer))
+            return fail("clean render differs from print()");
+
+        char buf[32];
+        auto pstart=std::chrono::steady_clock::now();
+        for(int i=0; i<EDITS; ++i){
+            snprintf(buf,sizeof(buf),"v%d",(i*7)%WIDGETS);
+            root->getElementbyID(buf)->setAttribute("data-value",buf);
+            libhtmlpp::HtmlString out;
+            libhtmlpp::print(root,out);
+        }
+        std::chrono::duration<double> printtime=std::chrono::steady_clock::now()-pstart;
+
+        auto rstart=std::chrono::steady_clock::now();
+        for(int i=0; i<EDITS; ++i){
+            snprintf(buf,sizeof(buf),"w%d",(i*7)%WIDGETS);
+            root->getElementbyID(buf)->setAttribute("data-value",buf);
+            renderer.render(root);
+        }
+        std::chrono::duration<double> rendertime=std::chrono::steady_clock::now()-rstart;
+
+        if(!same(root,renderer))
+            return fail("render after edits differs from print()");
+
+        //one renderer for two trees must not mix their spans
+        libhtmlpp::HtmlString treea("<div><p>AAAA</p><span>aaaaaa</span></div>"),treeb("<ul><li>x</li></ul>");
+        libhtmlpp::HtmlElement *roota=treea.parse(),*rootb=treeb.parse();
+        libhtmlpp::HtmlRenderer reused;
+        libhtmlpp::Element *order[]={roota,rootb,roota,roota->getElementbyTag("span"),roota};
+        for(size_t i=0; i<sizeof(order)/sizeof(order[0]); ++i){
+            reused.render(order[i]);
+            if(!same(order[i],reused))
+                return fail("renderer reused for another tree differs from print()");
+        }
+
+        libhtmlpp::HtmlString frozen("<div><p>shared</p></div>");
+        libhtmlpp::HtmlElement *froot=frozen.parse();
+        frozen.freeze();
+        try{
+            libhtmlpp::HtmlRenderer shared;
+            shared.render(froot);
+            return fail("frozen tree rendered");
+        }catch(libhtmlpp::HTMLException &exp){
+        }
+
+        std::cout << "page " << renderer.size() << " bytes" << std::endl;
+        std::cout << "edit + print():  " << EDITS/printtime.count() << " renders/s" << std::endl;
+        std::cout << "edit + render(): " << EDITS/rendertime.count() << " renders/s" << std::endl;
+    }catch(libhtmlpp::HTMLException &exp){
+        return fail(exp.what());
+    }
+    std::cout << Green << "Test Passed!" << NOCOLOR << std::endl;
+    return 0;
+}
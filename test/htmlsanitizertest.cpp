@@ -0,0 +1,326 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <string.h>
+
+#include "sanitizer.h"
+#include "exception.h"
+
+#define Red     "\033[0;31m"
+#define Green   "\033[0;32m"
+#define NOCOLOR "\033[0m"
+
+#define BENCHSIZE (16*1024*1024)
+
+static int fail(const char *msg){
+    std::cout << msg << std::endl;
+    std::cout << Red << "Test not Passed!" << NOCOLOR << std::endl;
+    return -1;
+}
+
+static std::string sanitize(libhtmlpp::HtmlSanitizer &san,const std::string &in){
+    san.sanitize(in.data(),in.size());
+    return std::string(san.data(),san.size());
+}
+
+static std::string lower(const std::string &in){
+    std::string out(in);
+    for(char &c : out)
+        c=(c>='A' && c<='Z') ? c|0x20 : c;
+    return out;
+}
+
+//a url is relative or starts with an allowed scheme
+static bool safeUrl(const std::string &url){
+    std::string scheme;
+    for(char c : url){
+        if(c==':')
+            return scheme=="http" || scheme=="https" || scheme=="mailto";
+        if(c=='/' || c=='?' || c=='#')
+            return true;
+        if(c!=' ' && c!='\t' && c!='\n')
+            scheme+=c;
+    }
+    return true;
+}
+
+//tokenizes the output again and complains about everything the policy forbids
+class Checker : public libhtmlpp::HtmlTokenizer {
+public:
+    Checker(const libhtmlpp::HtmlPolicy &policy) : Policy(policy){
+    }
+    const libhtmlpp::HtmlPolicy &Policy;
+    std::vector<int>             Open;
+    std::string                  Error;
+protected:
+    void onStartTag(const char *name,size_t nlen,const Attribute *attrs,
+                    size_t acount,bool selfclosing) override{
+        int tag=libhtmlpp::HtmlNames::getTag(name,nlen);
+        if(!Policy.isAllowed(tag))
+            Error="tag "+std::string(name,nlen);
+        for(size_t i=0; i<acount; ++i){
+            std::string key=lower(std::string(attrs[i].Key,attrs[i].KeySize));
+            if(!Policy.isAllowed(tag,libhtmlpp::HtmlNames::getAttribute(key.c_str())) || key.compare(0,2,"on")==0)
+                Error="attribute "+key;
+            if(attrs[i].Value && (key=="href" || key=="src" || key=="cite" || key=="srcset")
+               && !safeUrl(lower(std::string(attrs[i].Value,attrs[i].ValueSize))))
+                Error="url "+std::string(attrs[i].Value,attrs[i].ValueSize);
+        }
+        if(!libhtmlpp::HtmlNames::isVoid(tag))
+            Open.push_back(tag);
+    }
+    void onEndTag(const char *name,size_t nlen) override{
+        int tag=libhtmlpp::HtmlNames::getTag(name,nlen);
+        if(Open.empty() || Open.back()!=tag)
+            Error="unbalanced end tag "+std::string(name,nlen);
+        else
+            Open.pop_back();
+    }
+    void onComment(const char *text,size_t tlen) override{
+        Error="comment";
+    }
+    void onEnd() override{
+        if(!Open.empty())
+            Error="unclosed element";
+    }
+};
+
+//counts what the tokenizer reports
+class Counter : public libhtmlpp::HtmlTokenizer {
+public:
+    std::string Text,EndTags;
+protected:
+    void onText(const char *text,size_t tlen) override{
+        Text.append(text,tlen);
+    }
+    void onEndTag(const char *name,size_t nlen) override{
+        EndTags.append(name,nlen).append(" ");
+    }
+};
+
+static const char *Hostile[]={
+    "<script>alert(1)</script>",
+    "<SCRIPT SRC=//evil.example/x.js></SCRIPT>",
+    "<script/>alert(1)</script>",
+    "<img src=x onerror=alert(1)>",
+    "<img src=\"x\" onerror=\"alert(1)\">",
+    "<IMG SRC=\"javascript:alert('XSS');\">",
+    "<img src=JaVaScRiPt:alert(1)>",
+    "<a href=\"jav&#x09;ascript:alert(1)\">x</a>",
+    "<a href=\"jav&#x61;script:alert(1)\">x</a>",
+    "<a href=\"&#106;&#97;&#118;&#97;&#115;&#99;&#114;&#105;&#112;&#116;&#58;alert(1)\">x</a>",
+    "<a href=\"javascript&colon;alert(1)\">x</a>",
+    "<a href=\" \njavascript:alert(1)\">x</a>",
+    "<a href='vbscript:msgbox(1)'>x</a>",
+    "<a href=\"data:text/html;base64,PHNjcmlwdD5hbGVydCgxKTwvc2NyaXB0Pg==\">x</a>",
+    "<a href=\"http://example.com/\" onclick=\"alert(1)\">ok</a>",
+    "<a href=\"/relative?a=1&b=2\">ok</a>",
+    "<img srcset=\"a.png 1x, javascript:alert(1) 2x\">",
+    "<svg onload=alert(1)><circle/></svg>",
+    "<math><mi xlink:href=\"javascript:alert(1)\">x</mi></math>",
+    "<iframe src=\"javascript:alert(1)\"></iframe>",
+    "<iframe srcdoc=\"<script>alert(1)</script>\"></iframe>",
+    "<object data=\"javascript:alert(1)\"></object>",
+    "<embed src=\"javascript:alert(1)\">",
+    "<style>body{background:url(javascript:alert(1))}</style>",
+    "<div style=\"background:url(javascript:alert(1))\">x</div>",
+    "<div style=\"width:expression(alert(1))\">x</div>",
+    "<noscript><p title=\"</noscript><img src=x onerror=alert(1)>\"></noscript>",
+    "<title><script>alert(1)</script></title>",
+    "<textarea></textarea><script>alert(1)</script></textarea>",
+    "<!--<script>alert(1)</script>-->",
+    "<!--[if gte IE 4]><script>alert(1)</script><![endif]-->",
+    "<b title=\"a\"onmouseover=alert(1)>x</b>",
+    "<b title=a\"b>x</b>",
+    "<p><b><i>unclosed",
+    "</div></p></b>stray end tags",
+    "<table><tr><td colspan=2 onclick=x>cell</td></tr></table>",
+    "<form action=\"javascript:alert(1)\"><button formaction=javascript:x>b</button></form>",
+    "<meta http-equiv=\"refresh\" content=\"0;url=javascript:alert(1)\">",
+    "<base href=\"javascript:/\">",
+    "<x-custom onclick=alert(1)>custom</x-custom>",
+    "a < b && c > d & AT&T &amp; &#60;script&#62;",
+    "<<script>script>alert(1)<</script>/script>",
+    "<scr<script>ipt>alert(1)</scr</script>ipt>",
+    "<img src=\"x\"/onerror=alert(1)>",
+    "<details open ontoggle=alert(1)>",
+    "<a href=\"https://example.com/\" title=\"&quot;><script>alert(1)</script>\">ok</a>",
+    nullptr
+};
+
+int main(int argc,char *argv[]){
+    try{
+        libhtmlpp::HtmlPolicy policy=libhtmlpp::HtmlPolicy::basic();
+        libhtmlpp::HtmlSanitizer san(policy);
+
+        const char *cases[][2]={
+            {"<p onclick=\"x()\">Hello <b>World</b></p>","<p>Hello <b>World</b></p>"},
+            {"<script>alert(1)</script>text","text"},
+            {"<a href=\"javascript:alert(1)\" title=t>x</a>","<a title=\"t\">x</a>"},
+            {"<a HREF='https://example.com/?a=1&b=2'>x</a>","<a href=\"https://example.com/?a=1&amp;b=2\">x</a>"},
+            {"<unknown>keep</unknown> <br>","keep <br />"},
+            {"<p><b>open","<p><b>open</b></p>"},
+            {"</b>stray<!-- comment -->","stray"},
+            {"<!-->kept<!--->too<p>x</p>","kepttoo<p>x</p>"},
+            {"<p><i>a</p>b","<p><i>a</i></p>b"},
+            {"1 < 2 &copy; AT&T","1 &lt; 2 &copy; AT&amp;T"},
+            {"<img src=a.png alt=\"a\"b\" alt=c>","<img src=\"a.png\" alt=\"a\" />"},
+            {"<svg><p>inside</p></svg><svg><svg></svg>x</svg>y","y"},
+            {nullptr,nullptr}
+        };
+        for(size_t i=0; cases[i][0]; ++i){
+            if(sanitize(san,cases[i][0])!=cases[i][1]){
+                std::cout << cases[i][0] << " -> " << sanitize(san,cases[i][0]) << std::endl;
+                return fail("wrong sanitized output");
+            }
+        }
+
+        Counter raw;
+        const char script[]="<script>a</scriptx>b</SCRIPT >c";
+        raw.feed(script,sizeof(script)-1);
+        raw.finish();
+        if(raw.Text!="a</scriptx>bc" || raw.EndTags!="SCRIPT ")
+            return fail("raw text ended at a longer tag name");
+
+        //an unterminated quote doesn't keep the rest of the input
+        Counter open;
+        std::string block(4096,'x');
+        open.feed("<a title=\"",10);
+        for(int i=0; i<1024 && open.Text.empty(); ++i)
+            open.feed(block.data(),block.size());
+        if(open.Text.empty())
+            return fail("unterminated tag buffered without limit");
+        open.finish();
+
+        libhtmlpp::HtmlPolicy custom;
+        custom.allowTag("span");
+        custom.allowAttribute("span","style");
+        libhtmlpp::HtmlSanitizer styled(custom);
+        if(sanitize(styled,"<span style=\"color:red\">a</span><span style=\"x:expression(1)\">b</span>")
+           !="<span style=\"color:red\">a</span><span>b</span>")
+            return fail("wrong style filtering");
+        if(sanitize(styled,"<span style=\"x:expr/**/ession(1)\">a</span><span style=\"x:\\65xpression(1)\">b</span>")
+           !="<span>a</span><span>b</span>")
+            return fail("comment or escape in style accepted");
+
+        try{
+            custom.allowAttribute(nullptr,"onclick");
+            return fail("event handler allowed");
+        }catch(libhtmlpp::HTMLException &){
+        }
+
+        //fuzz corpus: the hostile snippets mixed, cut and mutated
+        std::string alphabet="<>/=\"' &;:#\t\nxj";
+        uint32_t seed=4711;
+        auto rnd=[&seed](uint32_t max){
+            seed=seed*1103515245+12345;
+            return (seed>>16)%max;
+        };
+        size_t hostile=0;
+        while(Hostile[hostile])
+            ++hostile;
+
+        std::string all;
+        for(int round=0; round<3000; ++round){
+            std::string in;
+            for(uint32_t parts=rnd(4)+1; parts>0; --parts){
+                std::string part=Hostile[rnd(hostile)];
+                if(rnd(3)==0)
+                    part=part.substr(rnd(part.size()));
+                for(uint32_t muts=rnd(4); muts>0 && !part.empty(); --muts){
+                    size_t pos=rnd(part.size());
+                    switch(rnd(4)){
+                        case 0:
+                            part.insert(pos,1,alphabet[rnd(alphabet.size())]);
+                            break;
+                        case 1:
+                            part.erase(pos,1);
+                            break;
+                        case 2:
+                            part[pos]^=0x20;
+                            break;
+                        default:
+                            part.insert(pos,Hostile[rnd(hostile)]);
+                    }
+                }
+                in+=part;
+            }
+            all+=in;
+
+            std::string out=sanitize(san,in);
+            Checker check(policy);
+            check.feed(out.data(),out.size());
+            check.finish();
+            if(!check.Error.empty() || lower(out).find("<script")!=std::string::npos){
+                std::cout << in << " -> " << out << " : " << check.Error << std::endl;
+                return fail("unsafe output");
+            }
+            if(sanitize(san,out)!=out){
+                std::cout << in << " -> " << out << std::endl;
+                return fail("output changes on the second pass");
+            }
+        }
+
+        //the output doesn't depend on the block size
+        std::string whole=sanitize(san,all);
+        for(size_t bsize=1; bsize<200; bsize+=bsize<16 ? 1 : 37){
+            std::string blocks;
+            san.reset();
+            for(size_t pos=0; pos<all.size(); pos+=bsize){
+                san.feed(all.data()+pos,std::min(bsize,all.size()-pos));
+                blocks.append(san.data(),san.size());
+                san.clear();
+            }
+            san.finish();
+            blocks.append(san.data(),san.size());
+            if(blocks!=whole)
+                return fail("output depends on the block size");
+        }
+
+        std::string doc;
+        while(doc.size()<BENCHSIZE){
+            doc+="<div class=\"comment\" onclick=\"vote()\"><p>Hello <b>world</b>, see "
+                 "<a href=\"https://example.com/page?a=1&amp;b=2\" target=_blank>this link</a> "
+                 "and <img src=\"/img/smile.png\" alt=\":)\" onerror=\"x()\"></p>"
+                 "<script>track();</script><ul><li>one</li><li>two &amp; three</li></ul>"
+                 "<!-- note --><blockquote cite=\"http://example.com\">quoted text</blockquote></div>\n";
+        }
+        auto start=std::chrono::steady_clock::now();
+        san.sanitize(doc.data(),doc.size());
+        std::chrono::duration<double> time=std::chrono::steady_clock::now()-start;
+        std::cout << "sanitizer: " << doc.size()/time.count()/1048576 << " MB/s, "
+                  << san.size()*100/doc.size() << "% of the input kept" << std::endl;
+    }catch(libhtmlpp::HTMLException &exp){
+        return fail(exp.what());
+    }
+    std::cout << Green << "Test Passed!" << NOCOLOR << std::endl;
+    return 0;
+}
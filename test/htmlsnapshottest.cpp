@@ -0,0 +1,146 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <chrono>
+#include <iostream>
+#include <string.h>
+
+#include "html.h"
+#include "snapshot.h"
+#include "exception.h"
+
+#define Red     "\033[0;31m"
+#define Green   "\033[0;32m"
+#define NOCOLOR "\033[0m"
+
+#define ROUNDS 200
+
+static int fail(const char *msg){
+    std::cout << msg << std::endl;
+    std::cout << Red << "Test not Passed!" << NOCOLOR << std::endl;
+    return -1;
+}
+
+int main(int arc,char *argv[]){
+    if(arc<2)
+        return fail("usage: htmlsnapshottest <html file>");
+
+    try{
+        libhtmlpp::HtmlPage page;
+        libhtmlpp::HtmlElement *index=page.loadFile(argv[1]);
+
+        libhtmlpp::HtmlString expected;
+        libhtmlpp::print(index,expected);
+
+        libhtmlpp::HtmlSnapshot snap;
+        snap.create(index);
+
+        libhtmlpp::HtmlString direct;
+        snap.print(direct);
+        if(strcmp(direct.c_str(),expected.c_str())!=0)
+            return fail("snapshot print differs from print()");
+
+        std::string path=std::string(argv[0])+".snap";
+        snap.saveFile(path.c_str());
+
+        libhtmlpp::HtmlSnapshot mapped;
+        mapped.loadFile(path.c_str());
+
+        libhtmlpp::HtmlString fromfile,fromdom;
+        mapped.print(fromfile);
+        libhtmlpp::print(mapped.parse(),fromdom);
+
+        if(strcmp(fromfile.c_str(),expected.c_str())!=0)
+            return fail("mapped snapshot print differs from print()");
+        if(strcmp(fromdom.c_str(),expected.c_str())!=0)
+            return fail("dom built from snapshot differs from print()");
+
+        std::vector<char> broken(snap.data(),snap.data()+snap.size());
+        libhtmlpp::HtmlSnapshot::Node *nodes=(libhtmlpp::HtmlSnapshot::Node*)(broken.data()+sizeof(libhtmlpp::HtmlSnapshot::Header));
+        nodes[0].Next=0;
+        try{
+            libhtmlpp::HtmlSnapshot bad;
+            bad.load(broken.data(),broken.size());
+            return fail("broken snapshot accepted");
+        }catch(libhtmlpp::HTMLException &e){
+        }
+
+        /*0 div, 1 p, 2 "a", 3 i, 4 b, 5 "c"*/
+        libhtmlpp::HtmlString small("<div><p>a</p><i><b>c</b></i></div>");
+        libhtmlpp::HtmlSnapshot ssnap;
+        ssnap.create(small.parse());
+        if(ssnap.getNodeCount()!=6 || ssnap.getNodes()[3].Child!=4)
+            return fail("unexpected snapshot layout");
+
+        //the dom of a snapshot starting with text, parse() returns the first element
+        libhtmlpp::HtmlString textdoc("hello<b>x</b>");
+        libhtmlpp::Element *textfirst=textdoc.parse()->prevElement();
+        libhtmlpp::HtmlSnapshot tsnap;
+        tsnap.create(textfirst);
+        libhtmlpp::HtmlElement *troot=tsnap.parse();
+        if(!troot || troot->getType()!=libhtmlpp::HtmlEl || !troot->prevElement())
+            return fail("snapshot parse() didn't return the first element");
+
+        for(int c=0; c<2; ++c){
+            std::vector<char> crafted(ssnap.data(),ssnap.data()+ssnap.size());
+            libhtmlpp::HtmlSnapshot::Node *cnodes=(libhtmlpp::HtmlSnapshot::Node*)(crafted.data()+sizeof(libhtmlpp::HtmlSnapshot::Header));
+            if(c==0)
+                cnodes[2].Next=4; //b is the child of i and the sibling of "a"
+            else
+                cnodes[1].Next=libhtmlpp::HtmlSnapshot::NoNode; //i and below are unreachable
+            try{
+                libhtmlpp::HtmlSnapshot bad;
+                bad.load(crafted.data(),crafted.size());
+                return fail(c==0 ? "shared node link accepted" : "unreachable node accepted");
+            }catch(libhtmlpp::HTMLException &e){
+            }
+        }
+
+        std::string src=expected.c_str();
+        auto pstart=std::chrono::steady_clock::now();
+        for(int i=0; i<ROUNDS; ++i){
+            libhtmlpp::HtmlString html(src);
+            html.parse();
+        }
+        std::chrono::duration<double> parsetime=std::chrono::steady_clock::now()-pstart;
+
+        auto lstart=std::chrono::steady_clock::now();
+        for(int i=0; i<ROUNDS; ++i){
+            libhtmlpp::HtmlSnapshot warm;
+            warm.loadFile(path.c_str());
+        }
+        std::chrono::duration<double> loadtime=std::chrono::steady_clock::now()-lstart;
+
+        std::cout << "html " << src.size() << " bytes, snapshot " << snap.size() << " bytes" << std::endl;
+        std::cout << "parse: " << ROUNDS/parsetime.count() << " docs/s, snapshot load: "
+                  << ROUNDS/loadtime.count() << " docs/s" << std::endl;
+    }catch(libhtmlpp::HTMLException &exp){
+        return fail(exp.what());
+    }
+    std::cout << Green << "Test Passed!" << NOCOLOR << std::endl;
+    return 0;
+}
@@ -0,0 +1,303 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <chrono>
+#include <iostream>
+#include <string.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "html.h"
+#include "tablereader.h"
+#include "tablewriter.h"
+#include "exception.h"
+
+#define Red     "\033[0;31m"
+#define Green   "\033[0;32m"
+#define NOCOLOR "\033[0m"
+
+#define ROWS 100000
+#define HTML_STREAMBLOCK 65536
+
+static int fail(const char *msg){
+    std::cout << msg << std::endl;
+    std::cout << Red << "Test not Passed!" << NOCOLOR << std::endl;
+    return -1;
+}
+
+class RowCollector : public libhtmlpp::HtmlTableReader {
+public:
+    RowCollector(){
+        Rows=0;
+    }
+
+    std::string Text;
+    size_t      Rows;
+protected:
+    void onRow(size_t table,libhtmlpp::HtmlTable::Row &row,bool header) override{
+        ++Rows;
+        if(Text.size()>4096)
+            return;
+        Text+=std::to_string(table);
+        Text+=header ? "h" : "r";
+        for(size_t i=0; i<row.getColumns(); ++i){
+            Text+="|";
+            Text.append(row[i].Data.data(),row[i].Data.size());
+        }
+        Text+="\n";
+    }
+};
+
+//counts the written bytes and drops them
+class NullBuffer : public std::streambuf {
+public:
+    NullBuffer(){
+        Bytes=0;
+    }
+    size_t Bytes;
+protected:
+    std::streamsize xsputn(const char *s,std::streamsize n) override{
+        Bytes+=n;
+        return n;
+    }
+    int overflow(int c) override{
+        ++Bytes;
+        return c;
+    }
+};
+
+//converts a table stream to csv without keeping the rows
+class CsvPipe : public libhtmlpp::HtmlTableReader {
+public:
+    CsvPipe(std::ostream &out) : Writer(out,libhtmlpp::HtmlTable::Csv){
+    }
+    libhtmlpp::HtmlTableWriter Writer;
+protected:
+    void onRow(size_t table,libhtmlpp::HtmlTable::Row &row,bool header) override{
+        if(header && Writer.getRows()==0)
+            Writer.setHeader(row);
+        else
+            Writer.writeRow(row);
+    }
+};
+
+static const char spans[]=
+    "<html><body><table><thead><tr><th>a</th><th colspan=\"2\">b &amp; c</th></tr></thead>"
+    "<tbody><tr><td rowspan=\"2\">x</td><td> 1 </td><td>2</td></tr>"
+    "<tr><td>3</td><td><b>4</b>&#x20AC;</td></tr></tbody></table></body></html>";
+
+static const char spanrows[]=
+    "0h|a|b & c|b & c\n"
+    "0r|x|1|2\n"
+    "0r|x|3|4\xe2\x82\xac\n";
+
+int main(int arc,char *argv[]){
+    try{
+        libhtmlpp::HtmlTable small;
+        small.setHeader(2,"name","value");
+        libhtmlpp::HtmlTable::Row row;
+        row << "a<b" << 1;
+        small << row;
+        row.clear();
+        row << "c&d" << 2;
+        small << row;
+        row.clear();
+        row << "" << 3;
+        small << row;
+
+        small[1][1].Data="22";
+        small.deleteRow(0);
+        if(small.getRows()!=2 || small[0].getColumns()!=2)
+            return fail("wrong table size after deleteRow");
+
+        const char expected[]="<table><tr><th>name</th><th>value</th></tr>"
+                              "<tr><td>c&amp;d</td><td>22</td></tr>"
+                              "<tr><td></td><td>3</td></tr></table>";
+
+        libhtmlpp::HtmlString direct;
+        small.print(direct);
+        if(strcmp(direct.c_str(),expected)!=0)
+            return fail(direct.c_str());
+
+        libhtmlpp::HtmlElement table;
+        small.insert(&table);
+        libhtmlpp::HtmlString dom;
+        libhtmlpp::print(&table,dom);
+        if(strcmp(dom.c_str(),expected)!=0)
+            return fail(dom.c_str());
+
+        bool thrown=false;
+        try{
+            small[2];
+        }catch(libhtmlpp::HTMLException &e){
+            thrown=true;
+        }
+        if(!thrown)
+            return fail("operator[] out of range doesn't throw");
+
+        libhtmlpp::HtmlString spandoc(spans);
+        libhtmlpp::HtmlTable parsed;
+        parsed.parse(spandoc.parse());
+        if(parsed.getRows()!=2)
+            return fail("parse returned wrong row count");
+        libhtmlpp::HtmlString reprint;
+        parsed.print(reprint);
+        if(strcmp(reprint.c_str(),"<table><tr><th>a</th><th>b &amp; c</th><th>b &amp; c</th></tr>"
+                                  "<tr><td>x</td><td>1</td><td>2</td></tr>"
+                                  "<tr><td>x</td><td>3</td><td>4\xe2\x82\xac</td></tr></table>")!=0)
+            return fail(reprint.c_str());
+
+        //every block size has to give the same rows
+        for(size_t block=1; block<=16; ++block){
+            RowCollector collector;
+            for(size_t pos=0; pos<sizeof(spans)-1; pos+=block)
+                collector.feed(spans+pos,std::min(block,sizeof(spans)-1-pos));
+            collector.finish();
+            if(collector.Text!=spanrows)
+                return fail(collector.Text.c_str());
+        }
+
+        //the tree and the reader read broken spans the same way
+        const char badspans[]="<table><tr><td colspan=\"-1\">a</td><td colspan=0 rowspan=x>b</td>"
+                              "<td COLSPAN=\" 2\">c</td><td colspan=\"1e3\">d</td></tr></table>";
+        RowCollector badreader;
+        badreader.feed(badspans,sizeof(badspans)-1);
+        badreader.finish();
+        libhtmlpp::HtmlString baddoc(badspans),badprint;
+        libhtmlpp::HtmlTable badtable;
+        badtable.parse(baddoc.parse());
+        badtable.print(badprint);
+        if(badreader.Text!="0r|a|b|c|c|d\n" ||
+           strcmp(badprint.c_str(),"<table><tr><td>a</td><td>b</td><td>c</td><td>c</td><td>d</td></tr></table>")!=0)
+            return fail(badprint.c_str());
+
+        RowCollector sloppy;
+        const char omitted[]="<table><tr><td>a<td>b<tr><th>c</table>"
+                             "<script>var t=\"<table><tr><td>no\";</script>"
+                             "<table><tr><td>1<table><tr><td>nested</table></td><td>2</table>";
+        sloppy.feed(omitted,sizeof(omitted)-1);
+        sloppy.finish();
+        if(sloppy.Text!="0r|a|b\n0h|c\n1r|1|2\n")
+            return fail(sloppy.Text.c_str());
+
+        RowCollector stream;
+        auto sstart=std::chrono::steady_clock::now();
+        std::string block="<table><tr><th>id</th><th>name</th><th>price</th></tr>";
+        for(int i=0; i<ROWS; ++i){
+            block+="<tr><td>"+std::to_string(i)+"</td><td>article &lt;"+std::to_string(i)
+                  +"&gt;</td><td>"+std::to_string(i*3)+"</td></tr>\n";
+            if(block.size()>HTML_STREAMBLOCK){
+                stream.feed(block.data(),block.size());
+                block.clear();
+            }
+        }
+        block+="</table>";
+        stream.feed(block.data(),block.size());
+        stream.finish();
+        std::chrono::duration<double> streamtime=std::chrono::steady_clock::now()-sstart;
+        if(stream.Rows!=ROWS+1)
+            return fail("stream returned wrong row count");
+
+        libhtmlpp::HtmlTable quoted;
+        quoted.setHeader(2,"name","note");
+        libhtmlpp::HtmlTable::Row qrow;
+        qrow << "a,b" << "say \"hi\"";
+        quoted << qrow;
+        qrow.clear();
+        qrow << "tab\there" << "line\nbreak\\";
+        quoted << qrow;
+
+        const char *formats[][2]={
+            {"name,note\r\n\"a,b\",\"say \"\"hi\"\"\"\r\ntab\there,\"line\nbreak\\\"\r\n",nullptr},
+            {"name\tnote\na,b\tsay \"hi\"\ntab\\there\tline\\nbreak\\\\\n",nullptr},
+            {"[{\"name\":\"a,b\",\"note\":\"say \\\"hi\\\"\"},"
+             "{\"name\":\"tab\\there\",\"note\":\"line\\nbreak\\\\\"}]",nullptr}
+        };
+        for(int format=libhtmlpp::HtmlTable::Csv; format<=libhtmlpp::HtmlTable::Json; ++format){
+            std::ostringstream out;
+            quoted.write(out,format);
+            if(out.str()!=formats[format][0])
+                return fail(out.str().c_str());
+        }
+
+        std::ostringstream plain;
+        small.write(plain,libhtmlpp::HtmlTable::Json);
+        if(plain.str()!="[{\"name\":\"c&d\",\"value\":\"22\"},{\"name\":\"\",\"value\":\"3\"}]")
+            return fail(plain.str().c_str());
+
+        std::ostringstream piped;
+        CsvPipe pipe(piped);
+        pipe.feed(spans,sizeof(spans)-1);
+        pipe.finish();
+        pipe.Writer.finish();
+        if(piped.str()!="a,b & c,b & c\r\nx,1,2\r\nx,3,4\xe2\x82\xac\r\n")
+            return fail(piped.str().c_str());
+
+        libhtmlpp::HtmlTable report;
+        report.setHeader(4,"id","name","price","stock");
+        auto fstart=std::chrono::steady_clock::now();
+        for(int i=0; i<ROWS; ++i){
+            libhtmlpp::HtmlTable::Row rrow;
+            rrow << i << "article <b>" << i*3 << i%17;
+            report << rrow;
+        }
+        std::chrono::duration<double> filltime=std::chrono::steady_clock::now()-fstart;
+
+        auto pstart=std::chrono::steady_clock::now();
+        libhtmlpp::HtmlString out;
+        report.print(out);
+        std::chrono::duration<double> printtime=std::chrono::steady_clock::now()-pstart;
+
+        auto istart=std::chrono::steady_clock::now();
+        libhtmlpp::HtmlElement rtable;
+        report.insert(&rtable);
+        std::chrono::duration<double> inserttime=std::chrono::steady_clock::now()-istart;
+
+        const char *names[]={"csv: ","tsv: ","json:"};
+        for(int format=libhtmlpp::HtmlTable::Csv; format<=libhtmlpp::HtmlTable::Json; ++format){
+            NullBuffer nullbuf;
+            std::ostream nullout(&nullbuf);
+            auto wstart=std::chrono::steady_clock::now();
+            report.write(nullout,format);
+            std::chrono::duration<double> writetime=std::chrono::steady_clock::now()-wstart;
+            std::cout << ROWS << " rows " << names[format] << "  " << ROWS/writetime.count()
+                      << " rows/s, " << nullbuf.Bytes << " bytes" << std::endl;
+        }
+
+        std::cout << ROWS << " rows fill:   " << filltime.count()*1000 << " ms" << std::endl;
+        std::cout << ROWS << " rows print:  " << printtime.count()*1000 << " ms, "
+                  << out.size() << " bytes" << std::endl;
+        std::cout << ROWS << " rows insert: " << inserttime.count()*1000 << " ms" << std::endl;
+        std::cout << ROWS << " rows stream: " << streamtime.count()*1000 << " ms" << std::endl;
+    }catch(libhtmlpp::HTMLException &exp){
+        return fail(exp.what());
+    }
+    std::cout << Green << "Test Passed!" << NOCOLOR << std::endl;
+    return 0;
+}
@@ -0,0 +1,166 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <chrono>
+#include <iostream>
+#include <string.h>
+
+#include "html.h"
+#include "template.h"
+#include "exception.h"
+
+#define Red     "\033[0;31m"
+#define Green   "\033[0;32m"
+#define NOCOLOR "\033[0m"
+
+#define RENDERS 2000
+
+const char *page =
+    "<!DOCTYPE html><html lang=\"en\"><head><title>shop</title></head><body>"
+    "<div class=\"header\"><a href=\"/user/{{uid}}\">profile</a></div>"
+    "<p>Hello <span id=\"user\">guest</span>, you have <b id=\"count\"></b> items.</p>"
+    "<ul><li>one</li><li>two</li><li>three</li></ul>"
+    "<!-- footer --><div id=\"footer\"><p>static footer</p></div></body></html>";
+
+static bool fail(const char *msg){
+    std::cout << msg << std::endl;
+    std::cout << Red << "Test not Passed!" << NOCOLOR << std::endl;
+    return false;
+}
+
+/*the way templates get filled without HtmlTemplate*/
+static void domRender(const char *user,const char *count,const char *uid,libhtmlpp::HtmlString &output){
+    libhtmlpp::HtmlString src(page);
+    libhtmlpp::HtmlElement *root=src.parse();
+
+    libhtmlpp::HtmlString escaped;
+    libhtmlpp::TextElement text;
+
+    libhtmlpp::HtmlEncode(user,&escaped);
+    text.setText(escaped.c_str());
+    root->getElementbyID("user")->insertChild(&text);
+
+    libhtmlpp::TextElement ctext;
+    ctext.setText(count);
+    root->getElementbyID("count")->insertChild(&ctext);
+
+    std::string href="/user/";
+    href+=uid;
+    root->getElementbyTag("a")->setAttribute("href",href.c_str());
+
+    libhtmlpp::print(root,output);
+}
+
+int main(int arc,char *argv[]){
+    try{
+        libhtmlpp::HtmlString src(page);
+        libhtmlpp::HtmlTemplate tpl;
+        tpl.compile(src);
+
+        long user=tpl.getSlot("user"),count=tpl.getSlot("count"),uid=tpl.getSlot("uid");
+        if(user<0 || count<0 || uid<0 || tpl.getSlot("footer")<0 || tpl.getSlot("header")>=0)
+            return fail("missing slots") ? 0 : -1;
+
+        std::vector<const char*> values(tpl.getSlots(),nullptr);
+        values[uid]="";
+
+        libhtmlpp::HtmlString plain,unbound;
+        libhtmlpp::print(src.parse(),plain);
+        tpl.render(values,unbound);
+
+        libhtmlpp::HtmlString expected(plain);
+        {
+            std::string tmp=expected.c_str();
+            tmp.replace(tmp.find("{{uid}}"),7,"");
+            expected=tmp.c_str();
+        }
+
+        if(strcmp(unbound.c_str(),expected.c_str())!=0)
+            return fail("unbound render differs from print") ? 0 : -1;
+
+        values[user]="<b>Jan & co</b>";
+        values[count]="3";
+        values[uid]="42";
+
+        libhtmlpp::HtmlString rendered,dom;
+        tpl.render(values,rendered);
+        domRender(values[user],values[count],values[uid],dom);
+
+        if(strcmp(rendered.c_str(),dom.c_str())!=0){
+            std::cout << rendered.c_str() << std::endl << dom.c_str() << std::endl;
+            return fail("render differs from parse-modify-print") ? 0 : -1;
+        }
+
+        libhtmlpp::HtmlString form("<form id=\"f\"><input id=\"user\" value=\"{{val}}\"><br id=\"gap\"></form>");
+        libhtmlpp::HtmlTemplate ftpl;
+        ftpl.compile(form);
+        if(ftpl.getSlot("user")>=0 || ftpl.getSlot("gap")>=0 || ftpl.getSlot("f")<0 || ftpl.getSlot("val")<0)
+            return fail("void elements got a content slot") ? 0 : -1;
+        libhtmlpp::HtmlString upper("<div ID=\"box\">x</div>");
+        libhtmlpp::HtmlTemplate utpl;
+        utpl.compile(upper);
+        if(utpl.getSlot("box")<0 || !upper.parse()->getElementbyID("box"))
+            return fail("upper case id got no slot") ? 0 : -1;
+
+        {
+            std::vector<const char*> fvalues(ftpl.getSlots(),nullptr);
+            fvalues[ftpl.getSlot("val")]="jan";
+            libhtmlpp::HtmlString frendered,fplain;
+            ftpl.render(fvalues,frendered);
+            libhtmlpp::print(form.parse(),fplain);
+            std::string fexpected=fplain.c_str();
+            fexpected.replace(fexpected.find("{{val}}"),7,"jan");
+            if(fexpected!=frendered.c_str()){
+                std::cout << frendered.c_str() << std::endl;
+                return fail("void element render differs from print") ? 0 : -1;
+            }
+        }
+
+        auto dstart=std::chrono::steady_clock::now();
+        for(int i=0; i<RENDERS; ++i){
+            libhtmlpp::HtmlString out;
+            domRender(values[user],values[count],values[uid],out);
+        }
+        std::chrono::duration<double> domtime=std::chrono::steady_clock::now()-dstart;
+
+        auto tstart=std::chrono::steady_clock::now();
+        for(int i=0; i<RENDERS; ++i){
+            libhtmlpp::HtmlString out;
+            tpl.render(values,out);
+        }
+        std::chrono::duration<double> tpltime=std::chrono::steady_clock::now()-tstart;
+
+        std::cout << "parse-modify-print: " << RENDERS/domtime.count() << " renders/s" << std::endl;
+        std::cout << "compiled template:  " << RENDERS/tpltime.count() << " renders/s" << std::endl;
+    }catch(libhtmlpp::HTMLException &exp){
+        std::cout << exp.what() << std::endl;
+        std::cout << Red << "Test not Passed!" << NOCOLOR << std::endl;
+        return -1;
+    }
+    std::cout << Green << "Test Passed!" << NOCOLOR << std::endl;
+    return 0;
+}
@@ -0,0 +1,136 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "html.h"
+#include "text.h"
+#include "exception.h"
+
+#define Red     "\033[0;31m"
+#define Green   "\033[0;32m"
+#define NOCOLOR "\033[0m"
+
+static int fail(const char *msg){
+    std::cout << msg << std::endl;
+    std::cout << Red << "Test not Passed!" << NOCOLOR << std::endl;
+    return -1;
+}
+
+struct Case {
+    const char *Input;
+    const char *Text;
+};
+
+static const Case Cases[]={
+    {"<div><p>Hello   <b>wor</b>ld</p><p>second\n line </p></div>","Hello world second line"},
+    {"<p>a<script>var x='<b>y</b>';</script>b<style>p{}</style>c<!-- c -->d</p>","abcd"},
+    {"<p>caf&eacute; &amp; &lt;tag&gt; &#x41;&#66; &nbsp;x &bogus; & y &amp</p>",
+     "caf&eacute; & <tag> AB \xC2\xA0x &bogus; & y &amp"},
+    {"<ul><li>one<li>two</ul>text<br>after","one two text after"},
+    {"<template><p>t</p><template>n</template>x</template><p>shown</p>","shown"},
+    {"<html><head><title>Title</title></head><body>\n  <h1>Head</h1>\n  <span>in</span>line\n</body></html>",
+     "Title Head inline"},
+    {nullptr,nullptr}
+};
+
+static std::string domText(const char *input){
+    libhtmlpp::HtmlString html(input),out;
+    libhtmlpp::printText(html.parse(),out);
+    return std::string(out.data(),out.size());
+}
+
+//feeds the input in blocks of bsize and takes the output after every block
+static std::string streamText(const char *input,size_t bsize){
+    libhtmlpp::HtmlTextExtractor extractor;
+    std::string out;
+    size_t len=strlen(input);
+    for(size_t i=0; i<len; i+=bsize){
+        extractor.feed(input+i,std::min(bsize,len-i));
+        out.append(extractor.data(),extractor.size());
+        extractor.clear();
+    }
+    extractor.finish();
+    out.append(extractor.data(),extractor.size());
+    return out;
+}
+
+int main(int argc,char *argv[]){
+    try{
+        for(size_t i=0; Cases[i].Input; ++i){
+            std::string dom=domText(Cases[i].Input);
+            if(dom!=Cases[i].Text){
+                std::cout << Cases[i].Input << " -> '" << dom << "'" << std::endl;
+                return fail("wrong text from the dom");
+            }
+            for(size_t bsize=1; bsize<=strlen(Cases[i].Input); bsize+=bsize<16 ? 1 : 32){
+                std::string stream=streamText(Cases[i].Input,bsize);
+                if(stream!=dom){
+                    std::cout << Cases[i].Input << " in blocks of " << bsize << " -> '" << stream << "'" << std::endl;
+                    return fail("streaming text differs from the dom");
+                }
+            }
+        }
+
+        libhtmlpp::HtmlString part("<div><p>a <b>b&amp;c</b> d</p></div>"),text;
+        part.parse()->getElementbyTag("b")->getTextContent(text);
+        if(std::string(text.data(),text.size())!="b&c")
+            return fail("getTextContent of one element");
+
+        std::string page="<!DOCTYPE html><html><head><title>t</title><style>p{color:red}</style></head><body>";
+        while(page.size()<4*1024*1024){
+            page+="<div class=\"item\"><p>Some <b>text</b> with   <a href=\"/x\">links</a> &amp; entities\n"
+                  "<p>and an open paragraph<ul><li>one<li>two</ul><script>track(1<2)</script></div>\n";
+        }
+        page+="</body></html>";
+
+        libhtmlpp::HtmlString doc(page.c_str()),domout;
+        libhtmlpp::HtmlElement *root=doc.parse();
+        auto start=std::chrono::steady_clock::now();
+        libhtmlpp::printText(root,domout);
+        std::chrono::duration<double> tdom=std::chrono::steady_clock::now()-start;
+
+        libhtmlpp::HtmlTextExtractor extractor;
+        start=std::chrono::steady_clock::now();
+        extractor.extract(page.data(),page.size());
+        std::chrono::duration<double> tstream=std::chrono::steady_clock::now()-start;
+
+        if(extractor.size()!=domout.size() || memcmp(extractor.data(),domout.data(),domout.size())!=0)
+            return fail("streaming text of the page differs from the dom");
+
+        std::cout << "text " << domout.size() << " bytes of " << page.size() << " bytes html" << std::endl;
+        std::cout << "dom walk: " << domout.size()/tdom.count()/1048576 << " MB/s text, stream: "
+                  << extractor.size()/tstream.count()/1048576 << " MB/s text ("
+                  << page.size()/tstream.count()/1048576 << " MB/s html)" << std::endl;
+    }catch(libhtmlpp::HTMLException &exp){
+        return fail(exp.what());
+    }
+    std::cout << Green << "Test Passed!" << NOCOLOR << std::endl;
+    return 0;
+}
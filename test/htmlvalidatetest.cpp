@@ -0,0 +1,178 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "html.h"
+#include "exception.h"
+
+#define Red     "\033[0;31m"
+#define Green   "\033[0;32m"
+#define NOCOLOR "\033[0m"
+
+typedef libhtmlpp::HtmlString::Diagnostic Diagnostic;
+
+static int fail(const char *msg){
+    std::cout << msg << std::endl;
+    std::cout << Red << "Test not Passed!" << NOCOLOR << std::endl;
+    return -1;
+}
+
+struct Case {
+    const char *Input;
+    //type, offset and start tag of every diagnostic, ends with -1
+    long        Expected[13];
+};
+
+static const long npos=(long)Diagnostic::npos;
+
+static const Case Cases[]={
+    {"<div><p>a<p>b</div>",{-1}},
+    {"<div><b>a</div></i><p><span>x",
+     {Diagnostic::MisnestedTag,9,5,Diagnostic::StrayEndTag,15,npos,Diagnostic::UnclosedElement,29,22,-1}},
+    {"<div></div><a href",{Diagnostic::UnterminatedTag,11,npos,-1}},
+    {"<b>x</b><!-- open",{Diagnostic::UnterminatedTag,8,npos,-1}},
+    {"<p><>x</p>",{Diagnostic::MissingTagName,3,npos,-1}},
+    {"<div/><a href=/x/>t</a><br><img src=\"a.png\" />",{-1}},
+    {"<a href=/x/>t",{Diagnostic::UnclosedElement,13,0,-1}},
+    {"<h1>a<h2>b</h2>",{Diagnostic::MisnestedTag,5,0,-1}},
+    {"<table><tr><td>1<td>2</table>",{-1}},
+    {"<div><table><tr><td></div>x</td></tr></table></div>",{Diagnostic::StrayEndTag,20,npos,-1}},
+    {"<script>if(a<b && c>d) x='</div>';</script><style>p>a{}</style>",{-1}},
+    {"<custom-el><CUSTOM-EL>a</custom-el></Custom-El>",{-1}},
+    {nullptr,{-1}}
+};
+
+//random markup of known, unknown, void and optional end tags
+static std::string randomDocument(size_t tags){
+    static const char *names[]={"div","p","span","b","li","ul","td","tr","table","h1","h2",
+                                "br","img","option","select","x-tag","dd","dl"};
+    std::string doc;
+    for(size_t i=0; i<tags; ++i){
+        const char *name=names[rand()%(sizeof(names)/sizeof(names[0]))];
+        switch(rand()%6){
+            case 0:
+            case 1:
+                doc+=std::string("</")+name+">";
+                break;
+            case 2:
+                doc+=std::string("<")+name+" />";
+                break;
+            default:
+                doc+=std::string("<")+name+" class=\"c\">";
+                break;
+        }
+        doc+="t";
+    }
+    return doc;
+}
+
+template<typename Fn>
+static double measure(Fn fn){
+    auto start=std::chrono::steady_clock::now();
+    fn();
+    std::chrono::duration<double> time=std::chrono::steady_clock::now()-start;
+    return time.count();
+}
+
+int main(int argc,char *argv[]){
+    try{
+        std::vector<Diagnostic> diags;
+        for(size_t i=0; Cases[i].Input; ++i){
+            libhtmlpp::HtmlString html(Cases[i].Input);
+            bool valid=html.validate(diags);
+            size_t count=0;
+            while(Cases[i].Expected[count*3]!=-1)
+                ++count;
+            bool match=diags.size()==count && valid==!count;
+            for(size_t ii=0; match && ii<count; ++ii){
+                const long *exp=&Cases[i].Expected[ii*3];
+                match=diags[ii].Type==exp[0] && (long)diags[ii].Offset==exp[1] &&
+                      (long)diags[ii].StartTag==exp[2];
+            }
+            if(!match){
+                std::cout << Cases[i].Input << " ->";
+                for(const Diagnostic &d : diags)
+                    std::cout << " " << d.Type << "@" << d.Offset << "/" << (long)d.StartTag;
+                std::cout << std::endl;
+                return fail("wrong diagnostics");
+            }
+        }
+
+        std::string err;
+        libhtmlpp::HtmlString bad("<div><b>a</div></i><x");
+        if(bad.validate(&err) || err!="1 stray end tags, 1 misnested tags, 0 unclosed elements, 1 malformed tags")
+            return fail("wrong summary");
+
+        //validate counts like the builder of parse()
+        srand(43);
+        for(int i=0; i<500; ++i){
+            std::string doc=randomDocument(1+rand()%60);
+            libhtmlpp::HtmlString checked(doc.c_str()),parsed(doc.c_str());
+            checked.validate(diags);
+            libhtmlpp::HtmlString::ParseErrors v=checked.getParseErrors();
+            try{
+                parsed.parse();
+            }catch(libhtmlpp::HTMLException &){
+                //documents of stray end tags have no tree, the counters are still set
+            }
+            const libhtmlpp::HtmlString::ParseErrors &p=parsed.getParseErrors();
+            if(v.StrayEndTags!=p.StrayEndTags || v.MisnestedTags!=p.MisnestedTags ||
+               v.UnclosedElements!=p.UnclosedElements || diags.size()!=v.StrayEndTags+v.MisnestedTags+v.UnclosedElements){
+                std::cout << doc << std::endl;
+                return fail("validate disagrees with parse");
+            }
+            for(size_t ii=1; ii<diags.size(); ++ii){
+                if(diags[ii].Offset<diags[ii-1].Offset)
+                    return fail("diagnostics not in document order");
+            }
+        }
+
+        std::string page="<!DOCTYPE html><html><head><meta charset=\"utf-8\"><title>t</title></head><body>";
+        while(page.size()<4*1024*1024){
+            page+="<div class=\"item\"><p>Some <b>text<br>with <a href=\"/x\">links</a>"
+                  "<p>and an open paragraph<ul><li>one<li>two</ul><img src=\"a.png\"></div>\n";
+        }
+        libhtmlpp::HtmlString doc(page.c_str());
+        double tparse=measure([&](){ doc.parse(); });
+        double tvalidate=measure([&](){ doc.validate(diags); });
+        std::cout << "validate: " << page.size()/tvalidate/1048576 << " MB/s, parse: "
+                  << page.size()/tparse/1048576 << " MB/s" << std::endl;
+        if(diags.size()!=doc.getParseErrors().MisnestedTags)
+            return fail("wrong diagnostics on the page");
+        if(tvalidate>tparse)
+            return fail("validate slower than parse");
+    }catch(libhtmlpp::HTMLException &exp){
+        return fail(exp.what());
+    }
+    std::cout << Green << "Test Passed!" << NOCOLOR << std::endl;
+    return 0;
+}
@@ -0,0 +1,261 @@
+/*******************************************************************************
+Copyright (c) 2021, Jan Koester jan.koester@gmx.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the <organization> nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <string.h>
+
+#include "request.h"
+#include "exception.h"
+
+#define Red     "\033[0;31m"
+#define Green   "\033[0;32m"
+#define NOCOLOR "\033[0m"
+
+#define UPLOADSIZE (32*1024*1024)
+
+static int fail(const char *msg){
+    std::cout << msg << std::endl;
+    std::cout << Red << "Test not Passed!" << NOCOLOR << std::endl;
+    return -1;
+}
+
+//byte by byte decoder to compare with
+static std::string decode(const std::string &in){
+    std::string out;
+    for(size_t i=0; i<in.size(); ++i){
+        if(in[i]=='+'){
+            out+=' ';
+        }else if(in[i]=='%' && i+2<in.size() && isxdigit(in[i+1]) && isxdigit(in[i+2])){
+            out+=(char)std::stoi(in.substr(i+1,2),nullptr,16);
+            i+=2;
+        }else{
+            out+=in[i];
+        }
+    }
+    return out;
+}
+
+class Collector : public libhtmlpp::HtmlMultipart {
+public:
+    Collector(const char *boundary) : HtmlMultipart(boundary,strlen(boundary)){
+        Chunks=0;
+        Ended=false;
+    }
+    std::string Events;
+    size_t      Chunks;
+    bool        Ended;
+protected:
+    void onPartBegin(const Part &part) override{
+        Events+="[";
+        Events.append(part.Name ? part.Name : "-",part.Name ? part.NameSize : 1);
+        if(part.Filename){
+            Events+="|";
+            Events.append(part.Filename,part.FilenameSize);
+        }
+        if(part.ContentType){
+            Events+="|";
+            Events.append(part.ContentType,part.ContentTypeSize);
+        }
+        Events+="|"+std::to_string(part.HeaderCount)+":";
+    }
+    void onPartData(const char *data,size_t size) override{
+        ++Chunks;
+        Events.append(data,size);
+    }
+    void onPartEnd() override{
+        Events+="]";
+    }
+    void onEnd() override{
+        Ended=true;
+    }
+};
+
+static const char body[]=
+    "preamble\r\n"
+    "--XyZ\r\n"
+    "Content-Disposition: form-data; name=\"title\"\r\n"
+    "\r\n"
+    "Hello World\r\n"
+    "--XyZ  \r\n"
+    "content-disposition: form-data; name=\"upload\"; filename=\"a;b.bin\"\r\n"
+    "Content-Type: application/octet-stream\r\n"
+    "\r\n"
+    "\r\n--Xy\r\n-\0\x01--XyZ\r\r\n--X\r\n"
+    "--XyZ\r\n"
+    "\r\n"
+    "no headers\r\n"
+    "--XyZ--\r\n"
+    "epilogue --XyZ\r\n";
+
+static const char events[]=
+    "[title|1:Hello World]"
+    "[upload|a;b.bin|application/octet-stream|2:\r\n--Xy\r\n-\0\x01--XyZ\r\r\n--X]"
+    "[-|0:no headers]";
+
+int main(int argc,char *argv[]){
+    try{
+        char plain[]="a+b%20c%2Fd%zz%4";
+        size_t len=libhtmlpp::UrlDecode(plain,strlen(plain));
+        if(std::string(plain,len)!="a b c/d%zz%4")
+            return fail("wrong url decoding");
+
+        char path[]="a+b%20";
+        len=libhtmlpp::UrlDecode(path,strlen(path),false);
+        if(std::string(path,len)!="a+b ")
+            return fail("wrong url decoding without plus");
+
+        //every length and position of the escapes around the 16 byte blocks
+        uint32_t seed=4711;
+        for(size_t size=0; size<80; ++size){
+            for(int round=0; round<20; ++round){
+                std::string in;
+                for(size_t i=0; i<size; ++i){
+                    seed=seed*1103515245+12345;
+                    switch((seed>>16)%12){
+                        case 0: in+='+'; break;
+                        case 1: in+='%'; break;
+                        case 2: in+="%4a"; break;
+                        default: in+=(char)('a'+(seed>>20)%26); break;
+                    }
+                }
+                std::string copy=in;
+                len=libhtmlpp::UrlDecode(&copy[0],copy.size());
+                if(copy.substr(0,len)!=decode(in))
+                    return fail(in.c_str());
+            }
+        }
+
+        char query[]="name=J%C3%BCrgen+K&empty=&flag&x=1%262&&=v";
+        libhtmlpp::HtmlForm form;
+        form.parse(query,strlen(query));
+        if(form.size()!=5)
+            return fail("wrong field count");
+        const libhtmlpp::HtmlForm::Field *field=form.getField("name");
+        if(!field || std::string(field->Value,field->ValueSize)!="J\xc3\xbcrgen K")
+            return fail("wrong field value");
+        field=form.getField("x");
+        if(!field || std::string(field->Value,field->ValueSize)!="1&2")
+            return fail("wrong escaped ampersand");
+        field=form.getField("flag");
+        if(!field || field->ValueSize!=0 || form[4].KeySize!=0 || form[4].Value[0]!='v')
+            return fail("wrong empty fields");
+
+        //the same events for every block size
+        for(size_t block=1; block<=sizeof(body); ++block){
+            Collector parts("XyZ");
+            for(size_t pos=0; pos<sizeof(body)-1; pos+=block)
+                parts.feed(body+pos,std::min(block,sizeof(body)-1-pos));
+            parts.finish();
+            if(parts.Events!=std::string(events,sizeof(events)-1) || !parts.Ended)
+                return fail(("block size "+std::to_string(block)+": "+parts.Events).c_str());
+        }
+
+        libhtmlpp::HtmlMultipart type;
+        const char ctype[]="multipart/form-data; charset=utf-8; boundary=\"XyZ\"";
+        type.setContentType(ctype,strlen(ctype));
+
+        bool thrown=false;
+        try{
+            Collector cut("XyZ");
+            cut.feed(body,100);
+            cut.finish();
+        }catch(libhtmlpp::HTMLException &e){
+            thrown=true;
+        }
+        if(!thrown)
+            return fail("data ending inside a part isn't an error");
+
+        //an upload full of line breaks and dashes streamed in 64k blocks
+        std::string upload="--a1b2c3\r\nContent-Disposition: form-data; name=\"file\"; filename=\"big.bin\"\r\n\r\n";
+        size_t head=upload.size();
+        upload.resize(head+UPLOADSIZE);
+        for(size_t i=head; i<upload.size(); ++i){
+            seed=seed*1103515245+12345;
+            const char bytes[]="\r\n--a1b2cx";
+            upload[i]=(seed>>16)%4==0 ? bytes[(seed>>20)%10] : (char)(seed>>24);
+        }
+        upload+="\r\n--a1b2c3--\r\n";
+
+        class Counter : public libhtmlpp::HtmlMultipart {
+        public:
+            Counter() : HtmlMultipart("a1b2c3",6){
+                Size=0;
+                Sum=0;
+                Chunks=0;
+            }
+            size_t   Size;
+            uint32_t Sum;
+            size_t   Chunks;
+        protected:
+            void onPartData(const char *data,size_t size) override{
+                for(size_t i=0; i<size; ++i)
+                    Sum=Sum*31+(unsigned char)data[i];
+                Size+=size;
+                ++Chunks;
+            }
+        } counter;
+
+        auto mstart=std::chrono::steady_clock::now();
+        for(size_t pos=0; pos<upload.size(); pos+=65536)
+            counter.feed(upload.data()+pos,std::min<size_t>(65536,upload.size()-pos));
+        counter.finish();
+        std::chrono::duration<double> mtime=std::chrono::steady_clock::now()-mstart;
+
+        uint32_t sum=0;
+        for(size_t i=head; i<head+UPLOADSIZE; ++i)
+            sum=sum*31+(unsigned char)upload[i];
+        if(counter.Size!=UPLOADSIZE || counter.Sum!=sum)
+            return fail("wrong upload content");
+        if(counter.Chunks<UPLOADSIZE/65536)
+            return fail("upload wasn't streamed");
+
+        std::string text(16*1024*1024,'x');
+        for(size_t i=0; i<text.size(); i+=64)
+            text[i]='=';
+        std::string encoded;
+        while(encoded.size()<text.size())
+            encoded+="caf%C3%A9+au+lait&";
+
+        auto pstart=std::chrono::steady_clock::now();
+        libhtmlpp::UrlDecode(&text[0],text.size());
+        std::chrono::duration<double> ptime=std::chrono::steady_clock::now()-pstart;
+        auto estart=std::chrono::steady_clock::now();
+        libhtmlpp::UrlDecode(&encoded[0],encoded.size());
+        std::chrono::duration<double> etime=std::chrono::steady_clock::now()-estart;
+
+        std::cout << "multipart: " << UPLOADSIZE/mtime.count()/1048576 << " MB/s in "
+                  << counter.Chunks << " pieces" << std::endl;
+        std::cout << "urldecode: plain " << text.size()/ptime.count()/1048576 << " MB/s, escaped "
+                  << encoded.size()/etime.count()/1048576 << " MB/s" << std::endl;
+    }catch(libhtmlpp::HTMLException &exp){
+        return fail(exp.what());
+    }
+    std::cout << Green << "Test Passed!" << NOCOLOR << std::endl;
+    return 0;
+}